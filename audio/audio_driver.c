@@ -25,6 +25,7 @@
 #include <file/file_path.h>
 #include <lists/dir_list.h>
 #include <string/stdstring.h>
+#include <compat/strl.h>
 
 #ifdef HAVE_CONFIG_H
 #include "../config.h"
@@ -40,11 +41,25 @@
 #include "../driver.h"
 #include "../configuration.h"
 #include "../retroarch.h"
+#include "../performance_counters.h"
 #include "../verbosity.h"
 #include "../list_special.h"
 
 #define AUDIO_BUFFER_FREE_SAMPLES_COUNT (8 * 1024)
 
+/* Latency auto-tuning: flushes per decision, flushes ignored
+ * after the driver starts, and clean windows before lowering. */
+#define AUDIO_LATENCY_AUTO_WINDOW       512
+#define AUDIO_LATENCY_AUTO_WARMUP       64
+#define AUDIO_LATENCY_AUTO_STABLE       4
+#define AUDIO_LATENCY_AUTO_MIN          8
+#define AUDIO_LATENCY_AUTO_MAX          512
+#define AUDIO_RATE_CONTROL_DELTA_MIN    0.001f
+#define AUDIO_RATE_CONTROL_DELTA_MAX    0.02f
+
+/* DSP chain instances reported as performance counters. */
+#define AUDIO_DRIVER_DSP_MAX_PERF 8
+
 /**
  * db_to_gain:
  * @db          : Decibels.
@@ -143,13 +158,31 @@ static size_t audio_driver_rewind_size                   = 0;
 static int16_t *audio_driver_rewind_buf                  = NULL;
 static int16_t *audio_driver_output_samples_conv_buf     = NULL;
 
+typedef struct audio_latency_tuner
+{
+   double avail_sum;
+   double avail_sq_sum;
+   unsigned flushes;
+   unsigned warmup;
+   unsigned max_avail;
+   unsigned starved;
+   unsigned stable_windows;
+   unsigned failed_latency;
+   unsigned pending_latency;
+   unsigned near_underruns;
+} audio_latency_tuner_t;
+
 static unsigned audio_driver_free_samples_buf[AUDIO_BUFFER_FREE_SAMPLES_COUNT];
 static uint64_t audio_driver_free_samples_count          = 0;
 
+static audio_latency_tuner_t audio_latency_tuner;
+
 static size_t audio_driver_buffer_size                   = 0;
 static size_t audio_driver_data_ptr                      = 0;
 
 static bool audio_driver_control                         = false;
+static bool audio_driver_latency_auto                    = false;
+static bool audio_driver_nonblock                        = false;
 static bool audio_driver_mixer_mute_enable               = false;
 static bool audio_driver_mute_enable                     = false;
 static bool audio_driver_use_float                       = false;
@@ -171,6 +204,8 @@ static double audio_source_ratio_current                 = 0.0f;
 static struct retro_audio_callback audio_callback        = {0};
 
 static retro_dsp_filter_t *audio_driver_dsp              = NULL;
+static struct retro_perf_counter audio_driver_dsp_perf[AUDIO_DRIVER_DSP_MAX_PERF];
+static char audio_driver_dsp_perf_ident[AUDIO_DRIVER_DSP_MAX_PERF][64];
 static struct string_list *audio_driver_devices_list     = NULL;
 static const retro_resampler_t *audio_driver_resampler   = NULL;
 
@@ -224,6 +259,7 @@ bool compute_audio_buffer_statistics(audio_statistics_t *stats)
    uint64_t accum_var            = 0;
    unsigned low_water_count      = 0;
    unsigned high_water_count     = 0;
+   settings_t *settings          = config_get_ptr();
    unsigned samples              = MIN(
          (unsigned)audio_driver_free_samples_count,
          AUDIO_BUFFER_FREE_SAMPLES_COUNT);
@@ -232,6 +268,15 @@ bool compute_audio_buffer_statistics(audio_statistics_t *stats)
       return false;
 
    stats->samples                = (unsigned)audio_driver_free_samples_count;
+   stats->rate_control_delta     = audio_driver_rate_control_delta;
+   stats->latency_auto           = audio_driver_latency_auto;
+   stats->near_underruns         = audio_latency_tuner.near_underruns;
+   stats->latency                = settings->uints.audio_latency;
+   stats->buffer_latency         = 0;
+   if (settings->uints.audio_out_rate)
+      stats->buffer_latency      = (unsigned)(audio_driver_buffer_size * 1000
+            / (settings->uints.audio_out_rate * 2 *
+               (audio_driver_use_float ? sizeof(float) : sizeof(int16_t))));
 
 #ifdef WARPUP
    /* uint64 to double not implemented, fair chance 
@@ -535,6 +580,7 @@ static bool audio_driver_init_internal(bool audio_cb_inited)
 
    audio_driver_output_samples_buf = samples_buf;
    audio_driver_control            = false;
+   audio_driver_latency_auto       = false;
 
    if (
          !audio_cb_inited
@@ -549,6 +595,7 @@ static bool audio_driver_init_internal(bool audio_cb_inited)
          audio_driver_buffer_size =
             current_audio->buffer_size(audio_driver_context_audio_data);
          audio_driver_control     = true;
+         audio_driver_latency_auto = settings->bools.audio_latency_auto;
       }
       else
          RARCH_WARN("Audio rate control was desired, but driver does not support needed features.\n");
@@ -558,6 +605,15 @@ static bool audio_driver_init_internal(bool audio_cb_inited)
 
    audio_driver_free_samples_count = 0;
 
+   /* Tuning carries over driver reinits, the window does not. */
+   audio_latency_tuner.flushes         = 0;
+   audio_latency_tuner.avail_sum       = 0;
+   audio_latency_tuner.avail_sq_sum    = 0;
+   audio_latency_tuner.max_avail       = 0;
+   audio_latency_tuner.starved         = 0;
+   audio_latency_tuner.pending_latency = 0;
+   audio_latency_tuner.warmup          = AUDIO_LATENCY_AUTO_WARMUP;
+
    audio_driver_mixer_init(settings->uints.audio_out_rate);
 
    /* Threaded driver is initially stopped. */
@@ -587,6 +643,150 @@ void audio_driver_set_nonblocking_state(bool enable)
    audio_driver_chunk_size = enable ?
       audio_driver_chunk_nonblock_size :
       audio_driver_chunk_block_size;
+   audio_driver_nonblock   = enable || !settings->bools.audio_sync;
+}
+
+/* The counters are static because they stay registered after
+ * the DSP chain they describe has been freed. */
+static void audio_driver_dsp_perf_update(void)
+{
+   unsigned i;
+   unsigned num = MIN(retro_dsp_filter_get_num_instances(audio_driver_dsp),
+         AUDIO_DRIVER_DSP_MAX_PERF);
+
+   for (i = 0; i < num; i++)
+   {
+      const struct retro_perf_counter *perf =
+         retro_dsp_filter_get_perf(audio_driver_dsp, i);
+      struct retro_perf_counter *counter    = &audio_driver_dsp_perf[i];
+
+      if (!counter->registered)
+      {
+         counter->ident = audio_driver_dsp_perf_ident[i];
+         rarch_perf_register(counter);
+      }
+
+      counter->total    = perf->total;
+      counter->call_cnt = perf->call_cnt;
+   }
+}
+
+/* Fed with every write_avail sample taken for rate control.
+ *
+ * Once per window it looks at how close the driver buffer came
+ * to running dry. A window with a near-underrun raises the latency
+ * right away and remembers the latency that failed; several windows
+ * in a row that kept more than a quarter of the buffer queued lower
+ * it, but not to within a quarter of a latency that failed before.
+ * Rate control holds the buffer around half full, so a quarter is
+ * the margin left above the near-underrun mark. Rate control delta
+ * follows the jitter of the buffer level. Latency changes need a
+ * driver reinit, which audio_driver_latency_auto_apply() does
+ * between frames. */
+static void audio_driver_latency_auto_update(unsigned avail)
+{
+   double mean, jitter, fill_min;
+   settings_t *settings          = NULL;
+   unsigned latency              = 0;
+   unsigned size                 = (unsigned)audio_driver_buffer_size;
+   audio_latency_tuner_t *tuner  = &audio_latency_tuner;
+
+   if (tuner->pending_latency || audio_driver_nonblock || !size)
+      return;
+
+   /* The buffer starts out empty, don't mistake that for jitter. */
+   if (tuner->warmup)
+   {
+      tuner->warmup--;
+      return;
+   }
+
+   tuner->flushes++;
+   tuner->avail_sum    += avail;
+   tuner->avail_sq_sum += (double)avail * avail;
+   if (avail > tuner->max_avail)
+      tuner->max_avail  = avail;
+
+   /* Less than a 16th of the buffer was left to play. */
+   if (avail >= size - size / 16)
+   {
+      tuner->starved++;
+      tuner->near_underruns++;
+   }
+
+   if (tuner->flushes < AUDIO_LATENCY_AUTO_WINDOW)
+      return;
+
+   settings = config_get_ptr();
+   latency  = settings->uints.audio_latency;
+   mean     = tuner->avail_sum / tuner->flushes;
+   jitter   = tuner->avail_sq_sum / tuner->flushes - mean * mean;
+   jitter   = sqrt(MAX(jitter, 0.0)) / size;
+   fill_min = 1.0 - (double)tuner->max_avail / size;
+
+   if (tuner->starved)
+   {
+      tuner->failed_latency  = MAX(tuner->failed_latency, latency);
+      tuner->stable_windows  = 0;
+      latency                = MIN(latency + latency / 2 + 1,
+            AUDIO_LATENCY_AUTO_MAX);
+      audio_driver_rate_control_delta = MIN(
+            audio_driver_rate_control_delta * 1.25f,
+            AUDIO_RATE_CONTROL_DELTA_MAX);
+   }
+   else if (fill_min <= 0.25)
+      tuner->stable_windows  = 0;
+   else if (++tuner->stable_windows >= AUDIO_LATENCY_AUTO_STABLE)
+   {
+      unsigned lower         = MAX(latency * 3 / 4, AUDIO_LATENCY_AUTO_MIN);
+
+      tuner->stable_windows  = 0;
+      if (lower >= tuner->failed_latency + tuner->failed_latency / 4)
+         latency             = lower;
+   }
+
+   if (jitter > 0.2)
+      audio_driver_rate_control_delta = MIN(
+            audio_driver_rate_control_delta * 1.1f,
+            AUDIO_RATE_CONTROL_DELTA_MAX);
+   else if (jitter < 0.05)
+      audio_driver_rate_control_delta = MAX(
+            audio_driver_rate_control_delta * 0.95f,
+            AUDIO_RATE_CONTROL_DELTA_MIN);
+
+   if (latency != settings->uints.audio_latency)
+      tuner->pending_latency = latency;
+
+   tuner->flushes      = 0;
+   tuner->avail_sum    = 0;
+   tuner->avail_sq_sum = 0;
+   tuner->max_avail    = 0;
+   tuner->starved      = 0;
+}
+
+/**
+ * audio_driver_latency_auto_apply:
+ *
+ * Reinitializes the audio driver if latency auto-tuning
+ * picked a new latency. Call between frames.
+ **/
+void audio_driver_latency_auto_apply(void)
+{
+   settings_t *settings = NULL;
+   unsigned latency     = audio_latency_tuner.pending_latency;
+
+   if (!latency)
+      return;
+
+   settings = config_get_ptr();
+   RARCH_LOG("[Audio]: Auto latency: %u ms -> %u ms,"
+         " rate control delta %.4f.\n",
+         settings->uints.audio_latency, latency,
+         audio_driver_rate_control_delta);
+
+   audio_latency_tuner.pending_latency = 0;
+   settings->uints.audio_latency       = latency;
+   command_event(CMD_EVENT_AUDIO_REINIT, NULL);
 }
 
 /**
@@ -645,6 +845,9 @@ static void audio_driver_flush(const int16_t *data, size_t samples)
 
       retro_dsp_filter_process(audio_driver_dsp, &dsp_data);
 
+      if (is_perfcnt_enable)
+         audio_driver_dsp_perf_update();
+
       if (dsp_data.output)
       {
          src_data.data_in            = dsp_data.output;
@@ -671,6 +874,9 @@ static void audio_driver_flush(const int16_t *data, size_t samples)
       audio_source_ratio_current   =
          audio_source_ratio_original * adjust;
 
+      if (audio_driver_latency_auto)
+         audio_driver_latency_auto_update(avail);
+
 #if 0
       if (verbosity_is_enabled())
       {
@@ -717,9 +923,11 @@ static void audio_driver_flush(const int16_t *data, size_t samples)
       output_frames  *= sizeof(int16_t);
    }
 
+   frame_telemetry_event_begin(FRAME_TELEMETRY_AUDIO_WRITE);
    if (current_audio->write(audio_driver_context_audio_data,
             output_data, output_frames * 2) < 0)
       audio_driver_active = false;
+   frame_telemetry_event_end(FRAME_TELEMETRY_AUDIO_WRITE);
 }
 
 /**
@@ -852,6 +1060,21 @@ void audio_driver_dsp_filter_init(const char *device)
    if (!audio_driver_dsp)
       goto error;
 
+   {
+      unsigned i;
+      unsigned num = retro_dsp_filter_get_num_instances(audio_driver_dsp);
+
+      for (i = 0; i < AUDIO_DRIVER_DSP_MAX_PERF; i++)
+      {
+         audio_driver_dsp_perf[i].total    = 0;
+         audio_driver_dsp_perf[i].call_cnt = 0;
+         if (i < num)
+            strlcpy(audio_driver_dsp_perf_ident[i],
+                  retro_dsp_filter_get_perf(audio_driver_dsp, i)->ident,
+                  sizeof(audio_driver_dsp_perf_ident[i]));
+      }
+   }
+
 #if defined(HAVE_DYLIB) && !defined(HAVE_FILTERS_BUILTIN)
    free(basedir);
    free(ext_name);
@@ -1382,6 +1605,10 @@ static void audio_driver_mixer_deinit(void)
       audio_driver_mixer_remove_stream(i);
    }
 
+   if (audio_mixer_get_underruns())
+      RARCH_LOG("[Audio]: Mixer streams underran %u times.\n",
+            audio_mixer_get_underruns());
+
    audio_mixer_done();
 }
 
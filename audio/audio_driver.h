@@ -75,7 +75,14 @@ typedef struct audio_statistics
    float std_deviation_percentage;
    float close_to_underrun;
    float close_to_blocking;
+   float rate_control_delta;
    unsigned samples;
+   /* Requested and actual driver latency, in milliseconds. */
+   unsigned latency;
+   unsigned buffer_latency;
+   /* Flushes that found the driver buffer nearly empty. */
+   unsigned near_underruns;
+   bool latency_auto;
 } audio_statistics_t;
 
 typedef struct audio_driver
@@ -250,6 +257,8 @@ void audio_driver_setup_rewind(void);
 
 void audio_driver_monitor_adjust_system_rates(void);
 
+void audio_driver_latency_auto_apply(void);
+
 bool audio_driver_set_callback(const void *data);
 
 bool audio_driver_callback(void);
@@ -1041,6 +1041,8 @@ static void command_event_init_controllers(void)
 
 static void command_event_deinit_core(bool reinit)
 {
+   frame_telemetry_deinit();
+
 #ifdef HAVE_CHEEVOS
    cheevos_unload();
 #endif
@@ -1277,6 +1279,9 @@ static bool command_event_init_core(enum rarch_core_type *data)
 
    rarch_ctl(RARCH_CTL_SET_FRAME_LIMIT, NULL);
 
+   frame_telemetry_init(settings->paths.path_frame_telemetry,
+         video_viewport_get_system_av_info()->timing.fps);
+
    return true;
 }
 
@@ -73,6 +73,7 @@ static const int crt_switch_resolution_super = 2560;
 static const bool def_history_list_enable = true;
 static const bool def_playlist_entry_remove = true;
 static const bool def_playlist_entry_rename = true;
+static const bool def_playlist_use_binary_format = false;
 
 static const unsigned int def_user_language = 0;
 
@@ -489,6 +490,10 @@ static const bool rate_control = false;
  * is allowed to adjust input rate. */
 static const float rate_control_delta = 0.005;
 
+/* Lets rate control tune audio latency and rate control delta
+ * at runtime, looking for the smallest buffer that does not run dry. */
+static const bool audio_latency_auto = false;
+
 /* Maximum timing skew. Defines how much adjust_system_rates
  * is allowed to adjust input rate. */
 static const float max_timing_skew = 0.05;
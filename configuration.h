@@ -104,6 +104,7 @@ typedef struct settings
         bool audio_enable_menu;
         bool audio_sync;
         bool audio_rate_control;
+        bool audio_latency_auto;
         bool audio_wasapi_exclusive_mode;
         bool audio_wasapi_float_format;
 
@@ -236,6 +237,7 @@ typedef struct settings
         bool auto_screenshot_filename;
         bool history_list_enable;
         bool playlist_entry_remove;
+        bool playlist_use_binary_format;
         bool playlist_entry_rename;
         bool rewind_enable;
         bool run_ahead_enabled;
@@ -475,6 +477,7 @@ typedef struct settings
         char path_cheat_settings[PATH_MAX_LENGTH];
         char path_shader[PATH_MAX_LENGTH];
         char path_font[PATH_MAX_LENGTH];
+        char path_frame_telemetry[PATH_MAX_LENGTH];
 
         char directory_audio_filter[PATH_MAX_LENGTH];
         char directory_autoconfig[PATH_MAX_LENGTH];
@@ -1736,7 +1736,8 @@ bool rarch_environment_cb(unsigned cmd, void *data)
             retro_vfs_file_read_impl,
             retro_vfs_file_write_impl,
             retro_vfs_file_flush_impl,
-            retro_vfs_file_remove_impl
+            retro_vfs_file_remove_impl,
+            retro_vfs_file_rename_impl
          };
 
          struct retro_vfs_interface_info *vfs_iface_info = (struct retro_vfs_interface_info *) data;
@@ -1749,6 +1750,24 @@ bool rarch_environment_cb(unsigned cmd, void *data)
          break;
       }
 
+      case RETRO_ENVIRONMENT_GET_VFS_MAP_INTERFACE:
+      {
+         const uint32_t supported_map_version = 1;
+         static struct retro_vfs_map_interface map_iface =
+         {
+            retro_vfs_file_map_impl,
+            retro_vfs_file_unmap_impl
+         };
+
+         struct retro_vfs_map_interface_info *map_iface_info = (struct retro_vfs_map_interface_info *) data;
+         if (map_iface_info->required_interface_version > supported_map_version)
+            return false;
+
+         map_iface_info->required_interface_version = supported_map_version;
+         map_iface_info->iface                      = &map_iface;
+         break;
+      }
+
       case RETRO_ENVIRONMENT_GET_LED_INTERFACE:
       {
          struct retro_led_interface *ledintf =
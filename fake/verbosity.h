@@ -0,0 +1 @@
+#include "../stub.h"
@@ -14,6 +14,14 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifdef HAVE_CONFIG_H
+#include "../../config.h"
+#endif
+
+#ifdef HAVE_MENU
+#include "../../menu/menu_driver.h"
+#endif
+
 #include "../video_driver.h"
 
 #include "../../driver.h"
@@ -22,11 +30,17 @@
 static void *null_gfx_init(const video_info_t *video,
       const input_driver_t **input, void **input_data)
 {
+   unsigned width  = video->width;
+   unsigned height = video->height;
+
    RARCH_ERR("Using the null video driver. RetroArch will not be visible.");
 
    *input = NULL;
    *input_data = NULL;
-   (void)video;
+
+   /* Pretend to have the requested size, so the menu lays out
+    * as it would on screen. */
+   video_driver_set_size(&width, &height);
 
    return (void*)-1;
 }
@@ -42,6 +56,11 @@ static bool null_gfx_frame(void *data, const void *frame,
    (void)pitch;
    (void)msg;
 
+#ifdef HAVE_MENU
+   /* Lets the menu run headless against the null display driver */
+   menu_driver_frame(video_info);
+#endif
+
    return true;
 }
 
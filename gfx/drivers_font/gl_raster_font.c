@@ -28,8 +28,8 @@
 /* TODO: Move viewport side effects to the caller: it's a source of bugs. */
 
 #define gl_raster_font_emit(c, vx, vy) do { \
-   font_vertex[     2 * (6 * i + c) + 0] = (x + (delta_x + off_x + vx * width) * scale) * inv_win_width; \
-   font_vertex[     2 * (6 * i + c) + 1] = (y + (delta_y - off_y - vy * height) * scale) * inv_win_height; \
+   font_vertex[     2 * (6 * i + c) + 0] = (x + (off_x + vx * width) * scale) * inv_win_width; \
+   font_vertex[     2 * (6 * i + c) + 1] = (y - (off_y + vy * height) * scale) * inv_win_height; \
    font_tex_coords[ 2 * (6 * i + c) + 0] = (tex_x + vx * width) * inv_tex_size_x; \
    font_tex_coords[ 2 * (6 * i + c) + 1] = (tex_y + vy * height) * inv_tex_size_y; \
    font_color[      4 * (6 * i + c) + 0] = color[0]; \
@@ -51,6 +51,7 @@ typedef struct
    const font_renderer_driver_t *font_driver;
    void *font_data;
    struct font_atlas *atlas;
+   font_run_cache_t *runs;
 
    video_font_raster_block_t *block;
 } gl_raster_t;
@@ -62,6 +63,8 @@ static void gl_raster_font_free_font(void *data,
    if (!font)
       return;
 
+   font_run_cache_free(font->runs);
+
    if (font->font_driver && font->font_data)
       font->font_driver->free(font->font_data);
 
@@ -201,6 +204,7 @@ static void *gl_raster_font_init_font(void *data,
       goto error;
 
    font->atlas->dirty = false;
+   font->runs         = font_run_cache_new(font->font_driver, font->font_data);
 
    glBindTexture(GL_TEXTURE_2D, font->gl->texture[font->gl->tex_index]);
 
@@ -220,6 +224,7 @@ static int gl_get_message_width(void *data, const char *msg,
    gl_raster_t *font   = (gl_raster_t*)data;
    const char* msg_end = msg + msg_len;
    int delta_x         = 0;
+   const font_run_t *run;
 
    if (     !font
          || !font->font_driver
@@ -227,6 +232,10 @@ static int gl_get_message_width(void *data, const char *msg,
          || !font->font_data )
       return 0;
 
+   run = font_run_cache_get(font->runs, msg, msg_len);
+   if (run)
+      return run->width * scale;
+
    while (msg < msg_end)
    {
       unsigned code                  = utf8_walk(&msg);
@@ -274,6 +283,8 @@ static void gl_raster_font_render_line(
       video_frame_info_t *video_info)
 {
    unsigned i;
+   unsigned j           = 0;
+   const font_run_t *run;
    struct video_coords coords;
    GLfloat font_tex_coords[2 * 6 * MAX_MSG_LEN_CHUNK];
    GLfloat font_vertex[2 * 6 * MAX_MSG_LEN_CHUNK];
@@ -300,28 +311,50 @@ static void gl_raster_font_render_line(
          break;
    }
 
-   while (msg < msg_end)
+   /* Static text is laid out once and then only looked up */
+   run = font_run_cache_get(font->runs, msg, msg_len);
+
+   while (run ? j < run->count : msg < msg_end)
    {
       i = 0;
-      while ((i < MAX_MSG_LEN_CHUNK) && (msg < msg_end))
+      while ((i < MAX_MSG_LEN_CHUNK)
+            && (run ? j < run->count : msg < msg_end))
       {
          int off_x, off_y, tex_x, tex_y, width, height;
-         unsigned                  code = utf8_walk(&msg);
-         const struct font_glyph *glyph = font->font_driver->get_glyph(
-               font->font_data, code);
 
-         if (!glyph) /* Do something smarter here ... */
-            glyph = font->font_driver->get_glyph(font->font_data, '?');
+         if (run)
+         {
+            const struct font_run_glyph *glyph = &run->glyphs[j++];
+
+            off_x  = glyph->x;
+            off_y  = glyph->y;
+            tex_x  = glyph->atlas_x;
+            tex_y  = glyph->atlas_y;
+            width  = glyph->width;
+            height = glyph->height;
+         }
+         else
+         {
+            unsigned                  code = utf8_walk(&msg);
+            const struct font_glyph *glyph = font->font_driver->get_glyph(
+                  font->font_data, code);
+
+            if (!glyph) /* Do something smarter here ... */
+               glyph = font->font_driver->get_glyph(font->font_data, '?');
 
-         if (!glyph)
-            continue;
+            if (!glyph)
+               continue;
 
-         off_x  = glyph->draw_offset_x;
-         off_y  = glyph->draw_offset_y;
-         tex_x  = glyph->atlas_offset_x;
-         tex_y  = glyph->atlas_offset_y;
-         width  = glyph->width;
-         height = glyph->height;
+            off_x    = delta_x + glyph->draw_offset_x;
+            off_y    = delta_y + glyph->draw_offset_y;
+            tex_x    = glyph->atlas_offset_x;
+            tex_y    = glyph->atlas_offset_y;
+            width    = glyph->width;
+            height   = glyph->height;
+
+            delta_x += glyph->advance_x;
+            delta_y += glyph->advance_y;
+         }
 
          gl_raster_font_emit(0, 0, 1); /* Bottom-left */
          gl_raster_font_emit(1, 1, 1); /* Bottom-right */
@@ -332,9 +365,6 @@ static void gl_raster_font_render_line(
          gl_raster_font_emit(5, 1, 1); /* Bottom-right */
 
          i++;
-
-         delta_x += glyph->advance_x;
-         delta_y -= glyph->advance_y;
       }
 
       coords.tex_coord     = font_tex_coords;
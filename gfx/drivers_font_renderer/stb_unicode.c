@@ -40,15 +40,6 @@
 
 #define STB_UNICODE_ATLAS_ROWS 16
 #define STB_UNICODE_ATLAS_COLS 16
-#define STB_UNICODE_ATLAS_SIZE (STB_UNICODE_ATLAS_ROWS * STB_UNICODE_ATLAS_COLS)
-
-typedef struct stb_unicode_atlas_slot
-{
-   struct font_glyph glyph;
-   unsigned charcode;
-   unsigned last_used;
-   struct stb_unicode_atlas_slot* next;
-}stb_unicode_atlas_slot_t;
 
 typedef struct
 {
@@ -60,142 +51,78 @@ typedef struct
    int line_height;
    float scale_factor;
 
-   struct font_atlas atlas;
-   stb_unicode_atlas_slot_t atlas_slots[STB_UNICODE_ATLAS_SIZE];
-   stb_unicode_atlas_slot_t* uc_map[0x100];
-   unsigned usage_counter;
+   font_atlas_cache_t cache;
 } stb_unicode_font_renderer_t;
 
 static struct font_atlas *font_renderer_stb_unicode_get_atlas(void *data)
 {
    stb_unicode_font_renderer_t *self = (stb_unicode_font_renderer_t*)data;
-   return &self->atlas;
+   return &self->cache.atlas;
 }
 
 static void font_renderer_stb_unicode_free(void *data)
 {
    stb_unicode_font_renderer_t *self = (stb_unicode_font_renderer_t*)data;
 
-   free(self->atlas.buffer);
+   font_atlas_cache_free(&self->cache);
    free(self->font_data);
    free(self);
 }
 
-static stb_unicode_atlas_slot_t* font_renderer_stb_unicode_get_slot(stb_unicode_font_renderer_t *handle)
-{
-   int i, map_id;
-   unsigned oldest = 0;
-
-   for (i = 1; i < STB_UNICODE_ATLAS_SIZE; i++)
-      if((handle->usage_counter - handle->atlas_slots[i].last_used) >
-         (handle->usage_counter - handle->atlas_slots[oldest].last_used))
-         oldest = i;
-
-   /* remove from map */
-   map_id = handle->atlas_slots[oldest].charcode & 0xFF;
-   if(handle->uc_map[map_id] == &handle->atlas_slots[oldest])
-      handle->uc_map[map_id] = handle->atlas_slots[oldest].next;
-   else if (handle->uc_map[map_id])
-   {
-      stb_unicode_atlas_slot_t* ptr = handle->uc_map[map_id];
-      while(ptr->next && ptr->next != &handle->atlas_slots[oldest])
-         ptr = ptr->next;
-      ptr->next = handle->atlas_slots[oldest].next;
-   }
-
-   return &handle->atlas_slots[oldest];
-}
-
 static const struct font_glyph *font_renderer_stb_unicode_get_glyph(
       void *data, uint32_t charcode)
 {
-   int glyph_index                      = 0;
-   int x0                               = 0;
-   int y1                               = 0;
-   int advance_width                    = 0;
-   int left_side_bearing                = 0;
-   unsigned map_id                      = 0;
-   uint8_t *dst                         = NULL;
-   stb_unicode_atlas_slot_t* atlas_slot = NULL;
-   stb_unicode_font_renderer_t *self    = (stb_unicode_font_renderer_t*)data;
+   int glyph_index                   = 0;
+   int x0                            = 0;
+   int y1                            = 0;
+   int advance_width                 = 0;
+   int left_side_bearing             = 0;
+   uint8_t *dst                      = NULL;
+   struct font_glyph *glyph          = NULL;
+   stb_unicode_font_renderer_t *self = (stb_unicode_font_renderer_t*)data;
 
    if(!self)
       return NULL;
 
-   map_id                               = charcode & 0xFF;
-   atlas_slot                           = self->uc_map[map_id];
-
-   while(atlas_slot)
-   {
-      if(atlas_slot->charcode == charcode)
-      {
-         atlas_slot->last_used = self->usage_counter++;
-         return &atlas_slot->glyph;
-      }
-      atlas_slot = atlas_slot->next;
-   }
-
-   atlas_slot             = font_renderer_stb_unicode_get_slot(self);
-   atlas_slot->charcode   = charcode;
-   atlas_slot->next       = self->uc_map[map_id];
-   self->uc_map[map_id] = atlas_slot;
-
-   glyph_index              = stbtt_FindGlyphIndex(&self->info, charcode);
+   glyph = font_atlas_cache_find(&self->cache, charcode);
+   if (glyph)
+      return glyph;
 
-   dst = (uint8_t*)self->atlas.buffer + atlas_slot->glyph.atlas_offset_x
-         + atlas_slot->glyph.atlas_offset_y * self->atlas.width;
+   glyph       = font_atlas_cache_add(&self->cache, charcode);
+   glyph_index = stbtt_FindGlyphIndex(&self->info, charcode);
 
+   dst = self->cache.atlas.buffer + glyph->atlas_offset_x
+         + glyph->atlas_offset_y * self->cache.atlas.width;
 
    stbtt_MakeGlyphBitmap(&self->info, dst, self->max_glyph_width, self->max_glyph_height,
-         self->atlas.width, self->scale_factor, self->scale_factor, glyph_index);
+         self->cache.atlas.width, self->scale_factor, self->scale_factor, glyph_index);
 
    stbtt_GetGlyphHMetrics(&self->info, glyph_index, &advance_width, &left_side_bearing);
    stbtt_GetGlyphBox(&self->info, glyph_index, &x0, NULL, NULL, &y1);
 
-   atlas_slot->glyph.width          = self->max_glyph_width;
-   atlas_slot->glyph.height         = self->max_glyph_height;
-   atlas_slot->glyph.advance_x      = advance_width * self->scale_factor;
-   /* atlas_slot->glyph.advance_y   = 0 ; */
-   atlas_slot->glyph.draw_offset_x  = x0 * self->scale_factor;
-   atlas_slot->glyph.draw_offset_y  = -y1 * self->scale_factor;
-
-
-   self->atlas.dirty = true;
-   atlas_slot->last_used = self->usage_counter++;
-   return &atlas_slot->glyph;
+   glyph->width          = self->max_glyph_width;
+   glyph->height         = self->max_glyph_height;
+   glyph->advance_x      = advance_width * self->scale_factor;
+   /* glyph->advance_y   = 0 ; */
+   glyph->draw_offset_x  = x0 * self->scale_factor;
+   glyph->draw_offset_y  = -y1 * self->scale_factor;
 
+   return glyph;
 }
 
 static bool font_renderer_stb_unicode_create_atlas(
       stb_unicode_font_renderer_t *self, float font_size)
 {
-   unsigned i, x, y;
-   stb_unicode_atlas_slot_t* slot = NULL;
+   unsigned i;
 
    self->max_glyph_width  = font_size < 0 ? -font_size : font_size;
    self->max_glyph_height = font_size < 0 ? -font_size : font_size;
 
-   self->atlas.width      = self->max_glyph_width  * STB_UNICODE_ATLAS_COLS;
-   self->atlas.height     = self->max_glyph_height * STB_UNICODE_ATLAS_ROWS;
-
-   self->atlas.buffer     = (uint8_t*)
-      calloc(self->atlas.width * self->atlas.height, 1);
-
-   if (!self->atlas.buffer)
+   if (!font_atlas_cache_init(&self->cache,
+            self->max_glyph_width, self->max_glyph_height,
+            STB_UNICODE_ATLAS_COLS, STB_UNICODE_ATLAS_ROWS))
       return false;
 
-   slot = self->atlas_slots;
-
-   for (y = 0; y < STB_UNICODE_ATLAS_ROWS; y++)
-   {
-      for (x = 0; x < STB_UNICODE_ATLAS_COLS; x++)
-      {
-         slot->glyph.atlas_offset_x = x * self->max_glyph_width;
-         slot->glyph.atlas_offset_y = y * self->max_glyph_height;
-         slot++;
-      }
-   }
-
    for (i = 0; i < 256; i++)
       font_renderer_stb_unicode_get_glyph(self, i);
 
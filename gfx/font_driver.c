@@ -15,6 +15,9 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
+
+#include <encodings/utf.h>
 
 #ifdef HAVE_CONFIG_H
 #include "../config.h"
@@ -151,6 +154,368 @@ static bool d3d9_font_init_first(
 }
 #endif
 
+static void font_atlas_cache_unlink(font_atlas_cache_t *cache,
+      font_atlas_slot_t *slot)
+{
+   if (slot->lru_prev)
+      slot->lru_prev->lru_next = slot->lru_next;
+   else
+      cache->lru_head          = slot->lru_next;
+
+   if (slot->lru_next)
+      slot->lru_next->lru_prev = slot->lru_prev;
+   else
+      cache->lru_tail          = slot->lru_prev;
+}
+
+static void font_atlas_cache_link_head(font_atlas_cache_t *cache,
+      font_atlas_slot_t *slot)
+{
+   slot->lru_prev = NULL;
+   slot->lru_next = cache->lru_head;
+
+   if (cache->lru_head)
+      cache->lru_head->lru_prev = slot;
+   else
+      cache->lru_tail           = slot;
+
+   cache->lru_head = slot;
+}
+
+bool font_atlas_cache_init(font_atlas_cache_t *cache,
+      unsigned cell_width, unsigned cell_height,
+      unsigned cols, unsigned rows)
+{
+   unsigned x, y;
+   font_atlas_slot_t *slot = NULL;
+
+   memset(cache, 0, sizeof(*cache));
+
+   cache->cell_width   = cell_width;
+   cache->cell_height  = cell_height;
+   cache->num_slots    = cols * rows;
+   cache->atlas.width  = cell_width  * cols;
+   cache->atlas.height = cell_height * rows;
+   cache->atlas.buffer = (uint8_t*)
+      calloc(cache->atlas.width * cache->atlas.height, 1);
+   cache->slots        = (font_atlas_slot_t*)
+      calloc(cache->num_slots, sizeof(*cache->slots));
+
+   if (!cache->atlas.buffer || !cache->slots)
+   {
+      font_atlas_cache_free(cache);
+      return false;
+   }
+
+   slot = cache->slots;
+
+   for (y = 0; y < rows; y++)
+   {
+      for (x = 0; x < cols; x++)
+      {
+         slot->glyph.atlas_offset_x = x * cell_width;
+         slot->glyph.atlas_offset_y = y * cell_height;
+         /* Unused cells go last, in atlas order */
+         slot->lru_prev             = cache->lru_tail;
+         if (cache->lru_tail)
+            cache->lru_tail->lru_next = slot;
+         else
+            cache->lru_head           = slot;
+         cache->lru_tail            = slot;
+         slot++;
+      }
+   }
+
+   return true;
+}
+
+void font_atlas_cache_free(font_atlas_cache_t *cache)
+{
+   if (!cache)
+      return;
+
+   free(cache->atlas.buffer);
+   free(cache->slots);
+
+   cache->atlas.buffer = NULL;
+   cache->slots        = NULL;
+}
+
+struct font_glyph *font_atlas_cache_find(font_atlas_cache_t *cache,
+      uint32_t charcode)
+{
+   font_atlas_slot_t *slot = cache->map[charcode & 0xFF];
+
+   for (; slot; slot = slot->next)
+   {
+      if (slot->charcode != charcode)
+         continue;
+
+      if (slot != cache->lru_head)
+      {
+         font_atlas_cache_unlink(cache, slot);
+         font_atlas_cache_link_head(cache, slot);
+      }
+
+      return &slot->glyph;
+   }
+
+   return NULL;
+}
+
+struct font_glyph *font_atlas_cache_add(font_atlas_cache_t *cache,
+      uint32_t charcode)
+{
+   unsigned y;
+   uint8_t *dst            = NULL;
+   font_atlas_slot_t *slot = cache->lru_tail;
+
+   if (slot->used)
+   {
+      font_atlas_slot_t **link = &cache->map[slot->charcode & 0xFF];
+
+      while (*link != slot)
+         link = &(*link)->next;
+      *link = slot->next;
+
+      cache->atlas.generation++;
+   }
+
+   font_atlas_cache_unlink(cache, slot);
+   font_atlas_cache_link_head(cache, slot);
+
+   slot->charcode = charcode;
+   slot->used     = true;
+   slot->next     = cache->map[charcode & 0xFF];
+   cache->map[charcode & 0xFF] = slot;
+
+   dst = cache->atlas.buffer + slot->glyph.atlas_offset_x
+      + slot->glyph.atlas_offset_y * cache->atlas.width;
+
+   for (y = 0; y < cache->cell_height; y++, dst += cache->atlas.width)
+      memset(dst, 0, cache->cell_width);
+
+   cache->atlas.dirty = true;
+
+   return &slot->glyph;
+}
+
+typedef struct font_run_entry
+{
+   font_run_t run;
+   uint32_t hash;
+   unsigned len;
+   char *key;
+   struct font_run_entry *next;
+   struct font_run_entry *lru_prev;
+   struct font_run_entry *lru_next;
+} font_run_entry_t;
+
+#define FONT_RUN_CACHE_BUCKETS 512
+
+struct font_run_cache
+{
+   const font_renderer_driver_t *driver;
+   void *renderer_data;
+   struct font_atlas *atlas;
+   unsigned generation;
+
+   font_run_entry_t *buckets[FONT_RUN_CACHE_BUCKETS];
+   /* Most recently used first */
+   font_run_entry_t *lru_head;
+   font_run_entry_t *lru_tail;
+   unsigned count;
+};
+
+static uint32_t font_run_cache_hash(const char *msg, unsigned len)
+{
+   unsigned i;
+   uint32_t hash = 5381;
+
+   for (i = 0; i < len; i++)
+      hash = (hash << 5) + hash + (uint8_t)msg[i];
+
+   return hash;
+}
+
+static void font_run_cache_remove(font_run_cache_t *cache,
+      font_run_entry_t *entry)
+{
+   font_run_entry_t **link =
+      &cache->buckets[entry->hash % FONT_RUN_CACHE_BUCKETS];
+
+   while (*link != entry)
+      link = &(*link)->next;
+   *link = entry->next;
+
+   if (entry->lru_prev)
+      entry->lru_prev->lru_next = entry->lru_next;
+   else
+      cache->lru_head           = entry->lru_next;
+
+   if (entry->lru_next)
+      entry->lru_next->lru_prev = entry->lru_prev;
+   else
+      cache->lru_tail           = entry->lru_prev;
+
+   cache->count--;
+
+   /* Key and glyphs share the entry's allocation */
+   free(entry);
+}
+
+static void font_run_cache_clear(font_run_cache_t *cache)
+{
+   while (cache->lru_head)
+      font_run_cache_remove(cache, cache->lru_head);
+}
+
+font_run_cache_t *font_run_cache_new(
+      const font_renderer_driver_t *driver, void *renderer_data)
+{
+   font_run_cache_t *cache = NULL;
+
+   if (!driver || !driver->get_glyph)
+      return NULL;
+
+   cache = (font_run_cache_t*)calloc(1, sizeof(*cache));
+   if (!cache)
+      return NULL;
+
+   cache->driver        = driver;
+   cache->renderer_data = renderer_data;
+   cache->atlas         = driver->get_atlas
+      ? driver->get_atlas(renderer_data) : NULL;
+   cache->generation    = cache->atlas ? cache->atlas->generation : 0;
+
+   return cache;
+}
+
+void font_run_cache_free(font_run_cache_t *cache)
+{
+   if (!cache)
+      return;
+
+   font_run_cache_clear(cache);
+   free(cache);
+}
+
+static font_run_entry_t *font_run_cache_layout(font_run_cache_t *cache,
+      const char *msg, unsigned msg_len, uint32_t hash)
+{
+   int pen_x                     = 0;
+   int pen_y                     = 0;
+   const char *msg_end           = msg + msg_len;
+   struct font_run_glyph *glyphs = NULL;
+   /* Never more glyphs than bytes */
+   font_run_entry_t *entry       = (font_run_entry_t*)malloc(
+         sizeof(*entry) + msg_len * sizeof(*glyphs) + msg_len + 1);
+
+   if (!entry)
+      return NULL;
+
+   glyphs           = (struct font_run_glyph*)(entry + 1);
+   entry->key       = (char*)(glyphs + msg_len);
+   entry->hash      = hash;
+   entry->len       = msg_len;
+   entry->run.count = 0;
+
+   memcpy(entry->key, msg, msg_len);
+   entry->key[msg_len] = '\0';
+
+   while (msg < msg_end)
+   {
+      struct font_run_glyph *out     = NULL;
+      unsigned code                  = utf8_walk(&msg);
+      const struct font_glyph *glyph = cache->driver->get_glyph(
+            cache->renderer_data, code);
+
+      if (!glyph) /* Do something smarter here ... */
+         glyph = cache->driver->get_glyph(cache->renderer_data, '?');
+      if (!glyph)
+         continue;
+
+      out          = &glyphs[entry->run.count++];
+      out->x       = pen_x + glyph->draw_offset_x;
+      out->y       = pen_y + glyph->draw_offset_y;
+      out->width   = glyph->width;
+      out->height  = glyph->height;
+      out->atlas_x = glyph->atlas_offset_x;
+      out->atlas_y = glyph->atlas_offset_y;
+
+      pen_x       += glyph->advance_x;
+      pen_y       += glyph->advance_y;
+   }
+
+   entry->run.glyphs = glyphs;
+   entry->run.width  = pen_x;
+
+   return entry;
+}
+
+const font_run_t *font_run_cache_get(font_run_cache_t *cache,
+      const char *msg, unsigned msg_len)
+{
+   font_run_entry_t *entry = NULL;
+   uint32_t hash           = 0;
+
+   if (!cache)
+      return NULL;
+
+   /* Evicted glyphs may have left their cell to another one */
+   if (cache->atlas && cache->atlas->generation != cache->generation)
+   {
+      font_run_cache_clear(cache);
+      cache->generation = cache->atlas->generation;
+   }
+
+   hash  = font_run_cache_hash(msg, msg_len);
+   entry = cache->buckets[hash % FONT_RUN_CACHE_BUCKETS];
+
+   for (; entry; entry = entry->next)
+      if (     entry->hash == hash
+            && entry->len  == msg_len
+            && !memcmp(entry->key, msg, msg_len))
+         break;
+
+   if (entry)
+   {
+      if (entry != cache->lru_head)
+      {
+         entry->lru_prev->lru_next = entry->lru_next;
+         if (entry->lru_next)
+            entry->lru_next->lru_prev = entry->lru_prev;
+         else
+            cache->lru_tail           = entry->lru_prev;
+      }
+      else
+         return &entry->run;
+   }
+   else
+   {
+      if (cache->count >= FONT_RUN_CACHE_SIZE)
+         font_run_cache_remove(cache, cache->lru_tail);
+
+      entry = font_run_cache_layout(cache, msg, msg_len, hash);
+      if (!entry)
+         return NULL;
+
+      entry->next = cache->buckets[hash % FONT_RUN_CACHE_BUCKETS];
+      cache->buckets[hash % FONT_RUN_CACHE_BUCKETS] = entry;
+      cache->count++;
+   }
+
+   entry->lru_prev = NULL;
+   entry->lru_next = cache->lru_head;
+   if (cache->lru_head)
+      cache->lru_head->lru_prev = entry;
+   else
+      cache->lru_tail           = entry;
+   cache->lru_head = entry;
+
+   return &entry->run;
+}
+
 #ifdef HAVE_OPENGL
 static const font_renderer_t *gl_font_backends[] = {
    &gl_raster_font,
@@ -760,6 +1125,17 @@ static INLINE unsigned font_get_replacement(const char* src, const char* start)
    return 0;
 }
 
+static bool font_driver_needs_reshape(const char *msg)
+{
+   const unsigned char *src = (const unsigned char*)msg;
+
+   for (; *src; src++)
+      if (IS_RTL(src))
+         return true;
+
+   return false;
+}
+
 static char* font_driver_reshape_msg(const char* msg)
 {
    /* worst case transformations are 2 bytes to 4 bytes */
@@ -856,7 +1232,10 @@ void font_driver_render_msg(
    if (msg && *msg && font && font->renderer && font->renderer->render_msg)
    {
 #ifdef HAVE_LANGEXTRA
-      char *new_msg = font_driver_reshape_msg(msg);
+      /* Most messages have nothing to reshape; leave those alone,
+       * so the renderer sees the same string every frame. */
+      char *new_msg = font_driver_needs_reshape(msg)
+         ? font_driver_reshape_msg(msg) : (char*)msg;
 #else
       char *new_msg = (char*)msg;
 #endif
@@ -864,7 +1243,8 @@ void font_driver_render_msg(
       font->renderer->render_msg(video_info,
             font->renderer_data, new_msg, params);
 #ifdef HAVE_LANGEXTRA
-      free(new_msg);
+      if (new_msg != msg)
+         free(new_msg);
 #endif
    }
 }
@@ -59,8 +59,63 @@ struct font_atlas
    unsigned width;
    unsigned height;
    bool dirty;
+   /* Bumped whenever a glyph gets evicted, so anything holding on
+    * to atlas coordinates knows they may be stale. */
+   unsigned generation;
 };
 
+/* Fixed-size cells handed out to glyphs on demand. Once every
+ * cell is taken, the least recently used glyph makes room. */
+typedef struct font_atlas_slot
+{
+   struct font_glyph glyph;
+   uint32_t charcode;
+   bool used;
+   struct font_atlas_slot *next;
+   struct font_atlas_slot *lru_prev;
+   struct font_atlas_slot *lru_next;
+} font_atlas_slot_t;
+
+typedef struct font_atlas_cache
+{
+   struct font_atlas atlas;
+   unsigned cell_width;
+   unsigned cell_height;
+   unsigned num_slots;
+   font_atlas_slot_t *slots;
+   font_atlas_slot_t *map[0x100];
+   /* Most recently used first */
+   font_atlas_slot_t *lru_head;
+   font_atlas_slot_t *lru_tail;
+} font_atlas_cache_t;
+
+/* A laid out line of text. Glyph positions are relative to the
+ * pen origin of the line, in unscaled font pixels. */
+struct font_run_glyph
+{
+   int x;
+   int y;
+   unsigned width;
+   unsigned height;
+   unsigned atlas_x;
+   unsigned atlas_y;
+};
+
+typedef struct font_run
+{
+   const struct font_run_glyph *glyphs;
+   unsigned count;
+   /* Sum of the glyph advances */
+   int width;
+} font_run_t;
+
+typedef struct font_run_cache font_run_cache_t;
+
+/* Upper bound on the runs kept per font. */
+#ifndef FONT_RUN_CACHE_SIZE
+#define FONT_RUN_CACHE_SIZE 256
+#endif
+
 struct font_params
 {
    float x;
@@ -123,6 +178,56 @@ typedef struct
    float size;
 } font_data_t;
 
+bool font_atlas_cache_init(font_atlas_cache_t *cache,
+      unsigned cell_width, unsigned cell_height,
+      unsigned cols, unsigned rows);
+
+void font_atlas_cache_free(font_atlas_cache_t *cache);
+
+/**
+ * font_atlas_cache_find:
+ * @cache                    : Glyph atlas.
+ * @charcode                 : Unicode code point.
+ *
+ * Returns: the glyph for @charcode if it already has a cell,
+ * otherwise NULL.
+ **/
+struct font_glyph *font_atlas_cache_find(font_atlas_cache_t *cache,
+      uint32_t charcode);
+
+/**
+ * font_atlas_cache_add:
+ * @cache                    : Glyph atlas.
+ * @charcode                 : Unicode code point.
+ *
+ * Takes a cell for @charcode, evicting the least recently used
+ * glyph when the atlas is full. The cell is cleared; the caller
+ * rasterizes into it and fills in the glyph metrics.
+ *
+ * Returns: the glyph, with its atlas offsets set.
+ **/
+struct font_glyph *font_atlas_cache_add(font_atlas_cache_t *cache,
+      uint32_t charcode);
+
+font_run_cache_t *font_run_cache_new(
+      const font_renderer_driver_t *driver, void *renderer_data);
+
+void font_run_cache_free(font_run_cache_t *cache);
+
+/**
+ * font_run_cache_get:
+ * @cache                    : Run cache of a font.
+ * @msg                      : UTF-8 text of a single line.
+ * @msg_len                  : Length of @msg in bytes.
+ *
+ * Lays out @msg, or returns the layout kept from an earlier
+ * call. The run stays valid until the next call.
+ *
+ * Returns: the run, or NULL on allocation failure.
+ **/
+const font_run_t *font_run_cache_get(font_run_cache_t *cache,
+      const char *msg, unsigned msg_len);
+
 /* font_path can be NULL for default font. */
 int font_renderer_create_default(const void **driver,
       void **handle, const char *font_path, unsigned font_size);
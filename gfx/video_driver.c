@@ -63,6 +63,7 @@
 #include "../input/input_driver.h"
 #include "../list_special.h"
 #include "../core.h"
+#include "../performance_counters.h"
 #include "../command.h"
 #include "../msg_hash.h"
 #include "../verbosity.h"
@@ -436,6 +437,13 @@ static void swap_buffers_null(void *data, void *data2)
 {
 }
 
+static void swap_buffers_telemetry(void *data, void *data2)
+{
+   frame_telemetry_event_begin(FRAME_TELEMETRY_SWAP);
+   current_video_context.swap_buffers(data, data2);
+   frame_telemetry_event_end(FRAME_TELEMETRY_SWAP);
+}
+
 static bool get_metrics_null(void *data, enum display_metric_types type,
       float *value)
 {
@@ -2531,16 +2539,7 @@ void video_driver_frame(const void *data, unsigned width,
    if (     video_info.font_enable
          && runloop_msg_queue_pull((const char**)&msg)
          && msg)
-   {
-#ifdef HAVE_THREADS
-      /* the msg pointer may point to data modified by another thread */
-      runloop_msg_queue_lock();
-#endif
       strlcpy(video_driver_msg, msg, sizeof(video_driver_msg));
-#ifdef HAVE_THREADS
-      runloop_msg_queue_unlock();
-#endif
-   }
 
    if (video_info.statistics_show)
    {
@@ -2572,6 +2571,7 @@ void video_driver_frame(const void *data, unsigned width,
             "Video Statistics:\n -Frame rate: %6.2f fps\n -Frame time: %6.2f ms\n -Frame time deviation: %.3f %%\n"
             " -Frame count: %" PRIu64"\n -Viewport: %d x %d x %3.2f\n"
             "Audio Statistics:\n -Average buffer saturation: %.2f %%\n -Standard deviation: %.2f %%\n -Time spent close to underrun: %.2f %%\n -Time spent close to blocking: %.2f %%\n -Sample count: %d\n"
+            " -Latency: %u ms%s (buffer: %u ms)\n -Rate control delta: %.4f\n -Near underruns: %u\n"
             "Core Geometry:\n -Size: %u x %u\n -Max Size: %u x %u\n -Aspect: %3.2f\nCore Timing:\n -FPS: %3.2f\n -Sample Rate: %6.2f\n",
             video_info.frame_rate,
             video_info.frame_time,
@@ -2585,6 +2585,11 @@ void video_driver_frame(const void *data, unsigned width,
             audio_stats.close_to_underrun,
             audio_stats.close_to_blocking,
             audio_stats.samples,
+            audio_stats.latency,
+            audio_stats.latency_auto ? " (auto)" : "",
+            audio_stats.buffer_latency,
+            audio_stats.rate_control_delta,
+            audio_stats.near_underruns,
             av_info->geometry.base_width,
             av_info->geometry.base_height,
             av_info->geometry.max_width,
@@ -2600,10 +2605,12 @@ void video_driver_frame(const void *data, unsigned width,
 #endif
    }
 
+   frame_telemetry_event_begin(FRAME_TELEMETRY_VIDEO_SUBMIT);
    video_driver_active = current_video->frame(
          video_driver_data, data, width, height,
          video_driver_frame_count,
          (unsigned)pitch, video_driver_msg, &video_info);
+   frame_telemetry_event_end(FRAME_TELEMETRY_VIDEO_SUBMIT);
 
    video_driver_frame_count++;
 
@@ -2807,6 +2814,9 @@ void video_driver_build_info(video_frame_info_t *video_info)
 
    video_info->cb_update_window_title = current_video_context.update_window_title;
    video_info->cb_swap_buffers        = current_video_context.swap_buffers;
+   /* Swaps on the video thread are not part of the frame being timed. */
+   if (frame_telemetry_is_enabled() && !video_driver_is_threaded())
+      video_info->cb_swap_buffers     = swap_buffers_telemetry;
    video_info->cb_get_metrics         = current_video_context.get_metrics;
    video_info->cb_set_resize          = current_video_context.set_resize;
 
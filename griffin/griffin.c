@@ -832,8 +832,10 @@ FILTERS
 #include "../gfx/video_filters/lq2x.c"
 #include "../gfx/video_filters/phosphor2x.c"
 
+#include "../libretro-common/audio/dsp_filters/fft/fft.c"
 #include "../libretro-common/audio/dsp_filters/echo.c"
 #include "../libretro-common/audio/dsp_filters/eq.c"
+#include "../libretro-common/audio/dsp_filters/convolution.c"
 #include "../libretro-common/audio/dsp_filters/chorus.c"
 #include "../libretro-common/audio/dsp_filters/iir.c"
 #include "../libretro-common/audio/dsp_filters/panning.c"
@@ -887,6 +889,7 @@ FILE
 MESSAGE
 ============================================================ */
 #include "../libretro-common/queues/message_queue.c"
+#include "../libretro-common/queues/message_channel.c"
 
 /*============================================================
 CONFIGURATION
@@ -1128,6 +1131,7 @@ MENU
 #include "../menu/menu_setting.c"
 #include "../menu/menu_cbs.c"
 #include "../menu/menu_content.c"
+#include "../menu/menu_thumbnail_cache.c"
 
 #include "../menu/menu_networking.c"
 
@@ -58,6 +58,7 @@
 #include "../driver.h"
 #include "../retroarch.h"
 #include "../movie.h"
+#include "../performance_counters.h"
 #include "../list_special.h"
 #include "../verbosity.h"
 #include "../tasks/tasks_internal.h"
@@ -586,7 +587,9 @@ void input_poll(void)
    settings_t *settings           = config_get_ptr();
    uint8_t max_users              = (uint8_t)input_driver_max_users;
 
+   frame_telemetry_event_begin(FRAME_TELEMETRY_INPUT_POLL);
    current_input->poll(current_input_data);
+   frame_telemetry_event_end(FRAME_TELEMETRY_INPUT_POLL);
 
    input_driver_turbo_btns.count++;
 
@@ -25,6 +25,9 @@
 
 #include <formats/rwav.h>
 #include <memalign.h>
+#include <queues/fifo_queue.h>
+#include <retro_inline.h>
+#include <retro_miscellaneous.h>
 
 #ifdef HAVE_THREADS
 #include <rthreads/rthreads.h>
@@ -62,8 +65,20 @@
 #include <ibxm/ibxm.h>
 #endif
 
-#define AUDIO_MIXER_MAX_VOICES      8
+#if !defined(AUDIO_MIXER_NO_SIMD)
+#if defined(__SSE__)
+#define AUDIO_MIXER_SSE
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define AUDIO_MIXER_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+#define AUDIO_MIXER_INITIAL_VOICES  8
 #define AUDIO_MIXER_TEMP_BUFFER 8192
+/* Length of the gain ramp applied when a voice's volume changes */
+#define AUDIO_MIXER_RAMP_FRAMES   256
 
 struct audio_mixer_sound
 {
@@ -124,6 +139,23 @@ struct audio_mixer_voice
    audio_mixer_sound_t *sound;
    audio_mixer_stop_cb_t stop_cb;
 
+   /* Gain currently applied, ramping towards ramp_target */
+   float    gain;
+   float    ramp_target;
+   float    ramp_step;
+   unsigned ramp_frames;
+
+   /* Slot in s_active while the voice plays */
+   unsigned active_index;
+
+   /* Streamed voices (ogg/flac/mp3/mod) are decoded ahead into a ring
+    * of interleaved stereo float samples at the output rate. */
+   fifo_buffer_t *ring;
+   unsigned chunk_samples;
+   unsigned repeats;
+   bool     decoding;
+   bool     eof;
+
    union
    {
       struct
@@ -134,8 +166,6 @@ struct audio_mixer_voice
 #ifdef HAVE_STB_VORBIS
       struct
       {
-         unsigned    position;
-         unsigned    samples;
          unsigned    buf_samples;
          float*      buffer;
          float       ratio;
@@ -148,8 +178,6 @@ struct audio_mixer_voice
 #ifdef HAVE_DR_FLAC
       struct
       {
-         unsigned    position;
-         unsigned    samples;
          unsigned    buf_samples;
          float*      buffer;
          float       ratio;
@@ -162,8 +190,6 @@ struct audio_mixer_voice
 #ifdef HAVE_DR_MP3
       struct
       {
-         unsigned    position;
-         unsigned    samples;
          unsigned    buf_samples;
          float*      buffer;
          float       ratio;
@@ -176,21 +202,53 @@ struct audio_mixer_voice
 #ifdef HAVE_IBXM
       struct
       {
-         unsigned    		position;
-         unsigned    		samples;
          unsigned    		buf_samples;
          int*               buffer;
+         float*             fbuffer;
          struct replay*		stream;
       } mod;
 #endif
    } types;
 };
 
-static struct audio_mixer_voice s_voices[AUDIO_MIXER_MAX_VOICES];
-static unsigned s_rate = 0;
+/* Stop callbacks raised while mixing; they run once the lock is
+ * released so that they can start or stop voices themselves. */
+typedef struct
+{
+   audio_mixer_stop_cb_t stop_cb;
+   audio_mixer_sound_t *sound;
+   unsigned reason;
+} audio_mixer_notify_t;
+
+typedef struct
+{
+   audio_mixer_notify_t *entries;
+   unsigned count;
+   unsigned capacity;
+} audio_mixer_notify_list_t;
+
+/* Voices are allocated one by one so that handles stay valid while the
+ * pool grows. Every voice is either playing (in s_active) or idle (in
+ * s_free); mixing and decoding only walk the active list. */
+static audio_mixer_voice_t **s_voices = NULL;
+static audio_mixer_voice_t **s_active = NULL;
+static audio_mixer_voice_t **s_free   = NULL;
+static unsigned s_voice_count         = 0;
+static unsigned s_voice_capacity      = 0;
+static unsigned s_active_count        = 0;
+static unsigned s_free_count          = 0;
+
+/* Only touched by the mixing thread */
+static audio_mixer_notify_list_t s_notify;
+
+static unsigned s_rate      = 0;
+static unsigned s_underruns = 0;
 
 #ifdef HAVE_THREADS
-static slock_t* s_locker = NULL;
+static slock_t* s_locker     = NULL;
+static scond_t* s_cond       = NULL;
+static sthread_t* s_worker   = NULL;
+static bool s_worker_alive   = false;
 #endif
 
 static bool wav2float(const rwav_t* wav, float** pcm, size_t samples_out)
@@ -306,34 +364,6 @@ static bool one_shot_resample(const float* in, size_t samples_in,
    return true;
 }
 
-void audio_mixer_init(unsigned rate)
-{
-   unsigned i;
-
-   s_rate = rate;
-
-   for (i = 0; i < AUDIO_MIXER_MAX_VOICES; i++)
-      s_voices[i].type = AUDIO_MIXER_TYPE_NONE;
-
-#ifdef HAVE_THREADS
-   s_locker = slock_new();
-#endif
-}
-
-void audio_mixer_done(void)
-{
-   unsigned i;
-
-#ifdef HAVE_THREADS
-   /* Dont call audio mixer functions after this point */
-   slock_free(s_locker);
-   s_locker = NULL;
-#endif
-
-   for (i = 0; i < AUDIO_MIXER_MAX_VOICES; i++)
-      s_voices[i].type = AUDIO_MIXER_TYPE_NONE;
-}
-
 audio_mixer_sound_t* audio_mixer_load_wav(void *buffer, int32_t size)
 {
    /* WAV data */
@@ -560,8 +590,6 @@ static bool audio_mixer_play_ogg(
    voice->types.ogg.buf_samples    = samples;
    voice->types.ogg.ratio          = ratio;
    voice->types.ogg.stream         = stb_vorbis;
-   voice->types.ogg.position       = 0;
-   voice->types.ogg.samples        = 0;
 
    return true;
 
@@ -583,6 +611,7 @@ static bool audio_mixer_play_mod(
    int buf_samples               = 0;
    int samples                   = 0;
    void *mod_buffer              = NULL;
+   void *mod_fbuffer             = NULL;
    struct module* module         = NULL;
    struct replay* replay         = NULL;
 
@@ -621,15 +650,24 @@ static bool audio_mixer_play_mod(
       goto error;
    }
 
+   mod_fbuffer = memalign_alloc(16, ((buf_samples + 15) & ~15) * sizeof(float));
+
+   if (!mod_fbuffer)
+   {
+      printf("audio_mixer_play_mod cannot allocate mod_fbuffer !\n");
+      goto error;
+   }
+
    voice->types.mod.buffer         = (int*)mod_buffer;
+   voice->types.mod.fbuffer        = (float*)mod_fbuffer;
    voice->types.mod.buf_samples    = buf_samples;
    voice->types.mod.stream         = replay;
-   voice->types.mod.position       = 0;
-    voice->types.mod.samples       = 0; /* samples; */
 
    return true;
 
 error:
+   if (mod_fbuffer)
+      memalign_free(mod_fbuffer);
    if (mod_buffer)
       memalign_free(mod_buffer);
    if (module)
@@ -683,8 +721,6 @@ static bool audio_mixer_play_flac(
    voice->types.flac.buf_samples    = samples;
    voice->types.flac.ratio          = ratio;
    voice->types.flac.stream         = dr_flac;
-   voice->types.flac.position       = 0;
-   voice->types.flac.samples        = 0;
 
    return true;
 
@@ -734,8 +770,6 @@ static bool audio_mixer_play_mp3(
    voice->types.mp3.buffer         = (float*)mp3_buffer;
    voice->types.mp3.buf_samples    = samples;
    voice->types.mp3.ratio          = ratio;
-   voice->types.mp3.position       = 0;
-   voice->types.mp3.samples        = 0;
 
    return true;
 
@@ -746,12 +780,624 @@ error:
 #endif
 
 
+static void audio_mixer_accumulate(float *out, const float *in,
+      size_t samples, float volume)
+{
+   size_t i = 0;
+#if defined(AUDIO_MIXER_SSE)
+   __m128 vol = _mm_set1_ps(volume);
+
+   for (; i + 8 <= samples; i += 8)
+   {
+      __m128 a = _mm_mul_ps(_mm_loadu_ps(in + i + 0), vol);
+      __m128 b = _mm_mul_ps(_mm_loadu_ps(in + i + 4), vol);
+      _mm_storeu_ps(out + i + 0, _mm_add_ps(_mm_loadu_ps(out + i + 0), a));
+      _mm_storeu_ps(out + i + 4, _mm_add_ps(_mm_loadu_ps(out + i + 4), b));
+   }
+#elif defined(AUDIO_MIXER_NEON)
+   for (; i + 8 <= samples; i += 8)
+   {
+      vst1q_f32(out + i + 0, vmlaq_n_f32(vld1q_f32(out + i + 0),
+               vld1q_f32(in + i + 0), volume));
+      vst1q_f32(out + i + 4, vmlaq_n_f32(vld1q_f32(out + i + 4),
+               vld1q_f32(in + i + 4), volume));
+   }
+#endif
+
+   for (; i < samples; i++)
+      out[i] += in[i] * volume;
+}
+
+/* Same as audio_mixer_accumulate on stereo frames, except that the
+ * gain starts at 'gain' and moves by 'step' every frame. */
+static void audio_mixer_accumulate_ramp(float *out, const float *in,
+      size_t frames, float gain, float step)
+{
+   size_t i = 0;
+#if defined(AUDIO_MIXER_SSE)
+   __m128 g  = _mm_setr_ps(gain, gain, gain + step, gain + step);
+   __m128 dg = _mm_set1_ps(2.0f * step);
+
+   for (; i + 2 <= frames; i += 2)
+   {
+      __m128 a = _mm_mul_ps(_mm_loadu_ps(in + i * 2), g);
+      _mm_storeu_ps(out + i * 2, _mm_add_ps(_mm_loadu_ps(out + i * 2), a));
+      g = _mm_add_ps(g, dg);
+   }
+#elif defined(AUDIO_MIXER_NEON)
+   float init[4];
+   float32x4_t g, dg;
+
+   init[0] = init[1] = gain;
+   init[2] = init[3] = gain + step;
+   g       = vld1q_f32(init);
+   dg      = vdupq_n_f32(2.0f * step);
+
+   for (; i + 2 <= frames; i += 2)
+   {
+      vst1q_f32(out + i * 2, vmlaq_f32(vld1q_f32(out + i * 2),
+               vld1q_f32(in + i * 2), g));
+      g = vaddq_f32(g, dg);
+   }
+#endif
+
+   for (; i < frames; i++)
+   {
+      float g         = gain + step * i;
+      out[i * 2 + 0] += in[i * 2 + 0] * g;
+      out[i * 2 + 1] += in[i * 2 + 1] * g;
+   }
+}
+
+/* Accumulates stereo samples of a voice. A change of the target volume
+ * is spread over AUDIO_MIXER_RAMP_FRAMES so that it does not click. */
+static void audio_mixer_voice_accumulate(audio_mixer_voice_t *voice,
+      float *out, const float *in, size_t samples, float target)
+{
+   if (target != voice->ramp_target)
+   {
+      voice->ramp_target = target;
+      voice->ramp_frames = AUDIO_MIXER_RAMP_FRAMES;
+      voice->ramp_step   = (target - voice->gain) / AUDIO_MIXER_RAMP_FRAMES;
+   }
+
+   if (voice->ramp_frames)
+   {
+      size_t frames = samples / 2;
+
+      if (frames > voice->ramp_frames)
+         frames = voice->ramp_frames;
+
+      audio_mixer_accumulate_ramp(out, in, frames,
+            voice->gain, voice->ramp_step);
+
+      voice->gain        += voice->ramp_step * frames;
+      voice->ramp_frames -= (unsigned)frames;
+
+      if (!voice->ramp_frames)
+         voice->gain      = voice->ramp_target;
+
+      out                += frames * 2;
+      in                 += frames * 2;
+      samples            -= frames * 2;
+   }
+
+   audio_mixer_accumulate(out, in, samples, voice->gain);
+}
+
+static bool audio_mixer_grow_voices(void)
+{
+   unsigned capacity            = s_voice_capacity
+      ? s_voice_capacity * 2 : AUDIO_MIXER_INITIAL_VOICES;
+   audio_mixer_voice_t **voices = (audio_mixer_voice_t**)realloc(
+         s_voices, capacity * sizeof(*voices));
+   audio_mixer_voice_t **active = NULL;
+   audio_mixer_voice_t **idle   = NULL;
+
+   if (!voices)
+      return false;
+   s_voices = voices;
+
+   active   = (audio_mixer_voice_t**)realloc(
+         s_active, capacity * sizeof(*active));
+   if (!active)
+      return false;
+   s_active = active;
+
+   idle     = (audio_mixer_voice_t**)realloc(
+         s_free, capacity * sizeof(*idle));
+   if (!idle)
+      return false;
+   s_free   = idle;
+
+   s_voice_capacity = capacity;
+   return true;
+}
+
+/* Takes an idle voice, growing the pool if there is none. */
+static audio_mixer_voice_t *audio_mixer_voice_alloc(void)
+{
+   audio_mixer_voice_t *voice = NULL;
+
+   if (s_free_count)
+      return s_free[--s_free_count];
+
+   if (s_voice_count == s_voice_capacity && !audio_mixer_grow_voices())
+      return NULL;
+
+   voice = (audio_mixer_voice_t*)calloc(1, sizeof(*voice));
+
+   if (voice)
+      s_voices[s_voice_count++] = voice;
+
+   return voice;
+}
+
+static void audio_mixer_voice_activate(audio_mixer_voice_t *voice)
+{
+   voice->active_index         = s_active_count;
+   s_active[s_active_count++]  = voice;
+}
+
+/* Stops a playing voice and returns it to the idle list. The last
+ * active voice takes its slot, so callers walking s_active must not
+ * advance past a released voice. */
+static void audio_mixer_voice_release(audio_mixer_voice_t *voice)
+{
+   audio_mixer_voice_t *last   = s_active[--s_active_count];
+
+   s_active[voice->active_index] = last;
+   last->active_index            = voice->active_index;
+
+   voice->type                   = AUDIO_MIXER_TYPE_NONE;
+   s_free[s_free_count++]        = voice;
+}
+
+static void audio_mixer_notify(audio_mixer_notify_list_t *list,
+      audio_mixer_voice_t *voice, unsigned reason)
+{
+   audio_mixer_notify_t *entry = NULL;
+
+   if (!voice->stop_cb || list->count >= list->capacity)
+      return;
+
+   entry          = &list->entries[list->count++];
+   entry->stop_cb = voice->stop_cb;
+   entry->sound   = voice->sound;
+   entry->reason  = reason;
+}
+
+static INLINE bool audio_mixer_voice_is_stream(const audio_mixer_voice_t *voice)
+{
+   return voice->type != AUDIO_MIXER_TYPE_NONE
+      && voice->type  != AUDIO_MIXER_TYPE_WAV;
+}
+
+#ifdef HAVE_STB_VORBIS
+static unsigned audio_mixer_decode_ogg(audio_mixer_voice_t* voice,
+      float *temp_buffer, const float **pcm)
+{
+   struct resampler_data info = { 0 };
+   unsigned temp_samples      = stb_vorbis_get_samples_float_interleaved(
+         voice->types.ogg.stream, 2, temp_buffer,
+         AUDIO_MIXER_TEMP_BUFFER) * 2;
+
+   *pcm = temp_buffer;
+
+   if (temp_samples == 0 || !voice->types.ogg.resampler)
+      return temp_samples;
+
+   info.data_in              = temp_buffer;
+   info.data_out             = voice->types.ogg.buffer;
+   info.input_frames         = temp_samples / 2;
+   info.output_frames        = 0;
+   info.ratio                = voice->types.ogg.ratio;
+
+   voice->types.ogg.resampler->process(voice->types.ogg.resampler_data, &info);
+
+   *pcm = voice->types.ogg.buffer;
+   return (unsigned)(info.output_frames * 2);
+}
+#endif
+
+#ifdef HAVE_IBXM
+static unsigned audio_mixer_decode_mod(audio_mixer_voice_t* voice,
+      float *temp_buffer, const float **pcm)
+{
+   unsigned i;
+   const int *in         = voice->types.mod.buffer;
+   float *out            = voice->types.mod.fbuffer;
+   unsigned temp_samples = replay_get_audio(
+         voice->types.mod.stream, voice->types.mod.buffer) * 2;
+
+   for (i = 0; i < temp_samples; i++)
+   {
+      float samplef = (float)(in[i] + 32768) / 65535.0f;
+      out[i]        = samplef * 2.0f - 1.0f;
+   }
+
+   *pcm = out;
+   return temp_samples;
+}
+#endif
+
+#ifdef HAVE_DR_FLAC
+static unsigned audio_mixer_decode_flac(audio_mixer_voice_t* voice,
+      float *temp_buffer, const float **pcm)
+{
+   struct resampler_data info = { 0 };
+   unsigned temp_samples      = (unsigned)drflac_read_f32(
+         voice->types.flac.stream, AUDIO_MIXER_TEMP_BUFFER, temp_buffer);
+
+   *pcm = temp_buffer;
+
+   if (temp_samples == 0 || !voice->types.flac.resampler)
+      return temp_samples;
+
+   info.data_in              = temp_buffer;
+   info.data_out             = voice->types.flac.buffer;
+   info.input_frames         = temp_samples / 2;
+   info.output_frames        = 0;
+   info.ratio                = voice->types.flac.ratio;
+
+   voice->types.flac.resampler->process(voice->types.flac.resampler_data, &info);
+
+   *pcm = voice->types.flac.buffer;
+   return (unsigned)(info.output_frames * 2);
+}
+#endif
+
+#ifdef HAVE_DR_MP3
+static unsigned audio_mixer_decode_mp3(audio_mixer_voice_t* voice,
+      float *temp_buffer, const float **pcm)
+{
+   struct resampler_data info = { 0 };
+   unsigned temp_samples      = (unsigned)drmp3_read_f32(
+         &voice->types.mp3.stream, AUDIO_MIXER_TEMP_BUFFER / 2,
+         temp_buffer) * 2;
+
+   *pcm = temp_buffer;
+
+   if (temp_samples == 0 || !voice->types.mp3.resampler)
+      return temp_samples;
+
+   info.data_in              = temp_buffer;
+   info.data_out             = voice->types.mp3.buffer;
+   info.input_frames         = temp_samples / 2;
+   info.output_frames        = 0;
+   info.ratio                = voice->types.mp3.ratio;
+
+   voice->types.mp3.resampler->process(voice->types.mp3.resampler_data, &info);
+
+   *pcm = voice->types.mp3.buffer;
+   return (unsigned)(info.output_frames * 2);
+}
+#endif
+
+static unsigned audio_mixer_decode_chunk(audio_mixer_voice_t* voice,
+      float *temp_buffer, const float **pcm)
+{
+   switch (voice->type)
+   {
+      case AUDIO_MIXER_TYPE_OGG:
+#ifdef HAVE_STB_VORBIS
+         return audio_mixer_decode_ogg(voice, temp_buffer, pcm);
+#else
+         break;
+#endif
+      case AUDIO_MIXER_TYPE_MOD:
+#ifdef HAVE_IBXM
+         return audio_mixer_decode_mod(voice, temp_buffer, pcm);
+#else
+         break;
+#endif
+      case AUDIO_MIXER_TYPE_FLAC:
+#ifdef HAVE_DR_FLAC
+         return audio_mixer_decode_flac(voice, temp_buffer, pcm);
+#else
+         break;
+#endif
+      case AUDIO_MIXER_TYPE_MP3:
+#ifdef HAVE_DR_MP3
+         return audio_mixer_decode_mp3(voice, temp_buffer, pcm);
+#else
+         break;
+#endif
+      case AUDIO_MIXER_TYPE_WAV:
+      case AUDIO_MIXER_TYPE_NONE:
+         break;
+   }
+
+   return 0;
+}
+
+static void audio_mixer_rewind(audio_mixer_voice_t* voice)
+{
+   switch (voice->type)
+   {
+      case AUDIO_MIXER_TYPE_OGG:
+#ifdef HAVE_STB_VORBIS
+         stb_vorbis_seek_start(voice->types.ogg.stream);
+#endif
+         break;
+      case AUDIO_MIXER_TYPE_MOD:
+#ifdef HAVE_IBXM
+         replay_seek(voice->types.mod.stream, 0);
+#endif
+         break;
+      case AUDIO_MIXER_TYPE_FLAC:
+#ifdef HAVE_DR_FLAC
+         drflac_seek_to_sample(voice->types.flac.stream, 0);
+#endif
+         break;
+      case AUDIO_MIXER_TYPE_MP3:
+#ifdef HAVE_DR_MP3
+         drmp3_seek_to_frame(&voice->types.mp3.stream, 0);
+#endif
+         break;
+      case AUDIO_MIXER_TYPE_WAV:
+      case AUDIO_MIXER_TYPE_NONE:
+         break;
+   }
+}
+
+/* Decodes the next chunk of a streamed voice, wrapping around to the
+ * start when the voice repeats. Does not touch the ring, so the worker
+ * can call it without holding the lock. Returns 0 at the end of the
+ * stream. */
+static unsigned audio_mixer_decode(audio_mixer_voice_t* voice,
+      float *temp_buffer, const float **pcm, bool *repeated)
+{
+   unsigned samples = audio_mixer_decode_chunk(voice, temp_buffer, pcm);
+
+   *repeated        = false;
+
+   if (samples == 0 && voice->repeat)
+   {
+      audio_mixer_rewind(voice);
+      *repeated = true;
+      samples   = audio_mixer_decode_chunk(voice, temp_buffer, pcm);
+   }
+
+   return samples;
+}
+
+/* Queues a decoded chunk; the lock must be held. */
+static void audio_mixer_push(audio_mixer_voice_t* voice,
+      const float *pcm, unsigned samples, bool repeated)
+{
+   size_t bytes = samples * sizeof(float);
+   size_t avail = fifo_write_avail(voice->ring);
+
+   if (repeated)
+      voice->repeats++;
+
+   if (samples == 0)
+   {
+      voice->eof = true;
+      return;
+   }
+
+   if (bytes > avail)
+      bytes = avail - (avail % (2 * sizeof(float)));
+
+   fifo_write(voice->ring, pcm, bytes);
+}
+
+static bool audio_mixer_needs_decode(audio_mixer_voice_t* voice)
+{
+   return audio_mixer_voice_is_stream(voice) && !voice->eof
+      && !voice->decoding && fifo_write_avail(voice->ring)
+      >= voice->chunk_samples * sizeof(float);
+}
+
+/* Decodes up to max_chunks chunks of a voice on the calling thread. */
+static void audio_mixer_fill(audio_mixer_voice_t* voice,
+      float *temp_buffer, unsigned max_chunks)
+{
+   while (max_chunks-- && audio_mixer_needs_decode(voice))
+   {
+      bool repeated    = false;
+      const float *pcm = NULL;
+      unsigned samples = audio_mixer_decode(voice,
+            temp_buffer, &pcm, &repeated);
+
+      audio_mixer_push(voice, pcm, samples, repeated);
+   }
+}
+
+static bool audio_mixer_stream_init(audio_mixer_voice_t* voice,
+      unsigned chunk_samples, float *temp_buffer)
+{
+   /* Room for three chunks: one being mixed, one queued and one
+    * being decoded. */
+   size_t size = chunk_samples * 3 * sizeof(float);
+
+   if (voice->ring && voice->ring->size <= size)
+   {
+      fifo_free(voice->ring);
+      voice->ring = NULL;
+   }
+
+   if (!voice->ring)
+      voice->ring = fifo_new(size);
+
+   if (!voice->ring)
+      return false;
+
+   fifo_clear(voice->ring);
+
+   voice->chunk_samples = chunk_samples;
+   voice->repeats       = 0;
+   voice->decoding      = false;
+   voice->eof           = false;
+
+   /* Prime the ring so that the first mix does not underrun. The voice
+    * type must already be set for the decoders to dispatch on it. */
+   audio_mixer_fill(voice, temp_buffer, 1);
+   return true;
+}
+
+#ifdef HAVE_THREADS
+static audio_mixer_voice_t *audio_mixer_worker_next_voice(void)
+{
+   unsigned i;
+   size_t best_avail                = 0;
+   audio_mixer_voice_t *best        = NULL;
+
+   /* Serve the voice closest to running dry first. */
+   for (i = 0; i < s_active_count; i++)
+   {
+      size_t avail;
+      audio_mixer_voice_t *voice = s_active[i];
+
+      if (!audio_mixer_needs_decode(voice))
+         continue;
+
+      avail = fifo_read_avail(voice->ring);
+
+      if (!best || avail < best_avail)
+      {
+         best       = voice;
+         best_avail = avail;
+      }
+   }
+
+   return best;
+}
+
+static void audio_mixer_worker(void *userdata)
+{
+   float *temp_buffer = (float*)malloc(
+         AUDIO_MIXER_TEMP_BUFFER * sizeof(float));
+
+   if (!temp_buffer)
+      return;
+
+   slock_lock(s_locker);
+
+   while (s_worker_alive)
+   {
+      bool repeated              = false;
+      const float *pcm           = NULL;
+      unsigned samples           = 0;
+      audio_mixer_voice_t *voice = audio_mixer_worker_next_voice();
+
+      if (!voice)
+      {
+         scond_wait(s_cond, s_locker);
+         continue;
+      }
+
+      /* The decoders only touch per-voice state, and the voice cannot
+       * be stopped or restarted while it is marked as decoding. */
+      voice->decoding = true;
+      slock_unlock(s_locker);
+
+      samples = audio_mixer_decode(voice, temp_buffer, &pcm, &repeated);
+
+      slock_lock(s_locker);
+      audio_mixer_push(voice, pcm, samples, repeated);
+      voice->decoding = false;
+      scond_broadcast(s_cond);
+   }
+
+   slock_unlock(s_locker);
+   free(temp_buffer);
+}
+
+/* Waits until the worker is done with a voice; the lock must be held. */
+static void audio_mixer_wait_voice(audio_mixer_voice_t* voice)
+{
+   while (voice->decoding)
+      scond_wait(s_cond, s_locker);
+}
+#endif
+
+static INLINE bool audio_mixer_worker_running(void)
+{
+#ifdef HAVE_THREADS
+   return s_worker != NULL;
+#else
+   return false;
+#endif
+}
+
+void audio_mixer_init(unsigned rate)
+{
+   s_rate         = rate;
+   s_underruns    = 0;
+   s_active_count = 0;
+   s_free_count   = 0;
+
+#ifdef HAVE_THREADS
+   s_locker       = slock_new();
+   s_cond         = scond_new();
+   s_worker_alive = true;
+
+   if (s_locker && s_cond)
+      s_worker    = sthread_create(audio_mixer_worker, NULL);
+
+   /* Without a worker, streams are decoded while mixing. */
+   if (!s_worker)
+      s_worker_alive = false;
+#endif
+}
+
+void audio_mixer_done(void)
+{
+   unsigned i;
+
+#ifdef HAVE_THREADS
+   if (s_worker)
+   {
+      slock_lock(s_locker);
+      s_worker_alive = false;
+      scond_broadcast(s_cond);
+      slock_unlock(s_locker);
+
+      sthread_join(s_worker);
+      s_worker = NULL;
+   }
+
+   /* Dont call audio mixer functions after this point */
+   if (s_cond)
+      scond_free(s_cond);
+   slock_free(s_locker);
+   s_cond   = NULL;
+   s_locker = NULL;
+#endif
+
+   for (i = 0; i < s_voice_count; i++)
+   {
+      if (s_voices[i]->ring)
+         fifo_free(s_voices[i]->ring);
+      free(s_voices[i]);
+   }
+
+   free(s_voices);
+   free(s_active);
+   free(s_free);
+   free(s_notify.entries);
+
+   s_voices          = NULL;
+   s_active          = NULL;
+   s_free            = NULL;
+   s_voice_count     = 0;
+   s_voice_capacity  = 0;
+   s_active_count    = 0;
+   s_free_count      = 0;
+   s_notify.entries  = NULL;
+   s_notify.count    = 0;
+   s_notify.capacity = 0;
+}
+
 audio_mixer_voice_t* audio_mixer_play(audio_mixer_sound_t* sound, bool repeat,
       float volume, audio_mixer_stop_cb_t stop_cb)
 {
-   unsigned i;
    bool res                   = false;
-   audio_mixer_voice_t* voice = s_voices;
+   unsigned chunk_samples     = 0;
+   audio_mixer_voice_t* voice = NULL;
 
    if (!sound)
       return NULL;
@@ -760,11 +1406,10 @@ audio_mixer_voice_t* audio_mixer_play(audio_mixer_sound_t* sound, bool repeat,
    slock_lock(s_locker);
 #endif
 
-   for (i = 0; i < AUDIO_MIXER_MAX_VOICES; i++, voice++)
-   {
-      if (voice->type != AUDIO_MIXER_TYPE_NONE)
-         continue;
+   voice = audio_mixer_voice_alloc();
 
+   if (voice)
+   {
       switch (sound->type)
       {
          case AUDIO_MIXER_TYPE_WAV:
@@ -773,42 +1418,64 @@ audio_mixer_voice_t* audio_mixer_play(audio_mixer_sound_t* sound, bool repeat,
          case AUDIO_MIXER_TYPE_OGG:
 #ifdef HAVE_STB_VORBIS
             res = audio_mixer_play_ogg(sound, voice, repeat, volume, stop_cb);
+            chunk_samples = voice->types.ogg.buf_samples + 16;
 #endif
             break;
          case AUDIO_MIXER_TYPE_MOD:
 #ifdef HAVE_IBXM
             res = audio_mixer_play_mod(sound, voice, repeat, volume, stop_cb);
+            chunk_samples = voice->types.mod.buf_samples;
 #endif
             break;
          case AUDIO_MIXER_TYPE_FLAC:
 #ifdef HAVE_DR_FLAC
             res = audio_mixer_play_flac(sound, voice, repeat, volume, stop_cb);
+            chunk_samples = voice->types.flac.buf_samples + 16;
 #endif
             break;
          case AUDIO_MIXER_TYPE_MP3:
 #ifdef HAVE_DR_MP3
             res = audio_mixer_play_mp3(sound, voice, repeat, volume, stop_cb);
+            chunk_samples = voice->types.mp3.buf_samples + 16;
 #endif
             break;
          case AUDIO_MIXER_TYPE_NONE:
             break;
       }
+   }
 
-      break;
+   if (res)
+   {
+      voice->type        = sound->type;
+      voice->repeat      = repeat;
+      voice->volume      = volume;
+      voice->sound       = sound;
+      voice->stop_cb     = stop_cb;
+      voice->gain        = volume;
+      voice->ramp_target = volume;
+      voice->ramp_frames = 0;
+
+      if (audio_mixer_voice_is_stream(voice))
+      {
+         float temp_buffer[AUDIO_MIXER_TEMP_BUFFER];
+
+         if (!audio_mixer_stream_init(voice, chunk_samples, temp_buffer))
+            res = false;
+      }
    }
 
    if (res)
+      audio_mixer_voice_activate(voice);
+   else if (voice)
    {
-      voice->type     = sound->type;
-      voice->repeat   = repeat;
-      voice->volume   = volume;
-      voice->sound    = sound;
-      voice->stop_cb  = stop_cb;
+      voice->type            = AUDIO_MIXER_TYPE_NONE;
+      s_free[s_free_count++] = voice;
+      voice                  = NULL;
    }
-   else
-      voice = NULL;
 
 #ifdef HAVE_THREADS
+   if (voice && audio_mixer_voice_is_stream(voice))
+      scond_broadcast(s_cond);
    slock_unlock(s_locker);
 #endif
 
@@ -827,9 +1494,11 @@ void audio_mixer_stop(audio_mixer_voice_t* voice)
 
 #ifdef HAVE_THREADS
       slock_lock(s_locker);
+      audio_mixer_wait_voice(voice);
 #endif
 
-      voice->type = AUDIO_MIXER_TYPE_NONE;
+      if (voice->type != AUDIO_MIXER_TYPE_NONE)
+         audio_mixer_voice_release(voice);
 
 #ifdef HAVE_THREADS
       slock_unlock(s_locker);
@@ -842,9 +1511,9 @@ void audio_mixer_stop(audio_mixer_voice_t* voice)
 
 static void audio_mixer_mix_wav(float* buffer, size_t num_frames,
       audio_mixer_voice_t* voice,
-      float volume)
+      float volume, audio_mixer_notify_list_t *notify)
 {
-   int i;
+   bool repeated                    = false;
    unsigned buf_free                = (unsigned)(num_frames * 2);
    const audio_mixer_sound_t* sound = voice->sound;
    unsigned pcm_available           = sound->types.wav.frames
@@ -855,13 +1524,14 @@ static void audio_mixer_mix_wav(float* buffer, size_t num_frames,
 again:
    if (pcm_available < buf_free)
    {
-      for (i = pcm_available; i != 0; i--)
-         *buffer++ += *pcm++ * volume;
+      audio_mixer_voice_accumulate(voice, buffer, pcm, pcm_available, volume);
+      buffer += pcm_available;
 
       if (voice->repeat)
       {
-         if (voice->stop_cb)
-            voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_REPEATED);
+         if (!repeated)
+            audio_mixer_notify(notify, voice, AUDIO_MIXER_SOUND_REPEATED);
+         repeated                   = true;
 
          buf_free                  -= pcm_available;
          pcm_available              = sound->types.wav.frames * 2;
@@ -870,364 +1540,133 @@ again:
          goto again;
       }
 
-      if (voice->stop_cb)
-         voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_FINISHED);
-
-      voice->type = AUDIO_MIXER_TYPE_NONE;
+      audio_mixer_notify(notify, voice, AUDIO_MIXER_SOUND_FINISHED);
+      audio_mixer_voice_release(voice);
    }
    else
    {
-      for (i = buf_free; i != 0; i--)
-         *buffer++ += *pcm++ * volume;
-
+      audio_mixer_voice_accumulate(voice, buffer, pcm, buf_free, volume);
       voice->types.wav.position += buf_free;
    }
 }
 
-#ifdef HAVE_STB_VORBIS
-static void audio_mixer_mix_ogg(float* buffer, size_t num_frames,
-      audio_mixer_voice_t* voice,
-      float volume)
-{
-   int i;
-   struct resampler_data info = { 0 };
-   float temp_buffer[AUDIO_MIXER_TEMP_BUFFER] = { 0 };
-   unsigned buf_free                = (unsigned)(num_frames * 2);
-   unsigned temp_samples            = 0;
-   float* pcm                       = NULL;
-
-   if (voice->types.ogg.position == voice->types.ogg.samples)
-   {
-again:
-      temp_samples = stb_vorbis_get_samples_float_interleaved(
-            voice->types.ogg.stream, 2, temp_buffer,
-            AUDIO_MIXER_TEMP_BUFFER) * 2;
-
-      if (temp_samples == 0)
-      {
-         if (voice->repeat)
-         {
-            if (voice->stop_cb)
-               voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_REPEATED);
-
-            stb_vorbis_seek_start(voice->types.ogg.stream);
-            goto again;
-         }
-         else
-         {
-            if (voice->stop_cb)
-               voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_FINISHED);
-
-            voice->type = AUDIO_MIXER_TYPE_NONE;
-            return;
-         }
-      }
-
-      info.data_in              = temp_buffer;
-      info.data_out             = voice->types.ogg.buffer;
-      info.input_frames         = temp_samples / 2;
-      info.output_frames        = 0;
-      info.ratio                = voice->types.ogg.ratio;
-
-      if (voice->types.ogg.resampler)
-        voice->types.ogg.resampler->process(voice->types.ogg.resampler_data, &info);
-      else
-        memcpy(voice->types.ogg.buffer, temp_buffer, temp_samples * sizeof(float));
-      voice->types.ogg.position = 0;
-      voice->types.ogg.samples  = voice->types.ogg.buf_samples;
-   }
-
-   pcm = voice->types.ogg.buffer + voice->types.ogg.position;
-
-   if (voice->types.ogg.samples < buf_free)
-   {
-      for (i = voice->types.ogg.samples; i != 0; i--)
-         *buffer++ += *pcm++ * volume;
-
-      buf_free -= voice->types.ogg.samples;
-      goto again;
-   }
-   else
-   {
-      int i;
-      for (i = buf_free; i != 0; --i )
-         *buffer++ += *pcm++ * volume;
-
-      voice->types.ogg.position += buf_free;
-      voice->types.ogg.samples  -= buf_free;
-   }
-}
-#endif
-
-#ifdef HAVE_IBXM
-static void audio_mixer_mix_mod(float* buffer, size_t num_frames,
+/* Mixes the decoded samples queued for a streamed voice. Decoding
+ * happens on the worker; only when there is none does the mixer
+ * decode here, one chunk at a time. */
+static void audio_mixer_mix_stream(float* buffer, size_t num_frames,
       audio_mixer_voice_t* voice,
-      float volume)
+      float volume, audio_mixer_notify_list_t *notify)
 {
-   int i;
-   float samplef                    = 0.0f;
-   int samplei                      = 0;
-   unsigned temp_samples            = 0;
-   unsigned buf_free                = (unsigned)(num_frames * 2);
-   int* pcm                         = NULL;
+   float temp_buffer[AUDIO_MIXER_TEMP_BUFFER];
+   size_t buf_free = num_frames * 2;
 
-   if (voice->types.mod.position == voice->types.mod.samples)
+   while (buf_free)
    {
-again:
-      temp_samples = replay_get_audio(
-            voice->types.mod.stream, voice->types.mod.buffer );
-
-      temp_samples *= 2; /* stereo */
+      size_t samples = fifo_read_avail(voice->ring) / sizeof(float);
 
-      if (temp_samples == 0)
+      if (samples == 0)
       {
-         if (voice->repeat)
-         {
-            if (voice->stop_cb)
-               voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_REPEATED);
-
-            replay_seek( voice->types.mod.stream, 0);
-            goto again;
-         }
-         else
-         {
-            if (voice->stop_cb)
-               voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_FINISHED);
+         if (voice->eof || audio_mixer_worker_running())
+            break;
 
-            voice->type = AUDIO_MIXER_TYPE_NONE;
-            return;
-         }
+         audio_mixer_fill(voice, temp_buffer, 1);
+         continue;
       }
 
-      voice->types.mod.position = 0;
-      voice->types.mod.samples  = temp_samples;
-   }
-   pcm = voice->types.mod.buffer + voice->types.mod.position;
+      if (samples > buf_free)
+         samples = buf_free;
+      if (samples > AUDIO_MIXER_TEMP_BUFFER)
+         samples = AUDIO_MIXER_TEMP_BUFFER;
 
-   if (voice->types.mod.samples < buf_free)
-   {
-      for (i = voice->types.mod.samples; i != 0; i--)
-      {
-         samplei     = *pcm++ * volume;
-         samplef     = (float)((int)samplei + 32768) / 65535.0f;
-         samplef     = samplef * 2.0f - 1.0f;
-         *buffer++  += samplef;
-      }
+      fifo_read(voice->ring, temp_buffer, samples * sizeof(float));
+      audio_mixer_voice_accumulate(voice, buffer, temp_buffer, samples, volume);
 
-      buf_free -= voice->types.mod.samples;
-      goto again;
+      buffer   += samples;
+      buf_free -= samples;
    }
-   else
-   {
-      int i;
-      for (i = buf_free; i != 0; --i )
-      {
-         samplei     = *pcm++ * volume;
-         samplef     = (float)((int)samplei + 32768) / 65535.0f;
-         samplef     = samplef * 2.0f - 1.0f;
-         *buffer++  += samplef;
-      }
 
-      voice->types.mod.position += buf_free;
-      voice->types.mod.samples  -= buf_free;
-   }
-}
-#endif
-
-#ifdef HAVE_DR_FLAC
-static void audio_mixer_mix_flac(float* buffer, size_t num_frames,
-      audio_mixer_voice_t* voice,
-      float volume)
-{
-   int i;
-   struct resampler_data info = { 0 };
-   float temp_buffer[AUDIO_MIXER_TEMP_BUFFER] = { 0 };
-   unsigned buf_free                = (unsigned)(num_frames * 2);
-   unsigned temp_samples            = 0;
-   float* pcm                       = NULL;
-
-   if (voice->types.flac.position == voice->types.flac.samples)
+   if (voice->repeats)
    {
-again:
-      temp_samples = drflac_read_f32( voice->types.flac.stream, AUDIO_MIXER_TEMP_BUFFER, temp_buffer);
-      if (temp_samples == 0)
-      {
-         if (voice->repeat)
-         {
-            if (voice->stop_cb)
-               voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_REPEATED);
-
-            drflac_seek_to_sample(voice->types.flac.stream,0);
-            goto again;
-         }
-         else
-         {
-            if (voice->stop_cb)
-               voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_FINISHED);
-
-            voice->type = AUDIO_MIXER_TYPE_NONE;
-            return;
-         }
-      }
-
-      info.data_in              = temp_buffer;
-      info.data_out             = voice->types.flac.buffer;
-      info.input_frames         = temp_samples / 2;
-      info.output_frames        = 0;
-      info.ratio                = voice->types.flac.ratio;
-
-      if (voice->types.flac.resampler)
-        voice->types.flac.resampler->process(voice->types.flac.resampler_data, &info);
-      else
-        memcpy(voice->types.flac.buffer, temp_buffer, temp_samples * sizeof(float));
-      voice->types.flac.position = 0;
-      voice->types.flac.samples  = voice->types.flac.buf_samples;
+      audio_mixer_notify(notify, voice, AUDIO_MIXER_SOUND_REPEATED);
+      voice->repeats = 0;
    }
 
-   pcm = voice->types.flac.buffer + voice->types.flac.position;
-
-   if (voice->types.flac.samples < buf_free)
+   if (voice->eof && fifo_read_avail(voice->ring) == 0)
    {
-      for (i = voice->types.flac.samples; i != 0; i--)
-         *buffer++ += *pcm++ * volume;
-
-      buf_free -= voice->types.flac.samples;
-      goto again;
-   }
-   else
-   {
-      int i;
-      for (i = buf_free; i != 0; --i )
-         *buffer++ += *pcm++ * volume;
-
-      voice->types.flac.position += buf_free;
-      voice->types.flac.samples  -= buf_free;
+      audio_mixer_notify(notify, voice, AUDIO_MIXER_SOUND_FINISHED);
+      audio_mixer_voice_release(voice);
    }
+   else if (buf_free)
+      s_underruns++;
 }
-#endif
-
-#ifdef HAVE_DR_MP3
-static void audio_mixer_mix_mp3(float* buffer, size_t num_frames,
-      audio_mixer_voice_t* voice,
-      float volume)
-{
-   int i;
-   struct resampler_data info = { 0 };
-   float temp_buffer[AUDIO_MIXER_TEMP_BUFFER] = { 0 };
-   unsigned buf_free                = (unsigned)(num_frames * 2);
-   unsigned temp_samples            = 0;
-   float* pcm                       = NULL;
-
-   if (voice->types.mp3.position == voice->types.mp3.samples)
-   {
-again:
-      temp_samples = drmp3_read_f32(&voice->types.mp3.stream, AUDIO_MIXER_TEMP_BUFFER/2, temp_buffer) * 2;
-      
-      if (temp_samples == 0)
-      {
-         if (voice->repeat)
-         {
-            if (voice->stop_cb)
-               voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_REPEATED);
-
-            drmp3_seek_to_frame(&voice->types.mp3.stream,0);
-            goto again;
-         }
-         else
-         {
-            if (voice->stop_cb)
-               voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_FINISHED);
-
-            voice->type = AUDIO_MIXER_TYPE_NONE;
-            return;
-         }
-      }
-
-      info.data_in              = temp_buffer;
-      info.data_out             = voice->types.mp3.buffer;
-      info.input_frames         = temp_samples / 2;
-      info.output_frames        = 0;
-      info.ratio                = voice->types.mp3.ratio;
-
-      if (voice->types.mp3.resampler)
-        voice->types.mp3.resampler->process(voice->types.mp3.resampler_data, &info);
-      else
-        memcpy(voice->types.mp3.buffer, temp_buffer, temp_samples * sizeof(float));
-      voice->types.mp3.position = 0;
-      voice->types.mp3.samples  = voice->types.mp3.buf_samples;
-   }
-
-   pcm = voice->types.mp3.buffer + voice->types.mp3.position;
-
-   if (voice->types.mp3.samples < buf_free)
-   {
-      for (i = voice->types.mp3.samples; i != 0; i--)
-         *buffer++ += *pcm++ * volume;
-
-      buf_free -= voice->types.mp3.samples;
-      goto again;
-   }
-   else
-   {
-      int i;
-      for (i = buf_free; i != 0; --i )
-         *buffer++ += *pcm++ * volume;
-
-      voice->types.mp3.position += buf_free;
-      voice->types.mp3.samples  -= buf_free;
-   }
-}
-#endif
 
 void audio_mixer_mix(float* buffer, size_t num_frames, float volume_override, bool override)
 {
    unsigned i;
    size_t j                   = 0;
    float* sample              = NULL;
-   audio_mixer_voice_t* voice = s_voices;
+   bool streamed              = false;
+   audio_mixer_notify_list_t *notify = &s_notify;
 
 #ifdef HAVE_THREADS
    slock_lock(s_locker);
 #endif
 
-   for (i = 0; i < AUDIO_MIXER_MAX_VOICES; i++, voice++)
+   /* Every voice can report a repeat and a finish per mix. */
+   if (notify->capacity < s_active_count * 2)
+   {
+      audio_mixer_notify_t *entries = (audio_mixer_notify_t*)realloc(
+            notify->entries, s_active_count * 2 * sizeof(*entries));
+
+      if (entries)
+      {
+         notify->entries  = entries;
+         notify->capacity = s_active_count * 2;
+      }
+   }
+
+   notify->count = 0;
+
+   /* Voices that finish are released, moving the last active voice
+    * into their slot; only advance past voices that are still playing. */
+   for (i = 0; i < s_active_count; )
    {
+      audio_mixer_voice_t* voice = s_active[i];
       float volume = (override) ? volume_override : voice->volume;
 
       switch (voice->type)
       {
          case AUDIO_MIXER_TYPE_WAV:
-            audio_mixer_mix_wav(buffer, num_frames, voice, volume);
+            audio_mixer_mix_wav(buffer, num_frames, voice, volume, notify);
             break;
          case AUDIO_MIXER_TYPE_OGG:
-#ifdef HAVE_STB_VORBIS
-            audio_mixer_mix_ogg(buffer, num_frames, voice, volume);
-#endif
-            break;
          case AUDIO_MIXER_TYPE_MOD:
-#ifdef HAVE_IBXM
-            audio_mixer_mix_mod(buffer, num_frames, voice, volume);
-#endif
-            break;
          case AUDIO_MIXER_TYPE_FLAC:
-#ifdef HAVE_DR_FLAC
-            audio_mixer_mix_flac(buffer, num_frames, voice, volume);
-#endif
-            break;
-            case AUDIO_MIXER_TYPE_MP3:
-#ifdef HAVE_DR_MP3
-            audio_mixer_mix_mp3(buffer, num_frames, voice, volume);
-#endif
+         case AUDIO_MIXER_TYPE_MP3:
+            audio_mixer_mix_stream(buffer, num_frames, voice, volume, notify);
+            streamed = true;
             break;
          case AUDIO_MIXER_TYPE_NONE:
             break;
       }
+
+      if (voice->type != AUDIO_MIXER_TYPE_NONE)
+         i++;
    }
 
 #ifdef HAVE_THREADS
+   /* Let the worker top up the rings we just drained. */
+   if (streamed)
+      scond_broadcast(s_cond);
    slock_unlock(s_locker);
 #endif
 
+   /* The callbacks may play or stop voices, but they cannot mix, so
+    * the list is not touched while they run. */
+   for (i = 0; i < notify->count; i++)
+      notify->entries[i].stop_cb(notify->entries[i].sound,
+            notify->entries[i].reason);
+
    for (j = 0, sample = buffer; j < num_frames; j++, sample++)
    {
       if (*sample < -1.0f)
@@ -1252,3 +1691,20 @@ void audio_mixer_voice_set_volume(audio_mixer_voice_t *voice, float val)
 
    voice->volume = val;
 }
+
+unsigned audio_mixer_get_underruns(void)
+{
+   unsigned underruns;
+
+#ifdef HAVE_THREADS
+   slock_lock(s_locker);
+#endif
+
+   underruns = s_underruns;
+
+#ifdef HAVE_THREADS
+   slock_unlock(s_locker);
+#endif
+
+   return underruns;
+}
@@ -21,6 +21,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <retro_miscellaneous.h>
 
@@ -34,8 +35,16 @@
 #include <string/stdstring.h>
 #include <libretro_dspfilter.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 #include <audio/dsp_filter.h>
 
+/* Blocks run serially to measure the plugs
+ * before the chain is split into pipeline stages. */
+#define DSP_FILTER_CALIBRATE_BLOCKS 64
+
 struct retro_dsp_plug
 {
 #ifdef HAVE_DYLIB
@@ -48,6 +57,34 @@ struct retro_dsp_instance
 {
    const struct dspfilter_implementation *impl;
    void *impl_data;
+
+   /* Updated by whichever thread runs the instance. */
+   struct retro_perf_counter perf;
+   /* Copy owned by the thread calling retro_dsp_filter_process(). */
+   struct retro_perf_counter perf_report;
+   char ident[64];
+};
+
+/* A contiguous run of instances. Stage 0 runs on the caller,
+ * every other stage on its own worker, one block behind the
+ * stage before it. */
+struct retro_dsp_stage
+{
+   retro_dsp_filter_t *dsp;
+   float *input;
+   const float *output;
+   unsigned input_frames;
+   unsigned input_capacity;
+   unsigned output_frames;
+   unsigned first;
+   unsigned count;
+#ifdef HAVE_THREADS
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+   bool busy;
+   bool quit;
+#endif
 };
 
 struct retro_dsp_filter
@@ -59,6 +96,14 @@ struct retro_dsp_filter
 
    struct retro_dsp_instance *instances;
    unsigned num_instances;
+
+   struct retro_dsp_stage *stages;
+   unsigned num_stages;
+   unsigned pipeline_stages;
+   unsigned calibrate_blocks;
+
+   float *output;
+   unsigned output_capacity;
 };
 
 static const struct dspfilter_implementation *find_implementation(
@@ -119,6 +164,11 @@ static bool create_filter_graph(retro_dsp_filter_t *dsp, float sample_rate)
       if (!dsp->instances[i].impl)
          return false;
 
+      snprintf(dsp->instances[i].ident, sizeof(dsp->instances[i].ident),
+            "dsp_%u_%s", i, name);
+      dsp->instances[i].perf.ident        = dsp->instances[i].ident;
+      dsp->instances[i].perf_report.ident = dsp->instances[i].ident;
+
       userdata.conf = dsp->conf;
       /* Index-specific configs take priority over ident-specific. */
       userdata.prefix[0] = key;
@@ -141,6 +191,7 @@ extern const struct dspfilter_implementation *phaser_dspfilter_get_implementatio
 extern const struct dspfilter_implementation *wahwah_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
 extern const struct dspfilter_implementation *eq_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
 extern const struct dspfilter_implementation *chorus_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *convolution_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
 
 static const dspfilter_get_implementation_t dsp_plugs_builtin[] = {
    panning_dspfilter_get_implementation,
@@ -150,6 +201,7 @@ static const dspfilter_get_implementation_t dsp_plugs_builtin[] = {
    wahwah_dspfilter_get_implementation,
    eq_dspfilter_get_implementation,
    chorus_dspfilter_get_implementation,
+   convolution_dspfilter_get_implementation,
 };
 
 static bool append_plugs(retro_dsp_filter_t *dsp, struct string_list *list)
@@ -232,6 +284,267 @@ static bool append_plugs(retro_dsp_filter_t *dsp, struct string_list *list)
 }
 #endif
 
+static void retro_dsp_run_instances(retro_dsp_filter_t *dsp,
+      unsigned first, unsigned count,
+      const float *samples, unsigned frames,
+      const float **out_samples, unsigned *out_frames)
+{
+   unsigned i;
+   struct dspfilter_output output = {0};
+   struct dspfilter_input input   = {0};
+
+   output.samples = (float*)samples;
+   output.frames  = frames;
+
+   for (i = first; i < first + count; i++)
+   {
+      struct retro_dsp_instance *inst = &dsp->instances[i];
+      retro_perf_tick_t start         = cpu_features_get_perf_counter();
+
+      input.samples = output.samples;
+      input.frames  = output.frames;
+      inst->impl->process(inst->impl_data, &output, &input);
+
+      inst->perf.total += cpu_features_get_perf_counter() - start;
+      inst->perf.call_cnt++;
+   }
+
+   *out_samples = output.samples;
+   *out_frames  = output.frames;
+}
+
+static void retro_dsp_publish_perf(retro_dsp_filter_t *dsp,
+      unsigned first, unsigned count)
+{
+   unsigned i;
+   for (i = first; i < first + count; i++)
+   {
+      dsp->instances[i].perf_report.total    = dsp->instances[i].perf.total;
+      dsp->instances[i].perf_report.call_cnt = dsp->instances[i].perf.call_cnt;
+   }
+}
+
+static bool retro_dsp_copy_frames(float **buf, unsigned *capacity,
+      const float *samples, unsigned frames)
+{
+   if (frames > *capacity)
+   {
+      float *new_buf = (float*)realloc(*buf, 2 * frames * sizeof(float));
+      if (!new_buf)
+         return false;
+      *buf      = new_buf;
+      *capacity = frames;
+   }
+
+   if (frames)
+      memcpy(*buf, samples, 2 * frames * sizeof(float));
+   return true;
+}
+
+static void retro_dsp_pipeline_free(retro_dsp_filter_t *dsp);
+
+#ifdef HAVE_THREADS
+static void retro_dsp_stage_thread(void *data)
+{
+   struct retro_dsp_stage *stage = (struct retro_dsp_stage*)data;
+
+   slock_lock(stage->lock);
+   for (;;)
+   {
+      while (!stage->busy && !stage->quit)
+         scond_wait(stage->cond, stage->lock);
+      if (stage->quit)
+         break;
+      slock_unlock(stage->lock);
+
+      retro_dsp_run_instances(stage->dsp, stage->first, stage->count,
+            stage->input, stage->input_frames,
+            &stage->output, &stage->output_frames);
+
+      slock_lock(stage->lock);
+      stage->busy = false;
+      scond_signal(stage->cond);
+   }
+   slock_unlock(stage->lock);
+}
+
+static void retro_dsp_stage_kick(struct retro_dsp_stage *stage)
+{
+   slock_lock(stage->lock);
+   stage->busy = true;
+   scond_signal(stage->cond);
+   slock_unlock(stage->lock);
+}
+
+static void retro_dsp_stage_wait(struct retro_dsp_stage *stage)
+{
+   slock_lock(stage->lock);
+   while (stage->busy)
+      scond_wait(stage->cond, stage->lock);
+   slock_unlock(stage->lock);
+}
+
+/* Splits the chain so every stage gets about the same share
+ * of the time measured while calibrating. */
+static void retro_dsp_pipeline_split(retro_dsp_filter_t *dsp)
+{
+   unsigned i;
+   unsigned stage          = 0;
+   retro_perf_tick_t sum   = 0;
+   retro_perf_tick_t total = 0;
+
+   for (i = 0; i < dsp->num_instances; i++)
+      total += dsp->instances[i].perf.total;
+
+   dsp->stages[0].first = 0;
+   for (i = 0; i < dsp->num_instances; i++)
+   {
+      unsigned remaining = dsp->num_instances - i;
+      unsigned left      = dsp->num_stages - stage;
+
+      /* Cut before this instance once the stage has its share,
+       * or when every stage left needs one instance each. */
+      if (     i > dsp->stages[stage].first
+            && stage + 1 < dsp->num_stages
+            && (remaining < left
+               || sum * dsp->num_stages >= total * (stage + 1)))
+      {
+         dsp->stages[stage].count = i - dsp->stages[stage].first;
+         dsp->stages[++stage].first = i;
+      }
+
+      sum += dsp->instances[i].perf.total;
+   }
+   dsp->stages[stage].count = dsp->num_instances - dsp->stages[stage].first;
+}
+
+static bool retro_dsp_pipeline_init(retro_dsp_filter_t *dsp)
+{
+   unsigned i;
+
+   dsp->stages = (struct retro_dsp_stage*)
+      calloc(dsp->pipeline_stages, sizeof(*dsp->stages));
+   if (!dsp->stages)
+      return false;
+
+   dsp->num_stages = dsp->pipeline_stages;
+   retro_dsp_pipeline_split(dsp);
+
+   /* Never hand a NULL output back, which callers take
+    * as a request to use the unfiltered input. */
+   dsp->output = (float*)calloc(2, sizeof(float));
+   if (!dsp->output)
+      goto error;
+   dsp->output_capacity = 1;
+
+   for (i = 1; i < dsp->num_stages; i++)
+   {
+      struct retro_dsp_stage *stage = &dsp->stages[i];
+
+      stage->dsp  = dsp;
+      stage->lock = slock_new();
+      stage->cond = scond_new();
+      if (!stage->lock || !stage->cond)
+         goto error;
+
+      stage->thread = sthread_create(retro_dsp_stage_thread, stage);
+      if (!stage->thread)
+         goto error;
+   }
+
+   return true;
+
+error:
+   retro_dsp_pipeline_free(dsp);
+   return false;
+}
+
+static void retro_dsp_pipeline_process(retro_dsp_filter_t *dsp,
+      struct retro_dsp_data *data)
+{
+   unsigned s;
+   const float *samples          = NULL;
+   unsigned frames               = 0;
+   unsigned last                 = dsp->num_stages - 1;
+   struct retro_dsp_stage *first = &dsp->stages[0];
+
+   /* Stage 0 runs on the new block while the workers
+    * finish the blocks they were given last time. */
+   retro_dsp_run_instances(dsp, first->first, first->count,
+         data->input, data->input_frames, &samples, &frames);
+   retro_dsp_publish_perf(dsp, first->first, first->count);
+
+   /* Collect from the back of the chain so every stage
+    * is idle by the time its next input is written. */
+   for (s = last; s >= 1; s--)
+   {
+      struct retro_dsp_stage *stage = &dsp->stages[s];
+
+      retro_dsp_stage_wait(stage);
+      retro_dsp_publish_perf(dsp, stage->first, stage->count);
+
+      if (s == last)
+      {
+         if (retro_dsp_copy_frames(&dsp->output, &dsp->output_capacity,
+                  stage->output, stage->output_frames))
+            data->output_frames = stage->output_frames;
+      }
+      else
+      {
+         struct retro_dsp_stage *next = &dsp->stages[s + 1];
+         next->input_frames = 0;
+         if (retro_dsp_copy_frames(&next->input, &next->input_capacity,
+                  stage->output, stage->output_frames))
+            next->input_frames = stage->output_frames;
+         retro_dsp_stage_kick(next);
+      }
+   }
+
+   dsp->stages[1].input_frames = 0;
+   if (retro_dsp_copy_frames(&dsp->stages[1].input,
+            &dsp->stages[1].input_capacity, samples, frames))
+      dsp->stages[1].input_frames = frames;
+   retro_dsp_stage_kick(&dsp->stages[1]);
+
+   data->output = dsp->output;
+}
+#endif
+
+static void retro_dsp_pipeline_free(retro_dsp_filter_t *dsp)
+{
+   unsigned i;
+
+   if (!dsp->stages)
+      return;
+
+   for (i = 1; i < dsp->num_stages; i++)
+   {
+      struct retro_dsp_stage *stage = &dsp->stages[i];
+#ifdef HAVE_THREADS
+      if (stage->thread)
+      {
+         slock_lock(stage->lock);
+         stage->quit = true;
+         scond_signal(stage->cond);
+         slock_unlock(stage->lock);
+         sthread_join(stage->thread);
+      }
+      if (stage->lock)
+         slock_free(stage->lock);
+      if (stage->cond)
+         scond_free(stage->cond);
+#endif
+      free(stage->input);
+   }
+
+   free(dsp->stages);
+   free(dsp->output);
+   dsp->stages          = NULL;
+   dsp->num_stages      = 0;
+   dsp->output          = NULL;
+   dsp->output_capacity = 0;
+}
+
 retro_dsp_filter_t *retro_dsp_filter_new(
       const char *filter_config,
       void *string_data,
@@ -265,6 +578,9 @@ retro_dsp_filter_t *retro_dsp_filter_new(
    if (!create_filter_graph(dsp, sample_rate))
       goto error;
 
+   config_get_uint(conf, "pipeline_stages", &dsp->pipeline_stages);
+   dsp->pipeline_stages = MIN(dsp->pipeline_stages, dsp->num_instances);
+
    return dsp;
 
 error:
@@ -280,6 +596,8 @@ void retro_dsp_filter_free(retro_dsp_filter_t *dsp)
    if (!dsp)
       return;
 
+   retro_dsp_pipeline_free(dsp);
+
    for (i = 0; i < dsp->num_instances; i++)
    {
       if (dsp->instances[i].impl_data && dsp->instances[i].impl)
@@ -305,21 +623,41 @@ void retro_dsp_filter_free(retro_dsp_filter_t *dsp)
 void retro_dsp_filter_process(retro_dsp_filter_t *dsp,
       struct retro_dsp_data *data)
 {
-   unsigned i;
-   struct dspfilter_output output = {0};
-   struct dspfilter_input input   = {0};
+   const float *samples = NULL;
+   unsigned frames      = 0;
 
-   output.samples = data->input;
-   output.frames  = data->input_frames;
-
-   for (i = 0; i < dsp->num_instances; i++)
+#ifdef HAVE_THREADS
+   if (dsp->num_stages > 1)
    {
-      input.samples = output.samples;
-      input.frames  = output.frames;
-      dsp->instances[i].impl->process(
-            dsp->instances[i].impl_data, &output, &input);
+      retro_dsp_pipeline_process(dsp, data);
+      return;
    }
+#endif
+
+   retro_dsp_run_instances(dsp, 0, dsp->num_instances,
+         data->input, data->input_frames, &samples, &frames);
+   retro_dsp_publish_perf(dsp, 0, dsp->num_instances);
+
+   data->output        = (float*)samples;
+   data->output_frames = frames;
 
-   data->output        = output.samples;
-   data->output_frames = output.frames;
+#ifdef HAVE_THREADS
+   if (     dsp->pipeline_stages > 1
+         && ++dsp->calibrate_blocks == DSP_FILTER_CALIBRATE_BLOCKS
+         && !retro_dsp_pipeline_init(dsp))
+      dsp->pipeline_stages = 0;
+#endif
+}
+
+unsigned retro_dsp_filter_get_num_instances(retro_dsp_filter_t *dsp)
+{
+   return dsp ? dsp->num_instances : 0;
+}
+
+const struct retro_perf_counter *retro_dsp_filter_get_perf(
+      retro_dsp_filter_t *dsp, unsigned index)
+{
+   if (!dsp || index >= dsp->num_instances)
+      return NULL;
+   return &dsp->instances[index].perf_report;
 }
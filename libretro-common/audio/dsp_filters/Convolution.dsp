@@ -0,0 +1,27 @@
+filters = 1
+filter0 = convolution
+
+# Path to the impulse response to convolve with.
+# 8-bit or 16-bit PCM WAV, mono or stereo. A mono response is applied
+# to both channels. Responses at another sample rate are resampled
+# to the output rate when loading.
+convolution_impulse_response = "cabinet.wav"
+
+# Defaults
+
+# The block size, in frames, the response is partitioned into.
+# This is also the latency of the filter. Lower values cost more CPU
+# per second of audio; the cost per block is fixed once the
+# response is loaded.
+# convolution_block_size_log2 = 8
+
+# The response is truncated to this length.
+# Bounds the CPU time and memory spent on very long reverb tails.
+# convolution_max_length_ms = 2000
+
+# Gain applied to the response, in dB.
+# convolution_gain = 0.0
+
+# Linear mix of the unprocessed and convolved signal.
+# convolution_dry = 0.0
+# convolution_wet = 1.0
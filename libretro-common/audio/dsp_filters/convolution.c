@@ -0,0 +1,400 @@
+/* Copyright  (C) 2010-2018 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (convolution.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <retro_inline.h>
+#include <retro_miscellaneous.h>
+#include <libretro_dspfilter.h>
+#include <formats/rwav.h>
+
+#ifdef HAVE_FILTERS_BUILTIN
+#include "fft/fft.h"
+#else
+#include "fft/fft.c"
+#include "../../formats/wav/rwav.c"
+#endif
+
+/* Uniformly partitioned overlap-save convolution.
+ *
+ * The impulse response is split into partitions of block_size
+ * frames, each transformed once at init with an FFT of twice
+ * the block size. Every block of input is transformed once and
+ * kept in a frequency-domain delay line; the output spectrum is
+ * the sum of delay line entries times the matching partition.
+ * Latency is one block and the cost per block is two FFTs plus
+ * one complex multiply-add per partition, regardless of when
+ * the impulse response decays. */
+
+struct conv_channel
+{
+   float *input;              /* Previous and current block. */
+   fft_complex_t *fdl;        /* partitions spectra of past input. */
+   const fft_complex_t *ir;   /* partitions spectra of the response. */
+};
+
+struct conv_data
+{
+   fft_t *fft;
+   fft_complex_t *ir[2];
+   fft_complex_t *accum;
+   float *time;
+   float *block;
+   float *buffer;
+   struct conv_channel channels[2];
+
+   unsigned buffer_frames;
+   unsigned block_size;
+   unsigned block_ptr;
+   unsigned bins;
+   unsigned partitions;
+   unsigned fdl_pos;
+
+   float dry;
+   float wet;
+};
+
+static void conv_free(void *data)
+{
+   unsigned c;
+   struct conv_data *conv = (struct conv_data*)data;
+   if (!conv)
+      return;
+
+   for (c = 0; c < 2; c++)
+   {
+      free(conv->channels[c].input);
+      free(conv->channels[c].fdl);
+   }
+
+   if (conv->ir[1] != conv->ir[0])
+      free(conv->ir[1]);
+   free(conv->ir[0]);
+   fft_free(conv->fft);
+   free(conv->accum);
+   free(conv->time);
+   free(conv->block);
+   free(conv->buffer);
+   free(conv);
+}
+
+static void conv_process_block(struct conv_data *conv, float *out)
+{
+   unsigned c, i, p;
+   unsigned size = conv->block_size;
+   unsigned fft_size = 2 * size;
+
+   for (c = 0; c < 2; c++)
+   {
+      struct conv_channel *ch = &conv->channels[c];
+      fft_complex_t *slot     = ch->fdl + conv->fdl_pos * conv->bins;
+      unsigned pos            = conv->fdl_pos;
+
+      memmove(ch->input, ch->input + size, size * sizeof(float));
+      for (i = 0; i < size; i++)
+         ch->input[size + i] = conv->block[2 * i + c];
+
+      /* Only the non-negative half of a real spectrum is kept. */
+      fft_process_forward(conv->fft, conv->accum, ch->input, 1);
+      memcpy(slot, conv->accum, conv->bins * sizeof(*slot));
+
+      fft_complex_multiply(conv->accum, slot, ch->ir, conv->bins);
+      for (p = 1; p < conv->partitions; p++)
+      {
+         pos = pos ? pos - 1 : conv->partitions - 1;
+         fft_complex_multiply_accumulate(conv->accum,
+               ch->fdl + pos * conv->bins,
+               ch->ir + p * conv->bins, conv->bins);
+      }
+
+      for (i = 1; i < size; i++)
+         conv->accum[fft_size - i] = fft_complex_conj(conv->accum[i]);
+
+      fft_process_inverse(conv->fft, conv->time, conv->accum, 1);
+
+      /* The first half wrapped around, the second is linear. */
+      for (i = 0; i < size; i++)
+         out[2 * i + c] = conv->dry * conv->block[2 * i + c]
+            + conv->wet * conv->time[size + i];
+   }
+
+   if (++conv->fdl_pos >= conv->partitions)
+      conv->fdl_pos = 0;
+}
+
+static void conv_process(void *data, struct dspfilter_output *output,
+      const struct dspfilter_input *input)
+{
+   float *out;
+   const float *in;
+   unsigned input_frames;
+   struct conv_data *conv = (struct conv_data*)data;
+   unsigned max_frames    = input->frames + conv->block_size;
+
+   output->samples        = conv->buffer;
+   output->frames         = 0;
+
+   if (max_frames > conv->buffer_frames)
+   {
+      float *buffer = (float*)realloc(conv->buffer,
+            2 * max_frames * sizeof(*buffer));
+      if (!buffer)
+         return;
+      conv->buffer        = buffer;
+      conv->buffer_frames = max_frames;
+      output->samples     = buffer;
+   }
+
+   out          = conv->buffer;
+   in           = input->samples;
+   input_frames = input->frames;
+
+   while (input_frames)
+   {
+      unsigned write_avail = conv->block_size - conv->block_ptr;
+
+      if (input_frames < write_avail)
+         write_avail = input_frames;
+
+      memcpy(conv->block + conv->block_ptr * 2, in,
+            write_avail * 2 * sizeof(float));
+
+      in              += write_avail * 2;
+      input_frames    -= write_avail;
+      conv->block_ptr += write_avail;
+
+      if (conv->block_ptr == conv->block_size)
+      {
+         conv_process_block(conv, out);
+         out             += conv->block_size * 2;
+         output->frames  += conv->block_size;
+         conv->block_ptr  = 0;
+      }
+   }
+}
+
+/* Reads a WAV impulse response as deinterleaved float channels
+ * at the output rate. Returns the number of frames, or 0. */
+static unsigned conv_load_ir(const char *path, float input_rate,
+      unsigned max_frames, float **out, unsigned *out_channels)
+{
+   rwav_t wav;
+   unsigned c, i, frames, channels;
+   long len;
+   double ratio;
+   float *ir         = NULL;
+   void *buf         = NULL;
+   FILE *file        = fopen(path, "rb");
+
+   wav.samples       = NULL;
+
+   if (!file)
+      return 0;
+
+   fseek(file, 0, SEEK_END);
+   len = ftell(file);
+   fseek(file, 0, SEEK_SET);
+
+   if (len <= 0 || !(buf = malloc(len)))
+      goto error;
+   if (fread(buf, 1, len, file) != (size_t)len)
+      goto error;
+
+   if (rwav_load(&wav, buf, len) != RWAV_ITERATE_DONE)
+      goto error;
+   if (!wav.numchannels || !wav.numsamples || !wav.samplerate)
+      goto error;
+
+   channels = MIN(wav.numchannels, 2);
+   ratio    = (double)wav.samplerate / input_rate;
+   frames   = (unsigned)(wav.numsamples / ratio);
+   frames   = MAX(MIN(frames, max_frames), 1);
+
+   ir = (float*)calloc(channels * frames, sizeof(*ir));
+   if (!ir)
+      goto error;
+
+   /* Linear interpolation is good enough to bring a response
+    * recorded at another rate close to the output rate. */
+   for (c = 0; c < channels; c++)
+   {
+      for (i = 0; i < frames; i++)
+      {
+         double pos   = i * ratio;
+         size_t idx   = (size_t)pos;
+         float frac   = (float)(pos - idx);
+         float s0, s1;
+         size_t i0    = idx * wav.numchannels + c;
+         size_t i1    = (idx + 1 < wav.numsamples ? idx + 1 : idx)
+            * wav.numchannels + c;
+
+         if (wav.bitspersample == 16)
+         {
+            const int16_t *s = (const int16_t*)wav.samples;
+            s0 = s[i0] * (1.0f / 0x8000);
+            s1 = s[i1] * (1.0f / 0x8000);
+         }
+         else
+         {
+            const uint8_t *s = (const uint8_t*)wav.samples;
+            s0 = (s[i0] - 128) * (1.0f / 0x80);
+            s1 = (s[i1] - 128) * (1.0f / 0x80);
+         }
+
+         ir[c * frames + i] = s0 + frac * (s1 - s0);
+      }
+   }
+
+   rwav_free(&wav);
+   free(buf);
+   fclose(file);
+
+   *out          = ir;
+   *out_channels = channels;
+   return frames;
+
+error:
+   if (wav.samples)
+      rwav_free(&wav);
+   free(buf);
+   fclose(file);
+   return 0;
+}
+
+static fft_complex_t *conv_create_partitions(struct conv_data *conv,
+      const float *ir, unsigned frames, float gain)
+{
+   unsigned p, i;
+   unsigned size    = conv->block_size;
+   fft_complex_t *h = (fft_complex_t*)calloc(
+         conv->partitions * conv->bins, sizeof(*h));
+   if (!h)
+      return NULL;
+
+   for (p = 0; p < conv->partitions; p++)
+   {
+      memset(conv->time, 0, 2 * size * sizeof(float));
+      for (i = 0; i < size && p * size + i < frames; i++)
+         conv->time[i] = gain * ir[p * size + i];
+
+      fft_process_forward(conv->fft, conv->accum, conv->time, 1);
+      memcpy(h + p * conv->bins, conv->accum, conv->bins * sizeof(*h));
+   }
+
+   return h;
+}
+
+static void *conv_init(const struct dspfilter_info *info,
+      const struct dspfilter_config *config, void *userdata)
+{
+   unsigned c, size, frames, channels;
+   int size_log2;
+   float max_length_ms, gain;
+   float *ir              = NULL;
+   char *ir_path          = NULL;
+   struct conv_data *conv = (struct conv_data*)calloc(1, sizeof(*conv));
+   if (!conv)
+      return NULL;
+
+   config->get_int(userdata, "block_size_log2", &size_log2, 8);
+   config->get_float(userdata, "max_length_ms", &max_length_ms, 2000.0f);
+   config->get_float(userdata, "gain", &gain, 0.0f);
+   config->get_float(userdata, "dry", &conv->dry, 0.0f);
+   config->get_float(userdata, "wet", &conv->wet, 1.0f);
+   config->get_string(userdata, "impulse_response", &ir_path, "");
+
+   size_log2        = MAX(MIN(size_log2, 13), 4);
+   size             = 1 << size_log2;
+   conv->block_size = size;
+   conv->bins       = size + 1;
+
+   frames = conv_load_ir(ir_path, info->input_rate,
+         (unsigned)(max_length_ms * 0.001f * info->input_rate) + 1,
+         &ir, &channels);
+   config->free(ir_path);
+
+   if (!frames)
+      goto error;
+
+   conv->partitions = (frames + size - 1) / size;
+   conv->fft        = fft_new(size_log2 + 1);
+   conv->accum      = (fft_complex_t*)calloc(2 * size, sizeof(*conv->accum));
+   conv->time       = (float*)calloc(2 * size, sizeof(*conv->time));
+   conv->block      = (float*)calloc(2 * size, sizeof(*conv->block));
+
+   if (!conv->fft || !conv->accum || !conv->time || !conv->block)
+      goto error;
+
+   /* A mono response is applied to both channels. */
+   gain        = pow(10.0, gain / 20.0);
+   conv->ir[0] = conv_create_partitions(conv, ir, frames, gain);
+   conv->ir[1] = channels > 1
+      ? conv_create_partitions(conv, ir + frames, frames, gain)
+      : conv->ir[0];
+
+   if (!conv->ir[0] || !conv->ir[1])
+      goto error;
+
+   for (c = 0; c < 2; c++)
+   {
+      struct conv_channel *ch = &conv->channels[c];
+      ch->ir                  = conv->ir[c];
+      ch->input               = (float*)calloc(2 * size, sizeof(*ch->input));
+      ch->fdl                 = (fft_complex_t*)calloc(
+            conv->partitions * conv->bins, sizeof(*ch->fdl));
+      if (!ch->input || !ch->fdl)
+         goto error;
+   }
+
+   free(ir);
+   return conv;
+
+error:
+   free(ir);
+   conv_free(conv);
+   return NULL;
+}
+
+static const struct dspfilter_implementation conv_plug = {
+   conv_init,
+   conv_process,
+   conv_free,
+
+   DSPFILTER_API_VERSION,
+   "Partitioned Convolution",
+   "convolution",
+};
+
+#ifdef HAVE_FILTERS_BUILTIN
+#define dspfilter_get_implementation convolution_dspfilter_get_implementation
+#endif
+
+const struct dspfilter_implementation *dspfilter_get_implementation(dspfilter_simd_mask_t mask)
+{
+   (void)mask;
+   return &conv_plug;
+}
+
+#undef dspfilter_get_implementation
@@ -29,7 +29,11 @@
 #include <filters.h>
 #include <libretro_dspfilter.h>
 
+#ifdef HAVE_FILTERS_BUILTIN
+#include "fft/fft.h"
+#else
 #include "fft/fft.c"
+#endif
 
 struct eq_data
 {
@@ -100,8 +104,8 @@ static void eq_process(void *data, struct dspfilter_output *output,
          for (c = 0; c < 2; c++)
          {
             fft_process_forward(eq->fft, eq->fftblock, eq->block + c, 2);
-            for (i = 0; i < 2 * eq->block_size; i++)
-               eq->fftblock[i] = fft_complex_mul(eq->fftblock[i], eq->filter[i]);
+            fft_complex_multiply(eq->fftblock, eq->fftblock,
+                  eq->filter, 2 * eq->block_size);
             fft_process_inverse(eq->fft, out + c, eq->fftblock, 2);
          }
 
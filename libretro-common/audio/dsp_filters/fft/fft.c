@@ -27,12 +27,25 @@
 
 #include <retro_miscellaneous.h>
 
+#if !defined(FFT_NO_SIMD)
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#define FFT_SSE
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FFT_NEON
+#endif
+#endif
+
 struct fft
 {
    fft_complex_t *interleave_buffer;
-   fft_complex_t *phase_lut;
+   /* Per-pass twiddles, see build_twiddles(). */
+   fft_complex_t *twiddle_forward;
+   fft_complex_t *twiddle_inverse;
    unsigned *bitinverse_buffer;
    unsigned size;
+   unsigned size_log2;
 };
 
 static unsigned bitswap(unsigned x, unsigned size_log2)
@@ -58,12 +71,27 @@ static fft_complex_t exp_imag(double phase)
    return out;
 }
 
-static void build_phase_lut(fft_complex_t *out, int size)
+/* The transform is done as an optional radix-2 pass
+ * followed by radix-4 passes. A radix-4 pass with step size s
+ * fuses the radix-2 passes s and 2s, so it needs twiddles
+ * W1[k] = e^(dir * i * pi * k / s) and W2[k] = e^(dir * i * pi * k / 2s)
+ * for k < s. They are stored back to back for every pass,
+ * which keeps the loads in the butterflies contiguous. */
+static void build_twiddles(fft_complex_t *out, int dir, unsigned size_log2)
 {
-   int i;
-   out += size;
-   for (i = -size; i <= size; i++)
-      out[i] = exp_imag((M_PI * i) / size);
+   unsigned k;
+   unsigned s = (size_log2 & 1) ? 2 : 1;
+   unsigned size = 1 << size_log2;
+
+   for (; s < size; s <<= 2)
+   {
+      for (k = 0; k < s; k++)
+      {
+         out[k]     = exp_imag((dir * M_PI * k) / s);
+         out[k + s] = exp_imag((dir * M_PI * k) / (2 * s));
+      }
+      out += 2 * s;
+   }
 }
 
 static void interleave_complex(const unsigned *bitinverse,
@@ -106,15 +134,21 @@ fft_t *fft_new(unsigned block_size_log2)
    size                   = 1 << block_size_log2;
    fft->interleave_buffer = (fft_complex_t*)calloc(size, sizeof(*fft->interleave_buffer));
    fft->bitinverse_buffer = (unsigned*)calloc(size, sizeof(*fft->bitinverse_buffer));
-   fft->phase_lut         = (fft_complex_t*)calloc(2 * size + 1, sizeof(*fft->phase_lut));
+   fft->twiddle_forward   = (fft_complex_t*)calloc(2 * size, sizeof(*fft->twiddle_forward));
+   fft->twiddle_inverse   = (fft_complex_t*)calloc(2 * size, sizeof(*fft->twiddle_inverse));
 
-   if (!fft->interleave_buffer || !fft->bitinverse_buffer || !fft->phase_lut)
+   if (     !fft->interleave_buffer
+         || !fft->bitinverse_buffer
+         || !fft->twiddle_forward
+         || !fft->twiddle_inverse)
       goto error;
 
-   fft->size = size;
+   fft->size      = size;
+   fft->size_log2 = block_size_log2;
 
    build_bitinverse(fft->bitinverse_buffer, block_size_log2);
-   build_phase_lut(fft->phase_lut, size);
+   build_twiddles(fft->twiddle_forward, -1, block_size_log2);
+   build_twiddles(fft->twiddle_inverse,  1, block_size_log2);
    return fft;
 
 error:
@@ -129,77 +163,293 @@ void fft_free(fft_t *fft)
 
    free(fft->interleave_buffer);
    free(fft->bitinverse_buffer);
-   free(fft->phase_lut);
+   free(fft->twiddle_forward);
+   free(fft->twiddle_inverse);
    free(fft);
 }
 
-static void butterfly(fft_complex_t *a, fft_complex_t *b, fft_complex_t mod)
+/* First pass for odd sizes. All twiddles are 1. */
+static void butterflies_radix2(fft_complex_t *buf, unsigned samples)
 {
-   mod = fft_complex_mul(mod, *b);
-   *b  = fft_complex_sub(*a, mod);
-   *a  = fft_complex_add(*a, mod);
+   unsigned i;
+   for (i = 0; i < samples; i += 2)
+   {
+      fft_complex_t a = buf[i];
+      buf[i]          = fft_complex_add(a, buf[i + 1]);
+      buf[i + 1]      = fft_complex_sub(a, buf[i + 1]);
+   }
 }
 
-static void butterflies(fft_complex_t *butterfly_buf,
-      const fft_complex_t *phase_lut,
-      int phase_dir, unsigned step_size, unsigned samples)
+static void butterflies_radix4_c(fft_complex_t *buf,
+      const fft_complex_t *w1, const fft_complex_t *w2,
+      float dir, unsigned s, unsigned samples)
 {
-   unsigned i, j;
-   for (i = 0; i < samples; i += step_size << 1)
+   unsigned i, k;
+   for (i = 0; i < samples; i += s << 2)
    {
-      int phase_step = (int)samples * phase_dir / (int)step_size;
-      for (j = i; j < i + step_size; j++)
-         butterfly(&butterfly_buf[j], &butterfly_buf[j + step_size],
-               phase_lut[phase_step * (int)(j - i)]);
+      for (k = 0; k < s; k++)
+      {
+         fft_complex_t b0, b1, b2, b3, t;
+         fft_complex_t *a = buf + i + k;
+
+         t      = fft_complex_mul(w1[k], a[s]);
+         b0     = fft_complex_add(a[0], t);
+         b1     = fft_complex_sub(a[0], t);
+         t      = fft_complex_mul(w1[k], a[3 * s]);
+         b2     = fft_complex_add(a[2 * s], t);
+         b3     = fft_complex_sub(a[2 * s], t);
+
+         t      = fft_complex_mul(w2[k], b2);
+         a[0]     = fft_complex_add(b0, t);
+         a[2 * s] = fft_complex_sub(b0, t);
+
+         /* W2[k + s] is W2[k] rotated by a quarter turn. */
+         t      = fft_complex_mul(w2[k], b3);
+         b3.real  = -dir * t.imag;
+         b3.imag  =  dir * t.real;
+         a[s]     = fft_complex_add(b1, b3);
+         a[3 * s] = fft_complex_sub(b1, b3);
+      }
    }
 }
 
-void fft_process_forward_complex(fft_t *fft,
-      fft_complex_t *out, const fft_complex_t *in, unsigned step)
+#if defined(FFT_SSE)
+/* Two interleaved complex numbers per register. */
+static INLINE __m128 fft_cmul_sse(__m128 a, __m128 b)
 {
-   unsigned step_size;
-   unsigned samples = fft->size;
-   interleave_complex(fft->bitinverse_buffer, out, in, samples, step);
+   const __m128 sign = _mm_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+   __m128 ar         = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 0, 0));
+   __m128 ai         = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 1, 1));
+   __m128 bs         = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1));
+   return _mm_add_ps(_mm_mul_ps(ar, b),
+         _mm_xor_ps(_mm_mul_ps(ai, bs), sign));
+}
 
-   for (step_size = 1; step_size < samples; step_size <<= 1)
+static void butterflies_radix4(fft_complex_t *buf,
+      const fft_complex_t *w1, const fft_complex_t *w2,
+      float dir, unsigned s, unsigned samples)
+{
+   unsigned i, k;
+   __m128 rot;
+
+   if (s < 2)
    {
-      butterflies(out,
-            fft->phase_lut + samples,
-            -1, step_size, samples);
+      butterflies_radix4_c(buf, w1, w2, dir, s, samples);
+      return;
+   }
+
+   rot = dir < 0.0f
+      ? _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f)
+      : _mm_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+
+   for (i = 0; i < samples; i += s << 2)
+   {
+      for (k = 0; k < s; k += 2)
+      {
+         float *a0  = (float*)(buf + i + k);
+         float *a1  = a0 + 2 * s;
+         float *a2  = a1 + 2 * s;
+         float *a3  = a2 + 2 * s;
+         __m128 tw1 = _mm_loadu_ps((const float*)(w1 + k));
+         __m128 tw2 = _mm_loadu_ps((const float*)(w2 + k));
+         __m128 x0  = _mm_loadu_ps(a0);
+         __m128 t   = fft_cmul_sse(tw1, _mm_loadu_ps(a1));
+         __m128 b0  = _mm_add_ps(x0, t);
+         __m128 b1  = _mm_sub_ps(x0, t);
+         __m128 x2  = _mm_loadu_ps(a2);
+         __m128 b2, b3;
+
+         t          = fft_cmul_sse(tw1, _mm_loadu_ps(a3));
+         b2         = _mm_add_ps(x2, t);
+         b3         = _mm_sub_ps(x2, t);
+
+         t          = fft_cmul_sse(tw2, b2);
+         _mm_storeu_ps(a0, _mm_add_ps(b0, t));
+         _mm_storeu_ps(a2, _mm_sub_ps(b0, t));
+
+         t          = fft_cmul_sse(tw2, b3);
+         t          = _mm_xor_ps(
+               _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 3, 0, 1)), rot);
+         _mm_storeu_ps(a1, _mm_add_ps(b1, t));
+         _mm_storeu_ps(a3, _mm_sub_ps(b1, t));
+      }
    }
 }
 
-void fft_process_forward(fft_t *fft,
-      fft_complex_t *out, const float *in, unsigned step)
+static void complex_multiply(fft_complex_t *out,
+      const fft_complex_t *a, const fft_complex_t *b,
+      unsigned samples, bool accumulate)
 {
-   unsigned step_size;
-   unsigned samples = fft->size;
-   interleave_float(fft->bitinverse_buffer, out, in, samples, step);
+   unsigned i;
+   for (i = 0; i + 2 <= samples; i += 2)
+   {
+      __m128 p = fft_cmul_sse(_mm_loadu_ps((const float*)(a + i)),
+            _mm_loadu_ps((const float*)(b + i)));
+      if (accumulate)
+         p = _mm_add_ps(p, _mm_loadu_ps((const float*)(out + i)));
+      _mm_storeu_ps((float*)(out + i), p);
+   }
+
+   for (; i < samples; i++)
+   {
+      fft_complex_t p = fft_complex_mul(a[i], b[i]);
+      out[i]          = accumulate ? fft_complex_add(out[i], p) : p;
+   }
+}
+#elif defined(FFT_NEON)
+static INLINE float32x4_t fft_cmul_neon(float32x4_t a, float32x4_t b)
+{
+   static const float sign[4] = { -1.0f, 1.0f, -1.0f, 1.0f };
+   float32x4x2_t     t        = vtrnq_f32(a, a);
+   return vmlaq_f32(vmulq_f32(t.val[0], b),
+         vmulq_f32(t.val[1], vld1q_f32(sign)), vrev64q_f32(b));
+}
+
+static void butterflies_radix4(fft_complex_t *buf,
+      const fft_complex_t *w1, const fft_complex_t *w2,
+      float dir, unsigned s, unsigned samples)
+{
+   unsigned i, k;
+   float32x4_t rot;
+
+   if (s < 2)
+   {
+      butterflies_radix4_c(buf, w1, w2, dir, s, samples);
+      return;
+   }
+
+   {
+      const float rot_lanes[4] = { -dir, dir, -dir, dir };
+      rot = vld1q_f32(rot_lanes);
+   }
+
+   for (i = 0; i < samples; i += s << 2)
+   {
+      for (k = 0; k < s; k += 2)
+      {
+         float *a0       = (float*)(buf + i + k);
+         float *a1       = a0 + 2 * s;
+         float *a2       = a1 + 2 * s;
+         float *a3       = a2 + 2 * s;
+         float32x4_t tw1 = vld1q_f32((const float*)(w1 + k));
+         float32x4_t tw2 = vld1q_f32((const float*)(w2 + k));
+         float32x4_t x0  = vld1q_f32(a0);
+         float32x4_t t   = fft_cmul_neon(tw1, vld1q_f32(a1));
+         float32x4_t b0  = vaddq_f32(x0, t);
+         float32x4_t b1  = vsubq_f32(x0, t);
+         float32x4_t x2  = vld1q_f32(a2);
+         float32x4_t b2, b3;
+
+         t               = fft_cmul_neon(tw1, vld1q_f32(a3));
+         b2              = vaddq_f32(x2, t);
+         b3              = vsubq_f32(x2, t);
+
+         t               = fft_cmul_neon(tw2, b2);
+         vst1q_f32(a0, vaddq_f32(b0, t));
+         vst1q_f32(a2, vsubq_f32(b0, t));
+
+         t               = fft_cmul_neon(tw2, b3);
+         t               = vmulq_f32(vrev64q_f32(t), rot);
+         vst1q_f32(a1, vaddq_f32(b1, t));
+         vst1q_f32(a3, vsubq_f32(b1, t));
+      }
+   }
+}
+
+static void complex_multiply(fft_complex_t *out,
+      const fft_complex_t *a, const fft_complex_t *b,
+      unsigned samples, bool accumulate)
+{
+   unsigned i;
+   for (i = 0; i + 2 <= samples; i += 2)
+   {
+      float32x4_t p = fft_cmul_neon(vld1q_f32((const float*)(a + i)),
+            vld1q_f32((const float*)(b + i)));
+      if (accumulate)
+         p = vaddq_f32(p, vld1q_f32((const float*)(out + i)));
+      vst1q_f32((float*)(out + i), p);
+   }
+
+   for (; i < samples; i++)
+   {
+      fft_complex_t p = fft_complex_mul(a[i], b[i]);
+      out[i]          = accumulate ? fft_complex_add(out[i], p) : p;
+   }
+}
+#else
+static void butterflies_radix4(fft_complex_t *buf,
+      const fft_complex_t *w1, const fft_complex_t *w2,
+      float dir, unsigned s, unsigned samples)
+{
+   butterflies_radix4_c(buf, w1, w2, dir, s, samples);
+}
 
-   for (step_size = 1; step_size < fft->size; step_size <<= 1)
+static void complex_multiply(fft_complex_t *out,
+      const fft_complex_t *a, const fft_complex_t *b,
+      unsigned samples, bool accumulate)
+{
+   unsigned i;
+   for (i = 0; i < samples; i++)
    {
-      butterflies(out,
-            fft->phase_lut + samples,
-            -1, step_size, samples);
+      fft_complex_t p = fft_complex_mul(a[i], b[i]);
+      out[i]          = accumulate ? fft_complex_add(out[i], p) : p;
    }
 }
+#endif
+
+static void butterfly_passes(fft_t *fft, fft_complex_t *buf, int dir)
+{
+   unsigned s               = 1;
+   unsigned samples         = fft->size;
+   const fft_complex_t *tw  = (dir < 0)
+      ? fft->twiddle_forward : fft->twiddle_inverse;
+
+   if (fft->size_log2 & 1)
+   {
+      butterflies_radix2(buf, samples);
+      s = 2;
+   }
+
+   for (; s < samples; s <<= 2)
+   {
+      butterflies_radix4(buf, tw, tw + s, (float)dir, s, samples);
+      tw += 2 * s;
+   }
+}
+
+void fft_process_forward_complex(fft_t *fft,
+      fft_complex_t *out, const fft_complex_t *in, unsigned step)
+{
+   interleave_complex(fft->bitinverse_buffer, out, in, fft->size, step);
+   butterfly_passes(fft, out, -1);
+}
+
+void fft_process_forward(fft_t *fft,
+      fft_complex_t *out, const float *in, unsigned step)
+{
+   interleave_float(fft->bitinverse_buffer, out, in, fft->size, step);
+   butterfly_passes(fft, out, -1);
+}
 
 void fft_process_inverse(fft_t *fft,
       float *out, const fft_complex_t *in, unsigned step)
 {
-   unsigned step_size;
    unsigned samples = fft->size;
 
    interleave_complex(fft->bitinverse_buffer, fft->interleave_buffer,
          in, samples, 1);
-
-   for (step_size = 1; step_size < samples; step_size <<= 1)
-   {
-      butterflies(fft->interleave_buffer,
-            fft->phase_lut + samples,
-            1, step_size, samples);
-   }
-
+   butterfly_passes(fft, fft->interleave_buffer, 1);
    resolve_float(out, fft->interleave_buffer, samples, 1.0f / samples, step);
 }
 
+void fft_complex_multiply(fft_complex_t *out,
+      const fft_complex_t *a, const fft_complex_t *b, unsigned samples)
+{
+   complex_multiply(out, a, b, samples, false);
+}
+
+void fft_complex_multiply_accumulate(fft_complex_t *out,
+      const fft_complex_t *a, const fft_complex_t *b, unsigned samples)
+{
+   complex_multiply(out, a, b, samples, true);
+}
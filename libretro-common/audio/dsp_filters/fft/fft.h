@@ -23,6 +23,7 @@
 #ifndef RARCH_FFT_H__
 #define RARCH_FFT_H__
 
+#include <boolean.h>
 #include <retro_inline.h>
 #include <math/complex.h>
 
@@ -41,6 +42,13 @@ void fft_process_forward(fft_t *fft,
 void fft_process_inverse(fft_t *fft,
       float *out, const fft_complex_t *in, unsigned step);
 
+/* out[i] = a[i] * b[i]. out may alias a or b. */
+void fft_complex_multiply(fft_complex_t *out,
+      const fft_complex_t *a, const fft_complex_t *b, unsigned samples);
+
+/* out[i] += a[i] * b[i]. */
+void fft_complex_multiply_accumulate(fft_complex_t *out,
+      const fft_complex_t *a, const fft_complex_t *b, unsigned samples);
 
 #endif
 
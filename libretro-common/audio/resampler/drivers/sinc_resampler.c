@@ -38,7 +38,26 @@
 #include <xmmintrin.h>
 #endif
 
+/* AVX kernels are compiled into x86 builds even when the compiler does
+ * not target AVX, and picked at runtime from the CPU feature mask. */
 #if defined(__AVX__)
+#define SINC_HAVE_AVX
+#define SINC_TARGET_AVX
+#elif defined(__SSE__) && (defined(__x86_64__) || defined(__i386__)) \
+   && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define SINC_HAVE_AVX
+#define SINC_TARGET_AVX __attribute__((target("avx")))
+#endif
+
+#if defined(__AVX2__) && defined(__FMA__)
+#define SINC_HAVE_AVX2_FMA
+#define SINC_TARGET_AVX2_FMA
+#elif defined(SINC_HAVE_AVX) && !defined(__AVX__)
+#define SINC_HAVE_AVX2_FMA
+#define SINC_TARGET_AVX2_FMA __attribute__((target("avx2,fma")))
+#endif
+
+#if defined(SINC_HAVE_AVX)
 #include <immintrin.h>
 #endif
 
@@ -52,6 +71,22 @@
 
 /* TODO, make all this more configurable. */
 
+/* Fixed-ratio polyphase path.
+ *
+ * While the ratio passed to process stays constant and is a fraction
+ * up/down with up <= SINC_POLY_MAX_PHASES, every output lands on one of
+ * 'up' exact phases. Those get their own precomputed filters, which
+ * removes the per-sample subphase interpolation and shrinks the table
+ * the inner loop walks. A ratio only has to match the fraction within
+ * SINC_POLY_TOLERANCE (1 ppm), well inside crystal clock tolerances. */
+#define SINC_POLY_MAX_PHASES   1024
+#define SINC_POLY_MAX_DOWN     (1 << 16)
+#define SINC_POLY_MAX_ELEMS    (1 << 18)
+#define SINC_POLY_TOLERANCE    1e-6
+/* Calls in a row with the same ratio before building a table for it;
+ * keeps dynamic rate control on the general path. */
+#define SINC_POLY_SETTLE_CALLS 4
+
 enum sinc_window
 {
    SINC_WINDOW_NONE   = 0,
@@ -65,6 +100,11 @@ enum sinc_window
  * of sinc taps, the AVX code is clearly faster than SSE1.
  */
 
+typedef void (*sinc_dot_t)(float *out, const float *left,
+      const float *right, const float *coeff, unsigned taps);
+
+struct rarch_sinc_resampler;
+
 typedef struct rarch_sinc_resampler
 {
    unsigned enable_avx;
@@ -85,6 +125,25 @@ typedef struct rarch_sinc_resampler
    float *phase_table;
    float *buffer_l;
    float *buffer_r;
+
+   /* General variable-ratio path, picked for the CPU at init */
+   void (*process)(void *re_, struct resampler_data *data);
+
+   /* Fixed-ratio polyphase state */
+   void (*process_poly)(struct rarch_sinc_resampler *resamp,
+         struct resampler_data *data);
+   float *poly_table;
+   double cutoff;
+   double poly_ratio;
+   double pending_ratio;
+   unsigned pending_count;
+   unsigned poly_up;
+   unsigned poly_down;
+   uint32_t poly_time;
+   /* Position below 1 / poly_up, in general path time units; kept so
+    * that switching paths back and forth does not drift. */
+   uint32_t poly_rem;
+   bool poly_active;
 } rarch_sinc_resampler_t;
 
 #if defined(__ARM_NEON__)
@@ -149,8 +208,9 @@ static void resampler_sinc_process_neon(void *re_, struct resampler_data *data)
 }
 #endif
 
-#if defined(__AVX__)
-static void resampler_sinc_process_avx(void *re_, struct resampler_data *data)
+#if defined(SINC_HAVE_AVX)
+static SINC_TARGET_AVX void resampler_sinc_process_avx(
+      void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
    unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
@@ -183,7 +243,7 @@ static void resampler_sinc_process_avx(void *re_, struct resampler_data *data)
       while (resamp->time < phases)
       {
          unsigned i;
-         __m256 delta, sum_l, sum_r;
+         __m256 delta, sum_l, sum_r, res_l, res_r;
          float *delta_table       = NULL;
          float *phase_table       = NULL;
          const float *buffer_l    = resamp->buffer_l + resamp->ptr;
@@ -227,8 +287,8 @@ static void resampler_sinc_process_avx(void *re_, struct resampler_data *data)
 
          /* hadd on AVX is weird, and acts on low-lanes
           * and high-lanes separately. */
-         __m256 res_l = _mm256_hadd_ps(sum_l, sum_l);
-         __m256 res_r = _mm256_hadd_ps(sum_r, sum_r);
+         res_l        = _mm256_hadd_ps(sum_l, sum_l);
+         res_r        = _mm256_hadd_ps(sum_r, sum_r);
          res_l        = _mm256_hadd_ps(res_l, res_l);
          res_r        = _mm256_hadd_ps(res_r, res_r);
          res_l        = _mm256_add_ps(_mm256_permute2f128_ps(res_l, res_l, 1), res_l);
@@ -444,10 +504,354 @@ static void resampler_sinc_free(void *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)data;
    if (resamp)
+   {
       memalign_free(resamp->main_buffer);
+      if (resamp->poly_table)
+         memalign_free(resamp->poly_table);
+   }
    free(resamp);
 }
 
+static INLINE void sinc_dot_c(float *out, const float *left,
+      const float *right, const float *coeff, unsigned taps)
+{
+   unsigned i;
+   float sum_l = 0.0f;
+   float sum_r = 0.0f;
+
+   for (i = 0; i < taps; i++)
+   {
+      sum_l += left[i]  * coeff[i];
+      sum_r += right[i] * coeff[i];
+   }
+
+   out[0] = sum_l;
+   out[1] = sum_r;
+}
+
+#if defined(__SSE__)
+static INLINE void sinc_store_sse(float *out, __m128 sum_l, __m128 sum_r)
+{
+   /* Same reduction as resampler_sinc_process_sse. */
+   __m128 sum = _mm_add_ps(_mm_shuffle_ps(sum_l, sum_r,
+            _MM_SHUFFLE(1, 0, 1, 0)),
+         _mm_shuffle_ps(sum_l, sum_r, _MM_SHUFFLE(3, 2, 3, 2)));
+
+   sum = _mm_add_ps(_mm_shuffle_ps(sum, sum, _MM_SHUFFLE(3, 3, 1, 1)), sum);
+
+   _mm_store_ss(out + 0, sum);
+   _mm_store_ss(out + 1, _mm_movehl_ps(sum, sum));
+}
+
+static INLINE void sinc_dot_sse(float *out, const float *left,
+      const float *right, const float *coeff, unsigned taps)
+{
+   unsigned i;
+   __m128 sum_l = _mm_setzero_ps();
+   __m128 sum_r = _mm_setzero_ps();
+
+   for (i = 0; i < taps; i += 4)
+   {
+      __m128 c = _mm_load_ps(coeff + i);
+      sum_l    = _mm_add_ps(sum_l, _mm_mul_ps(_mm_loadu_ps(left + i), c));
+      sum_r    = _mm_add_ps(sum_r, _mm_mul_ps(_mm_loadu_ps(right + i), c));
+   }
+
+   sinc_store_sse(out, sum_l, sum_r);
+}
+#endif
+
+#if defined(SINC_HAVE_AVX2_FMA)
+/* Taps are a multiple of 4, but only a multiple of 8 when the AVX
+ * general path is in use, hence the 4-wide tail. */
+static INLINE SINC_TARGET_AVX2_FMA void sinc_dot_avx2_fma(float *out,
+      const float *left, const float *right, const float *coeff,
+      unsigned taps)
+{
+   unsigned i   = 0;
+   __m256 acc_l = _mm256_setzero_ps();
+   __m256 acc_r = _mm256_setzero_ps();
+   __m128 sum_l, sum_r, sum;
+
+   for (; i + 8 <= taps; i += 8)
+   {
+      __m256 c = _mm256_loadu_ps(coeff + i);
+      acc_l    = _mm256_fmadd_ps(_mm256_loadu_ps(left + i),  c, acc_l);
+      acc_r    = _mm256_fmadd_ps(_mm256_loadu_ps(right + i), c, acc_r);
+   }
+
+   sum_l = _mm_add_ps(_mm256_castps256_ps128(acc_l),
+         _mm256_extractf128_ps(acc_l, 1));
+   sum_r = _mm_add_ps(_mm256_castps256_ps128(acc_r),
+         _mm256_extractf128_ps(acc_r, 1));
+
+   if (i < taps)
+   {
+      __m128 c = _mm_loadu_ps(coeff + i);
+      sum_l    = _mm_fmadd_ps(_mm_loadu_ps(left + i),  c, sum_l);
+      sum_r    = _mm_fmadd_ps(_mm_loadu_ps(right + i), c, sum_r);
+   }
+
+   sum = _mm_add_ps(_mm_shuffle_ps(sum_l, sum_r,
+            _MM_SHUFFLE(1, 0, 1, 0)),
+         _mm_shuffle_ps(sum_l, sum_r, _MM_SHUFFLE(3, 2, 3, 2)));
+   sum = _mm_add_ps(_mm_shuffle_ps(sum, sum, _MM_SHUFFLE(3, 3, 1, 1)), sum);
+
+   _mm_store_ss(out + 0, sum);
+   _mm_store_ss(out + 1, _mm_movehl_ps(sum, sum));
+}
+
+static bool sinc_cpu_has_avx2_fma(resampler_simd_mask_t mask)
+{
+   if (!(mask & RESAMPLER_SIMD_AVX2))
+      return false;
+#if defined(__FMA__)
+   return true;
+#else
+   /* The feature mask has no FMA bit. */
+   return __builtin_cpu_supports("fma");
+#endif
+}
+#endif
+
+/* Finds up/down close enough to ratio with the smallest 'up', walking
+ * the continued fraction convergents. */
+static bool sinc_find_fraction(double ratio, unsigned *up, unsigned *down)
+{
+   unsigned i;
+   double x    = ratio;
+   uint64_t p0 = 0;
+   uint64_t q0 = 1;
+   uint64_t p1 = 1;
+   uint64_t q1 = 0;
+
+   for (i = 0; i < 32; i++)
+   {
+      double a    = floor(x);
+      uint64_t p2 = (uint64_t)a * p1 + p0;
+      uint64_t q2 = (uint64_t)a * q1 + q0;
+
+      if (p2 > SINC_POLY_MAX_PHASES || q2 > SINC_POLY_MAX_DOWN)
+         break;
+
+      p0 = p1;
+      q0 = q1;
+      p1 = p2;
+      q1 = q2;
+
+      if (p1 && fabs((double)p1 / q1 - ratio) <= ratio * SINC_POLY_TOLERANCE)
+      {
+         *up   = (unsigned)p1;
+         *down = (unsigned)q1;
+         return true;
+      }
+
+      if (x - a < 1e-12)
+         break;
+      x = 1.0 / (x - a);
+   }
+
+   return false;
+}
+
+/* Evaluates the filter at the exact fractional positions p / phases,
+ * laid out like the general table so both paths share delay lines. */
+static void sinc_init_table_poly(rarch_sinc_resampler_t *resamp,
+      float *table, unsigned phases)
+{
+   unsigned p, j;
+   unsigned taps     = resamp->taps;
+   double sidelobes  = taps / 2.0;
+   double cutoff     = resamp->cutoff;
+   double window_mod = (resamp->window_type == SINC_WINDOW_KAISER)
+      ? kaiser_window_function(0.0, resamp->kaiser_beta)
+      : lanzcos_window_function(0.0);
+
+   for (p = 0; p < phases; p++)
+   {
+      for (j = 0; j < taps; j++)
+      {
+         double window_phase = 2.0 * (j + (double)p / phases) / taps - 1.0;
+         double sinc_phase   = sidelobes * window_phase;
+         double window       = (resamp->window_type == SINC_WINDOW_KAISER)
+            ? kaiser_window_function(window_phase, resamp->kaiser_beta)
+            : lanzcos_window_function(window_phase);
+
+         table[p * taps + j] = cutoff * sinc(M_PI * sinc_phase * cutoff)
+            * window / window_mod;
+      }
+   }
+}
+
+static bool resampler_sinc_poly_build(rarch_sinc_resampler_t *resamp,
+      double ratio)
+{
+   unsigned up    = 0;
+   unsigned down  = 0;
+   float *table   = NULL;
+
+   if (!sinc_find_fraction(ratio, &up, &down))
+      return false;
+
+   if ((size_t)up * resamp->taps > SINC_POLY_MAX_ELEMS)
+      return false;
+
+   table = (float*)memalign_alloc(128, sizeof(float) * up * resamp->taps);
+   if (!table)
+      return false;
+
+   sinc_init_table_poly(resamp, table, up);
+
+   /* Keep the stream position when swapping tables mid-stream. */
+   if (resamp->poly_active)
+   {
+      unsigned bits      = resamp->phase_bits + resamp->subphase_bits;
+      uint64_t pos       = ((((uint64_t)resamp->poly_time << bits)
+               + resamp->poly_rem) * up) / resamp->poly_up;
+      resamp->poly_time  = (uint32_t)(pos >> bits);
+      resamp->poly_rem   = (uint32_t)(pos & ((1 << bits) - 1));
+   }
+
+   if (resamp->poly_table)
+      memalign_free(resamp->poly_table);
+
+   resamp->poly_table    = table;
+   resamp->poly_ratio    = ratio;
+   resamp->poly_up       = up;
+   resamp->poly_down     = down;
+   return true;
+}
+
+/* Returns true when the polyphase path can run at this ratio. */
+static bool resampler_sinc_poly_update(rarch_sinc_resampler_t *resamp,
+      double ratio)
+{
+   if (resamp->poly_table && ratio == resamp->poly_ratio)
+      return true;
+
+   if (ratio != resamp->pending_ratio)
+   {
+      resamp->pending_ratio = ratio;
+      resamp->pending_count = 0;
+      return false;
+   }
+
+   /* Try each stable ratio once. */
+   if (resamp->pending_count < SINC_POLY_SETTLE_CALLS
+         && ++resamp->pending_count == SINC_POLY_SETTLE_CALLS)
+      return resampler_sinc_poly_build(resamp, ratio);
+
+   return false;
+}
+
+/* Instantiated once per dot product kernel so that the kernel is
+ * inlined into the loop. */
+static INLINE void resampler_sinc_process_poly(rarch_sinc_resampler_t *resamp,
+      struct resampler_data *data, sinc_dot_t dot)
+{
+   unsigned up                    = resamp->poly_up;
+   unsigned down                  = resamp->poly_down;
+   unsigned taps                  = resamp->taps;
+   const float *input             = data->data_in;
+   float *output                  = data->data_out;
+   size_t frames                  = data->input_frames;
+   size_t out_frames              = 0;
+
+   if (!resamp->poly_active)
+   {
+      unsigned bits       = resamp->phase_bits + resamp->subphase_bits;
+      uint64_t pos        = (uint64_t)resamp->time * up;
+      resamp->poly_time   = (uint32_t)(pos >> bits);
+      resamp->poly_rem    = (uint32_t)(pos & ((1 << bits) - 1));
+      resamp->poly_active = true;
+   }
+
+   while (frames)
+   {
+      while (frames && resamp->poly_time >= up)
+      {
+         /* Push in reverse to make filter more obvious. */
+         if (!resamp->ptr)
+            resamp->ptr = resamp->taps;
+         resamp->ptr--;
+
+         resamp->buffer_l[resamp->ptr + resamp->taps] =
+         resamp->buffer_l[resamp->ptr]                = *input++;
+
+         resamp->buffer_r[resamp->ptr + resamp->taps] =
+         resamp->buffer_r[resamp->ptr]                = *input++;
+
+         resamp->poly_time                           -= up;
+         frames--;
+      }
+
+      while (resamp->poly_time < up)
+      {
+         dot(output,
+               resamp->buffer_l + resamp->ptr,
+               resamp->buffer_r + resamp->ptr,
+               resamp->poly_table + resamp->poly_time * taps, taps);
+
+         output += 2;
+         out_frames++;
+         resamp->poly_time += down;
+      }
+   }
+
+   data->output_frames = out_frames;
+}
+
+static void resampler_sinc_process_poly_c(rarch_sinc_resampler_t *resamp,
+      struct resampler_data *data)
+{
+   resampler_sinc_process_poly(resamp, data, sinc_dot_c);
+}
+
+#if defined(__SSE__)
+static void resampler_sinc_process_poly_sse(rarch_sinc_resampler_t *resamp,
+      struct resampler_data *data)
+{
+   resampler_sinc_process_poly(resamp, data, sinc_dot_sse);
+}
+#endif
+
+#if defined(SINC_HAVE_AVX2_FMA)
+static SINC_TARGET_AVX2_FMA void resampler_sinc_process_poly_avx2_fma(
+      rarch_sinc_resampler_t *resamp, struct resampler_data *data)
+{
+   resampler_sinc_process_poly(resamp, data, sinc_dot_avx2_fma);
+}
+#endif
+
+#if defined(WANT_NEON)
+static void resampler_sinc_process_poly_neon(rarch_sinc_resampler_t *resamp,
+      struct resampler_data *data)
+{
+   resampler_sinc_process_poly(resamp, data, process_sinc_neon_asm);
+}
+#endif
+
+static void resampler_sinc_process(void *re_, struct resampler_data *data)
+{
+   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
+
+   if (resampler_sinc_poly_update(resamp, data->ratio))
+   {
+      resamp->process_poly(resamp, data);
+      return;
+   }
+
+   if (resamp->poly_active)
+   {
+      unsigned bits       = resamp->phase_bits + resamp->subphase_bits;
+      resamp->time        = (uint32_t)((((uint64_t)resamp->poly_time << bits)
+               + resamp->poly_rem) / resamp->poly_up);
+      resamp->poly_active = false;
+   }
+
+   resamp->process(resamp, data);
+}
+
 static void sinc_init_table_kaiser(rarch_sinc_resampler_t *resamp,
       double cutoff,
       float *phase_table, int phases, int taps, bool calculate_delta)
@@ -571,6 +975,7 @@ static void *resampler_sinc_new(const struct resampler_config *config,
    size_t phase_elems             = 0;
    size_t elems                   = 0;
    unsigned sidelobes             = 0;
+   bool use_avx                   = false;
    rarch_sinc_resampler_t *re     = (rarch_sinc_resampler_t*)
       calloc(1, sizeof(*re));
 
@@ -639,12 +1044,14 @@ static void *resampler_sinc_new(const struct resampler_config *config,
       re->taps = (unsigned)ceil(re->taps / bandwidth_mod);
    }
 
+#if defined(SINC_HAVE_AVX)
+   use_avx         = re->enable_avx && (mask & RESAMPLER_SIMD_AVX);
+#endif
+
    /* Be SIMD-friendly. */
-#if defined(__AVX__)
-   if (re->enable_avx)
-      re->taps  = (re->taps + 7) & ~7;
+   if (use_avx)
+      re->taps     = (re->taps + 7) & ~7;
    else
-#endif
    {
 #if defined(WANT_NEON)
       re->taps     = (re->taps + 7) & ~7;
@@ -653,6 +1060,8 @@ static void *resampler_sinc_new(const struct resampler_config *config,
 #endif
    }
 
+   re->cutoff      = cutoff;
+
    phase_elems     = ((1 << re->phase_bits) * re->taps);
    if (re->window_type == SINC_WINDOW_KAISER)
       phase_elems  = phase_elems * 2;
@@ -680,27 +1089,54 @@ static void *resampler_sinc_new(const struct resampler_config *config,
          goto error;
    }
 
-   sinc_resampler.process = resampler_sinc_process_c;
+   re->process      = resampler_sinc_process_c;
+   re->process_poly = resampler_sinc_process_poly_c;
 
-   if (mask & RESAMPLER_SIMD_AVX && re->enable_avx)
+   if (use_avx)
    {
-#if defined(__AVX__)
-      sinc_resampler.process = resampler_sinc_process_avx;
+#if defined(SINC_HAVE_AVX)
+      re->process = resampler_sinc_process_avx;
 #endif
    }
    else if (mask & RESAMPLER_SIMD_SSE)
    {
 #if defined(__SSE__)
-      sinc_resampler.process = resampler_sinc_process_sse;
+      re->process = resampler_sinc_process_sse;
 #endif
    }
    else if (mask & RESAMPLER_SIMD_NEON && re->window_type != SINC_WINDOW_KAISER)
    {
 #if defined(WANT_NEON)
-      sinc_resampler.process = resampler_sinc_process_neon;
+      re->process = resampler_sinc_process_neon;
+#endif
+   }
+
+   /* As with the general path, 8-wide kernels only pay off with the
+    * long filters of the higher quality levels. */
+#if defined(SINC_HAVE_AVX2_FMA)
+   if (re->enable_avx && sinc_cpu_has_avx2_fma(mask))
+      re->process_poly = resampler_sinc_process_poly_avx2_fma;
+   else
+#endif
+   if (mask & RESAMPLER_SIMD_SSE)
+   {
+#if defined(__SSE__)
+      re->process_poly = resampler_sinc_process_poly_sse;
+#endif
+   }
+   else if (mask & RESAMPLER_SIMD_NEON)
+   {
+#if defined(WANT_NEON)
+      re->process_poly = resampler_sinc_process_poly_neon;
 #endif
    }
 
+   /* Callers pass the nominal ratio as bandwidth_mod, so the fixed-ratio
+    * table can be ready before the first process call. */
+   re->pending_ratio = bandwidth_mod;
+   re->pending_count = SINC_POLY_SETTLE_CALLS;
+   resampler_sinc_poly_build(re, bandwidth_mod);
+
    return re;
 
 error:
@@ -710,7 +1146,7 @@ error:
 
 retro_resampler_t sinc_resampler = {
    resampler_sinc_new,
-   resampler_sinc_process_c,
+   resampler_sinc_process,
    resampler_sinc_free,
    RESAMPLER_API_VERSION,
    "sinc",
@@ -37,6 +37,21 @@
 
 #include "rpng_internal.h"
 
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define RPNG_NEON
+#endif
+
+#ifdef RPNG_NO_SIMD
+#undef __SSE2__
+#undef RPNG_NEON
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(RPNG_NEON)
+#include <arm_neon.h>
+#endif
+
 enum png_ihdr_color_type
 {
    PNG_IHDR_COLOR_GRAY       = 0,
@@ -78,6 +93,7 @@ struct idat_buffer
 {
    uint8_t *data;
    size_t size;
+   size_t capacity;
 };
 
 struct png_chunk
@@ -231,11 +247,29 @@ end:
 static void png_reverse_filter_copy_line_rgb(uint32_t *data,
       const uint8_t *decoded, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
 
    bpp /= 8;
 
-   for (i = 0; i < width; i++)
+#if defined(RPNG_NEON)
+   if (bpp == 1)
+   {
+      for (; i + 16 <= width; i += 16, decoded += 48)
+      {
+         uint8x16x4_t res;
+         uint8x16x3_t in = vld3q_u8(decoded);
+
+         res.val[0]      = in.val[2];
+         res.val[1]      = in.val[1];
+         res.val[2]      = in.val[0];
+         res.val[3]      = vdupq_n_u8(0xff);
+
+         vst4q_u8((uint8_t*)(data + i), res);
+      }
+   }
+#endif
+
+   for (; i < width; i++)
    {
       uint32_t r, g, b;
 
@@ -252,11 +286,45 @@ static void png_reverse_filter_copy_line_rgb(uint32_t *data,
 static void png_reverse_filter_copy_line_rgba(uint32_t *data,
       const uint8_t *decoded, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
 
    bpp /= 8;
 
-   for (i = 0; i < width; i++)
+   /* With 8-bit channels this is just an R/B swap. */
+#if defined(__SSE2__)
+   if (bpp == 1)
+   {
+      const __m128i mask_ag = _mm_set1_epi32((int)0xff00ff00);
+      const __m128i mask_r  = _mm_set1_epi32(0x00ff0000);
+      const __m128i mask_b  = _mm_set1_epi32(0x000000ff);
+
+      for (; i + 4 <= width; i += 4, decoded += 16)
+      {
+         const __m128i in = _mm_loadu_si128((const __m128i*)decoded);
+         __m128i ag       = _mm_and_si128(in, mask_ag);
+         __m128i r        = _mm_and_si128(_mm_slli_epi32(in, 16), mask_r);
+         __m128i b        = _mm_and_si128(_mm_srli_epi32(in, 16), mask_b);
+         _mm_storeu_si128((__m128i*)(data + i),
+               _mm_or_si128(ag, _mm_or_si128(r, b)));
+      }
+   }
+#elif defined(RPNG_NEON)
+   if (bpp == 1)
+   {
+      for (; i + 16 <= width; i += 16, decoded += 64)
+      {
+         uint8x16x4_t in = vld4q_u8(decoded);
+         uint8x16_t tmp  = in.val[0];
+
+         in.val[0]       = in.val[2];
+         in.val[2]       = tmp;
+
+         vst4q_u8((uint8_t*)(data + i), in);
+      }
+   }
+#endif
+
+   for (; i < width; i++)
    {
       uint32_t r, g, b, a;
       r        = *decoded;
@@ -578,10 +646,281 @@ error:
    return -1;
 }
 
+#if defined(__SSE2__) || defined(RPNG_NEON)
+/* Whole-pixel loads/stores for the 3 and 4 byte per pixel
+ * unfilter kernels. Except at the end of a scanline, 3 byte
+ * pixels are moved 4 bytes at a time; the extra byte belongs
+ * to the next pixel and gets rewritten when that one is done.
+ * Both SIMD targets are little-endian. */
+static INLINE uint32_t png_load_pixel(const uint8_t *src, unsigned avail)
+{
+   uint32_t val = 0;
+   if (avail >= 4)
+      memcpy(&val, src, 4);
+   else
+      memcpy(&val, src, 3);
+   return val;
+}
+
+static INLINE void png_store_pixel(uint8_t *dst, uint32_t val, unsigned avail)
+{
+   if (avail >= 4)
+      memcpy(dst, &val, 4);
+   else
+      memcpy(dst, &val, 3);
+}
+#endif
+
+#if defined(__SSE2__)
+static INLINE void png_unfilter_sub_simd(uint8_t *out, const uint8_t *in,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   __m128i a = _mm_setzero_si128();
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned avail = (bpp == 4) ? 4 : pitch - i;
+      a = _mm_add_epi8(a,
+            _mm_cvtsi32_si128(png_load_pixel(in + i, avail)));
+      png_store_pixel(out + i, _mm_cvtsi128_si32(a), avail);
+   }
+}
+
+static INLINE void png_unfilter_avg_simd(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   const __m128i one = _mm_set1_epi8(1);
+   __m128i a         = _mm_setzero_si128();
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned avail = (bpp == 4) ? 4 : pitch - i;
+      __m128i b   = _mm_cvtsi32_si128(png_load_pixel(prev + i, avail));
+      /* pavgb rounds up, floor((a + b) / 2) needs the carry removed. */
+      __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b),
+            _mm_and_si128(_mm_xor_si128(a, b), one));
+
+      a           = _mm_add_epi8(avg,
+            _mm_cvtsi32_si128(png_load_pixel(in + i, avail)));
+      png_store_pixel(out + i, _mm_cvtsi128_si32(a), avail);
+   }
+}
+
+static INLINE void png_unfilter_paeth_simd(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   const __m128i zero = _mm_setzero_si128();
+   __m128i a          = zero;
+   __m128i c          = zero;
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned avail = (bpp == 4) ? 4 : pitch - i;
+      __m128i pa, pb, pc, mask, pred;
+      __m128i b   = _mm_unpacklo_epi8(
+            _mm_cvtsi32_si128(png_load_pixel(prev + i, avail)), zero);
+
+      /* pa = |b - c|, pb = |a - c|, pc = |a + b - 2c| */
+      pa          = _mm_sub_epi16(b, c);
+      pb          = _mm_sub_epi16(a, c);
+      pc          = _mm_add_epi16(pa, pb);
+      pa          = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+      pb          = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+      pc          = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+
+      /* Ties prefer a, then b, then c. */
+      mask        = _mm_cmpgt_epi16(pb, pc);
+      pred        = _mm_or_si128(_mm_andnot_si128(mask, b),
+            _mm_and_si128(mask, c));
+      mask        = _mm_or_si128(_mm_cmpgt_epi16(pa, pb),
+            _mm_cmpgt_epi16(pa, pc));
+      pred        = _mm_or_si128(_mm_andnot_si128(mask, a),
+            _mm_and_si128(mask, pred));
+
+      a           = _mm_unpacklo_epi8(_mm_add_epi8(
+               _mm_packus_epi16(pred, pred),
+               _mm_cvtsi32_si128(png_load_pixel(in + i, avail))), zero);
+      c           = b;
+      png_store_pixel(out + i,
+            _mm_cvtsi128_si32(_mm_packus_epi16(a, a)), avail);
+   }
+}
+#elif defined(RPNG_NEON)
+static INLINE uint8x8_t png_load_pixel_neon(const uint8_t *src, unsigned avail)
+{
+   return vreinterpret_u8_u32(vdup_n_u32(png_load_pixel(src, avail)));
+}
+
+static INLINE void png_store_pixel_neon(uint8_t *dst, uint8x8_t val, unsigned avail)
+{
+   png_store_pixel(dst, vget_lane_u32(vreinterpret_u32_u8(val), 0), avail);
+}
+
+static INLINE void png_unfilter_sub_simd(uint8_t *out, const uint8_t *in,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned avail = (bpp == 4) ? 4 : pitch - i;
+      a = vadd_u8(a, png_load_pixel_neon(in + i, avail));
+      png_store_pixel_neon(out + i, a, avail);
+   }
+}
+
+static INLINE void png_unfilter_avg_simd(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned avail = (bpp == 4) ? 4 : pitch - i;
+      a = vadd_u8(vhadd_u8(a, png_load_pixel_neon(prev + i, avail)),
+            png_load_pixel_neon(in + i, avail));
+      png_store_pixel_neon(out + i, a, avail);
+   }
+}
+
+static INLINE void png_unfilter_paeth_simd(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   int16x8_t a = vdupq_n_s16(0);
+   int16x8_t c = vdupq_n_s16(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned avail = (bpp == 4) ? 4 : pitch - i;
+      uint8x8_t res;
+      uint16x8_t mask;
+      int16x8_t pa, pb, pc, pred;
+      int16x8_t b = vreinterpretq_s16_u16(
+            vmovl_u8(png_load_pixel_neon(prev + i, avail)));
+
+      /* pa = |b - c|, pb = |a - c|, pc = |a + b - 2c| */
+      pa   = vsubq_s16(b, c);
+      pb   = vsubq_s16(a, c);
+      pc   = vabsq_s16(vaddq_s16(pa, pb));
+      pa   = vabsq_s16(pa);
+      pb   = vabsq_s16(pb);
+
+      /* Ties prefer a, then b, then c. */
+      mask = vcgtq_s16(pb, pc);
+      pred = vbslq_s16(mask, c, b);
+      mask = vorrq_u16(vcgtq_s16(pa, pb), vcgtq_s16(pa, pc));
+      pred = vbslq_s16(mask, pred, a);
+
+      res  = vadd_u8(vmovn_u16(vreinterpretq_u16_s16(pred)),
+            png_load_pixel_neon(in + i, avail));
+      a    = vreinterpretq_s16_u16(vmovl_u8(res));
+      c    = b;
+      png_store_pixel_neon(out + i, res, avail);
+   }
+}
+#endif
+
+static void png_unfilter_up(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch)
+{
+   unsigned i = 0;
+
+#if defined(__SSE2__)
+   for (; i + 16 <= pitch; i += 16)
+      _mm_storeu_si128((__m128i*)(out + i), _mm_add_epi8(
+               _mm_loadu_si128((const __m128i*)(prev + i)),
+               _mm_loadu_si128((const __m128i*)(in + i))));
+#elif defined(RPNG_NEON)
+   for (; i + 16 <= pitch; i += 16)
+      vst1q_u8(out + i, vaddq_u8(vld1q_u8(prev + i), vld1q_u8(in + i)));
+#endif
+
+   for (; i < pitch; i++)
+      out[i] = prev[i] + in[i];
+}
+
+static void png_unfilter_sub(uint8_t *out, const uint8_t *in,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+
+#if defined(__SSE2__) || defined(RPNG_NEON)
+   if (bpp == 3 || bpp == 4)
+   {
+      if (bpp == 4)
+         png_unfilter_sub_simd(out, in, pitch, 4);
+      else
+         png_unfilter_sub_simd(out, in, pitch, 3);
+      return;
+   }
+#endif
+
+   for (i = 0; i < bpp; i++)
+      out[i] = in[i];
+   for (i = bpp; i < pitch; i++)
+      out[i] = out[i - bpp] + in[i];
+}
+
+static void png_unfilter_avg(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+
+#if defined(__SSE2__) || defined(RPNG_NEON)
+   if (bpp == 3 || bpp == 4)
+   {
+      if (bpp == 4)
+         png_unfilter_avg_simd(out, in, prev, pitch, 4);
+      else
+         png_unfilter_avg_simd(out, in, prev, pitch, 3);
+      return;
+   }
+#endif
+
+   for (i = 0; i < bpp; i++)
+   {
+      uint8_t avg = prev[i] >> 1;
+      out[i] = avg + in[i];
+   }
+   for (i = bpp; i < pitch; i++)
+   {
+      uint8_t avg = (out[i - bpp] + prev[i]) >> 1;
+      out[i] = avg + in[i];
+   }
+}
+
+static void png_unfilter_paeth(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+
+#if defined(__SSE2__) || defined(RPNG_NEON)
+   if (bpp == 3 || bpp == 4)
+   {
+      if (bpp == 4)
+         png_unfilter_paeth_simd(out, in, prev, pitch, 4);
+      else
+         png_unfilter_paeth_simd(out, in, prev, pitch, 3);
+      return;
+   }
+#endif
+
+   for (i = 0; i < bpp; i++)
+      out[i] = paeth(0, prev[i], 0) + in[i];
+   for (i = bpp; i < pitch; i++)
+      out[i] = paeth(out[i - bpp], prev[i], prev[i - bpp]) + in[i];
+}
+
 static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *ihdr,
       struct rpng_process *pngp, unsigned filter)
 {
-   unsigned i;
+   uint8_t *tmp;
 
    switch (filter)
    {
@@ -589,33 +928,20 @@ static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *i
          memcpy(pngp->decoded_scanline, pngp->inflate_buf, pngp->pitch);
          break;
       case PNG_FILTER_SUB:
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] = pngp->inflate_buf[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->decoded_scanline[i - pngp->bpp] + pngp->inflate_buf[i];
+         png_unfilter_sub(pngp->decoded_scanline, pngp->inflate_buf,
+               pngp->pitch, pngp->bpp);
          break;
       case PNG_FILTER_UP:
-         for (i = 0; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->prev_scanline[i] + pngp->inflate_buf[i];
+         png_unfilter_up(pngp->decoded_scanline, pngp->inflate_buf,
+               pngp->prev_scanline, pngp->pitch);
          break;
       case PNG_FILTER_AVERAGE:
-         for (i = 0; i < pngp->bpp; i++)
-         {
-            uint8_t avg = pngp->prev_scanline[i] >> 1;
-            pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
-         }
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-         {
-            uint8_t avg = (pngp->decoded_scanline[i - pngp->bpp] + pngp->prev_scanline[i]) >> 1;
-            pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
-         }
+         png_unfilter_avg(pngp->decoded_scanline, pngp->inflate_buf,
+               pngp->prev_scanline, pngp->pitch, pngp->bpp);
          break;
       case PNG_FILTER_PAETH:
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] = paeth(0, pngp->prev_scanline[i], 0) + pngp->inflate_buf[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = paeth(pngp->decoded_scanline[i - pngp->bpp],
-                  pngp->prev_scanline[i], pngp->prev_scanline[i - pngp->bpp]) + pngp->inflate_buf[i];
+         png_unfilter_paeth(pngp->decoded_scanline, pngp->inflate_buf,
+               pngp->prev_scanline, pngp->pitch, pngp->bpp);
          break;
 
       default:
@@ -643,7 +969,10 @@ static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *i
          break;
    }
 
-   memcpy(pngp->prev_scanline, pngp->decoded_scanline, pngp->pitch);
+   /* The decoded line becomes the previous one, no need to copy. */
+   tmp                    = pngp->prev_scanline;
+   pngp->prev_scanline    = pngp->decoded_scanline;
+   pngp->decoded_scanline = tmp;
 
    return IMAGE_PROCESS_NEXT;
 }
@@ -653,25 +982,27 @@ static int png_reverse_filter_regular_iterate(uint32_t **data, const struct png_
 {
    int ret = IMAGE_PROCESS_END;
 
-   if (pngp->h < ihdr->height)
+   /* The whole image has been inflated by now, so all
+    * scanlines are reverse filtered in a single pass. */
+   while (pngp->h < ihdr->height)
    {
       unsigned filter = *pngp->inflate_buf++;
       pngp->restore_buf_size += 1;
       ret = png_reverse_filter_copy_line(*data,
             ihdr, pngp, filter);
-   }
 
-   if (ret == IMAGE_PROCESS_END || ret == IMAGE_PROCESS_ERROR_END)
-      goto end;
+      if (ret == IMAGE_PROCESS_ERROR_END)
+         goto end;
 
-   pngp->h++;
-   pngp->inflate_buf           += pngp->pitch;
-   pngp->restore_buf_size      += pngp->pitch;
+      pngp->h++;
+      pngp->inflate_buf           += pngp->pitch;
+      pngp->restore_buf_size      += pngp->pitch;
 
-   *data                       += ihdr->width;
-   pngp->data_restore_buf_size += ihdr->width;
+      *data                       += ihdr->width;
+      pngp->data_restore_buf_size += ihdr->width;
+   }
 
-   return IMAGE_PROCESS_NEXT;
+   ret = IMAGE_PROCESS_END;
 
 end:
    png_reverse_filter_deinit(pngp);
@@ -857,12 +1188,26 @@ static bool png_read_trns(uint8_t *buf, uint32_t *palette, unsigned entries)
 
 bool png_realloc_idat(const struct png_chunk *chunk, struct idat_buffer *buf)
 {
-   uint8_t *new_buffer = (uint8_t*)realloc(buf->data, buf->size + chunk->size);
+   uint8_t *new_buffer = NULL;
+   size_t capacity     = buf->capacity;
+
+   if (buf->size + chunk->size <= capacity)
+      return true;
+
+   /* Grow geometrically, images are commonly split
+    * into many small IDAT chunks. */
+   if (capacity < buf->size + chunk->size)
+      capacity = buf->size + chunk->size;
+   if (capacity < buf->capacity * 2)
+      capacity = buf->capacity * 2;
+
+   new_buffer = (uint8_t*)realloc(buf->data, capacity);
 
    if (!new_buffer)
       return false;
 
-   buf->data  = new_buffer;
+   buf->data     = new_buffer;
+   buf->capacity = capacity;
    return true;
 }
 
@@ -957,7 +1302,6 @@ static bool png_parse_ihdr(uint8_t *buf,
 
 bool rpng_iterate_image(rpng_t *rpng)
 {
-   unsigned i;
    struct png_chunk chunk;
    uint8_t *buf           = (uint8_t*)rpng->buff_data;
 
@@ -1051,8 +1395,7 @@ bool rpng_iterate_image(rpng_t *rpng)
 
          buf += 8;
 
-         for (i = 0; i < chunk.size; i++)
-            rpng->idat_buf.data[i + rpng->idat_buf.size] = buf[i];
+         memcpy(rpng->idat_buf.data + rpng->idat_buf.size, buf, chunk.size);
 
          rpng->idat_buf.size += chunk.size;
 
@@ -24,12 +24,54 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <compat/zlib.h>
 #include <encodings/crc32.h>
 #include <streams/file_stream.h>
 #include <streams/trans_stream.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 #include "rpng_internal.h"
 
+/* Upper bound on strips encoded in parallel, and the
+ * smallest strip worth handing to its own thread. */
+#define RPNG_ENCODE_MAX_STRIPS     8
+#define RPNG_ENCODE_MIN_STRIP_ROWS 32
+
+struct rpng_encode_strip
+{
+   const struct rpng_encoder *encoder;
+   const uint8_t *data;      /* First source row of the strip */
+   const uint8_t *prev_data; /* Source row above it, if any */
+   uint8_t *encode_buf;      /* Filtered rows, inside encoder->encode_buf */
+   uint8_t *lines;           /* Current/previous line + filter scratch */
+   uint8_t *deflate_buf;     /* IDAT chunk header + deflated data */
+   void *stream;
+   size_t lines_size;
+   size_t deflate_buf_size;
+   size_t deflate_offset;
+   uint32_t total_out;
+   unsigned rows;
+   bool multi;
+   bool last;
+   bool ret;
+};
+
+struct rpng_encoder
+{
+   struct rpng_encode_strip strips[RPNG_ENCODE_MAX_STRIPS];
+   uint8_t *encode_buf;
+   size_t encode_buf_size;
+   unsigned max_strips;
+   unsigned width;
+   unsigned height;
+   unsigned pitch;
+   unsigned bpp;
+   bool fast;
+};
+
 #undef GOTO_END_ERROR
 #define GOTO_END_ERROR() do { \
    fprintf(stderr, "[RPNG]: Error in line %d.\n", __LINE__); \
@@ -205,187 +247,445 @@ static unsigned filter_paeth(uint8_t *target,
    return count_sad(target, width);
 }
 
-static bool rpng_save_image(const char *path,
-      const uint8_t *data,
-      unsigned width, unsigned height, unsigned pitch, unsigned bpp)
+static void rpng_encode_filter_line(uint8_t *target,
+      uint8_t *scratch, const uint8_t *line, const uint8_t *prev,
+      unsigned width, unsigned bpp, bool fast)
 {
-   unsigned h;
-   bool ret = true;
-   struct png_ihdr ihdr = {0};
-
-   const struct trans_stream_backend *stream_backend = NULL;
-   size_t encode_buf_size  = 0;
-   uint8_t *encode_buf     = NULL;
-   uint8_t *deflate_buf    = NULL;
-   uint8_t *rgba_line      = NULL;
-   uint8_t *up_filtered    = NULL;
-   uint8_t *sub_filtered   = NULL;
-   uint8_t *avg_filtered   = NULL;
-   uint8_t *paeth_filtered = NULL;
-   uint8_t *prev_encoded   = NULL;
-   uint8_t *encode_target  = NULL;
-   void *stream            = NULL;
-   uint32_t total_in       = 0;
-   uint32_t total_out      = 0;
-   RFILE *file             = filestream_open(path,
-         RETRO_VFS_FILE_ACCESS_WRITE,
-         RETRO_VFS_FILE_ACCESS_HINT_NONE);
-   if (!file)
-      GOTO_END_ERROR();
+   uint8_t filter                 = 0;
+   size_t line_size               = width * bpp;
+   uint8_t *up_filtered           = scratch;
+   uint8_t *sub_filtered          = scratch + line_size;
+   uint8_t *avg_filtered          = scratch + line_size * 2;
+   uint8_t *paeth_filtered        = scratch + line_size * 3;
+   const uint8_t *chosen_filtered = line;
+
+   /* Try every filtering method, and choose the method
+    * which has most entries as zero.
+    *
+    * This is probably not very optimal, but it's very
+    * simple to implement.
+    *
+    * Fast mode only tries the cheap Sub and Up filters.
+    */
+   unsigned min_sad     = count_sad(line, line_size);
+   unsigned sub_score   = filter_sub(sub_filtered, line, width, bpp);
+   unsigned up_score    = filter_up(up_filtered, line, prev, width, bpp);
+
+   if (sub_score < min_sad)
+   {
+      filter = 1;
+      chosen_filtered = sub_filtered;
+      min_sad = sub_score;
+   }
 
-   stream_backend = trans_stream_get_zlib_deflate_backend();
+   if (up_score < min_sad)
+   {
+      filter = 2;
+      chosen_filtered = up_filtered;
+      min_sad = up_score;
+   }
 
-   if (filestream_write(file, png_magic, sizeof(png_magic)) != sizeof(png_magic))
-      GOTO_END_ERROR();
+   if (!fast)
+   {
+      unsigned avg_score   = filter_avg(avg_filtered, line, prev, width, bpp);
+      unsigned paeth_score = filter_paeth(paeth_filtered, line, prev, width, bpp);
 
-   ihdr.width = width;
-   ihdr.height = height;
-   ihdr.depth = 8;
-   ihdr.color_type = bpp == sizeof(uint32_t) ? 6 : 2; /* RGBA or RGB */
-   if (!png_write_ihdr(file, &ihdr))
-      GOTO_END_ERROR();
+      if (avg_score < min_sad)
+      {
+         filter = 3;
+         chosen_filtered = avg_filtered;
+         min_sad = avg_score;
+      }
 
-   encode_buf_size = (width * bpp + 1) * height;
-   encode_buf = (uint8_t*)malloc(encode_buf_size);
-   if (!encode_buf)
-      GOTO_END_ERROR();
+      if (paeth_score < min_sad)
+      {
+         filter = 4;
+         chosen_filtered = paeth_filtered;
+      }
+   }
 
-   prev_encoded = (uint8_t*)calloc(1, width * bpp);
-   if (!prev_encoded)
-      GOTO_END_ERROR();
+   *target++ = filter;
+   memcpy(target, chosen_filtered, line_size);
+}
 
-   rgba_line      = (uint8_t*)malloc(width * bpp);
-   up_filtered    = (uint8_t*)malloc(width * bpp);
-   sub_filtered   = (uint8_t*)malloc(width * bpp);
-   avg_filtered   = (uint8_t*)malloc(width * bpp);
-   paeth_filtered = (uint8_t*)malloc(width * bpp);
-   if (!rgba_line || !up_filtered || !sub_filtered || !avg_filtered || !paeth_filtered)
-      GOTO_END_ERROR();
+static void copy_line(uint8_t *dst, const uint8_t *src,
+      unsigned width, unsigned bpp)
+{
+   if (bpp == sizeof(uint32_t))
+      copy_argb_line(dst, (const uint32_t*)src, width);
+   else
+      copy_bgr24_line(dst, src, width);
+}
+
+/* Adler-32 of the filtered image, for the trailer of a
+ * zlib stream assembled from independently deflated strips. */
+static uint32_t png_adler32(const uint8_t *data, size_t size)
+{
+   uint32_t a = 1;
+   uint32_t b = 0;
 
-   encode_target = encode_buf;
-   for (h = 0; h < height;
-         h++, encode_target += width * bpp, data += pitch)
+   while (size)
    {
-      if (bpp == sizeof(uint32_t))
-         copy_argb_line(rgba_line, (const uint32_t*)data, width);
-      else
-         copy_bgr24_line(rgba_line, data, width);
-
-      /* Try every filtering method, and choose the method
-       * which has most entries as zero.
-       *
-       * This is probably not very optimal, but it's very
-       * simple to implement.
-       */
+      size_t n = size < 5552 ? size : 5552;
+      size    -= n;
+
+      while (n--)
       {
-         unsigned none_score  = count_sad(rgba_line, width * bpp);
-         unsigned up_score    = filter_up(up_filtered, rgba_line, prev_encoded, width, bpp);
-         unsigned sub_score   = filter_sub(sub_filtered, rgba_line, width, bpp);
-         unsigned avg_score   = filter_avg(avg_filtered, rgba_line, prev_encoded, width, bpp);
-         unsigned paeth_score = filter_paeth(paeth_filtered, rgba_line, prev_encoded, width, bpp);
-
-         uint8_t filter       = 0;
-         unsigned min_sad     = none_score;
-         const uint8_t *chosen_filtered = rgba_line;
-
-         if (sub_score < min_sad)
-         {
-            filter = 1;
-            chosen_filtered = sub_filtered;
-            min_sad = sub_score;
-         }
-
-         if (up_score < min_sad)
-         {
-            filter = 2;
-            chosen_filtered = up_filtered;
-            min_sad = up_score;
-         }
-
-         if (avg_score < min_sad)
-         {
-            filter = 3;
-            chosen_filtered = avg_filtered;
-            min_sad = avg_score;
-         }
-
-         if (paeth_score < min_sad)
-         {
-            filter = 4;
-            chosen_filtered = paeth_filtered;
-         }
-
-         *encode_target++ = filter;
-         memcpy(encode_target, chosen_filtered, width * bpp);
-
-         memcpy(prev_encoded, rgba_line, width * bpp);
+         a += *data++;
+         b += a;
       }
+
+      a %= 65521;
+      b %= 65521;
    }
 
-   deflate_buf = (uint8_t*)malloc(encode_buf_size * 2); /* Just to be sure. */
-   if (!deflate_buf)
-      GOTO_END_ERROR();
+   return (b << 16) | a;
+}
+
+/**
+ * rpng_encode_strip:
+ * @data                      : struct rpng_encode_strip
+ *
+ * Filters and deflates one horizontal strip of the image.
+ * Strips only read the source image and write to their own
+ * buffers, so they can run concurrently.
+ **/
+static void rpng_encode_strip(void *data)
+{
+   unsigned h;
+   uint32_t total_in                   = 0;
+   struct rpng_encode_strip *strip     = (struct rpng_encode_strip*)data;
+   const struct rpng_encoder *encoder  = strip->encoder;
+   const struct trans_stream_backend *stream_backend =
+      trans_stream_get_zlib_deflate_backend();
+   unsigned width                      = encoder->width;
+   unsigned bpp                        = encoder->bpp;
+   size_t line_size                    = width * bpp;
+   size_t strip_size                   = (line_size + 1) * strip->rows;
+   const uint8_t *src                  = strip->data;
+   uint8_t *encode_target              = strip->encode_buf;
+   uint8_t *line                       = strip->lines;
+   uint8_t *prev_line                  = strip->lines + line_size;
+   uint8_t *scratch                    = strip->lines + line_size * 2;
+
+   strip->ret                          = false;
+   strip->total_out                    = 0;
+
+   if (strip->prev_data)
+      copy_line(prev_line, strip->prev_data, width, bpp);
+   else
+      memset(prev_line, 0, line_size);
+
+   for (h = 0; h < strip->rows;
+         h++, encode_target += line_size + 1, src += encoder->pitch)
+   {
+      uint8_t *tmp;
 
-   stream = stream_backend->stream_new();
+      copy_line(line, src, width, bpp);
+      rpng_encode_filter_line(encode_target, scratch,
+            line, prev_line, width, bpp, encoder->fast);
 
-   if (!stream)
-      GOTO_END_ERROR();
+      tmp       = prev_line;
+      prev_line = line;
+      line      = tmp;
+   }
+
+   if (!strip->stream)
+      strip->stream = stream_backend->stream_new();
+
+   if (!strip->stream)
+      return;
+
+   /* A single strip is a complete zlib stream. Otherwise every
+    * strip is raw deflate data ending on a sync point, except the
+    * last one which ends the stream; the zlib header and trailer
+    * are added when the strips are written out. */
+   stream_backend->define(strip->stream, "level", encoder->fast ? 1 : 9);
+   stream_backend->define(strip->stream, "window_bits",
+         strip->multi ? (uint32_t)-MAX_WBITS : MAX_WBITS);
+   stream_backend->define(strip->stream, "sync_flush",
+         strip->multi && !strip->last);
 
    stream_backend->set_in(
-         stream,
-         encode_buf,
-         (unsigned)encode_buf_size);
+         strip->stream,
+         strip->encode_buf,
+         (uint32_t)strip_size);
    stream_backend->set_out(
-         stream,
-         deflate_buf + 8,
-         (unsigned)(encode_buf_size * 2));
+         strip->stream,
+         strip->deflate_buf + strip->deflate_offset,
+         (uint32_t)(strip->deflate_buf_size - strip->deflate_offset - 4));
+
+   if (!stream_backend->trans(strip->stream, true,
+            &total_in, &strip->total_out, NULL))
+   {
+      /* Don't reuse a stream left in an unknown state. */
+      stream_backend->stream_free(strip->stream);
+      strip->stream = NULL;
+      return;
+   }
+
+   strip->ret = true;
+}
+
+static bool rpng_encoder_reserve(rpng_encoder_t *encoder,
+      unsigned num_strips, unsigned rows_per_strip)
+{
+   unsigned i;
+   size_t line_size        = encoder->width * encoder->bpp;
+   size_t encode_buf_size  = (line_size + 1) * encoder->height;
+   size_t lines_size       = line_size * 6;
+   /* Just to be sure. */
+   size_t deflate_buf_size = (line_size + 1) * rows_per_strip * 2 + 64;
+
+   if (encode_buf_size > encoder->encode_buf_size)
+   {
+      uint8_t *buf = (uint8_t*)realloc(encoder->encode_buf, encode_buf_size);
+      if (!buf)
+         return false;
+      encoder->encode_buf      = buf;
+      encoder->encode_buf_size = encode_buf_size;
+   }
+
+   for (i = 0; i < num_strips; i++)
+   {
+      struct rpng_encode_strip *strip = &encoder->strips[i];
+
+      if (lines_size > strip->lines_size)
+      {
+         uint8_t *buf = (uint8_t*)realloc(strip->lines, lines_size);
+         if (!buf)
+            return false;
+         strip->lines      = buf;
+         strip->lines_size = lines_size;
+      }
+
+      if (deflate_buf_size > strip->deflate_buf_size)
+      {
+         uint8_t *buf = (uint8_t*)realloc(strip->deflate_buf,
+               deflate_buf_size);
+         if (!buf)
+            return false;
+         strip->deflate_buf      = buf;
+         strip->deflate_buf_size = deflate_buf_size;
+      }
+   }
+
+   return true;
+}
+
+static bool rpng_encoder_save_image(rpng_encoder_t *encoder,
+      const char *path, const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   bool ret                = true;
+   struct png_ihdr ihdr    = {0};
+   unsigned num_strips     = 1;
+   unsigned rows_per_strip = height;
+   RFILE *file             = NULL;
+
+   if (!encoder || !width || !height)
+      return false;
 
-   if (!stream_backend->trans(stream, true, &total_in, &total_out, NULL))
+   encoder->width  = width;
+   encoder->height = height;
+   encoder->pitch  = pitch;
+   encoder->bpp    = bpp;
+
+   if (encoder->max_strips > 1 && height >= RPNG_ENCODE_MIN_STRIP_ROWS * 2)
    {
+      num_strips = height / RPNG_ENCODE_MIN_STRIP_ROWS;
+      if (num_strips > encoder->max_strips)
+         num_strips = encoder->max_strips;
+      rows_per_strip = (height + num_strips - 1) / num_strips;
+      num_strips     = (height + rows_per_strip - 1) / rows_per_strip;
+   }
+
+   if (!rpng_encoder_reserve(encoder, num_strips, rows_per_strip))
       GOTO_END_ERROR();
+
+   for (i = 0; i < num_strips; i++)
+   {
+      struct rpng_encode_strip *strip = &encoder->strips[i];
+      unsigned first_row              = i * rows_per_strip;
+
+      strip->encoder        = encoder;
+      strip->data           = data + (size_t)first_row * pitch;
+      strip->prev_data      = first_row ? strip->data - pitch : NULL;
+      strip->encode_buf     = encoder->encode_buf
+         + (size_t)first_row * (width * bpp + 1);
+      strip->rows           = height - first_row < rows_per_strip
+         ? height - first_row : rows_per_strip;
+      strip->multi          = num_strips > 1;
+      strip->last           = i == num_strips - 1;
+      /* Room for the IDAT chunk header, plus the zlib
+       * header in front of the first of several strips. */
+      strip->deflate_offset = (strip->multi && i == 0) ? 10 : 8;
+   }
+
+#ifdef HAVE_THREADS
+   {
+      sthread_t *threads[RPNG_ENCODE_MAX_STRIPS] = {NULL};
+
+      for (i = 1; i < num_strips; i++)
+         threads[i] = sthread_create(rpng_encode_strip, &encoder->strips[i]);
+
+      rpng_encode_strip(&encoder->strips[0]);
+
+      for (i = 1; i < num_strips; i++)
+      {
+         if (threads[i])
+            sthread_join(threads[i]);
+         else
+            rpng_encode_strip(&encoder->strips[i]);
+      }
    }
+#else
+   for (i = 0; i < num_strips; i++)
+      rpng_encode_strip(&encoder->strips[i]);
+#endif
+
+   for (i = 0; i < num_strips; i++)
+      if (!encoder->strips[i].ret)
+         GOTO_END_ERROR();
 
-   memcpy(deflate_buf + 4, "IDAT", 4);
-   dword_write_be(deflate_buf + 0,        ((uint32_t)total_out));
-   if (!png_write_idat(file, deflate_buf, ((size_t)total_out + 8)))
+   file = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_WRITE,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   if (!file)
       GOTO_END_ERROR();
 
+   if (filestream_write(file, png_magic, sizeof(png_magic)) != sizeof(png_magic))
+      GOTO_END_ERROR();
+
+   ihdr.width = width;
+   ihdr.height = height;
+   ihdr.depth = 8;
+   ihdr.color_type = bpp == sizeof(uint32_t) ? 6 : 2; /* RGBA or RGB */
+   if (!png_write_ihdr(file, &ihdr))
+      GOTO_END_ERROR();
+
+   /* Each strip becomes its own IDAT chunk; decoders treat
+    * consecutive IDAT chunks as one zlib stream. */
+   for (i = 0; i < num_strips; i++)
+   {
+      struct rpng_encode_strip *strip = &encoder->strips[i];
+      uint8_t *deflate_buf            = strip->deflate_buf;
+      size_t idat_size                = strip->deflate_offset - 8
+         + strip->total_out;
+
+      if (strip->multi && i == 0)
+      {
+         deflate_buf[8] = 0x78;
+         deflate_buf[9] = 0x9c;
+      }
+
+      if (strip->multi && strip->last)
+      {
+         dword_write_be(deflate_buf + 8 + idat_size,
+               png_adler32(encoder->encode_buf,
+                  (width * bpp + 1) * height));
+         idat_size += 4;
+      }
+
+      memcpy(deflate_buf + 4, "IDAT", 4);
+      dword_write_be(deflate_buf + 0, ((uint32_t)idat_size));
+      if (!png_write_idat(file, deflate_buf, idat_size + 8))
+         GOTO_END_ERROR();
+   }
+
    if (!png_write_iend(file))
       GOTO_END_ERROR();
 
 end:
    if (file)
       filestream_close(file);
-   free(encode_buf);
-   free(deflate_buf);
-   free(rgba_line);
-   free(prev_encoded);
-   free(up_filtered);
-   free(sub_filtered);
-   free(avg_filtered);
-   free(paeth_filtered);
-
-   if (stream_backend)
+   return ret;
+}
+
+rpng_encoder_t *rpng_encoder_new(unsigned threads, bool fast)
+{
+   rpng_encoder_t *encoder = (rpng_encoder_t*)calloc(1, sizeof(*encoder));
+
+   if (!encoder)
+      return NULL;
+
+#ifdef HAVE_THREADS
+   if (threads > RPNG_ENCODE_MAX_STRIPS)
+      threads = RPNG_ENCODE_MAX_STRIPS;
+#else
+   threads = 1;
+#endif
+
+   encoder->max_strips = threads ? threads : 1;
+   encoder->fast       = fast;
+
+   return encoder;
+}
+
+void rpng_encoder_free(rpng_encoder_t *encoder)
+{
+   unsigned i;
+   const struct trans_stream_backend *stream_backend =
+      trans_stream_get_zlib_deflate_backend();
+
+   if (!encoder)
+      return;
+
+   for (i = 0; i < RPNG_ENCODE_MAX_STRIPS; i++)
    {
-      if (stream)
-      {
-         if (stream_backend->stream_free)
-            stream_backend->stream_free(stream);
-      }
+      struct rpng_encode_strip *strip = &encoder->strips[i];
+
+      if (strip->stream)
+         stream_backend->stream_free(strip->stream);
+      free(strip->lines);
+      free(strip->deflate_buf);
    }
-   return ret;
+
+   free(encoder->encode_buf);
+   free(encoder);
 }
 
-bool rpng_save_image_argb(const char *path, const uint32_t *data,
+void rpng_encoder_set_fast(rpng_encoder_t *encoder, bool fast)
+{
+   if (encoder)
+      encoder->fast = fast;
+}
+
+bool rpng_encoder_save_image_argb(rpng_encoder_t *encoder,
+      const char *path, const uint32_t *data,
       unsigned width, unsigned height, unsigned pitch)
 {
-   return rpng_save_image(path, (const uint8_t*)data,
+   return rpng_encoder_save_image(encoder, path, (const uint8_t*)data,
          width, height, pitch, sizeof(uint32_t));
 }
 
-bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
+bool rpng_encoder_save_image_bgr24(rpng_encoder_t *encoder,
+      const char *path, const uint8_t *data,
       unsigned width, unsigned height, unsigned pitch)
 {
-   return rpng_save_image(path, (const uint8_t*)data,
+   return rpng_encoder_save_image(encoder, path, (const uint8_t*)data,
          width, height, pitch, 3);
 }
+
+bool rpng_save_image_argb(const char *path, const uint32_t *data,
+      unsigned width, unsigned height, unsigned pitch)
+{
+   rpng_encoder_t *encoder = rpng_encoder_new(1, false);
+   bool ret                = rpng_encoder_save_image_argb(encoder,
+         path, data, width, height, pitch);
+
+   rpng_encoder_free(encoder);
+   return ret;
+}
+
+bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch)
+{
+   rpng_encoder_t *encoder = rpng_encoder_new(1, false);
+   bool ret                = rpng_encoder_save_image_bgr24(encoder,
+         path, data, width, height, pitch);
+
+   rpng_encoder_free(encoder);
+   return ret;
+}
@@ -29,12 +29,19 @@
 
 #include <gfx/scaler/pixconv.h>
 
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define PIXCONV_NEON
+#endif
+
 #ifdef SCALER_NO_SIMD
 #undef __SSE2__
+#undef PIXCONV_NEON
 #endif
 
 #if defined(__SSE2__)
 #include <emmintrin.h>
+#elif defined(PIXCONV_NEON)
+#include <arm_neon.h>
 #endif
 
 void conv_rgb565_0rgb1555(void *output_, const void *input_,
@@ -45,24 +52,36 @@ void conv_rgb565_0rgb1555(void *output_, const void *input_,
    const uint16_t *input = (const uint16_t*)input_;
    uint16_t *output = (uint16_t*)output_;
 
-#if defined(__SSE2_)
+#if defined(__SSE2__)
    int max_width           = width - 7;
    const __m128i hi_mask   = _mm_set1_epi16(0x7fe0);
    const __m128i lo_mask   = _mm_set1_epi16(0x1f);
+#elif defined(PIXCONV_NEON)
+   int max_width           = width - 7;
+   const uint16x8_t hi_mask = vdupq_n_u16(0x7fe0);
+   const uint16x8_t lo_mask = vdupq_n_u16(0x1f);
 #endif
 
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
       int w = 0;
-#if defined(__SSE2_)
+#if defined(__SSE2__)
       for (; w < max_width; w += 8)
       {
          const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
-         __m128i hi = _mm_and_si128(_mm_slli_epi16(in, 1), hi_mask);
+         __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 1), hi_mask);
          __m128i lo = _mm_and_si128(in, lo_mask);
          _mm_storeu_si128((__m128i*)(output + w), _mm_or_si128(hi, lo));
       }
+#elif defined(PIXCONV_NEON)
+      for (; w < max_width; w += 8)
+      {
+         const uint16x8_t in = vld1q_u16(input + w);
+         uint16x8_t hi       = vandq_u16(vshrq_n_u16(in, 1), hi_mask);
+         uint16x8_t lo       = vandq_u16(in, lo_mask);
+         vst1q_u16(output + w, vorrq_u16(hi, lo));
+      }
 #endif
 
       for (; w < width; w++)
@@ -90,6 +109,12 @@ void conv_0rgb1555_rgb565(void *output_, const void *input_,
          (int16_t)((0x1f << 11) | (0x1f << 6)));
    const __m128i lo_mask   = _mm_set1_epi16(0x1f);
    const __m128i glow_mask = _mm_set1_epi16(1 << 5);
+#elif defined(PIXCONV_NEON)
+   int max_width             = width - 7;
+
+   const uint16x8_t hi_mask   = vdupq_n_u16((0x1f << 11) | (0x1f << 6));
+   const uint16x8_t lo_mask   = vdupq_n_u16(0x1f);
+   const uint16x8_t glow_mask = vdupq_n_u16(1 << 5);
 #endif
 
    for (h = 0; h < height;
@@ -106,6 +131,15 @@ void conv_0rgb1555_rgb565(void *output_, const void *input_,
          _mm_storeu_si128((__m128i*)(output + w),
                _mm_or_si128(rg, _mm_or_si128(b, glow)));
       }
+#elif defined(PIXCONV_NEON)
+      for (; w < max_width; w += 8)
+      {
+         const uint16x8_t in = vld1q_u16(input + w);
+         uint16x8_t rg       = vandq_u16(vshlq_n_u16(in, 1), hi_mask);
+         uint16x8_t b        = vandq_u16(in, lo_mask);
+         uint16x8_t glow     = vandq_u16(vshrq_n_u16(in, 4), glow_mask);
+         vst1q_u16(output + w, vorrq_u16(rg, vorrq_u16(b, glow)));
+      }
 #endif
 
       for (; w < width; w++)
@@ -134,6 +168,10 @@ void conv_0rgb1555_argb8888(void *output_, const void *input_,
    const __m128i mul15_hi    = _mm_set1_epi16(0x0210);
    const __m128i a           = _mm_set1_epi16(0x00ff);
 
+   int max_width = width - 7;
+#elif defined(PIXCONV_NEON)
+   const uint8x8_t mask_5    = vdup_n_u8(0x1f);
+
    int max_width = width - 7;
 #endif
 
@@ -169,6 +207,22 @@ void conv_0rgb1555_argb8888(void *output_, const void *input_,
          _mm_storeu_si128((__m128i*)(output + w + 0), res_lo);
          _mm_storeu_si128((__m128i*)(output + w + 4), res_hi);
       }
+#elif defined(PIXCONV_NEON)
+      for (; w < max_width; w += 8)
+      {
+         uint8x8x4_t res;
+         const uint16x8_t in = vld1q_u16(input + w);
+         uint8x8_t r = vand_u8(vmovn_u16(vshrq_n_u16(in, 10)), mask_5);
+         uint8x8_t g = vand_u8(vmovn_u16(vshrq_n_u16(in,  5)), mask_5);
+         uint8x8_t b = vand_u8(vmovn_u16(in), mask_5);
+
+         res.val[0]  = vorr_u8(vshl_n_u8(b, 3), vshr_n_u8(b, 2));
+         res.val[1]  = vorr_u8(vshl_n_u8(g, 3), vshr_n_u8(g, 2));
+         res.val[2]  = vorr_u8(vshl_n_u8(r, 3), vshr_n_u8(r, 2));
+         res.val[3]  = vdup_n_u8(0xff);
+
+         vst4_u8((uint8_t*)(output + w), res);
+      }
 #endif
 
       for (; w < width; w++)
@@ -203,6 +257,11 @@ void conv_rgb565_argb8888(void *output_, const void *input_,
    const __m128i mul16_b    = _mm_set1_epi16(0x4200);
    const __m128i a          = _mm_set1_epi16(0x00ff);
 
+   int max_width            = width - 7;
+#elif defined(PIXCONV_NEON)
+   const uint8x8_t mask_5   = vdup_n_u8(0x1f);
+   const uint8x8_t mask_6   = vdup_n_u8(0x3f);
+
    int max_width            = width - 7;
 #endif
 
@@ -237,6 +296,26 @@ void conv_rgb565_argb8888(void *output_, const void *input_,
          _mm_storeu_si128((__m128i*)(output + w + 0), res_lo);
          _mm_storeu_si128((__m128i*)(output + w + 4), res_hi);
       }
+#elif defined(PIXCONV_NEON)
+      for (; w < max_width; w += 8)
+      {
+         uint8x8x4_t res;
+         const uint16x8_t in = vld1q_u16(input + w);
+         uint8x8_t r = vmovn_u16(vshrq_n_u16(in, 11));
+         uint8x8_t g = vand_u8(vmovn_u16(vshrq_n_u16(in, 5)), mask_6);
+         uint8x8_t b = vand_u8(vmovn_u16(in), mask_5);
+
+         res.val[0]  = vorr_u8(vshl_n_u8(b, 3), vshr_n_u8(b, 2));
+         res.val[1]  = vorr_u8(vshl_n_u8(g, 2), vshr_n_u8(g, 4));
+         res.val[2]  = vorr_u8(vshl_n_u8(r, 3), vshr_n_u8(r, 2));
+#ifdef HAVE_NXRGUI
+         res.val[3]  = vtst_u8(r, r);
+#else
+         res.val[3]  = vdup_n_u8(0xff);
+#endif
+
+         vst4_u8((uint8_t*)(output + w), res);
+      }
 #endif
 
       for (; w < width; w++)
@@ -276,6 +355,11 @@ void conv_rgb565_abgr8888(void *output_, const void *input_,
    const __m128i mul16_b    = _mm_set1_epi16(0x4200);
    const __m128i a          = _mm_set1_epi16(0x00ff);
 
+   int max_width            = width - 7;
+#elif defined(PIXCONV_NEON)
+   const uint8x8_t mask_5   = vdup_n_u8(0x1f);
+   const uint8x8_t mask_6   = vdup_n_u8(0x3f);
+
    int max_width            = width - 7;
 #endif
 
@@ -287,7 +371,7 @@ void conv_rgb565_abgr8888(void *output_, const void *input_,
       for (; w < max_width; w += 8)
       {
          __m128i res_lo, res_hi;
-         __m128i res_lo_bg, res_hi_bg, res_lo_ra, res_hi_ra;
+         __m128i res_lo_rg, res_hi_rg, res_lo_ba, res_hi_ba;
          const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
          __m128i        r = _mm_and_si128(_mm_srli_epi16(in, 1), pix_mask_r);
          __m128i        g = _mm_and_si128(in, pix_mask_g);
@@ -297,19 +381,39 @@ void conv_rgb565_abgr8888(void *output_, const void *input_,
          g                = _mm_mulhi_epi16(g, mul16_g);
          b                = _mm_mulhi_epi16(b, mul16_b);
 
-         res_lo_bg        = _mm_unpacklo_epi8(b, g);
-         res_hi_bg        = _mm_unpackhi_epi8(b, g);
-         res_lo_ra        = _mm_unpacklo_epi8(r, a);
-         res_hi_ra        = _mm_unpackhi_epi8(r, a);
+         res_lo_rg        = _mm_unpacklo_epi8(r, g);
+         res_hi_rg        = _mm_unpackhi_epi8(r, g);
+         res_lo_ba        = _mm_unpacklo_epi8(b, a);
+         res_hi_ba        = _mm_unpackhi_epi8(b, a);
 
-         res_lo           = _mm_or_si128(res_lo_bg,
-               _mm_slli_si128(res_lo_ra, 2));
-         res_hi           = _mm_or_si128(res_hi_bg,
-               _mm_slli_si128(res_hi_ra, 2));
+         res_lo           = _mm_or_si128(res_lo_rg,
+               _mm_slli_si128(res_lo_ba, 2));
+         res_hi           = _mm_or_si128(res_hi_rg,
+               _mm_slli_si128(res_hi_ba, 2));
 
          _mm_storeu_si128((__m128i*)(output + w + 0), res_lo);
          _mm_storeu_si128((__m128i*)(output + w + 4), res_hi);
       }
+#elif defined(PIXCONV_NEON)
+      for (; w < max_width; w += 8)
+      {
+         uint8x8x4_t res;
+         const uint16x8_t in = vld1q_u16(input + w);
+         uint8x8_t r = vmovn_u16(vshrq_n_u16(in, 11));
+         uint8x8_t g = vand_u8(vmovn_u16(vshrq_n_u16(in, 5)), mask_6);
+         uint8x8_t b = vand_u8(vmovn_u16(in), mask_5);
+
+         res.val[2]  = vorr_u8(vshl_n_u8(b, 3), vshr_n_u8(b, 2));
+         res.val[1]  = vorr_u8(vshl_n_u8(g, 2), vshr_n_u8(g, 4));
+         res.val[0]  = vorr_u8(vshl_n_u8(r, 3), vshr_n_u8(r, 2));
+#ifdef HAVE_NXRGUI
+         res.val[3]  = vtst_u8(r, r);
+#else
+         res.val[3]  = vdup_n_u8(0xff);
+#endif
+
+         vst4_u8((uint8_t*)(output + w), res);
+      }
 #endif
 
       for (; w < width; w++)
@@ -364,14 +468,66 @@ void conv_rgba4444_argb8888(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
-   int h, w;
+   int h;
    const uint16_t *input = (const uint16_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
 
+#if defined(__SSE2__)
+   const __m128i mask_lo = _mm_set1_epi16(0x000f);
+   const __m128i mask_hi = _mm_set1_epi16(0x0f00);
+   const __m128i mul17   = _mm_set1_epi16(0x11);
+
+   int max_width         = width - 7;
+#elif defined(PIXCONV_NEON)
+   const uint8x8_t mask_lo = vdup_n_u8(0x0f);
+   const uint8x8_t mask_hi = vdup_n_u8(0xf0);
+
+   int max_width           = width - 7;
+#endif
+
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride >> 1)
    {
-      for (w = 0; w < width; w++)
+      int w = 0;
+#if defined(__SSE2__)
+      for (; w < max_width; w += 8)
+      {
+         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
+         /* Build B | G << 8 and R | A << 8, then expand
+          * each nibble to a full byte (x * 0x11). */
+         __m128i bg       = _mm_or_si128(
+               _mm_and_si128(_mm_srli_epi16(in, 4), mask_lo),
+               _mm_and_si128(in, mask_hi));
+         __m128i ra       = _mm_or_si128(
+               _mm_srli_epi16(in, 12),
+               _mm_slli_epi16(_mm_and_si128(in, mask_lo), 8));
+
+         bg               = _mm_mullo_epi16(bg, mul17);
+         ra               = _mm_mullo_epi16(ra, mul17);
+
+         _mm_storeu_si128((__m128i*)(output + w + 0),
+               _mm_unpacklo_epi16(bg, ra));
+         _mm_storeu_si128((__m128i*)(output + w + 4),
+               _mm_unpackhi_epi16(bg, ra));
+      }
+#elif defined(PIXCONV_NEON)
+      for (; w < max_width; w += 8)
+      {
+         uint8x8x4_t res;
+         const uint16x8_t in = vld1q_u16(input + w);
+         uint8x8_t rg = vmovn_u16(vshrq_n_u16(in, 8));
+         uint8x8_t ba = vmovn_u16(in);
+
+         res.val[0]   = vorr_u8(vand_u8(ba, mask_hi), vshr_n_u8(ba, 4));
+         res.val[1]   = vorr_u8(vand_u8(rg, mask_lo), vshl_n_u8(rg, 4));
+         res.val[2]   = vorr_u8(vand_u8(rg, mask_hi), vshr_n_u8(rg, 4));
+         res.val[3]   = vorr_u8(vand_u8(ba, mask_lo), vshl_n_u8(ba, 4));
+
+         vst4_u8((uint8_t*)(output + w), res);
+      }
+#endif
+
+      for (; w < width; w++)
       {
          uint32_t col = input[w];
          uint32_t r   = (col >> 12) & 0xf;
@@ -392,14 +548,50 @@ void conv_rgba4444_rgb565(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
-   int h, w;
+   int h;
    const uint16_t *input = (const uint16_t*)input_;
    uint16_t *output      = (uint16_t*)output_;
 
+#if defined(__SSE2__)
+   const __m128i mask_r  = _mm_set1_epi16((int16_t)0xf000);
+   const __m128i mask_g  = _mm_set1_epi16(0x0780);
+   const __m128i mask_b  = _mm_set1_epi16(0x001e);
+
+   int max_width         = width - 7;
+#elif defined(PIXCONV_NEON)
+   const uint16x8_t mask_r = vdupq_n_u16(0xf000);
+   const uint16x8_t mask_g = vdupq_n_u16(0x0780);
+   const uint16x8_t mask_b = vdupq_n_u16(0x001e);
+
+   int max_width           = width - 7;
+#endif
+
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
-      for (w = 0; w < width; w++)
+      int w = 0;
+#if defined(__SSE2__)
+      for (; w < max_width; w += 8)
+      {
+         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
+         __m128i r        = _mm_and_si128(in, mask_r);
+         __m128i g        = _mm_and_si128(_mm_srli_epi16(in, 1), mask_g);
+         __m128i b        = _mm_and_si128(_mm_srli_epi16(in, 3), mask_b);
+         _mm_storeu_si128((__m128i*)(output + w),
+               _mm_or_si128(r, _mm_or_si128(g, b)));
+      }
+#elif defined(PIXCONV_NEON)
+      for (; w < max_width; w += 8)
+      {
+         const uint16x8_t in = vld1q_u16(input + w);
+         uint16x8_t r        = vandq_u16(in, mask_r);
+         uint16x8_t g        = vandq_u16(vshrq_n_u16(in, 1), mask_g);
+         uint16x8_t b        = vandq_u16(vshrq_n_u16(in, 3), mask_b);
+         vst1q_u16(output + w, vorrq_u16(r, vorrq_u16(g, b)));
+      }
+#endif
+
+      for (; w < width; w++)
       {
          uint32_t col = input[w];
          uint32_t r   = (col >> 12) & 0xf;
@@ -633,15 +825,35 @@ void conv_bgr24_argb8888(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
-   int h, w;
+   int h;
    const uint8_t *input = (const uint8_t*)input_;
    uint32_t *output     = (uint32_t*)output_;
 
+#if defined(PIXCONV_NEON)
+   int max_width        = width - 15;
+#endif
+
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride)
    {
       const uint8_t *inp = input;
-      for (w = 0; w < width; w++)
+      int              w = 0;
+#if defined(PIXCONV_NEON)
+      for (; w < max_width; w += 16, inp += 48)
+      {
+         uint8x16x4_t res;
+         uint8x16x3_t in = vld3q_u8(inp);
+
+         res.val[0]      = in.val[0];
+         res.val[1]      = in.val[1];
+         res.val[2]      = in.val[2];
+         res.val[3]      = vdupq_n_u8(0xff);
+
+         vst4q_u8((uint8_t*)(output + w), res);
+      }
+#endif
+
+      for (; w < width; w++)
       {
          uint32_t b = *inp++;
          uint32_t g = *inp++;
@@ -655,14 +867,58 @@ void conv_argb8888_0rgb1555(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
-   int h, w;
+   int h;
    const uint32_t *input = (const uint32_t*)input_;
    uint16_t *output      = (uint16_t*)output_;
 
+#if defined(__SSE2__)
+   const __m128i mask_r  = _mm_set1_epi32(0x1f << 10);
+   const __m128i mask_g  = _mm_set1_epi32(0x1f <<  5);
+   const __m128i mask_b  = _mm_set1_epi32(0x1f <<  0);
+
+   int max_width         = width - 7;
+#elif defined(PIXCONV_NEON)
+   int max_width         = width - 7;
+#endif
+
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 2)
    {
-      for (w = 0; w < width; w++)
+      int w = 0;
+#if defined(__SSE2__)
+      for (; w < max_width; w += 8)
+      {
+         const __m128i in_lo = _mm_loadu_si128((const __m128i*)(input + w + 0));
+         const __m128i in_hi = _mm_loadu_si128((const __m128i*)(input + w + 4));
+         __m128i res_lo      = _mm_or_si128(
+               _mm_and_si128(_mm_srli_epi32(in_lo, 9), mask_r),
+               _mm_or_si128(
+                  _mm_and_si128(_mm_srli_epi32(in_lo, 6), mask_g),
+                  _mm_and_si128(_mm_srli_epi32(in_lo, 3), mask_b)));
+         __m128i res_hi      = _mm_or_si128(
+               _mm_and_si128(_mm_srli_epi32(in_hi, 9), mask_r),
+               _mm_or_si128(
+                  _mm_and_si128(_mm_srli_epi32(in_hi, 6), mask_g),
+                  _mm_and_si128(_mm_srli_epi32(in_hi, 3), mask_b)));
+
+         /* Results fit in 15 bits, so signed saturation is harmless. */
+         _mm_storeu_si128((__m128i*)(output + w),
+               _mm_packs_epi32(res_lo, res_hi));
+      }
+#elif defined(PIXCONV_NEON)
+      for (; w < max_width; w += 8)
+      {
+         uint8x8x4_t in = vld4_u8((const uint8_t*)(input + w));
+         uint16x8_t r   = vmovl_u8(vshr_n_u8(in.val[2], 3));
+         uint16x8_t g   = vmovl_u8(vshr_n_u8(in.val[1], 3));
+         uint16x8_t b   = vmovl_u8(vshr_n_u8(in.val[0], 3));
+
+         vst1q_u16(output + w, vorrq_u16(vshlq_n_u16(r, 10),
+                  vorrq_u16(vshlq_n_u16(g, 5), b)));
+      }
+#endif
+
+      for (; w < width; w++)
       {
          uint32_t col = input[w];
          uint16_t r   = (col >> 19) & 0x1f;
@@ -681,7 +937,7 @@ void conv_argb8888_bgr24(void *output_, const void *input_,
    const uint32_t *input = (const uint32_t*)input_;
    uint8_t *output       = (uint8_t*)output_;
 
-#if defined(__SSE2__)
+#if defined(__SSE2__) || defined(PIXCONV_NEON)
    int max_width = width - 15;
 #endif
 
@@ -699,6 +955,18 @@ void conv_argb8888_bgr24(void *output_, const void *input_,
                _mm_loadu_si128((const __m128i*)(input + w +  8)),
                _mm_loadu_si128((const __m128i*)(input + w + 12)));
       }
+#elif defined(PIXCONV_NEON)
+      for (; w < max_width; w += 16, out += 48)
+      {
+         uint8x16x3_t res;
+         uint8x16x4_t in = vld4q_u8((const uint8_t*)(input + w));
+
+         res.val[0]      = in.val[0];
+         res.val[1]      = in.val[1];
+         res.val[2]      = in.val[2];
+
+         vst3q_u8(out, res);
+      }
 #endif
 
       for (; w < width; w++)
@@ -715,14 +983,48 @@ void conv_argb8888_abgr8888(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
-   int h, w;
+   int h;
    const uint32_t *input = (const uint32_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
 
+#if defined(__SSE2__)
+   const __m128i mask_ag = _mm_set1_epi32((int)0xff00ff00);
+   const __m128i mask_b  = _mm_set1_epi32(0x00ff0000);
+   const __m128i mask_r  = _mm_set1_epi32(0x000000ff);
+
+   int max_width         = width - 3;
+#elif defined(PIXCONV_NEON)
+   int max_width         = width - 15;
+#endif
+
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride >> 2)
    {
-      for (w = 0; w < width; w++)
+      int w = 0;
+#if defined(__SSE2__)
+      for (; w < max_width; w += 4)
+      {
+         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
+         __m128i ag       = _mm_and_si128(in, mask_ag);
+         __m128i b        = _mm_and_si128(_mm_slli_epi32(in, 16), mask_b);
+         __m128i r        = _mm_and_si128(_mm_srli_epi32(in, 16), mask_r);
+         _mm_storeu_si128((__m128i*)(output + w),
+               _mm_or_si128(ag, _mm_or_si128(b, r)));
+      }
+#elif defined(PIXCONV_NEON)
+      for (; w < max_width; w += 16)
+      {
+         uint8x16x4_t in = vld4q_u8((const uint8_t*)(input + w));
+         uint8x16_t tmp  = in.val[0];
+
+         in.val[0]       = in.val[2];
+         in.val[2]       = tmp;
+
+         vst4q_u8((uint8_t*)(output + w), in);
+      }
+#endif
+
+      for (; w < width; w++)
       {
          uint32_t col = input[w];
          output[w]    = ((col << 16) & 0xff0000) |
@@ -761,6 +1063,8 @@ void conv_yuyv_argb8888(void *output_, const void *input_,
    const __m128i v_g_mul       = _mm_set1_epi16(YUV_MAT_V_G);
    const __m128i a             = _mm_cmpeq_epi16(
          _mm_setzero_si128(), _mm_setzero_si128());
+#elif defined(PIXCONV_NEON)
+   const int16x8_t chroma_offset = vdupq_n_s16(128);
 #endif
 
    for (h = 0; h < height; h++, output += out_stride >> 2, input += in_stride)
@@ -852,6 +1156,53 @@ void conv_yuyv_argb8888(void *output_, const void *input_,
          _mm_storeu_si128((__m128i*)(dst +  8), res2);
          _mm_storeu_si128((__m128i*)(dst + 12), res3);
       }
+#elif defined(PIXCONV_NEON)
+      /* Each loop processes 16 pixels. */
+      for (; w + 16 <= width; w += 16, src += 32, dst += 16)
+      {
+         uint8x8x4_t res_lo, res_hi;
+         uint8x8x2_t r, g, b;
+         /* Deinterleaves into [Y0 x 8], [U x 8], [Y1 x 8], [V x 8]. */
+         uint8x8x4_t yuv = vld4_u8(src);
+         int16x8_t _y0   = vmulq_n_s16(
+               vreinterpretq_s16_u16(vmovl_u8(yuv.val[0])), YUV_MAT_Y);
+         int16x8_t _y1   = vmulq_n_s16(
+               vreinterpretq_s16_u16(vmovl_u8(yuv.val[2])), YUV_MAT_Y);
+         int16x8_t u     = vsubq_s16(
+               vreinterpretq_s16_u16(vmovl_u8(yuv.val[1])), chroma_offset);
+         int16x8_t v     = vsubq_s16(
+               vreinterpretq_s16_u16(vmovl_u8(yuv.val[3])), chroma_offset);
+
+         /* Chroma contributions are shared by both luma samples. */
+         int16x8_t c_r   = vmulq_n_s16(v, YUV_MAT_V_R);
+         int16x8_t c_g   = vmlaq_n_s16(vmulq_n_s16(u, YUV_MAT_U_G),
+               v, YUV_MAT_V_G);
+         int16x8_t c_b   = vmulq_n_s16(u, YUV_MAT_U_B);
+
+         /* Rounding shift and saturate into 8-bit, then
+          * interleave even/odd pixels back into order. */
+         r = vzip_u8(
+               vqrshrun_n_s16(vaddq_s16(_y0, c_r), YUV_SHIFT),
+               vqrshrun_n_s16(vaddq_s16(_y1, c_r), YUV_SHIFT));
+         g = vzip_u8(
+               vqrshrun_n_s16(vaddq_s16(_y0, c_g), YUV_SHIFT),
+               vqrshrun_n_s16(vaddq_s16(_y1, c_g), YUV_SHIFT));
+         b = vzip_u8(
+               vqrshrun_n_s16(vaddq_s16(_y0, c_b), YUV_SHIFT),
+               vqrshrun_n_s16(vaddq_s16(_y1, c_b), YUV_SHIFT));
+
+         res_lo.val[0]   = b.val[0];
+         res_lo.val[1]   = g.val[0];
+         res_lo.val[2]   = r.val[0];
+         res_lo.val[3]   = vdup_n_u8(0xff);
+         res_hi.val[0]   = b.val[1];
+         res_hi.val[1]   = g.val[1];
+         res_hi.val[2]   = r.val[1];
+         res_hi.val[3]   = vdup_n_u8(0xff);
+
+         vst4_u8((uint8_t*)(dst + 0), res_lo);
+         vst4_u8((uint8_t*)(dst + 8), res_hi);
+      }
 #endif
 
       /* Finish off the rest (if any) in C. */
@@ -79,6 +79,10 @@ void audio_mixer_voice_set_volume(audio_mixer_voice_t *voice, float val);
 
 void audio_mixer_mix(float* buffer, size_t num_frames, float volume_override, bool override);
 
+/* Number of mixes in which a streamed voice ran out of decoded samples
+ * since audio_mixer_init. */
+unsigned audio_mixer_get_underruns(void);
+
 RETRO_END_DECLS
 
 #endif
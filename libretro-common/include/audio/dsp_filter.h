@@ -24,6 +24,7 @@
 #define __LIBRETRO_SDK_AUDIO_DSP_FILTER_H
 
 #include <retro_common_api.h>
+#include <libretro.h>
 
 RETRO_BEGIN_DECLS
 
@@ -44,9 +45,24 @@ struct retro_dsp_data
    unsigned output_frames;
 };
 
+/* Runs the chain on a block of interleaved stereo frames.
+ *
+ * If the config sets "pipeline_stages" above 1, the chain is
+ * split into that many stages once the plugs have been timed
+ * for a few blocks. Every stage after the first runs on its own
+ * thread one block behind the stage before it, so output then
+ * lags input by pipeline_stages - 1 blocks. */
 void retro_dsp_filter_process(retro_dsp_filter_t *dsp,
       struct retro_dsp_data *data);
 
+unsigned retro_dsp_filter_get_num_instances(retro_dsp_filter_t *dsp);
+
+/* Time spent in each instance of the chain, as of the last
+ * retro_dsp_filter_process() call. Only valid on the thread
+ * calling retro_dsp_filter_process(). */
+const struct retro_perf_counter *retro_dsp_filter_get_perf(
+      retro_dsp_filter_t *dsp, unsigned index);
+
 RETRO_END_DECLS
 
 #endif
@@ -56,6 +56,24 @@ bool rpng_save_image_argb(const char *path, const uint32_t *data,
 bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
       unsigned width, unsigned height, unsigned pitch);
 
+typedef struct rpng_encoder rpng_encoder_t;
+
+/* Reusable encoder. Images are split into up to @threads strips
+ * which are filtered and deflated in parallel; @fast trades file
+ * size for speed. Buffers are kept between saves. */
+rpng_encoder_t *rpng_encoder_new(unsigned threads, bool fast);
+
+void rpng_encoder_free(rpng_encoder_t *encoder);
+
+void rpng_encoder_set_fast(rpng_encoder_t *encoder, bool fast);
+
+bool rpng_encoder_save_image_argb(rpng_encoder_t *encoder,
+      const char *path, const uint32_t *data,
+      unsigned width, unsigned height, unsigned pitch);
+bool rpng_encoder_save_image_bgr24(rpng_encoder_t *encoder,
+      const char *path, const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch);
+
 RETRO_END_DECLS
 
 #endif
@@ -1090,6 +1090,48 @@ struct retro_vfs_interface_info
    struct retro_vfs_interface *iface;
 };
 
+#define RETRO_ENVIRONMENT_GET_VFS_MAP_INTERFACE (0x100 | RETRO_ENVIRONMENT_EXPERIMENTAL)
+                                           /* struct retro_vfs_map_interface_info * --
+                                            * Gets access to the VFS map interface.
+                                            * This is a frontend extension to the VFS interface, not part of
+                                            * any VFS API version, and it is versioned separately. It is
+                                            * numbered well clear of the sequential commands so that new
+                                            * API commands cannot collide with it. Its
+                                            * functions only accept handles opened through the interface from
+                                            * RETRO_ENVIRONMENT_GET_VFS_INTERFACE.
+                                            * Returns false if the frontend does not support it, in which case
+                                            * cores should read the data instead. */
+
+/* Get a read-only view of len bytes of the file starting at offset, so
+ * that data can be used in place instead of being read into a buffer.
+ * The view stays valid until it is unmapped or the file is closed, and
+ * must not be written to. Where the file cannot be memory mapped, the
+ * frontend returns a copy of the range instead.
+ * Returns NULL on error, or if the range is out of bounds.
+ * Introduced in VFS map interface v1 */
+typedef const void *(RETRO_CALLCONV *retro_vfs_map_t)(struct retro_vfs_file_handle *stream, uint64_t offset, uint64_t len);
+
+/* Release a view obtained from map. Returns 0 on success, -1 on failure
+ * Introduced in VFS map interface v1 */
+typedef int (RETRO_CALLCONV *retro_vfs_unmap_t)(struct retro_vfs_file_handle *stream, const void *data);
+
+struct retro_vfs_map_interface
+{
+	retro_vfs_map_t map;
+	retro_vfs_unmap_t unmap;
+};
+
+struct retro_vfs_map_interface_info
+{
+   /* Set by core: should this be higher than the version the front end supports,
+    * front end will return false in the RETRO_ENVIRONMENT_GET_VFS_MAP_INTERFACE call */
+   uint32_t required_interface_version;
+
+   /* Frontend writes interface pointer here. The frontend also sets the actual
+    * version, must be at least required_interface_version. */
+   struct retro_vfs_map_interface *iface;
+};
+
 enum retro_hw_render_interface_type
 {
 	RETRO_HW_RENDER_INTERFACE_VULKAN = 0,
@@ -32,12 +32,21 @@ RETRO_BEGIN_DECLS
 
 #include <boolean.h>
 
+struct file_list;
+
+/* Creates the actiondata of a deferred entry the first time it
+ * is asked for. 'tag' is the value the entry was deferred with. */
+typedef void (*file_list_materialize_t)(struct file_list *list,
+      size_t idx, unsigned tag);
+
 struct item_file
 {
    char *path;
    char *label;
    char *alt;
    unsigned type;
+   /* Non-zero while the entry waits for its actiondata */
+   unsigned deferred;
    size_t directory_ptr;
    size_t entry_idx;
    void *userdata;
@@ -50,6 +59,8 @@ typedef struct file_list
 
    size_t capacity;
    size_t size;
+
+   file_list_materialize_t materialize;
 } file_list_t;
 
 
@@ -132,10 +143,49 @@ void file_list_set_actiondata(const file_list_t *list, size_t idx, void *ptr);
 void file_list_get_alt_at_offset(const file_list_t *list, size_t index,
       const char **alt);
 
+/**
+ * @brief sorts the list on alt (or path), case-insensitively
+ *
+ * The entries are ordered through a precomputed key index, so
+ * each comparison touches a small key instead of a whole item.
+ *
+ * @param list
+ */
 void file_list_sort_on_alt(file_list_t *list);
 
 void file_list_sort_on_type(file_list_t *list);
 
+void file_list_set_materialize_cb(file_list_t *list,
+      file_list_materialize_t cb);
+
+/**
+ * @brief marks an entry as deferred
+ *
+ * The entry's actiondata is left empty until it is first read
+ * through file_list_get_actiondata_at_offset() or the entry falls
+ * inside a window passed to file_list_materialize(); the list's
+ * materialize callback is then called with @tag to create it.
+ *
+ * @param list
+ * @param idx
+ * @param tag non-zero caller-defined value
+ */
+void file_list_set_deferred(file_list_t *list, size_t idx, unsigned tag);
+
+bool file_list_is_deferred(const file_list_t *list, size_t idx);
+
+/**
+ * @brief materializes the deferred entries in [start, start + count)
+ *
+ * The window is clamped to the list size.
+ *
+ * @param list
+ * @param start
+ * @param count
+ */
+void file_list_materialize(const file_list_t *list,
+      size_t start, size_t count);
+
 bool file_list_search(const file_list_t *list, const char *needle,
       size_t *index);
 
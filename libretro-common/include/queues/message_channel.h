@@ -0,0 +1,105 @@
+/* Copyright  (C) 2010-2018 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (message_channel.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_MSG_CHANNEL_H
+#define __LIBRETRO_SDK_MSG_CHANNEL_H
+
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Messages shorter than this are stored inline in their slot.
+ * Longer ones are copied to the heap. */
+#define MSG_CHANNEL_MSG_SIZE 256
+
+/* A fixed-size, multi-producer single-consumer message channel.
+ * Any thread may push; only one thread may drain. Pushing never
+ * blocks: slots are claimed with compare-and-swap and a push into
+ * a full channel is dropped. Only messages of MSG_CHANNEL_MSG_SIZE
+ * bytes or more allocate. */
+typedef struct msg_channel msg_channel_t;
+
+typedef void (*msg_channel_cb_t)(void *userdata, const char *msg,
+      unsigned prio, unsigned duration, bool flush);
+
+/**
+ * msg_channel_new:
+ * @slots             : maximum number of pending messages
+ *
+ * Returns: NULL if allocation error, pointer to a message channel
+ * if successful. Has to be freed with msg_channel_free.
+ **/
+msg_channel_t *msg_channel_new(size_t slots);
+
+/**
+ * msg_channel_free:
+ * @chan              : pointer to channel object
+ *
+ * Frees the channel. No thread may push concurrently.
+ **/
+void msg_channel_free(msg_channel_t *chan);
+
+/**
+ * msg_channel_push:
+ * @chan              : pointer to channel object
+ * @tag               : coalescing key, or NULL
+ * @msg               : message text
+ * @prio              : priority level of the message
+ * @duration          : duration of the message
+ * @flush             : passed through to the consumer
+ *
+ * Publishes a message. If a message with the same non-NULL @tag
+ * is still pending, it is replaced instead of queueing another one,
+ * so frequent updates (e.g. progress) cost one slot at most.
+ * If a long message cannot be copied to the heap, it is truncated
+ * to MSG_CHANNEL_MSG_SIZE - 1 bytes.
+ *
+ * Returns: false if the message was dropped.
+ **/
+bool msg_channel_push(msg_channel_t *chan, const void *tag,
+      const char *msg, unsigned prio, unsigned duration, bool flush);
+
+/**
+ * msg_channel_drain:
+ * @chan              : pointer to channel object
+ * @cb                : invoked once per pending message
+ * @userdata          : passed to @cb
+ *
+ * Delivers pending messages ordered by the point at which each
+ * push completed. Messages pushed by one thread keep their order;
+ * pushes from different threads that overlap may come out in
+ * either order, and a message replaced through its tag moves to
+ * the position of its latest push. A push still in progress when
+ * the drain starts is left for the next drain.
+ * Must only be called from a single consumer thread.
+ *
+ * Returns: number of messages delivered.
+ **/
+unsigned msg_channel_drain(msg_channel_t *chan,
+      msg_channel_cb_t cb, void *userdata);
+
+RETRO_END_DECLS
+
+#endif
@@ -47,6 +47,10 @@ typedef struct RFILE RFILE;
 
 void filestream_vfs_init(const struct retro_vfs_interface_info* vfs_info);
 
+/* Optional; without it filestream_map copies ranges out of
+ * files opened through the frontend VFS. */
+void filestream_vfs_map_init(const struct retro_vfs_map_interface_info* map_info);
+
 int64_t filestream_get_size(RFILE *stream);
 
 /**
@@ -72,6 +76,23 @@ void filestream_rewind(RFILE *stream);
 
 int filestream_close(RFILE *stream);
 
+/**
+ * filestream_map:
+ * @stream           : file opened for reading.
+ * @offset           : start of the range.
+ * @len              : length of the range.
+ *
+ * Gets a read-only view of a range of the file, memory mapped where
+ * possible so the data can be used without reading it into a buffer.
+ * Falls back to a copy of the range when the file cannot be mapped.
+ *
+ * Returns: pointer to the range, valid until filestream_unmap or
+ * filestream_close, or NULL on error.
+ */
+const void *filestream_map(RFILE *stream, int64_t offset, int64_t len);
+
+int filestream_unmap(RFILE *stream, const void *data);
+
 int64_t filestream_read_file(const char *path, void **buf, int64_t *len);
 
 char *filestream_gets(RFILE *stream, char *s, size_t len);
@@ -62,4 +62,8 @@ int retro_vfs_file_rename_impl(const char *old_path, const char *new_path);
 
 const char *retro_vfs_file_get_path_impl(libretro_vfs_implementation_file *stream);
 
+const void *retro_vfs_file_map_impl(libretro_vfs_implementation_file *stream, uint64_t offset, uint64_t len);
+
+int retro_vfs_file_unmap_impl(libretro_vfs_implementation_file *stream, const void *data);
+
 #endif
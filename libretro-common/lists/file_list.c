@@ -21,6 +21,7 @@
  */
 
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -59,6 +60,7 @@ static void file_list_add(file_list_t *list, unsigned idx,
    list->list[idx].label         = NULL;
    list->list[idx].alt           = NULL;
    list->list[idx].type          = type;
+   list->list[idx].deferred      = 0;
    list->list[idx].directory_ptr = directory_ptr;
    list->list[idx].entry_idx     = entry_idx;
    list->list[idx].userdata      = NULL;
@@ -85,23 +87,11 @@ bool file_list_prepend(file_list_t *list,
       unsigned type, size_t directory_ptr,
       size_t entry_idx)
 {
-   unsigned i;
-
    if (!file_list_expand_if_needed(list))
       return false;
 
-   for (i = (unsigned)list->size; i > 0; i--)
-   {
-      struct item_file *copy = (struct item_file*)
-         calloc(1, sizeof(struct item_file));
-
-      memcpy(copy, &list->list[i-1], sizeof(struct item_file));
-
-      memcpy(&list->list[i-1], &list->list[i], sizeof(struct item_file));
-      memcpy(&list->list[i],             copy, sizeof(struct item_file));
-
-      free(copy);
-   }
+   memmove(&list->list[1], &list->list[0],
+         list->size * sizeof(struct item_file));
 
    file_list_add(list, 0, path, label, type,
          directory_ptr, entry_idx);
@@ -318,6 +308,14 @@ void file_list_get_alt_at_offset(const file_list_t *list, size_t idx,
          list->list[idx].alt : list->list[idx].path;
 }
 
+struct file_list_sort_key
+{
+   const char *str;
+   /* Characters 0-7 and 8-15 */
+   uint64_t prefix[2];
+   size_t idx;
+};
+
 static int file_list_alt_cmp(const void *a_, const void *b_)
 {
    const struct item_file *a = (const struct item_file*)a_;
@@ -339,9 +337,174 @@ static int file_list_type_cmp(const void *a_, const void *b_)
    return 1;
 }
 
+/* Eight characters of a case-folded key, packed so that an
+ * integer compare orders them the way strcmp() would. */
+static uint64_t file_list_sort_prefix(const char *str)
+{
+   unsigned i;
+   uint64_t prefix = 0;
+
+   for (i = 0; i < 8; i++)
+   {
+      uint64_t c = 0;
+
+      if (*str)
+         c = (unsigned char)*str++;
+
+      prefix = (prefix << 8) | c;
+   }
+
+   return prefix;
+}
+
+/* Orders keys whose prefixes are equal. */
+static int file_list_sort_key_cmp(const void *a_, const void *b_)
+{
+   const struct file_list_sort_key *a = (const struct file_list_sort_key*)a_;
+   const struct file_list_sort_key *b = (const struct file_list_sort_key*)b_;
+   int ret                            = strcmp(a->str + 16, b->str + 16);
+
+   if (ret)
+      return ret;
+
+   /* Keep equal keys in list order so the result is deterministic. */
+   return a->idx < b->idx ? -1 : (a->idx > b->idx);
+}
+
+/* LSD radix sort on the prefixes, then a qsort() of each run of
+ * equal prefixes. Returns whichever of the two buffers ends up
+ * holding the sorted keys. */
+static struct file_list_sort_key *file_list_sort_keys(
+      struct file_list_sort_key *keys,
+      struct file_list_sort_key *tmp, size_t size)
+{
+   size_t i, j;
+   unsigned pass;
+
+   for (pass = 0; pass < 16; pass++)
+   {
+      size_t count[256];
+      size_t pos                      = 0;
+      unsigned word                   = pass < 8 ? 1 : 0;
+      unsigned shift                  = (pass & 7) * 8;
+      struct file_list_sort_key *swap = NULL;
+
+      memset(count, 0, sizeof(count));
+
+      for (i = 0; i < size; i++)
+         count[(keys[i].prefix[word] >> shift) & 0xff]++;
+
+      /* Every key has the same byte here; nothing to do. */
+      if (count[(keys[0].prefix[word] >> shift) & 0xff] == size)
+         continue;
+
+      for (i = 0; i < 256; i++)
+      {
+         size_t c = count[i];
+         count[i] = pos;
+         pos     += c;
+      }
+
+      for (i = 0; i < size; i++)
+         tmp[count[(keys[i].prefix[word] >> shift) & 0xff]++] = keys[i];
+
+      swap = keys;
+      keys = tmp;
+      tmp  = swap;
+   }
+
+   for (i = 0; i < size; i = j)
+   {
+      for (j = i + 1; j < size
+            && keys[j].prefix[0] == keys[i].prefix[0]
+            && keys[j].prefix[1] == keys[i].prefix[1]; j++);
+
+      /* A zero low byte means the keys ended inside the prefix,
+       * so they are equal and already in list order. */
+      if (j - i > 1 && (keys[i].prefix[1] & 0xff))
+         qsort(&keys[i], j - i, sizeof(*keys), file_list_sort_key_cmp);
+   }
+
+   return keys;
+}
+
 void file_list_sort_on_alt(file_list_t *list)
 {
-   qsort(list->list, list->size, sizeof(list->list[0]), file_list_alt_cmp);
+   size_t i;
+   size_t folded_size              = 0;
+   char *folded                    = NULL;
+   char *out                       = NULL;
+   struct file_list_sort_key *keys = NULL;
+   struct file_list_sort_key *tmp  = NULL;
+   struct file_list_sort_key *res  = NULL;
+   struct item_file *items         = NULL;
+
+   if (!list || list->size < 2)
+      return;
+
+   for (i = 0; i < list->size; i++)
+   {
+      const struct item_file *item = &list->list[i];
+      const char *str              = item->alt ? item->alt : item->path;
+
+      folded_size += (str ? strlen(str) : 0) + 1;
+   }
+
+   /* Keys are case-folded once up front; most entries are then
+    * placed by their prefix alone, without any string compare. */
+   folded = (char*)malloc(folded_size);
+   keys   = (struct file_list_sort_key*)
+      malloc(list->size * sizeof(*keys));
+   tmp    = (struct file_list_sort_key*)
+      malloc(list->size * sizeof(*tmp));
+   items  = (struct item_file*)
+      malloc(list->size * sizeof(*items));
+
+   if (!folded || !keys || !tmp || !items)
+   {
+      qsort(list->list, list->size, sizeof(list->list[0]),
+            file_list_alt_cmp);
+      goto end;
+   }
+
+   out = folded;
+
+   for (i = 0; i < list->size; i++)
+   {
+      const struct item_file *item = &list->list[i];
+      const char *str              = item->alt ? item->alt : item->path;
+
+      keys[i].str = out;
+      keys[i].idx = i;
+
+      /* ASCII folding, same as strcasecmp() in the C locale. */
+      if (str)
+      {
+         for (; *str; str++)
+         {
+            char c = *str;
+            *out++ = (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+         }
+      }
+      *out++ = '\0';
+
+      keys[i].prefix[0] = file_list_sort_prefix(keys[i].str);
+      keys[i].prefix[1] = (keys[i].prefix[0] & 0xff)
+         ? file_list_sort_prefix(keys[i].str + 8) : 0;
+   }
+
+   res = file_list_sort_keys(keys, tmp, list->size);
+
+   for (i = 0; i < list->size; i++)
+      items[i] = list->list[res[i].idx];
+
+   memcpy(list->list, items, list->size * sizeof(*items));
+
+end:
+   free(folded);
+   free(keys);
+   free(tmp);
+   free(items);
 }
 
 void file_list_sort_on_type(file_list_t *list)
@@ -374,6 +537,8 @@ void *file_list_get_actiondata_at_offset(const file_list_t *list, size_t idx)
 {
    if (!list)
       return NULL;
+   if (list->list[idx].deferred)
+      file_list_materialize(list, idx, 1);
    return list->list[idx].actiondata;
 }
 
@@ -399,7 +564,55 @@ void *file_list_get_last_actiondata(const file_list_t *list)
 {
    if (!list)
       return NULL;
-   return list->list[list->size - 1].actiondata;
+   return file_list_get_actiondata_at_offset(list, list->size - 1);
+}
+
+void file_list_set_materialize_cb(file_list_t *list,
+      file_list_materialize_t cb)
+{
+   if (list)
+      list->materialize = cb;
+}
+
+void file_list_set_deferred(file_list_t *list, size_t idx, unsigned tag)
+{
+   if (!list || idx >= list->size)
+      return;
+   list->list[idx].deferred = tag;
+}
+
+bool file_list_is_deferred(const file_list_t *list, size_t idx)
+{
+   if (!list || idx >= list->size)
+      return false;
+   return list->list[idx].deferred != 0;
+}
+
+void file_list_materialize(const file_list_t *list,
+      size_t start, size_t count)
+{
+   size_t i, end;
+
+   if (!list || start >= list->size)
+      return;
+
+   end = list->size;
+   if (count < end - start)
+      end = start + count;
+
+   for (i = start; i < end; i++)
+   {
+      unsigned tag = list->list[i].deferred;
+
+      if (!tag)
+         continue;
+
+      /* Cleared first so that the callback may read the entry back. */
+      list->list[i].deferred = 0;
+
+      if (list->materialize)
+         list->materialize((file_list_t*)list, i, tag);
+   }
 }
 
 void file_list_get_at_offset(const file_list_t *list, size_t idx,
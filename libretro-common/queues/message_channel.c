@@ -0,0 +1,352 @@
+/* Copyright  (C) 2010-2018 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (message_channel.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <boolean.h>
+#include <queues/message_channel.h>
+#include <compat/strl.h>
+#include <compat/posix_string.h>
+
+#if defined(_MSC_VER) && defined(_WIN32)
+#include <windows.h>
+#define MSG_CHANNEL_CAS(ptr, oldval, newval) \
+   (InterlockedCompareExchange((volatile LONG*)(ptr), (newval), (oldval)) == (LONG)(oldval))
+#define MSG_CHANNEL_ADD(ptr, val) \
+   ((unsigned)InterlockedExchangeAdd((volatile LONG*)(ptr), (val)) + (val))
+#define MSG_CHANNEL_BARRIER() MemoryBarrier()
+#elif defined(__GNUC__) && ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1))
+#define MSG_CHANNEL_CAS(ptr, oldval, newval) \
+   __sync_bool_compare_and_swap((ptr), (oldval), (newval))
+#define MSG_CHANNEL_ADD(ptr, val) __sync_add_and_fetch((ptr), (val))
+#define MSG_CHANNEL_BARRIER() __sync_synchronize()
+#else
+/* No atomics available; serialize through a lock instead. */
+#define MSG_CHANNEL_LOCKED
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+#endif
+
+enum msg_channel_state
+{
+   MSG_CHANNEL_FREE = 0,
+   MSG_CHANNEL_WRITING,
+   MSG_CHANNEL_READY,
+   MSG_CHANNEL_READING
+};
+
+struct msg_channel_slot
+{
+   volatile unsigned state;
+   unsigned seq;
+   unsigned prio;
+   unsigned duration;
+   bool flush;
+   const void *tag;
+   /* Heap copy of messages too long for msg, otherwise NULL */
+   char *long_msg;
+   char msg[MSG_CHANNEL_MSG_SIZE];
+};
+
+struct msg_channel
+{
+   struct msg_channel_slot *slots;
+   struct msg_channel_slot **pending;
+   size_t num_slots;
+   volatile unsigned seq;
+   volatile unsigned ready;
+#if defined(MSG_CHANNEL_LOCKED) && defined(HAVE_THREADS)
+   slock_t *lock;
+#endif
+};
+
+#ifdef MSG_CHANNEL_LOCKED
+static bool msg_channel_cas(msg_channel_t *chan, volatile unsigned *ptr,
+      unsigned oldval, unsigned newval)
+{
+   bool ret = false;
+#ifdef HAVE_THREADS
+   slock_lock(chan->lock);
+#endif
+   if (*ptr == oldval)
+   {
+      *ptr = newval;
+      ret  = true;
+   }
+#ifdef HAVE_THREADS
+   slock_unlock(chan->lock);
+#endif
+   return ret;
+}
+
+static unsigned msg_channel_add(msg_channel_t *chan,
+      volatile unsigned *ptr, unsigned val)
+{
+   unsigned ret;
+#ifdef HAVE_THREADS
+   slock_lock(chan->lock);
+#endif
+   ret = *ptr += val;
+#ifdef HAVE_THREADS
+   slock_unlock(chan->lock);
+#endif
+   return ret;
+}
+
+#define MSG_CHANNEL_CAS(ptr, oldval, newval) msg_channel_cas(chan, ptr, oldval, newval)
+#define MSG_CHANNEL_ADD(ptr, val) msg_channel_add(chan, ptr, val)
+#define MSG_CHANNEL_BARRIER()
+#endif
+
+/**
+ * msg_channel_new:
+ * @slots             : maximum number of pending messages
+ *
+ * Returns: NULL if allocation error, pointer to a message channel
+ * if successful. Has to be freed with msg_channel_free.
+ **/
+msg_channel_t *msg_channel_new(size_t slots)
+{
+   msg_channel_t *chan = (msg_channel_t*)calloc(1, sizeof(*chan));
+
+   if (!chan || !slots)
+      goto error;
+
+   chan->num_slots = slots;
+   chan->slots     = (struct msg_channel_slot*)
+      calloc(slots, sizeof(*chan->slots));
+   chan->pending   = (struct msg_channel_slot**)
+      calloc(slots, sizeof(*chan->pending));
+
+   if (!chan->slots || !chan->pending)
+      goto error;
+
+#if defined(MSG_CHANNEL_LOCKED) && defined(HAVE_THREADS)
+   if (!(chan->lock = slock_new()))
+      goto error;
+#endif
+
+   return chan;
+
+error:
+   msg_channel_free(chan);
+   return NULL;
+}
+
+/**
+ * msg_channel_free:
+ * @chan              : pointer to channel object
+ *
+ * Frees the channel. No thread may push concurrently.
+ **/
+void msg_channel_free(msg_channel_t *chan)
+{
+   size_t i;
+
+   if (!chan)
+      return;
+
+   if (chan->slots)
+      for (i = 0; i < chan->num_slots; i++)
+         free(chan->slots[i].long_msg);
+
+#if defined(MSG_CHANNEL_LOCKED) && defined(HAVE_THREADS)
+   if (chan->lock)
+      slock_free(chan->lock);
+#endif
+   free(chan->slots);
+   free(chan->pending);
+   free(chan);
+}
+
+static void msg_channel_publish(msg_channel_t *chan,
+      struct msg_channel_slot *slot, bool was_ready)
+{
+   slot->seq   = MSG_CHANNEL_ADD(&chan->seq, 1);
+   /* Contents must be visible before the slot is. */
+   MSG_CHANNEL_BARRIER();
+   slot->state = MSG_CHANNEL_READY;
+   if (!was_ready)
+      MSG_CHANNEL_ADD(&chan->ready, 1);
+}
+
+/**
+ * msg_channel_push:
+ * @chan              : pointer to channel object
+ * @tag               : coalescing key, or NULL
+ * @msg               : message text
+ * @prio              : priority level of the message
+ * @duration          : duration of the message
+ * @flush             : passed through to the consumer
+ *
+ * Publishes a message. If a message with the same non-NULL @tag
+ * is still pending, it is replaced instead of queueing another one,
+ * so frequent updates (e.g. progress) cost one slot at most.
+ *
+ * Returns: false if the message was dropped.
+ **/
+bool msg_channel_push(msg_channel_t *chan, const void *tag,
+      const char *msg, unsigned prio, unsigned duration, bool flush)
+{
+   size_t i;
+   struct msg_channel_slot *slot = NULL;
+   bool was_ready                = false;
+
+   if (!chan)
+      return false;
+
+   if (tag)
+   {
+      for (i = 0; i < chan->num_slots; i++)
+      {
+         struct msg_channel_slot *cur = &chan->slots[i];
+
+         if (cur->tag == tag && MSG_CHANNEL_CAS(&cur->state,
+                  MSG_CHANNEL_READY, MSG_CHANNEL_WRITING))
+         {
+            /* The consumer may have freed and another producer
+             * reused the slot between the check and the claim. */
+            if (cur->tag == tag)
+            {
+               slot      = cur;
+               was_ready = true;
+               break;
+            }
+            cur->state = MSG_CHANNEL_READY;
+         }
+      }
+   }
+
+   for (i = 0; !slot && i < chan->num_slots; i++)
+   {
+      struct msg_channel_slot *cur = &chan->slots[i];
+
+      if (MSG_CHANNEL_CAS(&cur->state,
+               MSG_CHANNEL_FREE, MSG_CHANNEL_WRITING))
+         slot = cur;
+   }
+
+   if (!slot)
+      return false;
+
+   slot->tag      = tag;
+   slot->prio     = prio;
+   slot->duration = duration;
+   slot->flush    = flush;
+
+   /* A replaced message may have left its heap copy behind. */
+   if (slot->long_msg)
+   {
+      free(slot->long_msg);
+      slot->long_msg = NULL;
+   }
+
+   if (msg)
+   {
+      size_t len = strlcpy(slot->msg, msg, sizeof(slot->msg));
+
+      if (len >= sizeof(slot->msg))
+         slot->long_msg = strdup(msg);
+   }
+   else
+      slot->msg[0] = '\0';
+
+   msg_channel_publish(chan, slot, was_ready);
+
+   return true;
+}
+
+/**
+ * msg_channel_drain:
+ * @chan              : pointer to channel object
+ * @cb                : invoked once per pending message
+ * @userdata          : passed to @cb
+ *
+ * Delivers pending messages ordered by the point at which each
+ * push completed. Messages pushed by one thread keep their order;
+ * pushes from different threads that overlap may come out in
+ * either order, and a message replaced through its tag moves to
+ * the position of its latest push. A push still in progress when
+ * the drain starts is left for the next drain.
+ * Must only be called from a single consumer thread.
+ *
+ * Returns: number of messages delivered.
+ **/
+unsigned msg_channel_drain(msg_channel_t *chan,
+      msg_channel_cb_t cb, void *userdata)
+{
+   size_t i, j;
+   unsigned limit;
+   unsigned count = 0;
+
+   if (!chan || !chan->ready)
+      return 0;
+
+   /* A message published after the scan has passed a slot that was
+    * still being written could overtake it. Anything sequenced after
+    * this point is therefore left for the next drain. */
+   limit = chan->seq;
+   MSG_CHANNEL_BARRIER();
+
+   for (i = 0; i < chan->num_slots; i++)
+   {
+      struct msg_channel_slot *slot = &chan->slots[i];
+
+      if (!MSG_CHANNEL_CAS(&slot->state,
+               MSG_CHANNEL_READY, MSG_CHANNEL_READING))
+         continue;
+
+      if ((int)(slot->seq - limit) > 0)
+      {
+         slot->state = MSG_CHANNEL_READY;
+         continue;
+      }
+
+      MSG_CHANNEL_ADD(&chan->ready, (unsigned)-1);
+
+      /* Insertion sort by sequence number; the channel is small. */
+      for (j = count; j > 0 &&
+            (int)(chan->pending[j - 1]->seq - slot->seq) > 0; j--)
+         chan->pending[j] = chan->pending[j - 1];
+      chan->pending[j] = slot;
+      count++;
+   }
+
+   for (i = 0; i < count; i++)
+   {
+      struct msg_channel_slot *slot = chan->pending[i];
+
+      if (cb)
+         cb(userdata, slot->long_msg ? slot->long_msg : slot->msg,
+               slot->prio, slot->duration, slot->flush);
+
+      free(slot->long_msg);
+      slot->long_msg = NULL;
+      slot->tag      = NULL;
+      MSG_CHANNEL_BARRIER();
+      slot->state = MSG_CHANNEL_FREE;
+   }
+
+   return count;
+}
@@ -33,16 +33,29 @@ struct queue_elem
    unsigned duration;
    unsigned prio;
    char *msg;
+   size_t msg_size;
+   bool has_msg;
 };
 
+/* Elements and their message buffers are allocated once
+ * and recycled, so steady-state pushes do not allocate. */
 struct msg_queue
 {
    struct queue_elem **elems;
+   struct queue_elem **free_elems;
+   struct queue_elem *pool;
+   size_t num_free;
    size_t ptr;
    size_t size;
    char *tmp_msg;
+   size_t tmp_msg_size;
 };
 
+static void msg_queue_release(msg_queue_t *queue, struct queue_elem *elem)
+{
+   queue->free_elems[queue->num_free++] = elem;
+}
+
 /**
  * msg_queue_new:
  * @size              : maximum size of message
@@ -54,27 +67,36 @@ struct msg_queue
  **/
 msg_queue_t *msg_queue_new(size_t size)
 {
-   struct queue_elem **elems = NULL;
+   size_t i;
    msg_queue_t *queue        = (msg_queue_t*)calloc(1, sizeof(*queue));
 
    if (!queue)
       return NULL;
 
-   queue->size = size + 1;
-
-   elems = (struct queue_elem**)calloc(queue->size,
+   queue->size       = size + 1;
+   queue->elems      = (struct queue_elem**)calloc(queue->size,
+         sizeof(struct queue_elem*));
+   queue->free_elems = (struct queue_elem**)calloc(queue->size,
          sizeof(struct queue_elem*));
+   queue->pool       = (struct queue_elem*)calloc(queue->size,
+         sizeof(struct queue_elem));
 
-   if (!elems)
-   {
-      free(queue);
-      return NULL;
-   }
+   if (!queue->elems || !queue->free_elems || !queue->pool)
+      goto error;
+
+   for (i = 0; i < size; i++)
+      msg_queue_release(queue, &queue->pool[i]);
 
-   queue->elems = elems;
    queue->ptr   = 1;
 
    return queue;
+
+error:
+   free(queue->elems);
+   free(queue->free_elems);
+   free(queue->pool);
+   free(queue);
+   return NULL;
 }
 
 /**
@@ -85,11 +107,17 @@ msg_queue_t *msg_queue_new(size_t size)
  **/
 void msg_queue_free(msg_queue_t *queue)
 {
-   if (queue)
-   {
-      msg_queue_clear(queue);
-      free(queue->elems);
-   }
+   size_t i;
+
+   if (!queue)
+      return;
+
+   for (i = 0; i < queue->size; i++)
+      free(queue->pool[i].msg);
+   free(queue->pool);
+   free(queue->free_elems);
+   free(queue->elems);
+   free(queue->tmp_msg);
    free(queue);
 }
 
@@ -111,17 +139,31 @@ void msg_queue_push(msg_queue_t *queue, const char *msg,
    size_t tmp_ptr = 0;
    struct queue_elem *new_elem = NULL;
 
-   if (!queue || queue->ptr >= queue->size)
+   if (!queue || queue->ptr >= queue->size || !queue->num_free)
       return;
 
-   new_elem                      = (struct queue_elem*)
-      calloc(1, sizeof(struct queue_elem));
-   if (!new_elem)
-      return;
+   new_elem                      = queue->free_elems[queue->num_free - 1];
+
+   if (msg)
+   {
+      size_t len = strlen(msg) + 1;
+
+      if (len > new_elem->msg_size)
+      {
+         char *buf = (char*)realloc(new_elem->msg, len);
+         if (!buf)
+            return;
+         new_elem->msg      = buf;
+         new_elem->msg_size = len;
+      }
+      memcpy(new_elem->msg, msg, len);
+   }
+
+   queue->num_free--;
 
    new_elem->prio                = prio;
    new_elem->duration            = duration;
-   new_elem->msg                 = msg ? strdup(msg) : NULL;
+   new_elem->has_msg             = msg != NULL;
 
    queue->elems[queue->ptr]      = new_elem;
 
@@ -157,16 +199,10 @@ void msg_queue_clear(msg_queue_t *queue)
 
    for (i = 1; i < queue->ptr; i++)
    {
-      if (queue->elems[i])
-      {
-         free(queue->elems[i]->msg);
-         free(queue->elems[i]);
-         queue->elems[i] = NULL;
-      }
+      msg_queue_release(queue, queue->elems[i]);
+      queue->elems[i] = NULL;
    }
    queue->ptr = 1;
-   free(queue->tmp_msg);
-   queue->tmp_msg = NULL;
 }
 
 /**
@@ -180,61 +216,73 @@ void msg_queue_clear(msg_queue_t *queue)
  **/
 const char *msg_queue_pull(msg_queue_t *queue)
 {
-   struct queue_elem *front  = NULL, *last = NULL;
-   size_t tmp_ptr = 1;
-
-   (void)tmp_ptr;
+   char *buf                 = NULL;
+   size_t buf_size           = 0;
+   bool has_msg              = false;
+   struct queue_elem *front  = NULL;
+   size_t tmp_ptr            = 1;
 
    /* Nothing in queue. */
    if (!queue || queue->ptr == 1)
       return NULL;
 
-   front = (struct queue_elem*)queue->elems[1];
+   front = queue->elems[1];
    front->duration--;
    if (front->duration > 0)
-      return front->msg;
-
-   free(queue->tmp_msg);
-   queue->tmp_msg = front->msg;
-   front->msg = NULL;
-
-   front = (struct queue_elem*)queue->elems[1];
-   last  = (struct queue_elem*)queue->elems[--queue->ptr];
-   queue->elems[1] = last;
-   free(front);
+      return front->has_msg ? front->msg : NULL;
+
+   /* Hand the expiring message over to tmp_msg so it stays
+    * valid until the next pull; the element keeps the old
+    * tmp_msg buffer for reuse. */
+   has_msg             = front->has_msg;
+   buf                 = queue->tmp_msg;
+   buf_size            = queue->tmp_msg_size;
+   queue->tmp_msg      = front->msg;
+   queue->tmp_msg_size = front->msg_size;
+   front->msg          = buf;
+   front->msg_size     = buf_size;
+
+   msg_queue_release(queue, front);
+   queue->elems[1]     = queue->elems[--queue->ptr];
+   queue->elems[queue->ptr] = NULL;
 
    for (;;)
    {
       struct queue_elem *parent = NULL;
-      struct queue_elem *child  = NULL;
+      size_t left_index         = tmp_ptr * 2;
+      size_t right_index        = left_index + 1;
       size_t switch_index       = tmp_ptr;
-      bool left                 = (tmp_ptr * 2 <= queue->ptr)
-         && (queue->elems[tmp_ptr] < queue->elems[tmp_ptr * 2]);
-      bool right                = (tmp_ptr * 2 + 1 <= queue->ptr)
-         && (queue->elems[tmp_ptr] < queue->elems[tmp_ptr * 2 + 1]);
 
-      if (!left && !right)
-         break;
+      if (left_index < queue->ptr
+            && queue->elems[left_index]->prio
+               > queue->elems[switch_index]->prio)
+         switch_index = left_index;
+      if (right_index < queue->ptr
+            && queue->elems[right_index]->prio
+               > queue->elems[switch_index]->prio)
+         switch_index = right_index;
 
-      if (left && !right)
-         switch_index <<= 1;
-      else if (right && !left)
-         switch_index += switch_index + 1;
-      else
-      {
-         if (queue->elems[tmp_ptr * 2]
-               >= queue->elems[tmp_ptr * 2 + 1])
-            switch_index <<= 1;
-         else
-            switch_index += switch_index + 1;
-      }
+      if (switch_index == tmp_ptr)
+         break;
 
-      parent = (struct queue_elem*)queue->elems[tmp_ptr];
-      child  = (struct queue_elem*)queue->elems[switch_index];
-      queue->elems[tmp_ptr]      = child;
+      parent                     = queue->elems[tmp_ptr];
+      queue->elems[tmp_ptr]      = queue->elems[switch_index];
       queue->elems[switch_index] = parent;
       tmp_ptr                    = switch_index;
    }
 
-   return queue->tmp_msg;
+   return has_msg ? queue->tmp_msg : NULL;
+}
+
+/**
+ * msg_queue_size:
+ * @queue             : pointer to queue object
+ *
+ * Returns: number of messages in the queue.
+ **/
+size_t msg_queue_size(msg_queue_t *queue)
+{
+   if (!queue)
+      return 0;
+   return queue->ptr - 1;
 }
@@ -0,0 +1,216 @@
+/* Copyright  (C) 2010-2018 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (resampler_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Measures speed and quality of the audio resamplers.
+ *
+ * A 1 kHz stereo sine is fed through every resampler at every quality
+ * level, in blocks like the audio driver uses. Speed is reported in
+ * nanoseconds per output frame; quality as the SNR of the output
+ * against the best fitting sine at the output rate.
+ *
+ * "fixed" passes the same ratio on every call, which lets the sinc
+ * resampler use its polyphase path. "varying" nudges the ratio by
+ * one part per billion on every call, the way dynamic rate control
+ * does, which keeps it on the general path. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <audio/audio_resampler.h>
+#include <compat/strl.h>
+#include <features/features_cpu.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BENCH_BLOCK_FRAMES 1024
+#define BENCH_TONE_HZ      1000.0
+
+struct bench_rates
+{
+   double in_rate;
+   double out_rate;
+};
+
+static const struct bench_rates bench_rates[] = {
+   { 32040.0, 48000.0 },
+   { 44100.0, 48000.0 },
+   { 48000.0, 44100.0 },
+};
+
+static const char *bench_quality_names[] = {
+   "dontcare", "lowest", "lower", "normal", "higher", "highest"
+};
+
+/* Least-squares fit of a*sin + b*cos at frequency w; returns the SNR
+ * of the fit against the residual, in dB. */
+static double bench_snr(const float *out, size_t frames, size_t skip,
+      double w)
+{
+   size_t i;
+   double ss = 0.0, cc = 0.0, sc = 0.0, ys = 0.0, yc = 0.0;
+   double a, b, det, signal = 0.0, noise = 0.0;
+
+   for (i = skip; i < frames; i++)
+   {
+      double s = sin(w * i);
+      double c = cos(w * i);
+      double y = out[i * 2];
+      ss += s * s;
+      cc += c * c;
+      sc += s * c;
+      ys += y * s;
+      yc += y * c;
+   }
+
+   det = ss * cc - sc * sc;
+   a   = (ys * cc - yc * sc) / det;
+   b   = (yc * ss - ys * sc) / det;
+
+   for (i = skip; i < frames; i++)
+   {
+      double fit = a * sin(w * i) + b * cos(w * i);
+      double err = out[i * 2] - fit;
+      signal    += fit * fit;
+      noise     += err * err;
+   }
+
+   if (noise <= 0.0)
+      return 999.0;
+   return 10.0 * log10(signal / noise);
+}
+
+static void bench_run(const char *ident, enum resampler_quality quality,
+      const struct bench_rates *rates, bool varying,
+      const float *in, size_t in_frames, float *out, size_t out_cap)
+{
+   size_t pos                         = 0;
+   size_t out_frames                  = 0;
+   unsigned call                      = 0;
+   void *re                           = NULL;
+   const retro_resampler_t *resampler = NULL;
+   double ratio                       = rates->out_rate / rates->in_rate;
+   char name[32];
+   retro_time_t start, elapsed;
+
+   /* Driver lookup treats a pointer to the driver's own ident string
+    * as a mismatch, and identical literals may be merged. */
+   strlcpy(name, ident, sizeof(name));
+
+   if (!retro_resampler_realloc(&re, &resampler, name, quality, ratio))
+   {
+      printf("%-8s %-8s failed to initialize\n", ident,
+            bench_quality_names[quality]);
+      return;
+   }
+
+   start = cpu_features_get_time_usec();
+
+   while (pos < in_frames)
+   {
+      struct resampler_data info;
+      size_t frames      = in_frames - pos;
+
+      if (frames > BENCH_BLOCK_FRAMES)
+         frames          = BENCH_BLOCK_FRAMES;
+
+      /* Stop before the output buffer could overflow. */
+      if ((out_frames + frames * ratio + 16) > out_cap)
+         break;
+
+      info.data_in       = in + pos * 2;
+      info.data_out      = out + out_frames * 2;
+      info.input_frames  = frames;
+      info.output_frames = 0;
+      info.ratio         = ratio;
+
+      if (varying)
+         info.ratio      = ratio * ((call++ & 1) ? 1.000000001 : 0.999999999);
+
+      resampler->process(re, &info);
+
+      pos               += frames;
+      out_frames        += info.output_frames;
+   }
+
+   elapsed = cpu_features_get_time_usec() - start;
+
+   printf("%-8s %-8s %-8s %6.0f -> %6.0f  %8.2f ns/frame  %7.1f dB\n",
+         ident, bench_quality_names[quality], varying ? "varying" : "fixed",
+         rates->in_rate, rates->out_rate,
+         out_frames ? elapsed * 1000.0 / out_frames : 0.0,
+         bench_snr(out, out_frames, out_frames / 8,
+            2.0 * M_PI * BENCH_TONE_HZ / rates->out_rate));
+
+   resampler->free(re);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned r, q, i, v;
+   float *in, *out;
+   size_t out_cap;
+   double seconds          = 2.0;
+   static const char *idents[] = { "nearest",
+#ifdef HAVE_CC_RESAMPLER
+      "CC",
+#endif
+      "sinc" };
+
+   if (argc > 1)
+      seconds = atof(argv[1]);
+
+   for (r = 0; r < sizeof(bench_rates) / sizeof(bench_rates[0]); r++)
+   {
+      const struct bench_rates *rates = &bench_rates[r];
+      size_t in_frames                = (size_t)(rates->in_rate * seconds);
+
+      in      = (float*)malloc(in_frames * 2 * sizeof(float));
+      out_cap = (size_t)(in_frames * rates->out_rate / rates->in_rate) + 64;
+      out     = (float*)malloc(out_cap * 2 * sizeof(float));
+
+      if (!in || !out)
+         return 1;
+
+      for (i = 0; i < in_frames; i++)
+      {
+         float s       = (float)(0.5 * sin(2.0 * M_PI * BENCH_TONE_HZ
+                  * i / rates->in_rate));
+         in[i * 2 + 0] = s;
+         in[i * 2 + 1] = s;
+      }
+
+      for (i = 0; i < sizeof(idents) / sizeof(idents[0]); i++)
+         for (q = RESAMPLER_QUALITY_LOWEST; q <= RESAMPLER_QUALITY_HIGHEST; q++)
+            for (v = 0; v < 2; v++)
+               bench_run(idents[i], (enum resampler_quality)q, rates, v != 0,
+                     in, in_frames, out, out_cap);
+
+      free(in);
+      free(out);
+   }
+
+   return 0;
+}
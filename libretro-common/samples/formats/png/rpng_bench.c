@@ -0,0 +1,219 @@
+/* Copyright  (C) 2010-2018 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rpng_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Decodes PNG files with rpng and stb_image, checks that both
+ * decoders agree and reports the average decode time of each. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <formats/rpng.h>
+#include <formats/image.h>
+#include <features/features_cpu.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#include "../../../../deps/stb/stb_image.h"
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+   long size;
+   uint8_t *buf = NULL;
+   FILE *file   = fopen(path, "rb");
+
+   if (!file)
+      return NULL;
+
+   fseek(file, 0, SEEK_END);
+   size = ftell(file);
+   fseek(file, 0, SEEK_SET);
+
+   if (size > 0)
+      buf = (uint8_t*)malloc(size);
+
+   if (buf && fread(buf, 1, size, file) != (size_t)size)
+   {
+      free(buf);
+      buf = NULL;
+   }
+
+   fclose(file);
+   *len = (size_t)size;
+   return buf;
+}
+
+static uint32_t *decode_rpng(uint8_t *buf, size_t len,
+      unsigned *width, unsigned *height)
+{
+   int retval;
+   uint32_t *data = NULL;
+   rpng_t *rpng   = rpng_alloc();
+
+   if (!rpng)
+      return NULL;
+
+   if (!rpng_set_buf_ptr(rpng, buf) || !rpng_start(rpng))
+      goto end;
+
+   while (rpng_iterate_image(rpng));
+
+   if (!rpng_is_valid(rpng))
+      goto end;
+
+   do
+   {
+      retval = rpng_process_image(rpng,
+            (void**)&data, len, width, height);
+   }while(retval == IMAGE_PROCESS_NEXT);
+
+   if (retval == IMAGE_PROCESS_ERROR || retval == IMAGE_PROCESS_ERROR_END)
+   {
+      free(data);
+      data = NULL;
+   }
+
+end:
+   rpng_free(rpng);
+   return data;
+}
+
+static bool compare(const uint32_t *argb, const uint8_t *rgba,
+      unsigned width, unsigned height)
+{
+   unsigned i;
+
+   for (i = 0; i < width * height; i++, rgba += 4)
+   {
+      uint32_t col = ((uint32_t)rgba[3] << 24) | ((uint32_t)rgba[0] << 16)
+         | ((uint32_t)rgba[1] << 8) | rgba[2];
+
+      if (argb[i] != col)
+      {
+         fprintf(stderr, "  Mismatch at pixel %u (%u, %u): %08x != %08x\n",
+               i, i % width, i / width, argb[i], col);
+         return false;
+      }
+   }
+
+   return true;
+}
+
+static int bench_file(const char *path, unsigned iterations)
+{
+   unsigned i;
+   int w, h, comp;
+   retro_time_t start, rpng_time, stb_time;
+   unsigned width  = 0;
+   unsigned height = 0;
+   uint32_t *data  = NULL;
+   uint8_t *ref    = NULL;
+   size_t len      = 0;
+   uint8_t *buf    = read_file(path, &len);
+   int ret         = 1;
+
+   if (!buf)
+   {
+      fprintf(stderr, "%s: could not read file.\n", path);
+      return 1;
+   }
+
+   data = decode_rpng(buf, len, &width, &height);
+   ref  = stbi_load_from_memory(buf, (int)len, &w, &h, &comp, 4);
+
+   if (!data || !ref)
+   {
+      fprintf(stderr, "%s: decode failed (rpng: %s, stb_image: %s).\n",
+            path, data ? "ok" : "failed", ref ? "ok" : "failed");
+      goto end;
+   }
+
+   if (width != (unsigned)w || height != (unsigned)h)
+   {
+      fprintf(stderr, "%s: size mismatch (%ux%u vs %dx%d).\n",
+            path, width, height, w, h);
+      goto end;
+   }
+
+   if (!compare(data, ref, width, height))
+   {
+      fprintf(stderr, "%s: rpng and stb_image differ.\n", path);
+      goto end;
+   }
+
+   free(data);
+   stbi_image_free(ref);
+   data = NULL;
+   ref  = NULL;
+
+   start = cpu_features_get_time_usec();
+   for (i = 0; i < iterations; i++)
+      free(decode_rpng(buf, len, &width, &height));
+   rpng_time = cpu_features_get_time_usec() - start;
+
+   start = cpu_features_get_time_usec();
+   for (i = 0; i < iterations; i++)
+      stbi_image_free(stbi_load_from_memory(buf, (int)len, &w, &h, &comp, 4));
+   stb_time = cpu_features_get_time_usec() - start;
+
+   printf("%-32s %5ux%-5u rpng: %8.3f ms  stb_image: %8.3f ms\n",
+         path, width, height,
+         rpng_time / (1000.0 * iterations),
+         stb_time  / (1000.0 * iterations));
+
+   ret = 0;
+
+end:
+   free(data);
+   if (ref)
+      stbi_image_free(ref);
+   free(buf);
+   return ret;
+}
+
+int main(int argc, char *argv[])
+{
+   int i;
+   int ret             = 0;
+   unsigned iterations = 20;
+   int first           = 1;
+
+   if (argc > 2 && !strcmp(argv[1], "-n"))
+   {
+      iterations = (unsigned)strtoul(argv[2], NULL, 0);
+      if (!iterations)
+         iterations = 1;
+      first      = 3;
+   }
+
+   if (first >= argc)
+   {
+      fprintf(stderr, "Usage: %s [-n iterations] <png file>...\n", argv[0]);
+      return 1;
+   }
+
+   for (i = first; i < argc; i++)
+      ret |= bench_file(argv[i], iterations);
+
+   return ret;
+}
@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <features/features_cpu.h>
+#include <gfx/scaler/pixconv.h>
+
+#define BENCH_WIDTH  640
+#define BENCH_HEIGHT 480
+#define BENCH_FRAMES 200
+
+/* Row padding and base offsets for the correctness check, so that
+ * vector loops see unaligned rows and odd-sized tails. */
+#define CHECK_WIDTH  69
+#define CHECK_HEIGHT 3
+#define CHECK_PAD    13
+#define CHECK_GUARD  0xa5
+
+typedef void (*pixconv_t)(void *output, const void *input,
+      int width, int height, int out_stride, int in_stride);
+
+/* Built from pixconv_ref.c */
+#define PIXCONV_REF(name) void ref_##name(void *output, const void *input, \
+      int width, int height, int out_stride, int in_stride)
+PIXCONV_REF(conv_rgb565_0rgb1555);
+PIXCONV_REF(conv_0rgb1555_rgb565);
+PIXCONV_REF(conv_0rgb1555_argb8888);
+PIXCONV_REF(conv_rgb565_argb8888);
+PIXCONV_REF(conv_rgb565_abgr8888);
+PIXCONV_REF(conv_rgba4444_argb8888);
+PIXCONV_REF(conv_rgba4444_rgb565);
+PIXCONV_REF(conv_bgr24_argb8888);
+PIXCONV_REF(conv_argb8888_0rgb1555);
+PIXCONV_REF(conv_argb8888_bgr24);
+PIXCONV_REF(conv_argb8888_abgr8888);
+PIXCONV_REF(conv_0rgb1555_bgr24);
+PIXCONV_REF(conv_rgb565_bgr24);
+PIXCONV_REF(conv_yuyv_argb8888);
+
+struct pixconv_bench
+{
+   const char *name;
+   pixconv_t conv;
+   pixconv_t ref;
+   unsigned in_bpp;
+   unsigned out_bpp;
+};
+
+#define BENCH(name, conv, in_bpp, out_bpp) \
+   { name, conv, ref_##conv, in_bpp, out_bpp }
+
+static const struct pixconv_bench benches[] = {
+   BENCH("rgb565   -> 0rgb1555", conv_rgb565_0rgb1555,   2, 2),
+   BENCH("0rgb1555 -> rgb565",   conv_0rgb1555_rgb565,   2, 2),
+   BENCH("0rgb1555 -> argb8888", conv_0rgb1555_argb8888, 2, 4),
+   BENCH("rgb565   -> argb8888", conv_rgb565_argb8888,   2, 4),
+   BENCH("rgb565   -> abgr8888", conv_rgb565_abgr8888,   2, 4),
+   BENCH("rgba4444 -> argb8888", conv_rgba4444_argb8888, 2, 4),
+   BENCH("rgba4444 -> rgb565",   conv_rgba4444_rgb565,   2, 2),
+   BENCH("bgr24    -> argb8888", conv_bgr24_argb8888,    3, 4),
+   BENCH("argb8888 -> 0rgb1555", conv_argb8888_0rgb1555, 4, 2),
+   BENCH("argb8888 -> bgr24",    conv_argb8888_bgr24,    4, 3),
+   BENCH("argb8888 -> abgr8888", conv_argb8888_abgr8888, 4, 4),
+   BENCH("0rgb1555 -> bgr24",    conv_0rgb1555_bgr24,    2, 3),
+   BENCH("rgb565   -> bgr24",    conv_rgb565_bgr24,      2, 3),
+   BENCH("yuyv     -> argb8888", conv_yuyv_argb8888,     2, 4),
+};
+
+/* Compares @b against the plain C conversion at @width, with
+ * padded strides and the data shifted off alignment. Bytes past
+ * each row must be left alone.
+ * Returns: number of mismatching offsets. */
+static unsigned pixconv_check(const struct pixconv_bench *b,
+      const uint8_t *input, uint8_t *out, uint8_t *ref, int width)
+{
+   int offset;
+   unsigned failed = 0;
+   int in_stride   = width * b->in_bpp  + CHECK_PAD;
+   int out_stride  = width * b->out_bpp + CHECK_PAD;
+   size_t size     = (size_t)out_stride * CHECK_HEIGHT + 16;
+
+   for (offset = 0; offset < 4; offset++)
+   {
+      memset(out, CHECK_GUARD, size);
+      memset(ref, CHECK_GUARD, size);
+
+      b->conv(out + offset, input + offset, width, CHECK_HEIGHT,
+            out_stride, in_stride);
+      b->ref(ref + offset, input + offset, width, CHECK_HEIGHT,
+            out_stride, in_stride);
+
+      if (memcmp(out, ref, size))
+      {
+         printf("%s: mismatch at width %d, offset %d\n",
+               b->name, width, offset);
+         failed++;
+      }
+   }
+
+   return failed;
+}
+
+int main(void)
+{
+   unsigned i, frame;
+   unsigned failed = 0;
+   uint8_t *input  = (uint8_t*)malloc(BENCH_WIDTH * BENCH_HEIGHT * 4);
+   uint8_t *output = (uint8_t*)malloc(BENCH_WIDTH * BENCH_HEIGHT * 4);
+   uint8_t *ref    = (uint8_t*)malloc(BENCH_WIDTH * BENCH_HEIGHT * 4);
+
+   if (!input || !output || !ref)
+      return 1;
+
+   for (i = 0; i < BENCH_WIDTH * BENCH_HEIGHT * 4; i++)
+      input[i] = rand();
+
+   /* Every tail of the widest vector loops, then the bench width */
+   for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++)
+   {
+      int width;
+
+      for (width = 1; width <= CHECK_WIDTH; width++)
+         failed += pixconv_check(&benches[i], input, output, ref, width);
+      failed += pixconv_check(&benches[i], input, output, ref, BENCH_WIDTH);
+   }
+
+   printf("%u mismatches against the plain C conversions\n", failed);
+
+   printf("%ux%u, %u frames per conversion\n",
+         BENCH_WIDTH, BENCH_HEIGHT, BENCH_FRAMES);
+
+   for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++)
+   {
+      const struct pixconv_bench *b = &benches[i];
+      retro_time_t start            = cpu_features_get_time_usec();
+      retro_time_t elapsed;
+
+      for (frame = 0; frame < BENCH_FRAMES; frame++)
+         b->conv(output, input, BENCH_WIDTH, BENCH_HEIGHT,
+               BENCH_WIDTH * b->out_bpp, BENCH_WIDTH * b->in_bpp);
+
+      elapsed = cpu_features_get_time_usec() - start;
+
+      printf("%s: %8.1f us/frame, %7.2f Mpix/s\n", b->name,
+            (double)elapsed / BENCH_FRAMES,
+            (double)BENCH_WIDTH * BENCH_HEIGHT * BENCH_FRAMES / elapsed);
+   }
+
+   free(input);
+   free(output);
+   free(ref);
+   return failed ? 1 : 0;
+}
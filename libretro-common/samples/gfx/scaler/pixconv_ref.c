@@ -0,0 +1,22 @@
+/* The plain C conversions under other names, so that the bench
+ * can check the SIMD paths against them byte for byte. */
+#define SCALER_NO_SIMD
+
+#define conv_rgb565_0rgb1555   ref_conv_rgb565_0rgb1555
+#define conv_0rgb1555_rgb565   ref_conv_0rgb1555_rgb565
+#define conv_0rgb1555_argb8888 ref_conv_0rgb1555_argb8888
+#define conv_rgb565_argb8888   ref_conv_rgb565_argb8888
+#define conv_rgb565_abgr8888   ref_conv_rgb565_abgr8888
+#define conv_argb8888_rgba4444 ref_conv_argb8888_rgba4444
+#define conv_rgba4444_argb8888 ref_conv_rgba4444_argb8888
+#define conv_rgba4444_rgb565   ref_conv_rgba4444_rgb565
+#define conv_0rgb1555_bgr24    ref_conv_0rgb1555_bgr24
+#define conv_rgb565_bgr24      ref_conv_rgb565_bgr24
+#define conv_bgr24_argb8888    ref_conv_bgr24_argb8888
+#define conv_argb8888_0rgb1555 ref_conv_argb8888_0rgb1555
+#define conv_argb8888_bgr24    ref_conv_argb8888_bgr24
+#define conv_argb8888_abgr8888 ref_conv_argb8888_abgr8888
+#define conv_yuyv_argb8888     ref_conv_yuyv_argb8888
+#define conv_copy              ref_conv_copy
+
+#include "../../../gfx/scaler/pixconv.c"
@@ -47,10 +47,21 @@ static retro_vfs_write_t filestream_write_cb       = NULL;
 static retro_vfs_flush_t filestream_flush_cb       = NULL;
 static retro_vfs_remove_t filestream_remove_cb     = NULL;
 static retro_vfs_rename_t filestream_rename_cb     = NULL;
+static retro_vfs_map_t filestream_map_cb           = NULL;
+static retro_vfs_unmap_t filestream_unmap_cb       = NULL;
+
+/* A copied range, handed out by filestream_map when
+ * the frontend VFS cannot map. */
+struct filestream_view
+{
+   void *data;
+   struct filestream_view *next;
+};
 
 struct RFILE
 {
    struct retro_vfs_file_handle *hfile;
+   struct filestream_view *views;
 	bool error_flag;
 	bool eof_flag;
 };
@@ -92,6 +103,18 @@ void filestream_vfs_init(const struct retro_vfs_interface_info* vfs_info)
    filestream_rename_cb   = vfs_iface->rename;
 }
 
+void filestream_vfs_map_init(const struct retro_vfs_map_interface_info* map_info)
+{
+   filestream_map_cb      = NULL;
+   filestream_unmap_cb    = NULL;
+
+   if (!map_info->iface)
+      return;
+
+   filestream_map_cb      = map_info->iface->map;
+   filestream_unmap_cb    = map_info->iface->unmap;
+}
+
 /* Callback wrappers */
 bool filestream_exists(const char *path)
 {
@@ -154,6 +177,7 @@ RFILE *filestream_open(const char *path, unsigned mode, unsigned hints)
    output->error_flag = false;
    output->eof_flag   = false;
    output->hfile      = fp;
+   output->views      = NULL;
    return output;
 }
 
@@ -352,6 +376,9 @@ int filestream_close(RFILE *stream)
    int output;
    struct retro_vfs_file_handle* fp = stream->hfile;
 
+   while (stream->views)
+      filestream_unmap(stream, stream->views->data);
+
    if (filestream_close_cb != NULL)
       output = filestream_close_cb(fp);
    else
@@ -363,6 +390,98 @@ int filestream_close(RFILE *stream)
    return output;
 }
 
+static const void *filestream_map_copy(RFILE *stream,
+      int64_t offset, int64_t len)
+{
+   int64_t done                 = 0;
+   int64_t pos                  = filestream_tell(stream);
+   struct filestream_view *view = NULL;
+
+   if (pos < 0 || offset > filestream_get_size(stream) - len
+         || (int64_t)(size_t)len != len)
+      return NULL;
+
+   view = (struct filestream_view*)calloc(1, sizeof(*view));
+   if (!view)
+      return NULL;
+
+   view->data = malloc((size_t)len);
+   if (!view->data)
+      goto error;
+
+   if (filestream_seek(stream, offset, RETRO_VFS_SEEK_POSITION_START) < 0)
+      goto error;
+
+   while (done < len)
+   {
+      int64_t ret = filestream_read(stream,
+            (uint8_t*)view->data + done, len - done);
+      if (ret <= 0)
+         break;
+      done += ret;
+   }
+
+   filestream_seek(stream, pos, RETRO_VFS_SEEK_POSITION_START);
+
+   if (done != len)
+      goto error;
+
+   view->next    = stream->views;
+   stream->views = view;
+   return view->data;
+
+error:
+   free(view->data);
+   free(view);
+   return NULL;
+}
+
+const void *filestream_map(RFILE *stream, int64_t offset, int64_t len)
+{
+   if (!stream || offset < 0 || len <= 0)
+      return NULL;
+
+   /* The map interface only knows handles from the frontend VFS */
+   if (filestream_open_cb != NULL)
+   {
+      if (filestream_map_cb != NULL)
+         return filestream_map_cb(stream->hfile, offset, len);
+      return filestream_map_copy(stream, offset, len);
+   }
+   return retro_vfs_file_map_impl(
+         (libretro_vfs_implementation_file*)stream->hfile, offset, len);
+}
+
+int filestream_unmap(RFILE *stream, const void *data)
+{
+   struct filestream_view **prev = NULL;
+
+   if (!stream || !data)
+      return -1;
+
+   for (prev = &stream->views; *prev; prev = &(*prev)->next)
+   {
+      struct filestream_view *view = *prev;
+
+      if (view->data == data)
+      {
+         *prev = view->next;
+         free(view->data);
+         free(view);
+         return 0;
+      }
+   }
+
+   if (filestream_open_cb != NULL)
+   {
+      if (filestream_unmap_cb != NULL)
+         return filestream_unmap_cb(stream->hfile, data);
+      return -1;
+   }
+   return retro_vfs_file_unmap_impl(
+         (libretro_vfs_implementation_file*)stream->hfile, data);
+}
+
 /**
  * filestream_read_file:
  * @path             : path to file.
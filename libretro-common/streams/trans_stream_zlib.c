@@ -30,7 +30,9 @@
 struct zlib_trans_stream
 {
    bool inited;
+   bool sync_flush; /* deflate: finish with a sync flush instead of ending */
    int ex; /* window_bits or level */
+   int window_bits; /* deflate only */
    z_stream z;
 };
 
@@ -39,7 +41,8 @@ static void *zlib_deflate_stream_new(void)
    struct zlib_trans_stream *ret = (struct zlib_trans_stream*)calloc(1, sizeof(struct zlib_trans_stream));
    if (!ret)
       return NULL;
-   ret->ex = 9;
+   ret->ex          = 9;
+   ret->window_bits = MAX_WBITS;
    return (void *) ret;
 }
 
@@ -82,6 +85,22 @@ static bool zlib_deflate_define(void *data, const char *prop, uint32_t val)
          z->ex = (int) val;
       return true;
    }
+   /* Negative values produce a raw deflate stream
+    * without the zlib header and trailer. */
+   else if (string_is_equal(prop, "window_bits"))
+   {
+      if (z)
+         z->window_bits = (int)(int32_t) val;
+      return true;
+   }
+   /* Flushing emits a byte-aligned sync point instead of a
+    * final block, so several streams can be concatenated. */
+   else if (string_is_equal(prop, "sync_flush"))
+   {
+      if (z)
+         z->sync_flush = val != 0;
+      return true;
+   }
    return false;
 }
 
@@ -109,7 +128,8 @@ static void zlib_deflate_set_in(void *data, const uint8_t *in, uint32_t in_size)
 
    if (!z->inited)
    {
-      deflateInit(&z->z, z->ex);
+      deflateInit2(&z->z, z->ex, Z_DEFLATED, z->window_bits,
+            8, Z_DEFAULT_STRATEGY);
       z->inited = true;
    }
 }
@@ -155,13 +175,17 @@ static bool zlib_deflate_trans(
 
    if (!zt->inited)
    {
-      deflateInit(z, zt->ex);
+      deflateInit2(z, zt->ex, Z_DEFLATED, zt->window_bits,
+            8, Z_DEFAULT_STRATEGY);
       zt->inited = true;
    }
 
    pre_avail_in  = z->avail_in;
    pre_avail_out = z->avail_out;
-   zret          = deflate(z, flush ? Z_FINISH : Z_NO_FLUSH);
+   if (flush)
+      zret       = deflate(z, zt->sync_flush ? Z_SYNC_FLUSH : Z_FINISH);
+   else
+      zret       = deflate(z, Z_NO_FLUSH);
 
    if (zret == Z_OK)
    {
@@ -195,7 +219,10 @@ static bool zlib_deflate_trans(
    *rd = pre_avail_in - z->avail_in;
    *wn = pre_avail_out - z->avail_out;
 
-   if (flush && zret == Z_STREAM_END)
+   /* A completed sync flush also ends the stream, so the
+    * next set_in starts a fresh one. */
+   if (flush && (zret == Z_STREAM_END || (zt->sync_flush
+               && z->avail_in == 0 && z->avail_out != 0)))
    {
       deflateEnd(z);
       zt->inited = false;
@@ -87,6 +87,7 @@
 #endif
 #endif
 
+#include <boolean.h>
 #include <vfs/vfs_implementation.h>
 #include <libretro.h>
 #include <memmap.h>
@@ -95,6 +96,28 @@
 
 #define RFILE_HINT_UNBUFFERED (1 << 8)
 
+/* Ranges of a file can be mapped on their own where POSIX mmap exists;
+ * elsewhere views are served from the whole-file mapping or copied. */
+#if defined(HAVE_MMAP) && defined(HAVE_MMAN)
+#define VFS_MAP_RANGES
+#endif
+
+enum vfs_view_type
+{
+   VFS_VIEW_SHARED = 0, /* points into the whole-file mapping */
+   VFS_VIEW_MAPPED,     /* own mapping of a range */
+   VFS_VIEW_COPY        /* heap copy of a range */
+};
+
+struct vfs_view
+{
+   enum vfs_view_type type;
+   void *data;
+   void *base;
+   uint64_t len;
+   struct vfs_view *next;
+};
+
 #ifdef VFS_FRONTEND
 struct retro_vfs_file_handle
 #else
@@ -107,6 +130,7 @@ struct libretro_vfs_implementation_file
    char *buf;
    FILE *fp;
    char* orig_path;
+   struct vfs_view *views;
 #if defined(HAVE_MMAP)
    uint64_t mappos;
    uint64_t mapsize;
@@ -166,10 +190,15 @@ int64_t retro_vfs_file_seek_internal(libretro_vfs_implementation_file *stream, i
    }
 #endif
 
-   if (lseek(stream->fd, offset, whence) < 0)
-      goto error;
+   {
+      /* Report the new position, as the mapped path does. */
+      int64_t ret = (int64_t)lseek(stream->fd, (off_t)offset, whence);
 
-   return 0;
+      if (ret < 0)
+         goto error;
+
+      return ret;
+   }
 
 error:
    return -1;
@@ -344,6 +373,9 @@ int retro_vfs_file_close_impl(libretro_vfs_implementation_file *stream)
    if (!stream)
       return -1;
 
+   while (stream->views)
+      retro_vfs_file_unmap_impl(stream, stream->views->data);
+
    if ((stream->hints & RFILE_HINT_UNBUFFERED) == 0)
    {
       if (stream->fp)
@@ -399,10 +431,14 @@ int64_t retro_vfs_file_tell_impl(libretro_vfs_implementation_file *stream)
    if (stream->mapped && stream->hints & RETRO_VFS_FILE_ACCESS_HINT_FREQUENT_ACCESS)
       return stream->mappos;
 #endif
-   if (lseek(stream->fd, 0, SEEK_CUR) < 0)
-      return -1;
+   {
+      int64_t ret = (int64_t)lseek(stream->fd, 0, SEEK_CUR);
 
-   return 0;
+      if (ret < 0)
+         return -1;
+
+      return ret;
+   }
 }
 
 int64_t retro_vfs_file_seek_impl(libretro_vfs_implementation_file *stream, int64_t offset, int seek_position)
@@ -589,3 +625,140 @@ const char *retro_vfs_file_get_path_impl(libretro_vfs_implementation_file *strea
       abort();
    return stream->orig_path;
 }
+
+static void retro_vfs_view_free(struct vfs_view *view)
+{
+   switch (view->type)
+   {
+      case VFS_VIEW_MAPPED:
+#ifdef VFS_MAP_RANGES
+         munmap(view->base, (size_t)view->len);
+#endif
+         break;
+      case VFS_VIEW_COPY:
+         free(view->data);
+         break;
+      case VFS_VIEW_SHARED:
+         break;
+   }
+   free(view);
+}
+
+static bool retro_vfs_view_copy(libretro_vfs_implementation_file *stream,
+      struct vfs_view *view, uint64_t offset, uint64_t len)
+{
+   uint64_t done = 0;
+   int64_t pos   = retro_vfs_file_tell_impl(stream);
+
+   view->type    = VFS_VIEW_COPY;
+   view->len     = len;
+   view->data    = malloc((size_t)len);
+
+   if (!view->data || pos < 0)
+      return false;
+
+   if (retro_vfs_file_seek_internal(stream, (int64_t)offset, SEEK_SET) < 0)
+      return false;
+
+   while (done < len)
+   {
+      int64_t ret = retro_vfs_file_read_impl(stream,
+            (uint8_t*)view->data + done, len - done);
+      if (ret <= 0)
+         break;
+      done += ret;
+   }
+
+   /* Mapping must not disturb the file position. */
+   retro_vfs_file_seek_internal(stream, pos, SEEK_SET);
+
+   return done == len;
+}
+
+const void *retro_vfs_file_map_impl(libretro_vfs_implementation_file *stream,
+      uint64_t offset, uint64_t len)
+{
+   struct vfs_view *view = NULL;
+
+   if (     !stream
+         || !len
+         || stream->size < 0
+         || offset > (uint64_t)stream->size
+         || len > (uint64_t)stream->size - offset
+         || (uint64_t)(size_t)len != len)
+      return NULL;
+
+   view = (struct vfs_view*)calloc(1, sizeof(*view));
+
+   if (!view)
+      return NULL;
+
+#ifdef HAVE_MMAP
+   if (stream->mapped && stream->hints & RETRO_VFS_FILE_ACCESS_HINT_FREQUENT_ACCESS)
+   {
+      view->type = VFS_VIEW_SHARED;
+      view->data = stream->mapped + offset;
+      view->len  = len;
+   }
+#endif
+
+#ifdef VFS_MAP_RANGES
+   if (!view->data)
+   {
+      int fd = (stream->hints & RFILE_HINT_UNBUFFERED)
+         ? stream->fd
+         : (stream->fp ? fileno(stream->fp) : -1);
+
+      if (fd >= 0)
+      {
+         /* mmap offsets have to be page aligned. */
+         uint64_t page   = (uint64_t)sysconf(_SC_PAGESIZE);
+         uint64_t delta  = offset % page;
+         void *base      = mmap(NULL, (size_t)(len + delta), PROT_READ,
+               MAP_SHARED, fd, (off_t)(offset - delta));
+
+         if (base != MAP_FAILED)
+         {
+            view->type = VFS_VIEW_MAPPED;
+            view->base = base;
+            view->len  = len + delta;
+            view->data = (uint8_t*)base + delta;
+         }
+      }
+   }
+#endif
+
+   /* Fall back to a copy of the range. */
+   if (!view->data && !retro_vfs_view_copy(stream, view, offset, len))
+   {
+      retro_vfs_view_free(view);
+      return NULL;
+   }
+
+   view->next    = stream->views;
+   stream->views = view;
+   return view->data;
+}
+
+int retro_vfs_file_unmap_impl(libretro_vfs_implementation_file *stream,
+      const void *data)
+{
+   struct vfs_view **prev = NULL;
+
+   if (!stream || !data)
+      return -1;
+
+   for (prev = &stream->views; *prev; prev = &(*prev)->next)
+   {
+      struct vfs_view *view = *prev;
+
+      if (view->data == data)
+      {
+         *prev = view->next;
+         retro_vfs_view_free(view);
+         return 0;
+      }
+   }
+
+   return -1;
+}
@@ -0,0 +1,18 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <encodings/crc32.h>
+int old_apply(int, const uint8_t*, uint64_t, const uint8_t*, uint64_t, uint8_t**, uint64_t*);
+int new_apply(int, const uint8_t*, uint64_t, const uint8_t*, uint64_t, uint8_t**, uint64_t*, uint32_t*, int, int);
+static uint8_t *rd(const char *f, long *n){FILE*fp=fopen(f,"rb");uint8_t*b;fseek(fp,0,2);*n=ftell(fp);rewind(fp);b=malloc(*n+1);fread(b,1,*n,fp);fclose(fp);return b;}
+int main(int argc,char**argv){
+ int kind=atoi(argv[1]); long pl,sl; uint8_t *p=rd(argv[2],&pl),*s=rd(argv[3],&sl);
+ uint8_t *o,*n; uint64_t ol,nl; uint32_t crc; int oe,ne; clock_t c0,c1,c2;
+ c0=clock(); oe=old_apply(kind,p,pl,s,sl,&o,&ol); c1=clock();
+ ne=new_apply(kind,p,pl,s,sl,&n,&nl,&crc,atoi(argv[4]),atoi(argv[5])); c2=clock();
+ if (oe==1) { if(!ne||ol!=nl||memcmp(o,n,ol)||crc!=encoding_crc32(0,n,nl)) {printf("MISMATCH kind %d ol %lu nl %lu ne %d\n",kind,(unsigned long)ol,(unsigned long)nl,ne);return 1;} }
+ else if (ne) { printf("new succeeded where old failed (%d)\n",oe); return 1;}
+ printf("ok kind %d old %d %.3fs new %.3fs\n",kind,oe,(double)(c1-c0)/CLOCKS_PER_SEC,(double)(c2-c1)/CLOCKS_PER_SEC);
+ return 0;}
@@ -607,12 +607,16 @@ static void materialui_compute_entries_box(materialui_handle_t* mui, int width)
       materialui_node_t *node          = (materialui_node_t*)
          file_list_get_userdata_at_offset(list, i);
 
-      menu_entry_init(&entry);
-      menu_entry_get(&entry, 0, i, NULL, true);
-
+      /* Deferred entries (files, playlist items) have no sublabel;
+       * leave them unbound until they scroll into view. */
+      if (!file_list_is_deferred(list, i))
+      {
+         menu_entry_init(&entry);
+         menu_entry_get(&entry, 0, i, NULL, true);
 
-      sublabel_str = menu_entry_get_sublabel(&entry);
-      menu_entry_free(&entry);
+         sublabel_str = menu_entry_get_sublabel(&entry);
+         menu_entry_free(&entry);
+      }
 
       if (sublabel_str)
       {
@@ -1434,17 +1438,20 @@ static void materialui_frame(void *data, video_frame_info_t *video_info)
    font_driver_bind_block(mui->font, &mui->raster_block);
    font_driver_bind_block(mui->font2, &mui->raster_block2);
 
-   if (menu_display_get_update_pending())
-      materialui_render_menu_list(
-            video_info,
-            mui,
-            width,
-            height,
-            font_normal_color,
-            font_hover_color,
-            active_tab_marker_color ? &active_tab_marker_color[0] : NULL,
-            sublabel_color
-            );
+   menu_display_batch_begin(video_info);
+
+   materialui_render_menu_list(
+         video_info,
+         mui,
+         width,
+         height,
+         font_normal_color,
+         font_hover_color,
+         active_tab_marker_color ? &active_tab_marker_color[0] : NULL,
+         sublabel_color
+         );
+
+   menu_display_batch_end(video_info);
 
    font_driver_flush(video_info->width, video_info->height, mui->font,
          video_info);
@@ -1456,8 +1463,6 @@ static void materialui_frame(void *data, video_frame_info_t *video_info)
          video_info);
    font_driver_bind_block(mui->font2, NULL);
 
-   menu_animation_ctl(MENU_ANIMATION_CTL_SET_ACTIVE, NULL);
-
    /* header */
    menu_display_draw_quad(
          video_info,
@@ -21,6 +21,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <limits.h>
+#include <time.h>
 
 #include <string/stdstring.h>
 #include <lists/string_list.h>
@@ -29,6 +30,7 @@
 #include <encodings/utf.h>
 #include <file/file_path.h>
 #include <retro_inline.h>
+#include <features/features_cpu.h>
 #include <string/stdstring.h>
 #include <encodings/utf.h>
 
@@ -53,22 +55,58 @@
 #define RGUI_TERM_WIDTH(width) (((width - RGUI_TERM_START_X(width) - RGUI_TERM_START_X(width)) / (FONT_WIDTH_STRIDE)))
 #define RGUI_TERM_HEIGHT(width, height) (((height - RGUI_TERM_START_Y(height) - RGUI_TERM_START_X(width)) / (FONT_HEIGHT_STRIDE)) - 1)
 
+/* Fillers repeat every RGUI_FILLER_PERIOD pixels in both directions */
+#define RGUI_FILLER_PERIOD 4
+
+/* Text lines remembered per frame for dirty-rectangle updates;
+ * RGUI_TERM_HEIGHT() entries plus the header and footer lines. */
+#define RGUI_MAX_LINES 64
+
+/* One ticker step per RGUI_TERM_START_X() frames at 60 Hz */
+#define RGUI_TICKER_STEP_USEC (1000000 / 60)
+#define RGUI_LINE_SIZE 256
+
+typedef struct
+{
+      int x;
+      int y;
+      uint16_t color;
+      char text[RGUI_LINE_SIZE];
+} rgui_line_t;
+
 typedef struct
 {
       bool bg_modified;
       bool force_redraw;
+      bool full_redraw;
+      bool input_pending;
       bool mouse_show;
+      bool overlay_shown;
       unsigned last_width;
       unsigned last_height;
-      unsigned frame_count;
+      bool ticker_active;
+      unsigned last_ticker_idx;
+      time_t last_clock;
       bool bg_thickness;
       bool border_thickness;
+      int16_t last_mouse_x;
+      int16_t last_mouse_y;
+      int16_t last_pointer_y;
       float scroll_y;
       char *msgbox;
+      char *overlay;
+      unsigned cur_lines;
+      unsigned line_count[2];
+      rgui_line_t lines[2][RGUI_MAX_LINES];
 } rgui_t;
 
 static uint16_t *rgui_framebuf_data = NULL;
 
+/* Prerendered glyphs, one bit mask per glyph row */
+static uint8_t rgui_glyph_rows[256][FONT_HEIGHT];
+static bool rgui_glyph_blank[256];
+static bool rgui_glyphs_ready = false;
+
 #if defined(GEKKO) || defined(PSP)
 #define HOVER_COLOR(settings) ((3 << 0) | (10 << 4) | (3 << 8) | (7 << 12))
 #define NORMAL_COLOR(settings) 0x7FFF
@@ -127,10 +165,52 @@ static void rgui_fill_rect(
     uint16_t (*col)(rgui_t *rgui, unsigned x, unsigned y))
 {
       unsigned i, j;
+      size_t stride = pitch >> 1;
 
+      /* Only one period of the filler goes through the callback,
+       * the rest of the rectangle is copied a row at a time. */
       for (j = y; j < y + height; j++)
-            for (i = x; i < x + width; i++)
-                  data[j * (pitch >> 1) + i] = col(rgui, i, j);
+      {
+            uint16_t *row = data + j * stride + x;
+            unsigned filled = MIN(width, RGUI_FILLER_PERIOD);
+
+            if (j >= y + RGUI_FILLER_PERIOD)
+            {
+                  memcpy(row, row - RGUI_FILLER_PERIOD * stride,
+                         width * sizeof(uint16_t));
+                  continue;
+            }
+
+            for (i = 0; i < filled; i++)
+                  row[i] = col(rgui, x + i, j);
+
+            while (filled < width)
+            {
+                  unsigned chunk = MIN(filled, width - filled);
+                  memcpy(row + filled, row, chunk * sizeof(uint16_t));
+                  filled += chunk;
+            }
+      }
+}
+
+/* Fills the part of (x, y, width, height) that lies within
+ * the clip rectangle (cx, cy, cw, ch). */
+static void rgui_fill_rect_clipped(
+    rgui_t *rgui,
+    uint16_t *data,
+    size_t pitch,
+    int x, int y,
+    int width, int height,
+    int cx, int cy, int cw, int ch,
+    uint16_t (*col)(rgui_t *rgui, unsigned x, unsigned y))
+{
+      int x0 = MAX(x, cx);
+      int y0 = MAX(y, cy);
+      int x1 = MIN(x + width, cx + cw);
+      int y1 = MIN(y + height, cy + ch);
+
+      if (x0 < x1 && y0 < y1)
+            rgui_fill_rect(rgui, data, pitch, x0, y0, x1 - x0, y1 - y0, col);
 }
 
 static void rgui_color_rect(
@@ -152,32 +232,63 @@ static void rgui_color_rect(
 static void blit_line(int x, int y,
                       const char *message, uint16_t color)
 {
-      size_t pitch = menu_display_get_framebuffer_pitch();
-      const uint8_t *font_fb = menu_display_get_font_framebuffer();
+      size_t stride = menu_display_get_framebuffer_pitch() >> 1;
+
+      if (!rgui_glyphs_ready)
+            return;
+
+      while (!string_is_empty(message))
+      {
+            unsigned i, j;
+            uint16_t *dst;
+            uint8_t symbol = (uint8_t)*message++;
+
+            if (!rgui_glyph_blank[symbol])
+            {
+                  dst = rgui_framebuf_data + y * stride + x;
+
+                  for (j = 0; j < FONT_HEIGHT; j++, dst += stride)
+                  {
+                        uint8_t mask = rgui_glyph_rows[symbol][j];
+
+                        for (i = 0; mask; i++, mask >>= 1)
+                              if (mask & 1)
+                                    dst[i] = color;
+                  }
+            }
+
+            x += FONT_WIDTH_STRIDE;
+      }
+}
+
+static void rgui_init_glyphs(const uint8_t *font_fb)
+{
+      unsigned c, i, j;
 
-      if (font_fb)
+      for (c = 0; c < 256; c++)
       {
-            while (!string_is_empty(message))
+            rgui_glyph_blank[c] = true;
+
+            for (j = 0; j < FONT_HEIGHT; j++)
             {
-                  unsigned i, j;
-                  char symbol = *message++;
+                  uint8_t mask = 0;
 
-                  for (j = 0; j < FONT_HEIGHT; j++)
+                  for (i = 0; i < FONT_WIDTH; i++)
                   {
-                        for (i = 0; i < FONT_WIDTH; i++)
-                        {
-                              uint8_t rem = 1 << ((i + j * FONT_WIDTH) & 7);
-                              int offset = (i + j * FONT_WIDTH) >> 3;
-                              bool col = (font_fb[FONT_OFFSET(symbol) + offset] & rem);
-
-                              if (col)
-                                    rgui_framebuf_data[(y + j) * (pitch >> 1) + (x + i)] = color;
-                        }
+                        uint8_t rem = 1 << ((i + j * FONT_WIDTH) & 7);
+                        int offset = (i + j * FONT_WIDTH) >> 3;
+
+                        if (font_fb[FONT_OFFSET(c) + offset] & rem)
+                              mask |= 1 << i;
                   }
 
-                  x += FONT_WIDTH_STRIDE;
+                  rgui_glyph_rows[c][j] = mask;
+                  if (mask)
+                        rgui_glyph_blank[c] = false;
             }
       }
+
+      rgui_glyphs_ready = true;
 }
 
 #if 0
@@ -247,10 +358,31 @@ static bool rguidisp_init_font(menu_handle_t *menu)
 #endif
 
       menu_display_set_font_framebuffer(font_bin_buf);
+      rgui_init_glyphs(font_bin_buf);
 
       return true;
 }
 
+static void rgui_render_border(rgui_t *rgui,
+                               unsigned fb_width, unsigned fb_height, size_t fb_pitch,
+                               int cx, int cy, int cw, int ch)
+{
+      settings_t *settings = config_get_ptr();
+
+      if (!settings->bools.menu_rgui_border_filler_enable)
+            return;
+
+      rgui_fill_rect_clipped(rgui, rgui_framebuf_data, fb_pitch, 5, 5, fb_width - 10, 5,
+                             cx, cy, cw, ch, rgui_green_filler);
+      rgui_fill_rect_clipped(rgui, rgui_framebuf_data, fb_pitch, 5, fb_height - 10, fb_width - 10, 5,
+                             cx, cy, cw, ch, rgui_green_filler);
+
+      rgui_fill_rect_clipped(rgui, rgui_framebuf_data, fb_pitch, 5, 5, 5, fb_height - 10,
+                             cx, cy, cw, ch, rgui_green_filler);
+      rgui_fill_rect_clipped(rgui, rgui_framebuf_data, fb_pitch, fb_width - 10, 5, 5, fb_height - 10,
+                             cx, cy, cw, ch, rgui_green_filler);
+}
+
 static void rgui_render_background(rgui_t *rgui)
 {
       size_t pitch_in_pixels, size;
@@ -274,19 +406,47 @@ static void rgui_render_background(rgui_t *rgui)
       }
 
       if (rgui_framebuf_data)
-      {
-            settings_t *settings = config_get_ptr();
+            rgui_render_border(rgui, fb_width, fb_height, fb_pitch,
+                               0, 0, fb_width, fb_height);
+}
 
-            if (settings->bools.menu_rgui_border_filler_enable)
-            {
-                  rgui_fill_rect(rgui, rgui_framebuf_data, fb_pitch, 5, 5, fb_width - 10, 5, rgui_green_filler);
-                  rgui_fill_rect(rgui, rgui_framebuf_data, fb_pitch, 5, fb_height - 10, fb_width - 10, 5, rgui_green_filler);
+/* Repaints a rectangle of the framebuffer with the cached background,
+ * as rgui_render_background() would have left it. */
+static void rgui_restore_background(rgui_t *rgui,
+                                    int x, int y, int width, int height)
+{
+      int j;
+      size_t fb_pitch, stride;
+      unsigned fb_width, fb_height;
 
-                  rgui_fill_rect(rgui, rgui_framebuf_data, fb_pitch, 5, 5, 5, fb_height - 10, rgui_green_filler);
-                  rgui_fill_rect(rgui, rgui_framebuf_data, fb_pitch, fb_width - 10, 5, 5, fb_height - 10,
-                                 rgui_green_filler);
-            }
+      menu_display_get_fb_size(&fb_width, &fb_height,
+                               &fb_pitch);
+
+      stride = fb_pitch >> 1;
+
+      if (x < 0)
+      {
+            width += x;
+            x = 0;
       }
+      if (y < 0)
+      {
+            height += y;
+            y = 0;
+      }
+      width = MIN(width, (int)fb_width - x);
+      height = MIN(height, (int)fb_height - y);
+
+      if (width <= 0 || height <= 0)
+            return;
+
+      for (j = y; j < y + height; j++)
+            memcpy(rgui_framebuf_data + j * stride + x,
+                   rgui_framebuf_data + (fb_height + (j & 3)) * stride + x,
+                   width * sizeof(uint16_t));
+
+      rgui_render_border(rgui, fb_width, fb_height, fb_pitch,
+                         x, y, width, height);
 }
 
 static void rgui_set_message(void *data, const char *message)
@@ -419,8 +579,239 @@ static void rgui_frame(void *data, video_frame_info_t *video_info)
 
       rgui->bg_thickness = settings->bools.menu_rgui_background_filler_thickness_enable;
       rgui->border_thickness = settings->bools.menu_rgui_border_filler_thickness_enable;
+}
 
-      rgui->frame_count++;
+/* Returns true if the mouse or touch pointer moved since the last call. */
+static bool rgui_pointer_moved(rgui_t *rgui, settings_t *settings)
+{
+      bool moved = false;
+
+      if (settings->bools.menu_mouse_enable)
+      {
+            int16_t x = menu_input_mouse_state(MENU_MOUSE_X_AXIS);
+            int16_t y = menu_input_mouse_state(MENU_MOUSE_Y_AXIS);
+
+            moved = x != rgui->last_mouse_x || y != rgui->last_mouse_y;
+            rgui->last_mouse_x = x;
+            rgui->last_mouse_y = y;
+      }
+
+      if (settings->bools.menu_pointer_enable)
+      {
+            int16_t y = menu_input_pointer_state(MENU_POINTER_Y_AXIS);
+
+            if (y != rgui->last_pointer_y || menu_input_ctl(MENU_INPUT_CTL_IS_POINTER_DRAGGED, NULL))
+                  moved = true;
+            rgui->last_pointer_y = y;
+      }
+
+      return moved;
+}
+
+static void rgui_queue_line(rgui_t *rgui, int x, int y,
+                            const char *message, uint16_t color)
+{
+      rgui_line_t *line;
+      unsigned *count = &rgui->line_count[rgui->cur_lines];
+
+      if (*count >= RGUI_MAX_LINES)
+            return;
+
+      line = &rgui->lines[rgui->cur_lines][(*count)++];
+      line->x = x;
+      line->y = y;
+      line->color = color;
+      strlcpy(line->text, message, sizeof(line->text));
+}
+
+static bool rgui_line_equal(const rgui_line_t *a, const rgui_line_t *b)
+{
+      return a->x == b->x && a->y == b->y && a->color == b->color &&
+             string_is_equal(a->text, b->text);
+}
+
+static void rgui_line_rect(const rgui_line_t *line, int *rect)
+{
+      rect[0] = line->x;
+      rect[1] = line->y;
+      rect[2] = (int)strlen(line->text) * FONT_WIDTH_STRIDE;
+      rect[3] = FONT_HEIGHT;
+}
+
+static bool rgui_rect_intersects(const int *a, const int *b)
+{
+      return a[0] < b[0] + b[2] && b[0] < a[0] + a[2] &&
+             a[1] < b[1] + b[3] && b[1] < a[1] + a[3];
+}
+
+static bool rgui_lines_changed(rgui_t *rgui)
+{
+      unsigned i;
+      const rgui_line_t *cur = rgui->lines[rgui->cur_lines];
+      const rgui_line_t *old = rgui->lines[!rgui->cur_lines];
+      unsigned count = rgui->line_count[rgui->cur_lines];
+
+      if (count != rgui->line_count[!rgui->cur_lines])
+            return true;
+
+      for (i = 0; i < count; i++)
+            if (!rgui_line_equal(&cur[i], &old[i]))
+                  return true;
+
+      return false;
+}
+
+/* Draws the lines queued this frame. Unless @full is set, only lines
+ * that differ from the previous frame are erased and drawn again,
+ * along with any line overlapping them. Returns true if the
+ * framebuffer changed. */
+static bool rgui_draw_lines(rgui_t *rgui, bool full)
+{
+      unsigned i, j;
+      unsigned damage_count = 0;
+      bool changed = false;
+      int damage[RGUI_MAX_LINES * 2][4];
+      bool redraw[RGUI_MAX_LINES];
+      const rgui_line_t *cur = rgui->lines[rgui->cur_lines];
+      const rgui_line_t *old = rgui->lines[!rgui->cur_lines];
+      unsigned cur_count = rgui->line_count[rgui->cur_lines];
+      unsigned old_count = rgui->line_count[!rgui->cur_lines];
+
+      if (full)
+      {
+            rgui_render_background(rgui);
+
+            for (i = 0; i < cur_count; i++)
+                  blit_line(cur[i].x, cur[i].y, cur[i].text, cur[i].color);
+
+            return true;
+      }
+
+      for (i = 0; i < MAX(cur_count, old_count); i++)
+      {
+            bool same = i < cur_count && i < old_count &&
+                        rgui_line_equal(&cur[i], &old[i]);
+
+            if (i < cur_count)
+                  redraw[i] = !same;
+
+            if (same)
+                  continue;
+
+            changed = true;
+
+            if (i < old_count)
+            {
+                  int *rect = damage[damage_count++];
+
+                  rgui_line_rect(&old[i], rect);
+                  rgui_restore_background(rgui, rect[0], rect[1], rect[2], rect[3]);
+            }
+      }
+
+      if (!changed)
+            return false;
+
+      /* Lines are drawn in order, so anything drawn over an
+       * unchanged line forces that line to be drawn again too. */
+      for (i = 0; i < cur_count; i++)
+      {
+            int rect[4];
+
+            rgui_line_rect(&cur[i], rect);
+
+            for (j = 0; !redraw[i] && j < damage_count; j++)
+                  if (rgui_rect_intersects(rect, damage[j]))
+                        redraw[i] = true;
+
+            if (!redraw[i])
+                  continue;
+
+            blit_line(cur[i].x, cur[i].y, cur[i].text, cur[i].color);
+
+            if (damage_count < RGUI_MAX_LINES * 2)
+                  memcpy(damage[damage_count++], rect, sizeof(rect));
+      }
+
+      return true;
+}
+
+/* Draws the queued lines, then the on-screen keyboard, message box
+ * and mouse cursor on top. Since those cover the text, any change
+ * while one of them is up repaints the whole framebuffer. */
+static void rgui_render_overlays(rgui_t *rgui, settings_t *settings)
+{
+      char msg[255];
+      char overlay[1024];
+      bool changed = false;
+      bool full = rgui->full_redraw;
+      bool display_kb = menu_input_dialog_get_display_kb();
+      bool cursor = false;
+      bool has_overlay;
+
+      msg[0] = overlay[0] = '\0';
+
+      if (display_kb)
+      {
+            const char *str = menu_input_dialog_get_buffer();
+            const char *label = menu_input_dialog_get_label_buffer();
+
+            snprintf(msg, sizeof(msg), "%s\n%s", label, str);
+      }
+
+      if (rgui->mouse_show)
+      {
+            bool cursor_visible = settings->bools.video_fullscreen ||
+                                  !video_driver_has_windowed();
+
+            cursor = settings->bools.menu_mouse_enable && cursor_visible;
+      }
+
+      has_overlay = display_kb || cursor || !string_is_empty(rgui->msgbox);
+
+      if (has_overlay)
+            snprintf(overlay, sizeof(overlay), "%d %d %d\n%s\n%s",
+                     cursor, rgui->last_mouse_x, rgui->last_mouse_y, msg,
+                     rgui->msgbox ? rgui->msgbox : "");
+
+      if (!full && (has_overlay || rgui->overlay_shown))
+            full = has_overlay != rgui->overlay_shown ||
+                   !string_is_equal(overlay, rgui->overlay ? rgui->overlay : "") ||
+                   rgui_lines_changed(rgui);
+      else if (!full && rgui_framebuf_data)
+            changed = rgui_draw_lines(rgui, false);
+
+      if (full && rgui_framebuf_data)
+      {
+            changed = rgui_draw_lines(rgui, true);
+
+            if (display_kb)
+                  rgui_render_messagebox(rgui, msg);
+
+            if (!string_is_empty(rgui->msgbox))
+                  rgui_render_messagebox(rgui, rgui->msgbox);
+
+            if (cursor)
+                  rgui_blit_cursor();
+      }
+
+      if (!string_is_empty(rgui->msgbox))
+      {
+            free(rgui->msgbox);
+            rgui->msgbox = NULL;
+            rgui->force_redraw = true;
+      }
+
+      if (rgui->overlay)
+            free(rgui->overlay);
+      rgui->overlay = has_overlay ? strdup(overlay) : NULL;
+      rgui->overlay_shown = has_overlay;
+      rgui->full_redraw = false;
+
+      if (changed)
+            menu_display_set_framebuffer_dirty_flag();
+      else
+            menu_display_unset_framebuffer_dirty_flag();
 }
 
 static void rgui_render(void *data, bool is_idle)
@@ -434,14 +825,15 @@ static void rgui_render(void *data, bool is_idle)
       char title[255];
       char title_buf[255];
       char title_msg[64];
-      char msg[255];
       size_t entries_end = 0;
       bool msg_force = false;
+      bool pointer_moved = false;
+      unsigned ticker_idx;
       settings_t *settings = config_get_ptr();
       rgui_t *rgui = (rgui_t *)data;
-      uint64_t frame_count = rgui->frame_count;
+      time_t clock = 0;
 
-      msg[0] = title[0] = title_buf[0] = title_msg[0] = '\0';
+      title[0] = title_buf[0] = title_msg[0] = '\0';
 
       if (!rgui->force_redraw)
       {
@@ -465,15 +857,41 @@ static void rgui_render(void *data, bool is_idle)
                                  fb_pitch, 0, fb_height, fb_width, 4, rgui_gray_filler);
             rgui->last_width = fb_width;
             rgui->last_height = fb_height;
+            rgui->full_redraw = true;
       }
 
       if (rgui->bg_modified)
             rgui->bg_modified = false;
 
-      menu_display_set_framebuffer_dirty_flag();
+      pointer_moved = rgui_pointer_moved(rgui, settings);
+      /* The ticker runs on wall time, so it keeps its pace while the
+       * menu driver skips idle frames. */
+      ticker_idx = (unsigned)(cpu_features_get_time_usec() / (RGUI_TERM_START_X(fb_width) * RGUI_TICKER_STEP_USEC));
+
+      if (settings->bools.menu_timedate_enable)
+            clock = time(NULL);
+
+      /* Idle: nothing is rendered unless there was input, the pointer
+       * moved, a ticker step is due or the clock changed. */
+      if (!rgui->force_redraw && !rgui->full_redraw && !rgui->input_pending && !pointer_moved && ticker_idx == rgui->last_ticker_idx && clock == rgui->last_clock && !menu_input_dialog_get_display_kb())
+      {
+            /* Only a render calls the ticker, so keep asking for
+             * frames until the next step is due */
+            if (rgui->ticker_active)
+                  menu_driver_invalidate();
+            menu_display_unset_framebuffer_dirty_flag();
+            return;
+      }
+
       menu_animation_ctl(MENU_ANIMATION_CTL_CLEAR_ACTIVE, NULL);
 
       rgui->force_redraw = false;
+      rgui->input_pending = false;
+      rgui->last_ticker_idx = ticker_idx;
+      rgui->last_clock = clock;
+
+      rgui->cur_lines ^= 1;
+      rgui->line_count[rgui->cur_lines] = 0;
 
       if (settings->bools.menu_pointer_enable)
       {
@@ -531,13 +949,11 @@ static void rgui_render(void *data, bool is_idle)
 
       end = ((old_start + RGUI_TERM_HEIGHT(fb_width, fb_height)) <= (entries_end)) ? old_start + RGUI_TERM_HEIGHT(fb_width, fb_height) : entries_end;
 
-      rgui_render_background(rgui);
-
       menu_entries_get_title(title, sizeof(title));
 
       ticker.s = title_buf;
       ticker.len = RGUI_TERM_WIDTH(fb_width) - 10;
-      ticker.idx = frame_count / RGUI_TERM_START_X(fb_width);
+      ticker.idx = ticker_idx;
       ticker.str = title;
       ticker.selected = true;
 
@@ -555,8 +971,7 @@ static void rgui_render(void *data, bool is_idle)
 
             strlcpy(back_buf, msg_hash_to_str(MENU_ENUM_LABEL_VALUE_BASIC_MENU_CONTROLS_BACK), sizeof(back_buf));
             string_to_upper(back_buf);
-            if (rgui_framebuf_data)
-                  blit_line(
+            rgui_queue_line(rgui,
                       RGUI_TERM_START_X(fb_width),
                       RGUI_TERM_START_X(fb_width),
                       back_msg,
@@ -565,8 +980,7 @@ static void rgui_render(void *data, bool is_idle)
 
       string_to_upper(title_buf);
 
-      if (rgui_framebuf_data)
-            blit_line(
+      rgui_queue_line(rgui,
                 (int)(RGUI_TERM_START_X(fb_width) + (RGUI_TERM_WIDTH(fb_width) - utf8len(title_buf)) * FONT_WIDTH_STRIDE / 2),
                 RGUI_TERM_START_X(fb_width),
                 title_buf, TITLE_COLOR(settings));
@@ -574,8 +988,7 @@ static void rgui_render(void *data, bool is_idle)
       if (settings->bools.menu_core_enable &&
           menu_entries_get_core_title(title_msg, sizeof(title_msg)) == 0)
       {
-            if (rgui_framebuf_data)
-                  blit_line(
+            rgui_queue_line(rgui,
                       RGUI_TERM_START_X(fb_width),
                       (RGUI_TERM_HEIGHT(fb_width, fb_height) * FONT_HEIGHT_STRIDE) +
                           RGUI_TERM_START_Y(fb_height) + 2,
@@ -595,8 +1008,7 @@ static void rgui_render(void *data, bool is_idle)
 
             menu_display_timedate(&datetime);
 
-            if (rgui_framebuf_data)
-                  blit_line(
+            rgui_queue_line(rgui,
                       RGUI_TERM_WIDTH(fb_width) * FONT_WIDTH_STRIDE - RGUI_TERM_START_X(fb_width),
                       (RGUI_TERM_HEIGHT(fb_width, fb_height) * FONT_HEIGHT_STRIDE) +
                           RGUI_TERM_START_Y(fb_height) + 2,
@@ -640,7 +1052,7 @@ static void rgui_render(void *data, bool is_idle)
 
             ticker.s = entry_title_buf;
             ticker.len = RGUI_TERM_WIDTH(fb_width) - (entry_spacing + 1 + 2);
-            ticker.idx = frame_count / RGUI_TERM_START_X(fb_width);
+            ticker.idx = ticker_idx;
             ticker.str = entry_path;
             ticker.selected = entry_selected;
 
@@ -663,8 +1075,7 @@ static void rgui_render(void *data, bool is_idle)
                      entry_spacing,
                      type_str_buf);
 
-            if (rgui_framebuf_data)
-                  blit_line(x, y, message,
+            rgui_queue_line(rgui, x, y, message,
                             entry_selected ? hover_color : normal_color);
 
             menu_entry_free(&entry);
@@ -672,32 +1083,10 @@ static void rgui_render(void *data, bool is_idle)
                   free(entry_path);
       }
 
-      if (menu_input_dialog_get_display_kb())
-      {
-            const char *str = menu_input_dialog_get_buffer();
-            const char *label = menu_input_dialog_get_label_buffer();
-
-            snprintf(msg, sizeof(msg), "%s\n%s", label, str);
-            rgui_render_messagebox(rgui, msg);
-      }
-
-      if (!string_is_empty(rgui->msgbox))
-      {
-            rgui_render_messagebox(rgui, rgui->msgbox);
-            free(rgui->msgbox);
-            rgui->msgbox = NULL;
-            rgui->force_redraw = true;
-      }
-
-      if (rgui->mouse_show)
-      {
-            settings_t *settings = config_get_ptr();
-            bool cursor_visible = settings->bools.video_fullscreen ||
-                                  !video_driver_has_windowed();
+      /* A selected entry or title too long to fit has scrolled */
+      rgui->ticker_active = menu_animation_is_active();
 
-            if (settings->bools.menu_mouse_enable && cursor_visible)
-                  rgui_blit_cursor();
-      }
+      rgui_render_overlays(rgui, settings);
 }
 
 static void rgui_framebuffer_free(void)
@@ -771,6 +1160,17 @@ static void rgui_free(void *data)
 {
       const uint8_t *font_fb;
       bool fb_font_inited = false;
+      rgui_t *rgui = (rgui_t *)data;
+
+      if (rgui)
+      {
+            if (rgui->msgbox)
+                  free(rgui->msgbox);
+            if (rgui->overlay)
+                  free(rgui->overlay);
+            rgui->msgbox = NULL;
+            rgui->overlay = NULL;
+      }
 
       fb_font_inited = menu_display_get_font_data_init();
       font_fb = menu_display_get_font_framebuffer();
@@ -799,6 +1199,34 @@ static void rgui_set_texture(void)
                                      false, fb_width, fb_height, 1.0f);
 }
 
+static int rgui_iterate(void *data, void *userdata, enum menu_action action)
+{
+      rgui_t *rgui = (rgui_t *)userdata;
+
+      if (rgui && action != MENU_ACTION_NOOP)
+            rgui->input_pending = true;
+
+      return generic_menu_iterate(data, userdata, action);
+}
+
+static void rgui_context_reset(void *data, bool video_is_threaded)
+{
+      rgui_t *rgui = (rgui_t *)data;
+
+      /* The new context has no menu texture yet */
+      if (rgui)
+            rgui->full_redraw = true;
+      menu_display_set_framebuffer_dirty_flag();
+}
+
+static void rgui_toggle(void *userdata, bool menu_on)
+{
+      rgui_t *rgui = (rgui_t *)userdata;
+
+      if (rgui && menu_on)
+            rgui->full_redraw = true;
+}
+
 static void rgui_navigation_clear(void *data, bool pending_push)
 {
       size_t start;
@@ -809,6 +1237,7 @@ static void rgui_navigation_clear(void *data, bool pending_push)
       start = 0;
       menu_entries_ctl(MENU_ENTRIES_CTL_SET_START, &start);
       rgui->scroll_y = 0;
+      rgui->input_pending = true;
 }
 
 static void rgui_navigation_set(void *data, bool scroll)
@@ -818,6 +1247,10 @@ static void rgui_navigation_set(void *data, bool scroll)
       bool do_set_start = false;
       size_t end = menu_entries_get_size();
       size_t selection = menu_navigation_get_selection();
+      rgui_t *rgui = (rgui_t *)data;
+
+      if (rgui)
+            rgui->input_pending = true;
 
       if (!scroll)
             return;
@@ -878,12 +1311,14 @@ static int rgui_environ(enum menu_environ_cb type,
             if (!rgui)
                   return -1;
             rgui->mouse_show = true;
+            rgui->force_redraw = true;
             menu_display_set_framebuffer_dirty_flag();
             break;
       case MENU_ENVIRON_DISABLE_MOUSE_CURSOR:
             if (!rgui)
                   return -1;
             rgui->mouse_show = false;
+            rgui->force_redraw = true;
             menu_display_unset_framebuffer_dirty_flag();
             break;
       case 0:
@@ -923,15 +1358,15 @@ static int rgui_pointer_tap(void *data,
 menu_ctx_driver_t menu_ctx_rgui = {
     rgui_set_texture,
     rgui_set_message,
-    generic_menu_iterate,
+    rgui_iterate,
     rgui_render,
     rgui_frame,
     rgui_init,
     rgui_free,
-    NULL,
+    rgui_context_reset,
     NULL,
     rgui_populate_entries,
-    NULL,
+    rgui_toggle,
     rgui_navigation_clear,
     NULL,
     NULL,
@@ -53,6 +53,7 @@
 #include "../widgets/menu_filebrowser.h"
 
 #include "../menu_event.h"
+#include "../menu_thumbnail_cache.h"
 
 #include "../../verbosity.h"
 #include "../../configuration.h"
@@ -885,6 +886,81 @@ end:
    string_list_free(list);
 }
 
+/* Builds the path of the @pos thumbnail of @content
+ * for the current thumbnail system. */
+static void xmb_fill_thumbnail_path(xmb_handle_t *xmb,
+      const char *content, char pos, char *s, size_t len)
+{
+   settings_t *settings       = config_get_ptr();
+   const char *dir_thumbnails = settings->paths.directory_thumbnails;
+
+   s[0] = '\0';
+
+   /* Append thumbnail system directory */
+   if (!string_is_empty(xmb->thumbnail_system))
+      fill_pathname_join(
+            s,
+            dir_thumbnails,
+            xmb->thumbnail_system,
+            len);
+
+   if (!string_is_empty(s))
+   {
+      char            *tmp_new2      = (char*)
+         malloc(PATH_MAX_LENGTH * sizeof(char));
+
+      tmp_new2[0]                    = '\0';
+
+      /* Append Named_Snaps/Named_Boxarts/Named_Titles */
+      if (pos ==  'R')
+         fill_pathname_join(tmp_new2, s,
+               xmb_thumbnails_ident('R'), PATH_MAX_LENGTH * sizeof(char));
+      if (pos ==  'L')
+         fill_pathname_join(tmp_new2, s,
+               xmb_thumbnails_ident('L'), PATH_MAX_LENGTH * sizeof(char));
+
+      strlcpy(s, tmp_new2, len);
+      free(tmp_new2);
+   }
+
+   /* Scrub characters that are not cross-platform and/or violate the
+    * No-Intro filename standard:
+    * http://datomatic.no-intro.org/stuff/The%20Official%20No-Intro%20Convention%20(20071030).zip
+    * Replace these characters in the entry name with underscores.
+    */
+   if (!string_is_empty(content))
+   {
+      char *scrub_char_pointer       = NULL;
+      char            *tmp_new       = (char*)
+         malloc(PATH_MAX_LENGTH * sizeof(char));
+      char            *tmp           = strdup(content);
+
+      tmp_new[0]                     = '\0';
+
+      while((scrub_char_pointer = strpbrk(tmp, "&*/:`\"<>?\\|")))
+         *scrub_char_pointer = '_';
+
+      /* Look for thumbnail file with this scrubbed filename */
+
+      fill_pathname_join(tmp_new,
+            s,
+            tmp, PATH_MAX_LENGTH * sizeof(char));
+
+      if (!string_is_empty(tmp_new))
+         strlcpy(s,
+               tmp_new, len);
+
+      free(tmp_new);
+      free(tmp);
+   }
+
+   /* Append png extension */
+   if (!string_is_empty(s))
+      strlcat(s,
+            file_path_str(FILE_PATH_PNG_EXTENSION),
+            len);
+}
+
 static void xmb_update_thumbnail_path(void *data, unsigned i, char pos)
 {
    menu_entry_t entry;
@@ -959,70 +1035,8 @@ static void xmb_update_thumbnail_path(void *data, unsigned i, char pos)
       }
    }
 
-   /* Append thumbnail system directory */
-   if (!string_is_empty(xmb->thumbnail_system))
-      fill_pathname_join(
-            new_path,
-            dir_thumbnails,
-            xmb->thumbnail_system,
-            sizeof(new_path));
-
-   if (!string_is_empty(new_path))
-   {
-      char            *tmp_new2      = (char*)
-         malloc(PATH_MAX_LENGTH * sizeof(char));
-
-      tmp_new2[0]                    = '\0';
-
-      /* Append Named_Snaps/Named_Boxarts/Named_Titles */
-      if (pos ==  'R')
-         fill_pathname_join(tmp_new2, new_path,
-               xmb_thumbnails_ident('R'), PATH_MAX_LENGTH * sizeof(char));
-      if (pos ==  'L')
-         fill_pathname_join(tmp_new2, new_path,
-               xmb_thumbnails_ident('L'), PATH_MAX_LENGTH * sizeof(char));
-
-      strlcpy(new_path, tmp_new2,
-            PATH_MAX_LENGTH * sizeof(char));
-      free(tmp_new2);
-   }
-
-   /* Scrub characters that are not cross-platform and/or violate the
-    * No-Intro filename standard:
-    * http://datomatic.no-intro.org/stuff/The%20Official%20No-Intro%20Convention%20(20071030).zip
-    * Replace these characters in the entry name with underscores.
-    */
-   if (!string_is_empty(xmb->thumbnail_content))
-   {
-      char *scrub_char_pointer       = NULL;
-      char            *tmp_new       = (char*)
-         malloc(PATH_MAX_LENGTH * sizeof(char));
-      char            *tmp           = strdup(xmb->thumbnail_content);
-
-      tmp_new[0]                     = '\0';
-
-      while((scrub_char_pointer = strpbrk(tmp, "&*/:`\"<>?\\|")))
-         *scrub_char_pointer = '_';
-
-      /* Look for thumbnail file with this scrubbed filename */
-
-      fill_pathname_join(tmp_new,
-            new_path,
-            tmp, PATH_MAX_LENGTH * sizeof(char));
-
-      if (!string_is_empty(tmp_new))
-         strlcpy(new_path,
-               tmp_new, sizeof(new_path));
-
-      free(tmp_new);
-      free(tmp);
-   }
-
-   /* Append png extension */
-   if (!string_is_empty(new_path))
-      strlcat(new_path,
-            file_path_str(FILE_PATH_PNG_EXTENSION),
-            sizeof(new_path));
+   xmb_fill_thumbnail_path(xmb, xmb->thumbnail_content, pos,
+         new_path, sizeof(new_path));
 
 end:
    if (xmb && !string_is_empty(new_path))
@@ -1104,7 +1118,7 @@ static void xmb_update_thumbnail_image(void *data)
    if (!(string_is_empty(xmb->thumbnail_file_path)))
    {
       if (filestream_exists(xmb->thumbnail_file_path))
-         task_push_image_load(xmb->thumbnail_file_path,
+         menu_thumbnail_cache_load(xmb->thumbnail_file_path,
                menu_display_handle_thumbnail_upload, NULL);
       else
          xmb->thumbnail = 0;
@@ -1116,7 +1130,7 @@ static void xmb_update_thumbnail_image(void *data)
    if (!(string_is_empty(xmb->left_thumbnail_file_path)))
    {
       if (filestream_exists(xmb->left_thumbnail_file_path))
-         task_push_image_load(xmb->left_thumbnail_file_path,
+         menu_thumbnail_cache_load(xmb->left_thumbnail_file_path,
                menu_display_handle_left_thumbnail_upload, NULL);
       else
          xmb->left_thumbnail = 0;
@@ -1180,6 +1194,70 @@ static unsigned xmb_get_system_tab(xmb_handle_t *xmb, unsigned i)
    return UINT_MAX;
 }
 
+/* Queues the thumbnails of the playlist entries around
+ * @selection, nearest first, so that scrolling onto them
+ * finds them already decoded. Missing files are left to the
+ * decode task to find, off the main thread. */
+static void xmb_prefetch_thumbnails(xmb_handle_t *xmb,
+      size_t selection, size_t end)
+{
+   unsigned d;
+   size_t count               = 0;
+   char *paths[MENU_THUMBNAIL_PREFETCH_RADIUS * 4];
+   file_list_t *selection_buf = menu_entries_get_selection_buf_ptr(0);
+   playlist_t *playlist       = playlist_get_cached();
+   const char *off            = msg_hash_to_str(MENU_ENUM_LABEL_VALUE_OFF);
+   bool right                 = !string_is_equal(
+         xmb_thumbnails_ident('R'), off);
+   bool left                  = !string_is_equal(
+         xmb_thumbnails_ident('L'), off);
+
+   for (d = 1; d <= MENU_THUMBNAIL_PREFETCH_RADIUS * 2; d++)
+   {
+      char new_path[PATH_MAX_LENGTH];
+      const char *core_name = NULL;
+      const char *path      = NULL;
+      size_t i              = (d & 1)
+         ? selection + (d + 1) / 2 : selection - d / 2;
+
+      /* Out of range on one side wraps around to a huge index */
+      if (i >= end)
+         continue;
+
+      file_list_get_at_offset(selection_buf, i, &path, NULL, NULL, NULL);
+
+      if (string_is_empty(path))
+         continue;
+
+      if (playlist)
+      {
+         playlist_get_index(playlist, i,
+               NULL, NULL, NULL, &core_name, NULL, NULL);
+         if (string_is_equal(core_name, "imageviewer"))
+            continue;
+      }
+
+      if (right)
+      {
+         xmb_fill_thumbnail_path(xmb, path, 'R',
+               new_path, sizeof(new_path));
+         paths[count++] = strdup(new_path);
+      }
+
+      if (left)
+      {
+         xmb_fill_thumbnail_path(xmb, path, 'L',
+               new_path, sizeof(new_path));
+         paths[count++] = strdup(new_path);
+      }
+   }
+
+   menu_thumbnail_cache_prefetch((const char**)paths, count);
+
+   while (count)
+      free(paths[--count]);
+}
+
 static void xmb_selection_pointer_changed(
       xmb_handle_t *xmb, bool allow_animations)
 {
@@ -1255,6 +1333,8 @@ static void xmb_selection_pointer_changed(
                   xmb_update_thumbnail_path(xmb, i, 'L');
                   xmb_update_thumbnail_image(xmb);
                }
+
+               xmb_prefetch_thumbnails(xmb, selection, end);
             }
             else if (((entry_type == FILE_TYPE_IMAGE || entry_type == FILE_TYPE_IMAGEVIEWER ||
                         entry_type == FILE_TYPE_RDB || entry_type == FILE_TYPE_RDB_ENTRY)
@@ -2711,6 +2791,8 @@ static void xmb_draw_items(
 
    xmb_calculate_visible_range(xmb, height, end, (unsigned)current, &first, &last);
 
+   menu_entries_materialize(list, first, last);
+
    menu_display_blend_begin(video_info);
 
    for (i = first; i <= last; i++)
@@ -2879,6 +2961,9 @@ static void xmb_draw_bg(
       }
 
       menu_display_draw_pipeline(&draw, video_info);
+
+      /* The background keeps moving on its own */
+      menu_driver_invalidate();
    }
    else
 #endif
@@ -2994,6 +3079,10 @@ static void xmb_frame(void *data, video_frame_info_t *video_info)
    xmb->raster_block.carr.coords.vertices  = 0;
    xmb->raster_block2.carr.coords.vertices = 0;
 
+   /* All text up to the font flush goes to the raster blocks,
+    * so icons and quads in between can be merged. */
+   menu_display_batch_begin(video_info);
+
    menu_display_set_alpha(coord_black, MIN(
             (float)video_info->xmb_alpha_factor/100, xmb->alpha));
    menu_display_set_alpha(coord_white, xmb->alpha);
@@ -3676,6 +3765,8 @@ static void xmb_frame(void *data, video_frame_info_t *video_info)
             width,
             height);
 
+   menu_display_batch_end(video_info);
+
    font_driver_flush(video_info->width, video_info->height, xmb->font,
          video_info);
    font_driver_bind_block(xmb->font, NULL);
@@ -4590,6 +4681,9 @@ static void xmb_list_deep_copy(const file_list_t *src, file_list_t *dst,
    file_list_clear(dst);
    file_list_reserve(dst, (last + 1) - first);
 
+   /* Deferred entries have no actiondata to copy yet. */
+   file_list_materialize(src, first, (last + 1) - first);
+
    for (i = first; i <= last; ++i)
    {
       struct item_file *d = &dst->list[j];
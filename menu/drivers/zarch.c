@@ -921,6 +921,9 @@ static void zarch_frame(void *data, video_frame_info_t *video_info)
          0, 0, zui->width, zui->height);
    menu_display_snow(zui->width, zui->height);
 
+   /* Snow keeps falling, and zui polls the mouse itself */
+   menu_driver_invalidate();
+
    switch (zarch_layout)
    {
       case LAY_HOME:
@@ -287,5 +287,6 @@ menu_display_ctx_driver_t menu_display_ctx_d3d10 = {
    menu_display_d3d10_font_init_first,
    MENU_VIDEO_DRIVER_DIRECT3D10,
    "menu_display_d3d10",
-   true
+   true,
+   false
 };
@@ -286,5 +286,6 @@ menu_display_ctx_driver_t menu_display_ctx_d3d11 = {
    menu_display_d3d11_font_init_first,
    MENU_VIDEO_DRIVER_DIRECT3D11,
    "menu_display_d3d11",
-   true
+   true,
+   false
 };
@@ -323,5 +323,6 @@ menu_display_ctx_driver_t menu_display_ctx_d3d9 = {
    menu_display_d3d9_font_init_first,
    MENU_VIDEO_DRIVER_DIRECT3D9,
    "menu_display_d3d9",
+   false,
    false
 };
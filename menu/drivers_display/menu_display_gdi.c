@@ -122,5 +122,6 @@ menu_display_ctx_driver_t menu_display_ctx_gdi = {
    menu_display_gdi_font_init_first,
    MENU_VIDEO_DRIVER_GDI,
    "menu_display_gdi",
+   false,
    false
 };
@@ -264,5 +264,6 @@ menu_display_ctx_driver_t menu_display_ctx_gl = {
    menu_display_gl_font_init_first,
    MENU_VIDEO_DRIVER_OPENGL,
    "menu_display_gl",
-   false
+   false,
+   true
 };
@@ -17,15 +17,45 @@
 
 #include <queues/message_queue.h>
 #include <retro_miscellaneous.h>
+#include <gfx/math/matrix_4x4.h>
 
 #include "../../gfx/font_driver.h"
 #include "../../gfx/video_driver.h"
 
 #include "../menu_driver.h"
 
+/* Mirrors the GL conventions, so that menu drivers lay out and
+ * batch exactly as they would there. */
+static const float null_vertexes[] = {
+   0, 0,
+   1, 0,
+   0, 1,
+   1, 1
+};
+
+static const float null_tex_coords[] = {
+   0, 1,
+   1, 1,
+   0, 0,
+   1, 0
+};
+
+static math_matrix_4x4 null_mvp;
+static bool null_mvp_init     = false;
+
+/* What actually reached the driver, for measuring headless runs */
+static unsigned null_draws    = 0;
+static unsigned null_vertices = 0;
+
 static void *menu_display_null_get_default_mvp(video_frame_info_t *video_info)
 {
-   return NULL;
+   if (!null_mvp_init)
+   {
+      matrix_4x4_ortho(null_mvp, 0, 1, 0, 1, -1, 1);
+      null_mvp_init = true;
+   }
+
+   return &null_mvp;
 }
 
 static void menu_display_null_blend_begin(video_frame_info_t *video_info)
@@ -39,6 +69,11 @@ static void menu_display_null_blend_end(video_frame_info_t *video_info)
 static void menu_display_null_draw(menu_display_ctx_draw_t *draw,
       video_frame_info_t *video_info)
 {
+   if (!draw || !draw->coords)
+      return;
+
+   null_draws++;
+   null_vertices += draw->coords->vertices;
 }
 
 static void menu_display_null_draw_pipeline(
@@ -72,14 +107,20 @@ static bool menu_display_null_font_init_first(
 
 static const float *menu_display_null_get_default_vertices(void)
 {
-   static float dummy[16] = {0.0f};
-   return &dummy[0];
+   return &null_vertexes[0];
 }
 
 static const float *menu_display_null_get_default_tex_coords(void)
 {
-   static float dummy[16] = {0.0f};
-   return &dummy[0];
+   return &null_tex_coords[0];
+}
+
+void menu_display_null_get_counts(unsigned *draws, unsigned *vertices)
+{
+   if (draws)
+      *draws    = null_draws;
+   if (vertices)
+      *vertices = null_vertices;
 }
 
 menu_display_ctx_driver_t menu_display_ctx_null = {
@@ -96,5 +137,6 @@ menu_display_ctx_driver_t menu_display_ctx_null = {
    menu_display_null_font_init_first,
    MENU_VIDEO_DRIVER_GENERIC,
    "menu_display_null",
-   false
+   false,
+   true
 };
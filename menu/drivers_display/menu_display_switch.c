@@ -86,5 +86,6 @@ menu_display_ctx_driver_t menu_display_ctx_switch = {
    menu_display_switch_font_init_first,
    MENU_VIDEO_DRIVER_SWITCH,
    "menu_display_switch",
+   false,
    false
 };
\ No newline at end of file
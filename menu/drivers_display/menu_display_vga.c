@@ -102,5 +102,6 @@ menu_display_ctx_driver_t menu_display_ctx_vga = {
    menu_display_vga_font_init_first,
    MENU_VIDEO_DRIVER_VGA,
    "menu_display_vga",
+   false,
    false
 };
@@ -248,5 +248,6 @@ menu_display_ctx_driver_t menu_display_ctx_vita2d = {
    menu_display_vita2d_font_init_first,
    MENU_VIDEO_DRIVER_VITA2D,
    "menu_display_vita2d",
-   true
+   true,
+   false
 };
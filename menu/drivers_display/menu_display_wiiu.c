@@ -342,5 +342,6 @@ menu_display_ctx_driver_t menu_display_ctx_wiiu = {
    menu_display_wiiu_font_init_first,
    MENU_VIDEO_DRIVER_WIIU,
    "menu_display_wiiu",
-   true
+   true,
+   false
 };
@@ -24,32 +24,61 @@
 #include <features/features_cpu.h>
 
 #include "menu_animation.h"
+#include "menu_driver.h"
 #include "../configuration.h"
 #include "../performance_counters.h"
 
 #define IDEAL_DELTA_TIME (1.0 / 60.0 * 1000000.0)
 
-struct tween
-{
-   bool        alive;
-   float       duration;
-   float       running_since;
-   float       initial_value;
-   float       target_value;
-   float       *subject;
-   uintptr_t   tag;
-   easing_cb   easing;
-   tween_cb    cb;
+#define TWEEN_NONE ((unsigned)-1)
+
+/* Tweens are stored as parallel arrays, one set per easing type,
+ * so an update runs one tight loop per curve instead of an
+ * indirect call per tween. Removal swaps the last tween into
+ * the hole, which keeps every group packed. */
+struct tween_group
+{
+   size_t size;
+   size_t capacity;
+
+   float *running_since;
+   float *duration;
+   float *initial_value;
+   float *delta_value;
+   float *target_value;
+   float *value;
+   float **subject;
+   tween_cb *cb;
+   unsigned *node;
 };
 
+/* Where a tween currently lives. Nodes sharing a tag bucket are
+ * chained together, so killing a tag never scans the groups. */
+struct tween_node
+{
+   uintptr_t tag;
+   unsigned group;
+   unsigned index;
+   unsigned prev;
+   unsigned next;
+};
+
+#define MENU_ANIMATION_TAG_BUCKETS 256
+
 struct menu_animation
 {
-   struct tween *list;
-   bool need_defrag;
+   struct tween_group groups[EASING_LAST];
+
+   struct tween_node *nodes;
+   unsigned nodes_capacity;
+   unsigned nodes_free;
+   unsigned buckets[MENU_ANIMATION_TAG_BUCKETS];
+
+   /* Callbacks of tweens finished during the current update */
+   tween_cb *pending;
+   size_t pending_capacity;
 
-   size_t capacity;
    size_t size;
-   size_t first_dead;
 };
 
 typedef struct menu_animation menu_animation_t;
@@ -313,232 +342,305 @@ static void menu_animation_ticker_generic(uint64_t idx,
    *width = max_width;
 }
 
-bool menu_animation_push(menu_animation_ctx_entry_t *entry)
+static bool menu_animation_group_grow(struct tween_group *g)
 {
-   struct tween t;
-   struct tween *target = NULL;
+   size_t cap = g->capacity ? g->capacity * 2 : 16;
 
-   t.alive              = true;
-   t.duration           = entry->duration;
-   t.running_since      = 0;
-   t.initial_value      = *entry->subject;
-   t.target_value       = entry->target_value;
-   t.subject            = entry->subject;
-   t.tag                = entry->tag;
-   t.cb                 = entry->cb;
-   t.easing             = NULL;
+#define TWEEN_GROW(field, type) \
+   { \
+      type *tmp = (type*)realloc(g->field, cap * sizeof(type)); \
+      if (!tmp) \
+         return false; \
+      g->field = tmp; \
+   }
+   TWEEN_GROW(running_since, float)
+   TWEEN_GROW(duration,      float)
+   TWEEN_GROW(initial_value, float)
+   TWEEN_GROW(delta_value,   float)
+   TWEEN_GROW(target_value,  float)
+   TWEEN_GROW(value,         float)
+   TWEEN_GROW(subject,       float*)
+   TWEEN_GROW(cb,            tween_cb)
+   TWEEN_GROW(node,          unsigned)
+#undef TWEEN_GROW
+
+   g->capacity = cap;
+   return true;
+}
 
-   switch (entry->easing_enum)
+static void menu_animation_group_free(struct tween_group *g)
+{
+   free(g->running_since);
+   free(g->duration);
+   free(g->initial_value);
+   free(g->delta_value);
+   free(g->target_value);
+   free(g->value);
+   free(g->subject);
+   free(g->cb);
+   free(g->node);
+}
+
+static unsigned menu_animation_tag_bucket(uintptr_t tag)
+{
+   uint32_t h = (uint32_t)(tag ^ (tag >> 16));
+   return (h * 2654435761u) >> 24;
+}
+
+static unsigned menu_animation_node_alloc(uintptr_t tag)
+{
+   unsigned n, bucket;
+
+   if (!anim.nodes_capacity)
    {
-      case EASING_LINEAR:
-         t.easing       = &easing_linear;
-         break;
-         /* Quad */
-      case EASING_IN_QUAD:
-         t.easing       = &easing_in_quad;
-         break;
-      case EASING_OUT_QUAD:
-         t.easing       = &easing_out_quad;
-         break;
-      case EASING_IN_OUT_QUAD:
-         t.easing       = &easing_in_out_quad;
-         break;
-      case EASING_OUT_IN_QUAD:
-         t.easing       = &easing_out_in_quad;
-         break;
-         /* Cubic */
-      case EASING_IN_CUBIC:
-         t.easing       = &easing_in_cubic;
-         break;
-      case EASING_OUT_CUBIC:
-         t.easing       = &easing_out_cubic;
-         break;
-      case EASING_IN_OUT_CUBIC:
-         t.easing       = &easing_in_out_cubic;
-         break;
-      case EASING_OUT_IN_CUBIC:
-         t.easing       = &easing_out_in_cubic;
-         break;
-         /* Quart */
-      case EASING_IN_QUART:
-         t.easing       = &easing_in_quart;
-         break;
-      case EASING_OUT_QUART:
-         t.easing       = &easing_out_quart;
-         break;
-      case EASING_IN_OUT_QUART:
-         t.easing       = &easing_in_out_quart;
-         break;
-      case EASING_OUT_IN_QUART:
-         t.easing       = &easing_out_in_quart;
-         break;
-         /* Quint */
-      case EASING_IN_QUINT:
-         t.easing       = &easing_in_quint;
-         break;
-      case EASING_OUT_QUINT:
-         t.easing       = &easing_out_quint;
-         break;
-      case EASING_IN_OUT_QUINT:
-         t.easing       = &easing_in_out_quint;
-         break;
-      case EASING_OUT_IN_QUINT:
-         t.easing       = &easing_out_in_quint;
-         break;
-         /* Sine */
-      case EASING_IN_SINE:
-         t.easing       = &easing_in_sine;
-         break;
-      case EASING_OUT_SINE:
-         t.easing       = &easing_out_sine;
-         break;
-      case EASING_IN_OUT_SINE:
-         t.easing       = &easing_in_out_sine;
-         break;
-      case EASING_OUT_IN_SINE:
-         t.easing       = &easing_out_in_sine;
-         break;
-         /* Expo */
-      case EASING_IN_EXPO:
-         t.easing       = &easing_in_expo;
-         break;
-      case EASING_OUT_EXPO:
-         t.easing       = &easing_out_expo;
-         break;
-      case EASING_IN_OUT_EXPO:
-         t.easing       = &easing_in_out_expo;
-         break;
-      case EASING_OUT_IN_EXPO:
-         t.easing       = &easing_out_in_expo;
-         break;
-         /* Circ */
-      case EASING_IN_CIRC:
-         t.easing       = &easing_in_circ;
-         break;
-      case EASING_OUT_CIRC:
-         t.easing       = &easing_out_circ;
-         break;
-      case EASING_IN_OUT_CIRC:
-         t.easing       = &easing_in_out_circ;
-         break;
-      case EASING_OUT_IN_CIRC:
-         t.easing       = &easing_out_in_circ;
-         break;
-         /* Bounce */
-      case EASING_IN_BOUNCE:
-         t.easing       = &easing_in_bounce;
-         break;
-      case EASING_OUT_BOUNCE:
-         t.easing       = &easing_out_bounce;
-         break;
-      case EASING_IN_OUT_BOUNCE:
-         t.easing       = &easing_in_out_bounce;
-         break;
-      case EASING_OUT_IN_BOUNCE:
-         t.easing       = &easing_out_in_bounce;
-         break;
-      default:
-         break;
+      for (n = 0; n < MENU_ANIMATION_TAG_BUCKETS; n++)
+         anim.buckets[n] = TWEEN_NONE;
+      anim.nodes_free = TWEEN_NONE;
    }
 
-   /* ignore born dead tweens */
-   if (!t.easing || t.duration == 0 || t.initial_value == t.target_value)
-      return false;
-
-   if (anim.first_dead < anim.size && !anim.list[anim.first_dead].alive)
-      target = &anim.list[anim.first_dead++];
-   else
+   if (anim.nodes_free == TWEEN_NONE)
    {
-      if (anim.size >= anim.capacity)
+      unsigned cap = anim.nodes_capacity ? anim.nodes_capacity * 2 : 64;
+      struct tween_node *nodes = (struct tween_node*)
+         realloc(anim.nodes, cap * sizeof(*nodes));
+
+      if (!nodes)
+         return TWEEN_NONE;
+
+      for (n = cap; n-- > anim.nodes_capacity; )
       {
-         anim.capacity++;
-         anim.list = (struct tween*)realloc(anim.list,
-               anim.capacity * sizeof(struct tween));
+         nodes[n].next   = anim.nodes_free;
+         anim.nodes_free = n;
       }
 
-      target = &anim.list[anim.size++];
+      anim.nodes          = nodes;
+      anim.nodes_capacity = cap;
    }
 
-   *target = t;
+   n               = anim.nodes_free;
+   anim.nodes_free = anim.nodes[n].next;
+   bucket          = menu_animation_tag_bucket(tag);
 
-   anim.need_defrag = true;
+   anim.nodes[n].tag  = tag;
+   anim.nodes[n].prev = TWEEN_NONE;
+   anim.nodes[n].next = anim.buckets[bucket];
 
-   return true;
+   if (anim.buckets[bucket] != TWEEN_NONE)
+      anim.nodes[anim.buckets[bucket]].prev = n;
+   anim.buckets[bucket] = n;
+
+   return n;
+}
+
+static void menu_animation_node_free(unsigned n)
+{
+   struct tween_node *node = &anim.nodes[n];
+
+   if (node->prev != TWEEN_NONE)
+      anim.nodes[node->prev].next = node->next;
+   else
+      anim.buckets[menu_animation_tag_bucket(node->tag)] = node->next;
+
+   if (node->next != TWEEN_NONE)
+      anim.nodes[node->next].prev = node->prev;
+
+   node->next      = anim.nodes_free;
+   anim.nodes_free = n;
 }
 
-static int menu_animation_defrag_cmp(const void *a, const void *b)
+/* Drops tween @i of @g by moving the group's last tween over it. */
+static void menu_animation_remove(struct tween_group *g, size_t i)
 {
-   const struct tween *ta = (const struct tween *)a;
-   const struct tween *tb = (const struct tween *)b;
+   size_t last = g->size - 1;
+
+   menu_animation_node_free(g->node[i]);
+
+   if (i != last)
+   {
+      g->running_since[i] = g->running_since[last];
+      g->duration[i]      = g->duration[last];
+      g->initial_value[i] = g->initial_value[last];
+      g->delta_value[i]   = g->delta_value[last];
+      g->target_value[i]  = g->target_value[last];
+      g->subject[i]       = g->subject[last];
+      g->cb[i]            = g->cb[last];
+      g->node[i]          = g->node[last];
+
+      anim.nodes[g->node[i]].index = (unsigned)i;
+   }
+
+   g->size--;
+   anim.size--;
+}
 
-   return tb->alive - ta->alive;
+bool menu_animation_push(menu_animation_ctx_entry_t *entry)
+{
+   size_t i;
+   unsigned n;
+   struct tween_group *g = NULL;
+
+   /* ignore born dead tweens */
+   if (     (unsigned)entry->easing_enum >= EASING_LAST
+         || entry->duration == 0
+         || *entry->subject == entry->target_value)
+      return false;
+
+   g = &anim.groups[entry->easing_enum];
+
+   if (g->size >= g->capacity && !menu_animation_group_grow(g))
+      return false;
+
+   n = menu_animation_node_alloc(entry->tag);
+   if (n == TWEEN_NONE)
+      return false;
+
+   i                    = g->size++;
+   anim.nodes[n].group  = entry->easing_enum;
+   anim.nodes[n].index  = (unsigned)i;
+
+   g->running_since[i]  = 0;
+   g->duration[i]       = entry->duration;
+   g->initial_value[i]  = *entry->subject;
+   g->delta_value[i]    = entry->target_value - *entry->subject;
+   g->target_value[i]   = entry->target_value;
+   g->subject[i]        = entry->subject;
+   g->cb[i]             = entry->cb;
+   g->node[i]           = n;
+
+   anim.size++;
+
+   menu_driver_invalidate();
+
+   return true;
 }
 
-/* defragments and shrinks the tween list when possible */
-static void menu_animation_defrag()
+/* Evaluates the curve of every tween in @g into g->value. The
+ * easing is called directly, so simple curves get inlined into
+ * a loop the compiler can vectorize. */
+static void menu_animation_ease(enum menu_animation_easing_type type,
+      struct tween_group *g)
 {
    size_t i;
 
-   qsort(anim.list, anim.size, sizeof(anim.list[0]), menu_animation_defrag_cmp);
+#define TWEEN_EASE(fn) \
+   for (i = 0; i < g->size; i++) \
+      g->value[i] = fn(g->running_since[i], g->initial_value[i], \
+            g->delta_value[i], g->duration[i]); \
+   break
 
-   for (i = anim.size-1; i > 0; i--)
+   switch (type)
    {
-      if (anim.list[i].alive)
+      case EASING_LINEAR:        TWEEN_EASE(easing_linear);
+         /* Quad */
+      case EASING_IN_QUAD:       TWEEN_EASE(easing_in_quad);
+      case EASING_OUT_QUAD:      TWEEN_EASE(easing_out_quad);
+      case EASING_IN_OUT_QUAD:   TWEEN_EASE(easing_in_out_quad);
+      case EASING_OUT_IN_QUAD:   TWEEN_EASE(easing_out_in_quad);
+         /* Cubic */
+      case EASING_IN_CUBIC:      TWEEN_EASE(easing_in_cubic);
+      case EASING_OUT_CUBIC:     TWEEN_EASE(easing_out_cubic);
+      case EASING_IN_OUT_CUBIC:  TWEEN_EASE(easing_in_out_cubic);
+      case EASING_OUT_IN_CUBIC:  TWEEN_EASE(easing_out_in_cubic);
+         /* Quart */
+      case EASING_IN_QUART:      TWEEN_EASE(easing_in_quart);
+      case EASING_OUT_QUART:     TWEEN_EASE(easing_out_quart);
+      case EASING_IN_OUT_QUART:  TWEEN_EASE(easing_in_out_quart);
+      case EASING_OUT_IN_QUART:  TWEEN_EASE(easing_out_in_quart);
+         /* Quint */
+      case EASING_IN_QUINT:      TWEEN_EASE(easing_in_quint);
+      case EASING_OUT_QUINT:     TWEEN_EASE(easing_out_quint);
+      case EASING_IN_OUT_QUINT:  TWEEN_EASE(easing_in_out_quint);
+      case EASING_OUT_IN_QUINT:  TWEEN_EASE(easing_out_in_quint);
+         /* Sine */
+      case EASING_IN_SINE:       TWEEN_EASE(easing_in_sine);
+      case EASING_OUT_SINE:      TWEEN_EASE(easing_out_sine);
+      case EASING_IN_OUT_SINE:   TWEEN_EASE(easing_in_out_sine);
+      case EASING_OUT_IN_SINE:   TWEEN_EASE(easing_out_in_sine);
+         /* Expo */
+      case EASING_IN_EXPO:       TWEEN_EASE(easing_in_expo);
+      case EASING_OUT_EXPO:      TWEEN_EASE(easing_out_expo);
+      case EASING_IN_OUT_EXPO:   TWEEN_EASE(easing_in_out_expo);
+      case EASING_OUT_IN_EXPO:   TWEEN_EASE(easing_out_in_expo);
+         /* Circ */
+      case EASING_IN_CIRC:       TWEEN_EASE(easing_in_circ);
+      case EASING_OUT_CIRC:      TWEEN_EASE(easing_out_circ);
+      case EASING_IN_OUT_CIRC:   TWEEN_EASE(easing_in_out_circ);
+      case EASING_OUT_IN_CIRC:   TWEEN_EASE(easing_out_in_circ);
+         /* Bounce */
+      case EASING_IN_BOUNCE:     TWEEN_EASE(easing_in_bounce);
+      case EASING_OUT_BOUNCE:    TWEEN_EASE(easing_out_bounce);
+      case EASING_IN_OUT_BOUNCE: TWEEN_EASE(easing_in_out_bounce);
+      case EASING_OUT_IN_BOUNCE: TWEEN_EASE(easing_out_in_bounce);
+      default:
          break;
-
-      anim.size--;
    }
 
-   anim.first_dead = anim.size;
-   anim.need_defrag = false;
+#undef TWEEN_EASE
 }
 
 bool menu_animation_update(float delta_time)
 {
-   unsigned i;
-   unsigned active_tweens = 0;
+   unsigned type;
+   size_t i, pending = 0;
 
-   for(i = 0; i < anim.size; i++)
+   for (type = 0; type < EASING_LAST; type++)
    {
-      struct tween *tween = &anim.list[i];
-      if (!tween || !tween->alive)
+      struct tween_group *g = &anim.groups[type];
+
+      if (!g->size)
          continue;
 
-      tween->running_since += delta_time;
+      for (i = 0; i < g->size; i++)
+         g->running_since[i] += delta_time;
+
+      menu_animation_ease((enum menu_animation_easing_type)type, g);
 
-      *tween->subject = tween->easing(
-            tween->running_since,
-            tween->initial_value,
-            tween->target_value - tween->initial_value,
-            tween->duration);
+      for (i = 0; i < g->size; i++)
+         *g->subject[i] = g->value[i];
 
-      if (tween->running_since >= tween->duration)
+      /* Walk backwards, so whatever gets swapped into a finished
+       * tween's slot has already been looked at. */
+      for (i = g->size; i-- > 0; )
       {
-         *tween->subject = tween->target_value;
-         tween->alive    = false;
-         anim.need_defrag = true;
+         if (g->running_since[i] < g->duration[i])
+            continue;
 
-         if (tween->cb)
-            tween->cb();
-      }
+         *g->subject[i] = g->target_value[i];
 
-      if (tween->running_since < tween->duration)
-         active_tweens += 1;
-   }
+         /* Callbacks may push or kill tweens, so they only run
+          * once every group is done. */
+         if (g->cb[i])
+         {
+            if (pending >= anim.pending_capacity)
+            {
+               size_t cap    = anim.pending_capacity
+                  ? anim.pending_capacity * 2 : 16;
+               tween_cb *tmp = (tween_cb*)realloc(anim.pending,
+                     cap * sizeof(*tmp));
 
-   if (anim.need_defrag)
-      menu_animation_defrag();
+               if (tmp)
+               {
+                  anim.pending          = tmp;
+                  anim.pending_capacity = cap;
+               }
+            }
 
-   if (!active_tweens)
-   {
-      anim.size           = 0;
-      anim.first_dead     = 0;
-      anim.need_defrag    = false;
-      return false;
+            if (pending < anim.pending_capacity)
+               anim.pending[pending++] = g->cb[i];
+         }
+
+         menu_animation_remove(g, i);
+      }
    }
 
+   for (i = 0; i < pending; i++)
+      anim.pending[i]();
+
+   if (!anim.size)
+      return false;
 
    animation_is_active = true;
+   menu_driver_invalidate();
 
    return true;
 }
@@ -578,6 +680,7 @@ bool menu_animation_ticker(const menu_animation_ctx_ticker_t *ticker)
          str_len);
 
    animation_is_active = true;
+   menu_driver_invalidate();
 
    return true;
 }
@@ -609,6 +712,7 @@ void menu_animation_update_time(bool timedate_enable)
    {
       animation_is_active   = true;
       last_clock_update     = cur_time;
+      menu_driver_invalidate();
    }
 }
 
@@ -623,15 +727,13 @@ bool menu_animation_ctl(enum menu_animation_ctl_state state, void *data)
    {
       case MENU_ANIMATION_CTL_DEINIT:
          {
-            size_t i;
+            unsigned i;
 
-            for (i = 0; i < anim.size; i++)
-            {
-               if (anim.list[i].subject)
-                  anim.list[i].subject = NULL;
-            }
+            for (i = 0; i < EASING_LAST; i++)
+               menu_animation_group_free(&anim.groups[i]);
 
-            free(anim.list);
+            free(anim.nodes);
+            free(anim.pending);
 
             memset(&anim, 0, sizeof(menu_animation_t));
          }
@@ -644,6 +746,7 @@ bool menu_animation_ctl(enum menu_animation_ctl_state state, void *data)
          break;
       case MENU_ANIMATION_CTL_SET_ACTIVE:
          animation_is_active       = true;
+         menu_driver_invalidate();
          break;
       case MENU_ANIMATION_CTL_DELTA_TIME:
          {
@@ -655,53 +758,50 @@ bool menu_animation_ctl(enum menu_animation_ctl_state state, void *data)
          break;
       case MENU_ANIMATION_CTL_KILL_BY_TAG:
          {
-            unsigned i;
+            unsigned n;
             menu_animation_ctx_tag *tag = (menu_animation_ctx_tag*)data;
 
-            if (!tag || *tag == (uintptr_t)-1)
+            if (!tag || *tag == (uintptr_t)-1 || !anim.nodes_capacity)
                return false;
 
-            for (i = 0; i < anim.size; ++i)
-            {
-               if (anim.list[i].tag != *tag)
-                  continue;
+            n = anim.buckets[menu_animation_tag_bucket(*tag)];
 
-               anim.list[i].alive   = false;
-               anim.list[i].subject = NULL;
+            while (n != TWEEN_NONE)
+            {
+               struct tween_node *node = &anim.nodes[n];
+               unsigned next           = node->next;
 
-               if (i < anim.first_dead)
-                  anim.first_dead = i;
+               if (node->tag == *tag)
+                  menu_animation_remove(
+                        &anim.groups[node->group], node->index);
 
-               anim.need_defrag = true;
+               n = next;
             }
          }
          break;
       case MENU_ANIMATION_CTL_KILL_BY_SUBJECT:
          {
-            unsigned i, j,  killed = 0;
+            unsigned type;
+            size_t i, j, killed = 0;
             menu_animation_ctx_subject_t *subject =
                (menu_animation_ctx_subject_t*)data;
             float            **sub = (float**)subject->data;
 
-            for (i = 0; i < anim.size && killed < subject->count; ++i)
+            for (type = 0; type < EASING_LAST; type++)
             {
-               if (!anim.list[i].alive)
-                  continue;
+               struct tween_group *g = &anim.groups[type];
 
-               for (j = 0; j < subject->count; ++j)
+               for (i = g->size; i-- > 0 && killed < subject->count; )
                {
-                  if (anim.list[i].subject != sub[j])
-                     continue;
-
-                  anim.list[i].alive   = false;
-                  anim.list[i].subject = NULL;
-
-                  if (i < anim.first_dead)
-                     anim.first_dead = i;
-
-                  killed++;
-                  anim.need_defrag = true;
-                  break;
+                  for (j = 0; j < subject->count; ++j)
+                  {
+                     if (g->subject[i] != sub[j])
+                        continue;
+
+                     menu_animation_remove(g, i);
+                     killed++;
+                     break;
+                  }
                }
             }
          }
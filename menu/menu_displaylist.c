@@ -1245,6 +1245,10 @@ static int menu_displaylist_parse_playlist(menu_displaylist_info_t *info,
       playlist_t *playlist, const char *path_playlist, bool is_history)
 {
    unsigned i;
+   char *path_copy  = NULL;
+   char *fill_buf   = NULL;
+   char *path_short = NULL;
+   size_t path_size = PATH_MAX_LENGTH * sizeof(char);
    size_t selection = menu_navigation_get_selection();
    size_t list_size = playlist_size(playlist);
 
@@ -1265,11 +1269,16 @@ static int menu_displaylist_parse_playlist(menu_displaylist_info_t *info,
    /* preallocate the file list */
    file_list_reserve(info->list, list_size);
 
+   /* Scratch buffers are shared by every entry. */
+   path_copy  = (char*)malloc(path_size);
+   fill_buf   = (char*)malloc(path_size);
+   path_short = (char*)malloc(path_size);
+
+   if (!path_copy || !fill_buf || !path_short)
+      goto end;
+
    for (i = 0; i < list_size; i++)
    {
-      char *path_copy                 = (char*)malloc(PATH_MAX_LENGTH * sizeof(char));
-      char *fill_buf                  = (char*)malloc(PATH_MAX_LENGTH * sizeof(char));
-      size_t path_size                = PATH_MAX_LENGTH * sizeof(char);
       const char *core_name           = NULL;
       const char *path                = NULL;
       const char *label               = NULL;
@@ -1302,8 +1311,6 @@ static int menu_displaylist_parse_playlist(menu_displaylist_info_t *info,
 
       if (path)
       {
-         char *path_short = (char*)malloc(PATH_MAX_LENGTH * sizeof(char));
-
          path_short[0] = '\0';
 
          fill_short_pathname_representation(path_short, path,
@@ -1317,35 +1324,31 @@ static int menu_displaylist_parse_playlist(menu_displaylist_info_t *info,
             if (!string_is_equal(core_name,
                      file_path_str(FILE_PATH_DETECT)))
             {
-               char *tmp       = (char*)
-                  malloc(PATH_MAX_LENGTH * sizeof(char));
+               char tmp[PATH_MAX_LENGTH];
 
                tmp[0] = '\0';
 
-               snprintf(tmp, path_size, " (%s)", core_name);
+               snprintf(tmp, sizeof(tmp), " (%s)", core_name);
                strlcat(fill_buf, tmp, path_size);
-
-               free(tmp);
             }
          }
-
-         free(path_short);
       }
 
       if (!path)
-         menu_entries_append_enum(info->list, fill_buf, path_playlist,
+         menu_entries_append_deferred(info->list, fill_buf, path_playlist,
                MENU_ENUM_LABEL_PLAYLIST_ENTRY, FILE_TYPE_PLAYLIST_ENTRY, 0, i);
       else if (is_history)
-         menu_entries_append_enum(info->list, fill_buf,
+         menu_entries_append_deferred(info->list, fill_buf,
                path, MENU_ENUM_LABEL_PLAYLIST_ENTRY, FILE_TYPE_RPL_ENTRY, 0, i);
       else
-         menu_entries_append_enum(info->list, label,
+         menu_entries_append_deferred(info->list, label,
                path, MENU_ENUM_LABEL_PLAYLIST_ENTRY, FILE_TYPE_RPL_ENTRY, 0, i);
-
-      free(path_copy);
-      free(fill_buf);
    }
 
+end:
+   free(path_copy);
+   free(fill_buf);
+   free(path_short);
    return 0;
 
 error:
@@ -1556,21 +1559,41 @@ error:
    return -1;
 }
 
-static enum msg_file_type extension_to_file_hash_type(const char *ext)
+/* Finds the playlist entry of a database entry through the hash
+ * index on the playlist CRC field, which holds "<hash>|<type>". */
+static bool menu_displaylist_find_playlist_entry(playlist_t *playlist,
+      const database_info_t *db_info_entry, const char *crc_str,
+      size_t *idx)
 {
-   if (string_is_equal(ext, "sha1"))
-      return FILE_TYPE_SHA1;
-   else if (string_is_equal(ext, "crc"))
-      return FILE_TYPE_CRC;
-   else if (string_is_equal(ext, "md5"))
-      return FILE_TYPE_MD5;
-   return FILE_TYPE_NONE;
+   char key[64];
+
+   key[0] = '\0';
+
+   snprintf(key, sizeof(key), "%s|crc", crc_str);
+   if (playlist_get_index_by_crc32(playlist, key, idx))
+      return true;
+
+   if (!string_is_empty(db_info_entry->sha1))
+   {
+      snprintf(key, sizeof(key), "%s|sha1", db_info_entry->sha1);
+      if (playlist_get_index_by_crc32(playlist, key, idx))
+         return true;
+   }
+
+   if (!string_is_empty(db_info_entry->md5))
+   {
+      snprintf(key, sizeof(key), "%s|md5", db_info_entry->md5);
+      if (playlist_get_index_by_crc32(playlist, key, idx))
+         return true;
+   }
+
+   return false;
 }
 
 static int menu_displaylist_parse_database_entry(menu_handle_t *menu,
       menu_displaylist_info_t *info)
 {
-   unsigned i, j, k;
+   unsigned i, k;
    char path_playlist[PATH_MAX_LENGTH];
    char path_base[PATH_MAX_LENGTH];
    char query[PATH_MAX_LENGTH];
@@ -1629,56 +1652,11 @@ static int menu_displaylist_parse_database_entry(menu_handle_t *menu,
 
       if (playlist)
       {
-         for (j = 0; j < playlist_size(playlist); j++)
-         {
-            const char *crc32                = NULL;
-            bool match_found                 = false;
-            struct string_list *tmp_str_list = NULL;
-
-            playlist_get_index(playlist, j,
-                  NULL, NULL, NULL, NULL,
-                  NULL, &crc32);
-
-            if (crc32)
-                tmp_str_list = string_split(crc32, "|");
-
-            if (!tmp_str_list)
-               continue;
-
-            if (tmp_str_list->size > 0)
-            {
-               if (tmp_str_list->size > 1)
-               {
-                  const char *elem0 = tmp_str_list->elems[0].data;
-                  const char *elem1 = tmp_str_list->elems[1].data;
+         size_t idx;
 
-                  switch (extension_to_file_hash_type(elem1))
-                  {
-                     case FILE_TYPE_CRC:
-                        if (string_is_equal(crc_str, elem0))
-                           match_found = true;
-                        break;
-                     case FILE_TYPE_SHA1:
-                        if (string_is_equal(db_info_entry->sha1, elem0))
-                           match_found = true;
-                        break;
-                     case FILE_TYPE_MD5:
-                        if (string_is_equal(db_info_entry->md5, elem0))
-                           match_found = true;
-                        break;
-                     default:
-                        break;
-                  }
-               }
-            }
-
-            string_list_free(tmp_str_list);
-
-            if (!match_found)
-               continue;
-
-            menu->scratchpad.unsigned_var = j;
-         }
+         if (menu_displaylist_find_playlist_entry(playlist,
+                  db_info_entry, crc_str, &idx))
+            menu->scratchpad.unsigned_var = (unsigned)idx;
       }
 
       if (db_info_entry->name)
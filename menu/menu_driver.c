@@ -21,6 +21,7 @@
 #include <compat/strl.h>
 #include <retro_miscellaneous.h>
 #include <formats/image.h>
+#include <gfx/math/matrix_4x4.h>
 #include <file/file_path.h>
 #include <streams/file_stream.h>
 #include <string/stdstring.h>
@@ -45,7 +46,9 @@
 #include "menu_event.h"
 #include "menu_entries.h"
 #include "widgets/menu_dialog.h"
+#include "widgets/menu_input_dialog.h"
 #include "menu_shader.h"
+#include "menu_thumbnail_cache.h"
 
 #include "../config.def.h"
 #include "../content.h"
@@ -65,6 +68,9 @@
 
 #define PARTICLES_COUNT            100
 
+/* Pending batches before a flush is forced */
+#define MENU_DISPLAY_BATCH_MAX     64
+
 typedef struct menu_ctx_load_image
 {
    void *data;
@@ -168,6 +174,29 @@ static bool menu_display_framebuf_dirty          = false;
 static const uint8_t *menu_display_font_framebuf = NULL;
 static menu_display_ctx_driver_t *menu_disp      = NULL;
 
+typedef struct menu_display_batch
+{
+   uintptr_t texture;
+   int blend;
+   /* Bounds of everything in the batch, in window coordinates */
+   float x0, y0, x1, y1;
+   video_coord_array_t ca;
+} menu_display_batch_t;
+
+/* Blend state last asked for by the menu driver, and last
+ * handed down to the display driver; -1 when unknown. They
+ * only differ while batching. */
+static int menu_display_blend_wanted             = -1;
+static int menu_display_blend_current            = -1;
+
+static menu_display_batch_t menu_display_batches[MENU_DISPLAY_BATCH_MAX];
+static unsigned menu_display_batch_count         = 0;
+static unsigned menu_display_batch_width         = 0;
+static unsigned menu_display_batch_height        = 0;
+static bool menu_display_batching                = false;
+static video_frame_info_t *menu_display_batch_info = NULL;
+static menu_display_batch_stats_t menu_display_batch_stats;
+
 /* when enabled, on next iteration the 'Quick Menu' list will
  * be pushed onto the stack */
 static bool menu_driver_pending_quick_menu      = false;
@@ -177,6 +206,14 @@ static bool menu_driver_prevent_populate        = false;
 /* Is the menu driver still running? */
 static bool menu_driver_alive                   = false;
 
+/* Something on screen may have changed since the last menu
+ * frame. While clear, idle menu frames are skipped. */
+static bool menu_driver_invalidated             = true;
+
+/* Output size the last menu frame was rendered at */
+static unsigned menu_driver_frame_width         = 0;
+static unsigned menu_driver_frame_height        = 0;
+
 /* A menu toggle has been requested; if the menu was running,
  * it will be closed; if the menu was not running, it will be opened */
 static bool menu_driver_toggled                 = false;
@@ -356,18 +393,335 @@ void menu_display_timedate(menu_display_ctx_datetime_t *datetime)
    }
 }
 
+static void menu_display_set_blend(video_frame_info_t *video_info,
+      int blend)
+{
+   if (blend == 1)
+   {
+      if (menu_disp->blend_begin)
+         menu_disp->blend_begin(video_info);
+   }
+   else if (menu_disp->blend_end)
+      menu_disp->blend_end(video_info);
+
+   menu_display_blend_current = blend;
+}
+
 /* Begin blending operation */
 void menu_display_blend_begin(video_frame_info_t *video_info)
 {
-   if (menu_disp && menu_disp->blend_begin)
-      menu_disp->blend_begin(video_info);
+   menu_display_blend_wanted = 1;
+
+   /* Deferred until something is drawn with it */
+   if (menu_disp && !menu_display_batching)
+      menu_display_set_blend(video_info, 1);
 }
 
 /* End blending operation */
 void menu_display_blend_end(video_frame_info_t *video_info)
 {
-   if (menu_disp && menu_disp->blend_end)
-      menu_disp->blend_end(video_info);
+   menu_display_blend_wanted = 0;
+
+   if (menu_disp && !menu_display_batching)
+      menu_display_set_blend(video_info, 0);
+}
+
+void menu_display_batch_flush(video_frame_info_t *video_info)
+{
+   unsigned i;
+
+   for (i = 0; menu_disp && i < menu_display_batch_count; i++)
+   {
+      menu_display_ctx_draw_t draw;
+      struct video_coords coords;
+      menu_display_batch_t *batch = &menu_display_batches[i];
+
+      if (batch->blend != -1 && batch->blend != menu_display_blend_current)
+         menu_display_set_blend(video_info, batch->blend);
+
+      coords.vertex             = batch->ca.coords.vertex;
+      coords.color              = batch->ca.coords.color;
+      coords.tex_coord          = batch->ca.coords.tex_coord;
+      coords.lut_tex_coord      = batch->ca.coords.lut_tex_coord;
+      coords.vertices           = batch->ca.coords.vertices;
+      coords.index              = NULL;
+      coords.indexes            = 0;
+
+      draw.x                    = 0;
+      draw.y                    = 0;
+      draw.color                = NULL;
+      draw.vertex               = NULL;
+      draw.tex_coord            = NULL;
+      draw.width                = menu_display_batch_width;
+      draw.height               = menu_display_batch_height;
+      draw.texture              = batch->texture;
+      draw.vertex_count         = coords.vertices;
+      draw.coords               = &coords;
+      draw.matrix_data          = NULL;
+      draw.prim_type            = MENU_DISPLAY_PRIM_TRIANGLES;
+      draw.pipeline.id          = 0;
+      draw.pipeline.backend_data      = NULL;
+      draw.pipeline.backend_data_size = 0;
+      draw.pipeline.active      = false;
+      draw.rotation             = 0.0f;
+      draw.scale_factor         = 1.0f;
+
+      menu_disp->draw(&draw, video_info);
+      menu_display_batch_stats.backend_draws++;
+
+      batch->ca.coords.vertices = 0;
+   }
+
+   menu_display_batch_count = 0;
+}
+
+/* Flushes pending batches and settles the blend state ahead of
+ * anything that cannot be batched. */
+static void menu_display_batch_barrier(video_frame_info_t *video_info)
+{
+   if (!menu_display_batching)
+      return;
+
+   if (!video_info)
+      video_info = menu_display_batch_info;
+
+   menu_display_batch_flush(video_info);
+
+   if (     menu_display_blend_wanted != -1
+         && menu_display_blend_wanted != menu_display_blend_current)
+      menu_display_set_blend(video_info, menu_display_blend_wanted);
+}
+
+/* Turns @draw into triangles in the 0..1 space of a full
+ * viewport and appends them to a batch.
+ *
+ * Returns: false if @draw has to go to the driver as is. */
+static bool menu_display_batch_push(menu_display_ctx_draw_t *draw,
+      video_frame_info_t *video_info)
+{
+   static const unsigned strip[6] = { 0, 1, 2, 2, 1, 3 };
+   float vertex[12], color[24], tex_coord[12], lut_tex_coord[12];
+   struct video_coords coords;
+   unsigned i, count;
+   int idx;
+   float x0, y0, x1, y1;
+   math_matrix_4x4 *mvp         = NULL;
+   const float *vert            = NULL;
+   const float *tex             = NULL;
+   const float *lut             = NULL;
+   menu_display_batch_t *batch  = NULL;
+   int blend                    = menu_display_blend_wanted;
+
+   if (!draw->coords || draw->pipeline.id)
+      return false;
+
+   switch (draw->prim_type)
+   {
+      case MENU_DISPLAY_PRIM_TRIANGLESTRIP:
+         if (draw->coords->vertices != 4)
+            return false;
+         count = 6;
+         break;
+      case MENU_DISPLAY_PRIM_TRIANGLES:
+         if (draw->coords->vertices != 3 && draw->coords->vertices != 6)
+            return false;
+         count = draw->coords->vertices;
+         break;
+      default:
+         return false;
+   }
+
+   vert = draw->coords->vertex
+      ? draw->coords->vertex : menu_disp->get_default_vertices();
+   tex  = draw->coords->tex_coord
+      ? draw->coords->tex_coord : menu_disp->get_default_tex_coords();
+   lut  = draw->coords->lut_tex_coord
+      ? draw->coords->lut_tex_coord : menu_disp->get_default_tex_coords();
+   mvp  = (math_matrix_4x4*)(draw->matrix_data
+      ? draw->matrix_data : menu_disp->get_default_mvp(video_info));
+
+   if (!vert || !tex || !lut || !mvp)
+      return false;
+
+   x0 = y0 = 1e30f;
+   x1 = y1 = -1e30f;
+
+   for (i = 0; i < count; i++)
+   {
+      float cx, cy, cw, wx, wy;
+      unsigned j = (draw->prim_type == MENU_DISPLAY_PRIM_TRIANGLESTRIP)
+         ? strip[i] : i;
+      float vx   = vert[2 * j + 0];
+      float vy   = vert[2 * j + 1];
+
+      cx = MAT_ELEM_4X4(*mvp, 0, 0) * vx
+         + MAT_ELEM_4X4(*mvp, 0, 1) * vy + MAT_ELEM_4X4(*mvp, 0, 3);
+      cy = MAT_ELEM_4X4(*mvp, 1, 0) * vx
+         + MAT_ELEM_4X4(*mvp, 1, 1) * vy + MAT_ELEM_4X4(*mvp, 1, 3);
+      cw = MAT_ELEM_4X4(*mvp, 3, 0) * vx
+         + MAT_ELEM_4X4(*mvp, 3, 1) * vy + MAT_ELEM_4X4(*mvp, 3, 3);
+
+      if (cw <= 0.0f)
+         return false;
+
+      cx /= cw;
+      cy /= cw;
+
+      /* The draw's own viewport would have clipped this */
+      if (cx < -1.0001f || cx > 1.0001f || cy < -1.0001f || cy > 1.0001f)
+         return false;
+
+      wx = draw->x + (cx + 1.0f) * 0.5f * draw->width;
+      wy = draw->y + (cy + 1.0f) * 0.5f * draw->height;
+
+      if (wx < x0)
+         x0 = wx;
+      if (wx > x1)
+         x1 = wx;
+      if (wy < y0)
+         y0 = wy;
+      if (wy > y1)
+         y1 = wy;
+
+      vertex[2 * i + 0]        = wx / menu_display_batch_width;
+      vertex[2 * i + 1]        = wy / menu_display_batch_height;
+      tex_coord[2 * i + 0]     = tex[2 * j + 0];
+      tex_coord[2 * i + 1]     = tex[2 * j + 1];
+      lut_tex_coord[2 * i + 0] = lut[2 * j + 0];
+      lut_tex_coord[2 * i + 1] = lut[2 * j + 1];
+
+      if (draw->coords->color)
+         memcpy(&color[4 * i], &draw->coords->color[4 * j],
+               4 * sizeof(float));
+      else
+         color[4 * i + 0] = color[4 * i + 1] =
+            color[4 * i + 2] = color[4 * i + 3] = 1.0f;
+   }
+
+   /* Join the latest batch with the same state, as long as
+    * nothing queued after it overlaps this draw. */
+   for (idx = (int)menu_display_batch_count - 1; idx >= 0; idx--)
+   {
+      menu_display_batch_t *b = &menu_display_batches[idx];
+
+      if (b->texture == draw->texture && b->blend == blend)
+      {
+         batch = b;
+         break;
+      }
+
+      if (x0 < b->x1 && b->x0 < x1 && y0 < b->y1 && b->y0 < y1)
+         break;
+   }
+
+   if (batch)
+   {
+      if (x0 < batch->x0)
+         batch->x0 = x0;
+      if (x1 > batch->x1)
+         batch->x1 = x1;
+      if (y0 < batch->y0)
+         batch->y0 = y0;
+      if (y1 > batch->y1)
+         batch->y1 = y1;
+   }
+   else
+   {
+      if (menu_display_batch_count == MENU_DISPLAY_BATCH_MAX)
+         menu_display_batch_flush(video_info);
+
+      batch          = &menu_display_batches[menu_display_batch_count++];
+      batch->texture = draw->texture;
+      batch->blend   = blend;
+      batch->x0      = x0;
+      batch->y0      = y0;
+      batch->x1      = x1;
+      batch->y1      = y1;
+      batch->ca.coords.vertices = 0;
+   }
+
+   coords.vertex        = vertex;
+   coords.color         = color;
+   coords.tex_coord     = tex_coord;
+   coords.lut_tex_coord = lut_tex_coord;
+   coords.vertices      = count;
+   coords.index         = NULL;
+   coords.indexes       = 0;
+
+   if (!video_coord_array_append(&batch->ca, &coords, count))
+   {
+      if (!batch->ca.coords.vertices)
+         menu_display_batch_count--;
+      return false;
+   }
+
+   menu_display_batch_stats.batched++;
+   return true;
+}
+
+void menu_display_batch_begin(video_frame_info_t *video_info)
+{
+   if (     !menu_disp
+         || !menu_disp->supports_batching
+         || !video_info
+         || !video_info->width
+         || !video_info->height
+         || menu_display_batching)
+      return;
+
+   menu_display_batch_width  = video_info->width;
+   menu_display_batch_height = video_info->height;
+   menu_display_batch_info   = video_info;
+   menu_display_batching     = true;
+}
+
+void menu_display_batch_end(video_frame_info_t *video_info)
+{
+   if (!menu_display_batching)
+      return;
+
+   menu_display_batch_barrier(video_info);
+
+   menu_display_batching     = false;
+   menu_display_batch_info   = NULL;
+   menu_display_batch_stats.frames++;
+}
+
+void menu_display_get_batch_stats(menu_display_batch_stats_t *stats)
+{
+   if (stats)
+      *stats = menu_display_batch_stats;
+}
+
+static void menu_display_batch_deinit(void)
+{
+   unsigned i;
+   menu_display_batch_stats_t *stats = &menu_display_batch_stats;
+
+   if (stats->submitted)
+      RARCH_LOG("[Menu]: %u draws over %u batched frames, "
+            "%u reached the display driver (%.1f%%).\n",
+            stats->submitted, stats->frames, stats->backend_draws,
+            100.0 * stats->backend_draws / stats->submitted);
+
+   if (menu_disp == &menu_display_ctx_null)
+   {
+      unsigned draws, vertices;
+      menu_display_null_get_counts(&draws, &vertices);
+      RARCH_LOG("[Menu]: Null display driver took %u draws, "
+            "%u vertices.\n", draws, vertices);
+   }
+
+   for (i = 0; i < MENU_DISPLAY_BATCH_MAX; i++)
+      video_coord_array_free(&menu_display_batches[i].ca);
+
+   memset(stats, 0, sizeof(*stats));
+
+   menu_display_batch_count   = 0;
+   menu_display_batching      = false;
+   menu_display_batch_info    = NULL;
+   menu_display_blend_wanted  = -1;
+   menu_display_blend_current = -1;
 }
 
 /* Teardown; deinitializes and frees all
@@ -552,11 +906,13 @@ bool menu_display_get_update_pending(void)
 
 void menu_display_set_viewport(unsigned width, unsigned height)
 {
+   menu_display_batch_barrier(NULL);
    video_driver_set_viewport(width, height, true, false);
 }
 
 void menu_display_unset_viewport(unsigned width, unsigned height)
 {
+   menu_display_batch_barrier(NULL);
    video_driver_set_viewport(width, height, false, true);
 }
 
@@ -632,6 +988,7 @@ bool menu_display_restore_clear_color(void)
 {
    if (!menu_disp || !menu_disp->restore_clear_color)
       return false;
+   menu_display_batch_barrier(NULL);
    menu_disp->restore_clear_color();
    return true;
 }
@@ -639,6 +996,7 @@ bool menu_display_restore_clear_color(void)
 void menu_display_clear_color(menu_display_ctx_clearcolor_t *color,
       video_frame_info_t *video_info)
 {
+   menu_display_batch_barrier(video_info);
    if (menu_disp && menu_disp->clear_color)
       menu_disp->clear_color(color, video_info);
 }
@@ -653,14 +1011,29 @@ void menu_display_draw(menu_display_ctx_draw_t *draw,
    if (draw->height <= 0)
       draw->height = 1;
 
+   menu_display_batch_stats.submitted++;
+
+   if (menu_display_batching && menu_display_batch_push(draw, video_info))
+      return;
+
+   menu_display_batch_barrier(video_info);
+
    menu_disp->draw(draw, video_info);
+   menu_display_batch_stats.backend_draws++;
 }
 
 void menu_display_draw_pipeline(menu_display_ctx_draw_t *draw,
       video_frame_info_t *video_info)
 {
-   if (menu_disp && draw && menu_disp->draw_pipeline)
-      menu_disp->draw_pipeline(draw, video_info);
+   if (!menu_disp || !draw || !menu_disp->draw_pipeline)
+      return;
+
+   menu_display_batch_barrier(video_info);
+   menu_disp->draw_pipeline(draw, video_info);
+
+   /* Pipelines set up their own shader and blending */
+   menu_display_blend_wanted  = -1;
+   menu_display_blend_current = -1;
 }
 
 void menu_display_draw_bg(menu_display_ctx_draw_t *draw,
@@ -730,8 +1103,7 @@ void menu_display_draw_quad(
    coords.lut_tex_coord = NULL;
    coords.color         = color;
 
-   if (menu_disp && menu_disp->blend_begin)
-      menu_disp->blend_begin(video_info);
+   menu_display_blend_begin(video_info);
 
    draw.x            = x;
    draw.y            = (int)height - y - (int)h;
@@ -747,8 +1119,7 @@ void menu_display_draw_quad(
 
    menu_display_draw(&draw, video_info);
 
-   if (menu_disp && menu_disp->blend_end)
-      menu_disp->blend_end(video_info);
+   menu_display_blend_end(video_info);
 }
 
 void menu_display_draw_texture(
@@ -1116,6 +1487,8 @@ bool menu_display_get_tex_coords(menu_display_ctx_coord_draw_t *draw)
 
 static bool menu_driver_load_image(menu_ctx_load_image_t *load_image_info)
 {
+   menu_driver_invalidate();
+
    if (menu_driver_ctx && menu_driver_ctx->load_image)
       return menu_driver_ctx->load_image(menu_userdata,
             load_image_info->data, load_image_info->type);
@@ -1131,10 +1504,9 @@ void menu_display_handle_thumbnail_upload(void *task_data,
    load_image_info.data = img;
    load_image_info.type = MENU_IMAGE_THUMBNAIL;
 
+   /* img is owned by the thumbnail cache */
    menu_driver_load_image(&load_image_info);
 
-   image_texture_free(img);
-   free(img);
    free(user_data);
 }
 
@@ -1147,10 +1519,9 @@ void menu_display_handle_left_thumbnail_upload(void *task_data,
    load_image_info.data = img;
    load_image_info.type = MENU_IMAGE_LEFT_THUMBNAIL;
 
+   /* img is owned by the thumbnail cache */
    menu_driver_load_image(&load_image_info);
 
-   image_texture_free(img);
-   free(img);
    free(user_data);
 }
 
@@ -1227,8 +1598,7 @@ void menu_display_draw_cursor(
    coords.lut_tex_coord = NULL;
    coords.color         = (const float*)color;
 
-   if (menu_disp && menu_disp->blend_begin)
-      menu_disp->blend_begin(video_info);
+   menu_display_blend_begin(video_info);
 
    draw.x               = x - (cursor_size / 2);
    draw.y               = (int)height - y - (cursor_size / 2);
@@ -1242,8 +1612,7 @@ void menu_display_draw_cursor(
 
    menu_display_draw(&draw, video_info);
 
-   if (menu_disp && menu_disp->blend_end)
-      menu_disp->blend_end(video_info);
+   menu_display_blend_end(video_info);
 }
 
 static INLINE float menu_display_scalef(float val,
@@ -1675,6 +2044,8 @@ static void menu_driver_toggle(bool on)
 
    menu_driver_toggled = on;
 
+   menu_driver_invalidate();
+
    if (!on)
       menu_display_toggle_set_reason(MENU_TOGGLE_REASON_NONE);
 
@@ -1753,6 +2124,41 @@ void menu_driver_frame(video_frame_info_t *video_info)
 {
    if (menu_driver_alive && menu_driver_ctx->frame)
       menu_driver_ctx->frame(menu_userdata, video_info);
+
+   /* In case the driver returned halfway through a batch */
+   menu_display_batch_end(video_info);
+}
+
+void menu_driver_invalidate(void)
+{
+   menu_driver_invalidated = true;
+}
+
+static bool menu_driver_needs_frame(bool rarch_is_inited,
+      bool rarch_is_dummy_core)
+{
+   unsigned width       = 0;
+   unsigned height      = 0;
+   settings_t *settings = config_get_ptr();
+
+   video_driver_get_size(&width, &height);
+
+   if (     width  != menu_driver_frame_width
+         || height != menu_driver_frame_height)
+   {
+      menu_driver_frame_width  = width;
+      menu_driver_frame_height = height;
+      return true;
+   }
+
+   /* Whatever changes every frame without telling us */
+   return menu_driver_invalidated
+      || BIT64_GET(menu_driver_data->state, MENU_STATE_RENDER_MESSAGEBOX)
+      || menu_input_dialog_get_display_kb()
+      || menu_display_libretro_running(rarch_is_inited, rarch_is_dummy_core)
+      || settings->bools.video_fps_show
+      || settings->bools.video_statistics_show
+      || settings->bools.audio_enable_menu;
 }
 
 bool menu_driver_render(bool is_idle, bool rarch_is_inited,
@@ -1761,6 +2167,21 @@ bool menu_driver_render(bool is_idle, bool rarch_is_inited,
    if (!menu_driver_data)
       return false;
 
+   if (BIT64_GET(menu_driver_data->state, MENU_STATE_BLIT))
+   {
+      settings_t *settings = config_get_ptr();
+      menu_animation_update_time(settings->bools.menu_timedate_enable);
+   }
+
+   if (!menu_driver_needs_frame(rarch_is_inited, rarch_is_dummy_core))
+   {
+      menu_driver_data->state = 0;
+      return false;
+   }
+
+   /* Anything invalidating from here on asks for the next frame */
+   menu_driver_invalidated = false;
+
    if (BIT64_GET(menu_driver_data->state, MENU_STATE_RENDER_FRAMEBUFFER)
          != BIT64_GET(menu_driver_data->state, MENU_STATE_RENDER_MESSAGEBOX))
       BIT64_SET(menu_driver_data->state, MENU_STATE_RENDER_FRAMEBUFFER);
@@ -1785,9 +2206,6 @@ bool menu_driver_render(bool is_idle, bool rarch_is_inited,
 
    if (BIT64_GET(menu_driver_data->state, MENU_STATE_BLIT))
    {
-      settings_t *settings = config_get_ptr();
-      menu_animation_update_time(settings->bools.menu_timedate_enable);
-
       if (menu_driver_ctx->render)
          menu_driver_ctx->render(menu_userdata, is_idle);
    }
@@ -1929,6 +2347,7 @@ static bool menu_driver_context_reset(bool video_is_threaded)
 
 bool menu_driver_init(bool video_is_threaded)
 {
+   menu_driver_invalidate();
    if (menu_driver_init_internal(video_is_threaded))
       return menu_driver_context_reset(video_is_threaded);
    return false;
@@ -1936,12 +2355,14 @@ bool menu_driver_init(bool video_is_threaded)
 
 void menu_driver_navigation_set(bool scroll)
 {
+   menu_driver_invalidate();
    if (menu_driver_ctx->navigation_set)
       menu_driver_ctx->navigation_set(menu_userdata, scroll);
 }
 
 void menu_driver_populate_entries(menu_displaylist_info_t *info)
 {
+   menu_driver_invalidate();
    if (menu_driver_ctx && menu_driver_ctx->populate_entries)
       menu_driver_ctx->populate_entries(
             menu_userdata, info->path,
@@ -2076,6 +2497,7 @@ bool menu_driver_ctl(enum rarch_menu_ctl_state state, void *data)
 
          playlist_free_cached();
          menu_shader_manager_free();
+         menu_thumbnail_cache_deinit();
 
          if (menu_driver_data)
          {
@@ -2107,6 +2529,7 @@ bool menu_driver_ctl(enum rarch_menu_ctl_state state, void *data)
             }
 
             video_coord_array_free(&menu_disp_ca);
+            menu_display_batch_deinit();
             menu_display_msg_force       = false;
             menu_display_header_height   = 0;
             menu_disp                    = NULL;
@@ -375,6 +375,10 @@ typedef struct menu_display_ctx_driver
    enum menu_display_driver_type type;
    const char *ident;
    bool handles_transform;
+   /* Set if draw() takes TRIANGLES in the 0..1 space of the default
+    * MVP over a full viewport, so that menu_display can merge quads
+    * into a single call. */
+   bool supports_batching;
 } menu_display_ctx_driver_t;
 
 
@@ -432,6 +436,17 @@ struct menu_display_ctx_draw
    float scale_factor;
 };
 
+typedef struct menu_display_batch_stats
+{
+   /* Draws handed to menu_display_draw() */
+   unsigned submitted;
+   /* Of those, draws merged into a batch */
+   unsigned batched;
+   /* Draw calls that reached the display driver */
+   unsigned backend_draws;
+   unsigned frames;
+} menu_display_batch_stats_t;
+
 typedef struct menu_display_ctx_rotate_draw
 {
    bool scale_enable;
@@ -632,8 +647,16 @@ const char* config_get_menu_driver_options(void);
 
 const char *menu_driver_ident(void);
 
+/* Renders a menu frame, unless nothing has invalidated the menu
+ * since the last one.
+ *
+ * Returns: false if no frame was rendered. */
 bool menu_driver_render(bool is_idle, bool is_inited, bool is_dummy);
 
+/* Asks for a new menu frame. Calls made while a frame renders
+ * ask for the one after it. Main thread only. */
+void menu_driver_invalidate(void);
+
 bool menu_driver_ctl(enum rarch_menu_ctl_state state, void *data);
 
 bool menu_driver_is_binding_state(void);
@@ -709,6 +732,15 @@ bool menu_display_init_first_driver(bool video_is_threaded);
 bool menu_display_restore_clear_color(void);
 void menu_display_clear_color(menu_display_ctx_clearcolor_t *color,
       video_frame_info_t *video_info);
+/* Draws between these two calls may be deferred and merged by
+ * texture and blend state. Text drawn in between must go to a
+ * bound raster block, as it would otherwise end up underneath. */
+void menu_display_batch_begin(video_frame_info_t *video_info);
+void menu_display_batch_end(video_frame_info_t *video_info);
+void menu_display_batch_flush(video_frame_info_t *video_info);
+
+void menu_display_get_batch_stats(menu_display_batch_stats_t *stats);
+
 void menu_display_draw(menu_display_ctx_draw_t *draw,
       video_frame_info_t *video_info);
 void menu_display_draw_keyboard(
@@ -816,6 +848,9 @@ extern menu_display_ctx_driver_t menu_display_ctx_vga;
 extern menu_display_ctx_driver_t menu_display_ctx_switch;
 extern menu_display_ctx_driver_t menu_display_ctx_null;
 
+/* Draw calls and vertices received by the null display driver. */
+void menu_display_null_get_counts(unsigned *draws, unsigned *vertices);
+
 extern menu_ctx_driver_t menu_ctx_xui;
 extern menu_ctx_driver_t menu_ctx_rgui;
 extern menu_ctx_driver_t menu_ctx_nxrgui;
@@ -577,6 +577,82 @@ void menu_entries_append_enum(file_list_t *list, const char *path,
    menu_cbs_init(list, cbs, path, label, type, idx);
 }
 
+/* Binds the callbacks of an entry appended with
+ * menu_entries_append_deferred(); 'tag' holds its enum_idx + 1. */
+static void menu_entries_materialize_cb(file_list_t *list,
+      size_t idx, unsigned tag)
+{
+   menu_file_list_cbs_t *cbs    = (menu_file_list_cbs_t*)
+      calloc(1, sizeof(menu_file_list_cbs_t));
+   enum msg_hash_enums enum_idx = (enum msg_hash_enums)(tag - 1);
+   const char *path             = list->list[idx].path;
+   const char *label            = list->list[idx].label;
+
+   if (!cbs)
+      return;
+
+   file_list_set_actiondata(list, idx, cbs);
+
+   cbs->enum_idx = enum_idx;
+
+   if (enum_idx != MENU_ENUM_LABEL_PLAYLIST_ENTRY
+       && enum_idx != MENU_ENUM_LABEL_PLAYLIST_COLLECTION_ENTRY
+       && enum_idx != MENU_ENUM_LABEL_RDB_ENTRY)
+      cbs->setting  = menu_setting_find_enum(enum_idx);
+
+   menu_cbs_init(list, cbs, path, label, list->list[idx].type, idx);
+}
+
+void menu_entries_append_deferred(file_list_t *list, const char *path,
+      const char *label,
+      enum msg_hash_enums enum_idx,
+      unsigned type, size_t directory_ptr, size_t entry_idx)
+{
+   menu_ctx_list_t list_info;
+   size_t idx;
+   const char *menu_path           = NULL;
+   if (!list || !label)
+      return;
+
+   if (!file_list_append(list, path, label, type, directory_ptr, entry_idx))
+      return;
+
+   menu_entries_get_last_stack(&menu_path, NULL, NULL, NULL, NULL);
+
+   idx                   = list->size - 1;
+
+   list_info.fullpath    = NULL;
+
+   if (!string_is_empty(menu_path))
+      list_info.fullpath = strdup(menu_path);
+   list_info.list        = list;
+   list_info.path        = path;
+   list_info.label       = label;
+   list_info.idx         = idx;
+   list_info.entry_type  = type;
+
+   menu_driver_ctl(RARCH_MENU_CTL_LIST_INSERT, &list_info);
+
+   if (list_info.fullpath)
+      free(list_info.fullpath);
+
+   file_list_free_actiondata(list, idx);
+   file_list_set_materialize_cb(list, menu_entries_materialize_cb);
+   file_list_set_deferred(list, idx, (unsigned)enum_idx + 1);
+}
+
+void menu_entries_materialize(file_list_t *list, size_t first, size_t last)
+{
+   size_t start = first > MENU_ENTRIES_MATERIALIZE_MARGIN
+      ? first - MENU_ENTRIES_MATERIALIZE_MARGIN : 0;
+
+   if (last < first)
+      return;
+
+   file_list_materialize(list, start,
+         (last - start) + 1 + MENU_ENTRIES_MATERIALIZE_MARGIN);
+}
+
 void menu_entries_prepend(file_list_t *list, const char *path, const char *label,
       enum msg_hash_enums enum_idx,
       unsigned type, size_t directory_ptr, size_t entry_idx)
@@ -750,6 +826,8 @@ bool menu_entries_ctl(enum menu_entries_ctl_state state, void *data)
                menu_entries_nonblocking_refresh = true;
             else
                menu_entries_need_refresh        = true;
+
+            menu_driver_invalidate();
          }
          break;
       case MENU_ENTRIES_CTL_UNSET_REFRESH:
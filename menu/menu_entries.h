@@ -29,6 +29,9 @@
 
 RETRO_BEGIN_DECLS
 
+/* Entries bound ahead of and behind the visible window */
+#define MENU_ENTRIES_MATERIALIZE_MARGIN 16
+
 enum menu_entries_ctl_state
 {
    MENU_ENTRIES_CTL_NONE = 0,
@@ -178,6 +181,18 @@ void menu_entries_append_enum(file_list_t *list, const char *path, const char *l
       enum msg_hash_enums enum_idx,
       unsigned type, size_t directory_ptr, size_t entry_idx);
 
+/* Like menu_entries_append_enum(), but the entry's callbacks are only
+ * bound once it is first accessed or drawn. Meant for long listings
+ * (directories, playlists) where most entries are never looked at. */
+void menu_entries_append_deferred(file_list_t *list, const char *path,
+      const char *label,
+      enum msg_hash_enums enum_idx,
+      unsigned type, size_t directory_ptr, size_t entry_idx);
+
+/* Binds the deferred entries in [first, last], plus a margin on
+ * either side so that scrolling does not stall on every step. */
+void menu_entries_materialize(file_list_t *list, size_t first, size_t last);
+
 bool menu_entries_ctl(enum menu_entries_ctl_state state, void *data);
 
 RETRO_END_DECLS
@@ -246,6 +246,7 @@ static int menu_input_mouse_frame(
          if (!rarch_timer_is_running(&mouse_activity_timer))
             mouse_activity = true;
          menu_event_set_osk_ptr(point.retcode);
+         menu_driver_invalidate();
       }
       else
       {
@@ -256,6 +257,13 @@ static int menu_input_mouse_frame(
       mouse_old_y = point.y;
    }
 
+   /* The idle timer keeps expiring once it has been stopped,
+    * only the frame hiding the cursor needs redrawing. */
+   if (     mouse_state != MENU_MOUSE_ACTION_NONE
+         || (no_mouse_activity
+            && rarch_timer_is_running(&mouse_activity_timer)))
+      menu_driver_invalidate();
+
    if (BIT64_GET(mouse_state, MENU_MOUSE_ACTION_BUTTON_L))
    {
       menu_ctx_pointer_t point;
@@ -431,6 +439,11 @@ static int menu_input_pointer_post_iterate(
       return 0;
 #endif
 
+   if (     menu_input->pointer.pressed[0]
+         || pointer_oldpressed[0]
+         || menu_input->pointer.back)
+      menu_driver_invalidate();
+
    if (menu_input->pointer.pressed[0])
    {
       gfx_ctx_metrics_t metrics;
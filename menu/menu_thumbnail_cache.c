@@ -0,0 +1,426 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <retro_miscellaneous.h>
+#include <formats/image.h>
+#include <string/stdstring.h>
+
+#include "menu_thumbnail_cache.h"
+
+#include "../msg_hash.h"
+#include "../verbosity.h"
+#include "../tasks/tasks_internal.h"
+
+/* Everything here runs on the main thread: loads and prefetches
+ * come from the menu driver, and image task callbacks are
+ * dispatched from task_queue_check(). Only the decode itself
+ * happens on a worker thread, when the task queue is threaded. */
+
+typedef struct menu_thumbnail_cache_entry
+{
+   char *path;
+   uint32_t hash;
+   size_t bytes;
+   struct texture_image image;
+   struct menu_thumbnail_cache_entry *prev;
+   struct menu_thumbnail_cache_entry *next;
+} menu_thumbnail_cache_entry_t;
+
+typedef struct menu_thumbnail_cache_request
+{
+   char *path;
+   uint32_t hash;
+   void *task;
+   unsigned generation;
+   bool cancelled;
+   /* Waiter, NULL for a plain prefetch */
+   retro_task_callback_t cb;
+   void *user_data;
+   struct menu_thumbnail_cache_request *next;
+} menu_thumbnail_cache_request_t;
+
+/* Most recently used first */
+static menu_thumbnail_cache_entry_t   *cache_head     = NULL;
+static menu_thumbnail_cache_entry_t   *cache_tail     = NULL;
+static menu_thumbnail_cache_request_t *cache_requests = NULL;
+static unsigned cache_generation                      = 0;
+/* Hashes of paths whose prefetch failed, oldest overwritten first,
+ * so that thumbnails that don't exist are not queued on every
+ * selection change. Explicit loads still try them. */
+static uint32_t cache_missing[MENU_THUMBNAIL_CACHE_MISSING];
+static unsigned cache_missing_count                   = 0;
+static menu_thumbnail_cache_stats_t cache_stats;
+
+static void menu_thumbnail_cache_unlink(
+      menu_thumbnail_cache_entry_t *entry)
+{
+   if (entry->prev)
+      entry->prev->next = entry->next;
+   else
+      cache_head        = entry->next;
+
+   if (entry->next)
+      entry->next->prev = entry->prev;
+   else
+      cache_tail        = entry->prev;
+
+   entry->prev = NULL;
+   entry->next = NULL;
+}
+
+static void menu_thumbnail_cache_link_head(
+      menu_thumbnail_cache_entry_t *entry)
+{
+   entry->prev = NULL;
+   entry->next = cache_head;
+
+   if (cache_head)
+      cache_head->prev = entry;
+   else
+      cache_tail       = entry;
+
+   cache_head = entry;
+}
+
+static void menu_thumbnail_cache_entry_free(
+      menu_thumbnail_cache_entry_t *entry)
+{
+   image_texture_free(&entry->image);
+   free(entry->path);
+   free(entry);
+}
+
+static menu_thumbnail_cache_entry_t *menu_thumbnail_cache_find(
+      const char *path, uint32_t hash)
+{
+   menu_thumbnail_cache_entry_t *entry = cache_head;
+
+   for (; entry; entry = entry->next)
+      if (entry->hash == hash && string_is_equal(entry->path, path))
+         return entry;
+
+   return NULL;
+}
+
+static menu_thumbnail_cache_request_t *menu_thumbnail_cache_find_request(
+      const char *path, uint32_t hash)
+{
+   menu_thumbnail_cache_request_t *req = cache_requests;
+
+   for (; req; req = req->next)
+      if (     !req->cancelled
+            && req->hash == hash
+            && string_is_equal(req->path, path))
+         return req;
+
+   return NULL;
+}
+
+static void menu_thumbnail_cache_evict(size_t needed)
+{
+   while (cache_tail
+         && cache_stats.bytes + needed > MENU_THUMBNAIL_CACHE_SIZE)
+   {
+      menu_thumbnail_cache_entry_t *entry = cache_tail;
+
+      menu_thumbnail_cache_unlink(entry);
+
+      cache_stats.bytes -= entry->bytes;
+      cache_stats.count--;
+      cache_stats.evicted++;
+
+      menu_thumbnail_cache_entry_free(entry);
+   }
+}
+
+/* Takes ownership of @img on success. */
+static menu_thumbnail_cache_entry_t *menu_thumbnail_cache_insert(
+      const char *path, uint32_t hash, struct texture_image *img)
+{
+   menu_thumbnail_cache_entry_t *entry = NULL;
+   size_t bytes = (size_t)img->width * img->height * sizeof(uint32_t);
+
+   if (!img->pixels || bytes > MENU_THUMBNAIL_CACHE_SIZE)
+      return NULL;
+
+   entry = (menu_thumbnail_cache_entry_t*)calloc(1, sizeof(*entry));
+   if (!entry)
+      return NULL;
+
+   entry->path  = strdup(path);
+   entry->hash  = hash;
+   entry->bytes = bytes;
+   entry->image = *img;
+
+   if (!entry->path)
+   {
+      free(entry);
+      return NULL;
+   }
+
+   menu_thumbnail_cache_evict(bytes);
+   menu_thumbnail_cache_link_head(entry);
+
+   cache_stats.bytes += bytes;
+   cache_stats.count++;
+
+   return entry;
+}
+
+static void menu_thumbnail_cache_unlink_request(
+      menu_thumbnail_cache_request_t *req)
+{
+   menu_thumbnail_cache_request_t **link = &cache_requests;
+
+   for (; *link; link = &(*link)->next)
+   {
+      if (*link == req)
+      {
+         *link = req->next;
+         break;
+      }
+   }
+}
+
+/* Drops the waiter of a request without telling it, as its
+ * callback would otherwise upload a stale image. */
+static void menu_thumbnail_cache_drop_waiter(
+      menu_thumbnail_cache_request_t *req)
+{
+   if (req->user_data)
+      free(req->user_data);
+   req->cb        = NULL;
+   req->user_data = NULL;
+}
+
+static void menu_thumbnail_cache_cancel(
+      menu_thumbnail_cache_request_t *req)
+{
+   if (req->cancelled)
+      return;
+
+   req->cancelled = true;
+   cache_stats.cancelled++;
+
+   /* The task stays alive until this request's callback runs,
+    * which is also where the request is unlinked. */
+   task_queue_cancel_task(req->task);
+}
+
+static bool menu_thumbnail_cache_is_missing(uint32_t hash)
+{
+   unsigned i;
+   unsigned count = MIN(cache_missing_count, MENU_THUMBNAIL_CACHE_MISSING);
+
+   for (i = 0; i < count; i++)
+      if (cache_missing[i] == hash)
+         return true;
+   return false;
+}
+
+static void menu_thumbnail_cache_task_cb(void *task_data,
+      void *user_data, const char *err)
+{
+   struct texture_image           *img = (struct texture_image*)task_data;
+   menu_thumbnail_cache_request_t *req =
+      (menu_thumbnail_cache_request_t*)user_data;
+   menu_thumbnail_cache_entry_t *entry = NULL;
+
+   menu_thumbnail_cache_unlink_request(req);
+
+   if (!img && !req->cancelled)
+      cache_missing[cache_missing_count++
+         % MENU_THUMBNAIL_CACHE_MISSING] = req->hash;
+
+   if (img)
+   {
+      if (!req->cancelled)
+         entry = menu_thumbnail_cache_insert(req->path, req->hash, img);
+
+      if (entry)
+      {
+         free(img);
+         img = &entry->image;
+      }
+   }
+
+   if (req->cb)
+      req->cb(img, req->user_data, err);
+
+   if (img && !entry)
+   {
+      image_texture_free(img);
+      free(img);
+   }
+
+   free(req->path);
+   free(req);
+}
+
+static menu_thumbnail_cache_request_t *menu_thumbnail_cache_push(
+      const char *path, uint32_t hash,
+      retro_task_callback_t cb, void *user_data)
+{
+   menu_thumbnail_cache_request_t *req =
+      (menu_thumbnail_cache_request_t*)calloc(1, sizeof(*req));
+
+   if (!req)
+      return NULL;
+
+   req->path       = strdup(path);
+   req->hash       = hash;
+   req->generation = cache_generation;
+   req->cb         = cb;
+   req->user_data  = user_data;
+
+   if (!req->path)
+      goto error;
+
+   req->task = task_push_image_load_cancellable(path,
+         menu_thumbnail_cache_task_cb, req);
+   if (!req->task)
+      goto error;
+
+   req->next      = cache_requests;
+   cache_requests = req;
+
+   return req;
+
+error:
+   if (req->path)
+      free(req->path);
+   free(req);
+   return NULL;
+}
+
+bool menu_thumbnail_cache_load(const char *path,
+      retro_task_callback_t cb, void *user_data)
+{
+   uint32_t hash;
+   menu_thumbnail_cache_entry_t   *entry = NULL;
+   menu_thumbnail_cache_request_t *req   = NULL;
+
+   if (string_is_empty(path) || !cb)
+      return false;
+
+   /* Whatever was asked for last through this callback wins. */
+   for (req = cache_requests; req; req = req->next)
+      if (req->cb == cb)
+         menu_thumbnail_cache_drop_waiter(req);
+
+   hash  = msg_hash_calculate(path);
+   entry = menu_thumbnail_cache_find(path, hash);
+
+   if (entry)
+   {
+      cache_stats.hits++;
+
+      menu_thumbnail_cache_unlink(entry);
+      menu_thumbnail_cache_link_head(entry);
+
+      cb(&entry->image, user_data, NULL);
+      return true;
+   }
+
+   cache_stats.misses++;
+
+   req = menu_thumbnail_cache_find_request(path, hash);
+
+   if (req)
+   {
+      req->cb        = cb;
+      req->user_data = user_data;
+      return true;
+   }
+
+   return menu_thumbnail_cache_push(path, hash, cb, user_data) != NULL;
+}
+
+void menu_thumbnail_cache_prefetch(const char **paths, size_t count)
+{
+   size_t i;
+   menu_thumbnail_cache_request_t *req = NULL;
+
+   cache_generation++;
+
+   for (i = 0; i < count; i++)
+   {
+      uint32_t hash;
+
+      if (string_is_empty(paths[i]))
+         continue;
+
+      hash = msg_hash_calculate(paths[i]);
+
+      if (     menu_thumbnail_cache_find(paths[i], hash)
+            || menu_thumbnail_cache_is_missing(hash))
+         continue;
+
+      req = menu_thumbnail_cache_find_request(paths[i], hash);
+
+      if (req)
+         req->generation = cache_generation;
+      else if (menu_thumbnail_cache_push(paths[i], hash, NULL, NULL))
+         cache_stats.prefetched++;
+   }
+
+   /* Whatever scrolled out of range is not worth decoding anymore,
+    * unless something is waiting on it. */
+   for (req = cache_requests; req; req = req->next)
+      if (!req->cb && req->generation != cache_generation)
+         menu_thumbnail_cache_cancel(req);
+}
+
+void menu_thumbnail_cache_get_stats(menu_thumbnail_cache_stats_t *stats)
+{
+   if (stats)
+      *stats = cache_stats;
+}
+
+void menu_thumbnail_cache_deinit(void)
+{
+   menu_thumbnail_cache_request_t *req = NULL;
+   unsigned lookups = cache_stats.hits + cache_stats.misses;
+
+   if (lookups)
+      RARCH_LOG("[thumbnail cache] %u/%u hits (%.1f%%), %u prefetched, "
+            "%u cancelled, %u evicted.\n",
+            cache_stats.hits, lookups,
+            100.0 * cache_stats.hits / lookups,
+            cache_stats.prefetched, cache_stats.cancelled,
+            cache_stats.evicted);
+
+   /* Requests are freed by their callbacks, if the task queue
+    * ever gets to them. The queue itself may already be gone on
+    * shutdown, so the tasks are left to finish on their own. */
+   for (req = cache_requests; req; req = req->next)
+   {
+      menu_thumbnail_cache_drop_waiter(req);
+      req->cancelled = true;
+   }
+
+   while (cache_head)
+   {
+      menu_thumbnail_cache_entry_t *entry = cache_head;
+      menu_thumbnail_cache_unlink(entry);
+      menu_thumbnail_cache_entry_free(entry);
+   }
+
+   memset(&cache_stats, 0, sizeof(cache_stats));
+   cache_missing_count = 0;
+}
@@ -0,0 +1,90 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MENU_THUMBNAIL_CACHE_H
+#define _MENU_THUMBNAIL_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+#include <queues/task_queue.h>
+
+RETRO_BEGIN_DECLS
+
+/* Upper bound on the decoded pixels kept around, in bytes. */
+#ifndef MENU_THUMBNAIL_CACHE_SIZE
+#define MENU_THUMBNAIL_CACHE_SIZE (32 * 1024 * 1024)
+#endif
+
+/* Number of entries on each side of the selection to prefetch. */
+#ifndef MENU_THUMBNAIL_PREFETCH_RADIUS
+#define MENU_THUMBNAIL_PREFETCH_RADIUS 4
+#endif
+
+/* Number of paths remembered as failing to prefetch. */
+#ifndef MENU_THUMBNAIL_CACHE_MISSING
+#define MENU_THUMBNAIL_CACHE_MISSING 64
+#endif
+
+typedef struct menu_thumbnail_cache_stats
+{
+   unsigned hits;
+   unsigned misses;
+   unsigned prefetched;
+   unsigned cancelled;
+   unsigned evicted;
+   size_t   bytes;
+   size_t   count;
+} menu_thumbnail_cache_stats_t;
+
+/**
+ * menu_thumbnail_cache_load:
+ * @path                     : Path to the image.
+ * @cb                       : Upload callback.
+ * @user_data                : Passed to @cb, which frees it.
+ *
+ * Hands the decoded image at @path to @cb, either right away
+ * if it is cached or once the image task finishes. The
+ * texture_image passed to @cb is owned by the cache and must
+ * not be freed. A later load with the same @cb supersedes any
+ * earlier one still waiting.
+ *
+ * Returns: true if @cb was called or will be called.
+ **/
+bool menu_thumbnail_cache_load(const char *path,
+      retro_task_callback_t cb, void *user_data);
+
+/**
+ * menu_thumbnail_cache_prefetch:
+ * @paths                    : Paths to decode, most wanted first.
+ * @count                    : Number of paths.
+ *
+ * Queues background decodes for @paths that are neither cached
+ * nor already being decoded, and cancels earlier prefetches no
+ * longer in the set. Paths need not exist; the check is left to
+ * the decode task, and recent failures are not queued again.
+ **/
+void menu_thumbnail_cache_prefetch(const char **paths, size_t count);
+
+void menu_thumbnail_cache_get_stats(menu_thumbnail_cache_stats_t *stats);
+
+/* Cancels outstanding decodes and frees every cached image. */
+void menu_thumbnail_cache_deinit(void);
+
+RETRO_END_DECLS
+
+#endif
@@ -157,13 +157,17 @@ void filebrowser_parse(void *data, unsigned type_data)
    }
    else
    {
+      /* One more for the parent directory entry prepended below. */
+      file_list_reserve(info->list, info->list->size + list_size + 1);
+
       for (i = 0; i < list_size; i++)
       {
          char label[64];
-         bool is_dir                   = false;
-         enum msg_hash_enums enum_idx  = MSG_UNKNOWN;
-         enum msg_file_type file_type  = FILE_TYPE_NONE;
-         const char *path              = str_list->elems[i].data;
+         bool is_dir                        = false;
+         enum rarch_content_type media_type = RARCH_CONTENT_NONE;
+         enum msg_hash_enums enum_idx       = MSG_UNKNOWN;
+         enum msg_file_type file_type       = FILE_TYPE_NONE;
+         const char *path                   = str_list->elems[i].data;
 
          label[0] = '\0';
 
@@ -222,13 +226,16 @@ void filebrowser_parse(void *data, unsigned type_data)
                file_type = FILE_TYPE_PLAYLIST_COLLECTION;
          }
 
-         if (!is_dir && path_is_media_type(path) == RARCH_CONTENT_MUSIC)
+         if (!is_dir)
+            media_type = path_is_media_type(path);
+
+         if (media_type == RARCH_CONTENT_MUSIC)
             file_type = FILE_TYPE_MUSIC;
          else if (!is_dir &&
                (settings->bools.multimedia_builtin_mediaplayer_enable ||
                 settings->bools.multimedia_builtin_imageviewer_enable))
          {
-            switch (path_is_media_type(path))
+            switch (media_type)
             {
                case RARCH_CONTENT_MOVIE:
 #ifdef HAVE_FFMPEG
@@ -285,7 +292,7 @@ void filebrowser_parse(void *data, unsigned type_data)
          }
 
          items_found++;
-         menu_entries_append_enum(info->list, path, label,
+         menu_entries_append_deferred(info->list, path, label,
                enum_idx,
                file_type, 0, 0);
       }
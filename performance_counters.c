@@ -15,6 +15,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef _WIN32
@@ -24,6 +25,10 @@
 #endif
 
 #include <compat/strl.h>
+#include <retro_miscellaneous.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
 
 #include "performance_counters.h"
 
@@ -36,6 +41,47 @@
 #define PERF_LOG_FMT "[PERF]: Avg (%s): %llu ticks, %llu runs.\n"
 #endif
 
+/* Number of most recent frames kept by the frame telemetry. */
+#define FRAME_TELEMETRY_MAX_FRAMES 8192
+
+/* Gaps between frames longer than this (menu, pause, loading)
+ * are not counted as frame pacing samples. */
+#define FRAME_TELEMETRY_MAX_INTERVAL 1000000
+
+struct frame_telemetry_span
+{
+   retro_time_t start;
+   retro_time_t duration;
+   unsigned count;
+};
+
+struct frame_telemetry_frame
+{
+   retro_time_t start;
+   retro_time_t duration;
+   struct frame_telemetry_span events[FRAME_TELEMETRY_EVENT_LAST];
+};
+
+typedef struct frame_telemetry
+{
+   struct frame_telemetry_frame *frames;
+   struct frame_telemetry_frame *current;
+   retro_time_t event_start[FRAME_TELEMETRY_EVENT_LAST];
+   retro_time_t frame_time_target;
+   uint64_t frame_count;
+   char path[PATH_MAX_LENGTH];
+} frame_telemetry_t;
+
+static const char *frame_telemetry_event_names[FRAME_TELEMETRY_EVENT_LAST] = {
+   "input_poll",
+   "core_run",
+   "video_submit",
+   "swap",
+   "audio_write"
+};
+
+static frame_telemetry_t *frame_telemetry                = NULL;
+
 static struct retro_perf_counter *perf_counters_rarch[MAX_COUNTERS];
 static struct retro_perf_counter *perf_counters_libretro[MAX_COUNTERS];
 static unsigned perf_ptr_rarch;
@@ -173,3 +219,296 @@ void rarch_timer_begin(rarch_timer_t *timer, uint64_t sec)
    timer->timer_begin = true;
    timer->timer_end   = false;
 }
+
+bool frame_telemetry_init(const char *path, double fps)
+{
+   frame_telemetry_t *telemetry = NULL;
+
+   frame_telemetry_deinit();
+
+   if (string_is_empty(path))
+      return false;
+
+   telemetry = (frame_telemetry_t*)calloc(1, sizeof(*telemetry));
+
+   if (!telemetry)
+      return false;
+
+   telemetry->frames = (struct frame_telemetry_frame*)
+      calloc(FRAME_TELEMETRY_MAX_FRAMES, sizeof(*telemetry->frames));
+
+   if (!telemetry->frames)
+   {
+      free(telemetry);
+      return false;
+   }
+
+   telemetry->frame_time_target = (retro_time_t)
+      (1000000.0 / (fps > 0.0 ? fps : 60.0));
+   strlcpy(telemetry->path, path, sizeof(telemetry->path));
+
+   frame_telemetry = telemetry;
+
+   RARCH_LOG("[PERF]: Recording frame telemetry to \"%s\".\n", path);
+   return true;
+}
+
+bool frame_telemetry_is_enabled(void)
+{
+   return frame_telemetry != NULL;
+}
+
+void frame_telemetry_frame_begin(void)
+{
+   frame_telemetry_t *telemetry = frame_telemetry;
+   struct frame_telemetry_frame *frame = NULL;
+
+   if (!telemetry)
+      return;
+
+   frame = &telemetry->frames[
+      telemetry->frame_count % FRAME_TELEMETRY_MAX_FRAMES];
+
+   memset(frame, 0, sizeof(*frame));
+   frame->start       = cpu_features_get_time_usec();
+   telemetry->current = frame;
+   telemetry->frame_count++;
+}
+
+void frame_telemetry_frame_end(void)
+{
+   frame_telemetry_t *telemetry = frame_telemetry;
+
+   if (!telemetry || !telemetry->current)
+      return;
+
+   telemetry->current->duration = cpu_features_get_time_usec()
+      - telemetry->current->start;
+   telemetry->current           = NULL;
+}
+
+void frame_telemetry_event_begin(enum frame_telemetry_event event)
+{
+   frame_telemetry_t *telemetry = frame_telemetry;
+
+   if (!telemetry || !telemetry->current)
+      return;
+
+   telemetry->event_start[event] = cpu_features_get_time_usec();
+}
+
+/* Events outside of a frame (menu, loading) are ignored.
+ * An event happening several times in one frame keeps its
+ * first start time and accumulates the durations. */
+void frame_telemetry_event_end(enum frame_telemetry_event event)
+{
+   struct frame_telemetry_span *span = NULL;
+   frame_telemetry_t *telemetry      = frame_telemetry;
+
+   if (!telemetry || !telemetry->current
+         || !telemetry->event_start[event])
+      return;
+
+   span = &telemetry->current->events[event];
+
+   if (!span->count++)
+      span->start    = telemetry->event_start[event];
+   span->duration   += cpu_features_get_time_usec()
+      - telemetry->event_start[event];
+
+   telemetry->event_start[event] = 0;
+}
+
+static int frame_telemetry_time_cmp(const void *a, const void *b)
+{
+   retro_time_t x = *(const retro_time_t*)a;
+   retro_time_t y = *(const retro_time_t*)b;
+   return (x > y) - (x < y);
+}
+
+static void frame_telemetry_log_samples(const char *name,
+      retro_time_t *samples, unsigned count)
+{
+   unsigned i;
+   retro_time_t total = 0;
+
+   if (!count)
+      return;
+
+   qsort(samples, count, sizeof(*samples), frame_telemetry_time_cmp);
+
+   for (i = 0; i < count; i++)
+      total += samples[i];
+
+   RARCH_LOG("[PERF]: %-14s avg %7.3f ms, p50 %7.3f ms, "
+         "p99 %7.3f ms, max %7.3f ms (%u samples).\n",
+         name,
+         total / (1000.0 * count),
+         samples[count / 2] / 1000.0,
+         samples[(uint64_t)count * 99 / 100] / 1000.0,
+         samples[count - 1] / 1000.0,
+         count);
+}
+
+static void frame_telemetry_log(frame_telemetry_t *telemetry,
+      uint64_t first, unsigned count)
+{
+   unsigned i, j, num;
+   unsigned late         = 0;
+   retro_time_t *samples = (retro_time_t*)
+      malloc(count * sizeof(*samples));
+
+   if (!samples)
+      return;
+
+   RARCH_LOG("[PERF]: Frame telemetry over the last %u frames:\n", count);
+
+   /* Frame pacing, a frame is late if it took longer
+    * than one and a half frame periods to start. */
+   for (i = 1, num = 0; i < count; i++)
+   {
+      retro_time_t interval = telemetry->frames[
+         (first + i) % FRAME_TELEMETRY_MAX_FRAMES].start
+         - telemetry->frames[
+         (first + i - 1) % FRAME_TELEMETRY_MAX_FRAMES].start;
+
+      if (interval > FRAME_TELEMETRY_MAX_INTERVAL)
+         continue;
+
+      if (interval * 2 > telemetry->frame_time_target * 3)
+         late++;
+      samples[num++] = interval;
+   }
+
+   frame_telemetry_log_samples("frame_interval", samples, num);
+
+   for (j = 0; j < FRAME_TELEMETRY_EVENT_LAST; j++)
+   {
+      for (i = 0, num = 0; i < count; i++)
+      {
+         const struct frame_telemetry_span *span = &telemetry->frames[
+            (first + i) % FRAME_TELEMETRY_MAX_FRAMES].events[j];
+
+         if (span->count)
+            samples[num++] = span->duration;
+      }
+
+      frame_telemetry_log_samples(frame_telemetry_event_names[j],
+            samples, num);
+   }
+
+   RARCH_LOG("[PERF]: %u late frames (target frame time %.3f ms).\n",
+         late, telemetry->frame_time_target / 1000.0);
+
+   free(samples);
+}
+
+static bool frame_telemetry_export(frame_telemetry_t *telemetry,
+      uint64_t first, unsigned count)
+{
+   unsigned i, j;
+   const char *ext  = path_get_extension(telemetry->path);
+   bool csv         = string_is_equal_noncase(ext, "csv");
+   RFILE *file      = filestream_open(telemetry->path,
+         RETRO_VFS_FILE_ACCESS_WRITE,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+      return false;
+
+   if (csv)
+   {
+      filestream_printf(file, "frame,start_us,duration_us");
+      for (j = 0; j < FRAME_TELEMETRY_EVENT_LAST; j++)
+         filestream_printf(file, ",%s_start_us,%s_us",
+               frame_telemetry_event_names[j],
+               frame_telemetry_event_names[j]);
+      filestream_printf(file, "\n");
+   }
+   else
+      filestream_printf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+   for (i = 0; i < count; i++)
+   {
+      const struct frame_telemetry_frame *frame = &telemetry->frames[
+         (first + i) % FRAME_TELEMETRY_MAX_FRAMES];
+
+      /* Event start times are relative to the start of their frame. */
+      if (csv)
+      {
+         filestream_printf(file, "%u,%lld,%lld", (unsigned)(first + i),
+               (long long)frame->start, (long long)frame->duration);
+
+         for (j = 0; j < FRAME_TELEMETRY_EVENT_LAST; j++)
+         {
+            if (frame->events[j].count)
+               filestream_printf(file, ",%lld,%lld",
+                     (long long)(frame->events[j].start - frame->start),
+                     (long long)frame->events[j].duration);
+            else
+               filestream_printf(file, ",,");
+         }
+
+         filestream_printf(file, "\n");
+         continue;
+      }
+
+      filestream_printf(file,
+            "%s\n{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+            "\"ts\":%lld,\"dur\":%lld,\"args\":{\"frame\":%u}}",
+            i ? "," : "", (long long)frame->start,
+            (long long)frame->duration, (unsigned)(first + i));
+
+      for (j = 0; j < FRAME_TELEMETRY_EVENT_LAST; j++)
+      {
+         if (!frame->events[j].count)
+            continue;
+
+         filestream_printf(file,
+               ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+               "\"ts\":%lld,\"dur\":%lld,\"args\":{\"count\":%u}}",
+               frame_telemetry_event_names[j],
+               (long long)frame->events[j].start,
+               (long long)frame->events[j].duration,
+               frame->events[j].count);
+      }
+   }
+
+   if (!csv)
+      filestream_printf(file, "\n]}\n");
+
+   filestream_close(file);
+   return true;
+}
+
+void frame_telemetry_deinit(void)
+{
+   uint64_t first;
+   unsigned count;
+   frame_telemetry_t *telemetry = frame_telemetry;
+
+   if (!telemetry)
+      return;
+
+   frame_telemetry = NULL;
+
+   /* The frame in progress, if any, is incomplete. */
+   if (telemetry->current)
+      telemetry->frame_count--;
+
+   count = telemetry->frame_count < FRAME_TELEMETRY_MAX_FRAMES
+      ? (unsigned)telemetry->frame_count : FRAME_TELEMETRY_MAX_FRAMES;
+   first = telemetry->frame_count - count;
+
+   if (count)
+   {
+      frame_telemetry_log(telemetry, first, count);
+
+      if (!frame_telemetry_export(telemetry, first, count))
+         RARCH_ERR("[PERF]: Failed to write frame telemetry to \"%s\".\n",
+               telemetry->path);
+   }
+
+   free(telemetry->frames);
+   free(telemetry);
+}
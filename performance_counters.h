@@ -89,6 +89,47 @@ void rarch_perf_register(struct retro_perf_counter *perf);
  **/
 #define performance_counter_stop_plus(is_perfcnt_enable, perf) performance_counter_stop_internal(is_perfcnt_enable, perf)
 
+enum frame_telemetry_event
+{
+   FRAME_TELEMETRY_INPUT_POLL = 0,
+   FRAME_TELEMETRY_CORE_RUN,
+   FRAME_TELEMETRY_VIDEO_SUBMIT,
+   FRAME_TELEMETRY_SWAP,
+   FRAME_TELEMETRY_AUDIO_WRITE,
+   FRAME_TELEMETRY_EVENT_LAST
+};
+
+/**
+ * frame_telemetry_init:
+ * @path               : file to export the samples to when telemetry
+ *                       is stopped. Ending in .csv selects CSV,
+ *                       anything else the Chrome trace event format.
+ * @fps                : expected frame rate, used to count late frames.
+ *
+ * Starts recording per-frame timestamps. Does nothing if @path is empty.
+ *
+ * Returns: true (1) if telemetry is being recorded, otherwise false (0).
+ **/
+bool frame_telemetry_init(const char *path, double fps);
+
+/**
+ * frame_telemetry_deinit:
+ *
+ * Logs pacing statistics, exports the recorded frames and stops
+ * recording.
+ **/
+void frame_telemetry_deinit(void);
+
+bool frame_telemetry_is_enabled(void);
+
+void frame_telemetry_frame_begin(void);
+
+void frame_telemetry_frame_end(void);
+
+void frame_telemetry_event_begin(enum frame_telemetry_event event);
+
+void frame_telemetry_event_end(enum frame_telemetry_event event);
+
 void rarch_timer_tick(rarch_timer_t *timer);
 
 bool rarch_timer_is_running(rarch_timer_t *timer);
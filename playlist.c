@@ -17,9 +17,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 
 #include <libretro.h>
 #include <boolean.h>
+#include <retro_inline.h>
+#include <features/features_cpu.h>
 #include <compat/posix_string.h>
 #include <string/stdstring.h>
 #include <streams/interface_stream.h>
@@ -33,6 +36,38 @@
 #define PLAYLIST_ENTRIES 6
 #endif
 
+/* Entries allocated up front; storage then doubles
+ * as the playlist fills, up to its capacity. */
+#ifndef PLAYLIST_INITIAL_SIZE
+#define PLAYLIST_INITIAL_SIZE 64
+#endif
+
+/* Binary playlist file:
+ *
+ * header   : magic, version, entry count, string table size,
+ *            generation (changed by every full write)
+ * records  : one per entry, oldest first; six string table offsets
+ *            (+ 1, 0 for none) then the path and CRC hashes
+ * strings  : NUL terminated, shared between entries
+ * journal  : pushes and deletes appended since the file was written,
+ *            each a record size, an opcode and its arguments
+ *
+ * All integers are 32-bit little endian. The hashes are those of
+ * playlist_hash, so changing it requires a new version. */
+#define PLAYLIST_BINARY_MAGIC       "RPLB"
+#define PLAYLIST_BINARY_VERSION     2
+#define PLAYLIST_BINARY_HEADER_SIZE 20
+#define PLAYLIST_BINARY_RECORD_SIZE 32
+
+#define PLAYLIST_JOURNAL_PUSH       1
+#define PLAYLIST_JOURNAL_DELETE     2
+
+/* Journal records allowed in a file before it is written out
+ * in full again, on top of a quarter of the entry count. */
+#ifndef PLAYLIST_JOURNAL_MAX
+#define PLAYLIST_JOURNAL_MAX 256
+#endif
+
 struct playlist_entry
 {
    char *path;
@@ -41,23 +76,292 @@ struct playlist_entry
    char *core_name;
    char *db_name;
    char *crc32;
+   uint32_t path_hash;
+   uint32_t crc32_hash;
+};
+
+/* Open addressed hash of entry slots with linear probing.
+ * Buckets hold slot + 1, so that 0 marks an empty bucket. */
+struct playlist_index
+{
+   uint32_t *buckets;
+   size_t mask;
 };
 
 struct content_playlist
 {
    bool modified;
+   bool index_dirty;
+   /* The file holds every change but the pending journal records,
+    * so those can be appended instead of writing the whole file. */
+   bool journal_valid;
+   bool replaying;
+   /* Generation and size of the file as last read or written here.
+    * Deletes are journaled by index, so the journal is only appended
+    * to a file that still matches them. */
+   uint32_t generation;
+   int64_t disk_size;
    size_t size;
    size_t cap;
+   size_t alloc;
 
    char *conf_path;
+
+   /* Contents of a binary file; strings of entries loaded from it
+    * point in here until they are replaced. */
+   char *file_data;
+   size_t file_size;
+
+   uint8_t *journal;
+   size_t journal_size;
+   size_t journal_cap;
+   size_t journal_records;
+
+   /* Stored oldest first so that pushing to the top is an append;
+    * index 0 of the playlist is the last slot. */
    struct playlist_entry *entries;
+   struct playlist_index path_index;
+   struct playlist_index crc32_index;
 };
 static playlist_t *playlist_cached = NULL;
+static bool playlist_binary_format = false;
+
+#define PLAYLIST_SLOT(playlist, idx) ((playlist)->size - 1 - (idx))
 
 typedef int (playlist_sort_fun_t)(
       const struct playlist_entry *a,
       const struct playlist_entry *b);
 
+static uint32_t playlist_hash(const char *s)
+{
+   uint32_t hash = 5381;
+
+   if (!s)
+      return hash;
+
+   /* Case is folded on every platform, so that hashes stay
+    * valid for the case-insensitive matching done on Windows. */
+   for (; *s; s++)
+      hash = (hash << 5) + hash + (uint32_t)tolower((unsigned char)*s);
+
+   return hash;
+}
+
+static INLINE bool playlist_key_equal(const char *a, const char *b,
+      bool noncase)
+{
+   if (!a || !b)
+      return !a && !b;
+#ifdef _WIN32
+   if (noncase)
+      return string_is_equal_noncase(a, b);
+#endif
+   return string_is_equal(a, b);
+}
+
+static void playlist_entry_rehash(struct playlist_entry *entry)
+{
+   entry->path_hash  = playlist_hash(entry->path);
+   entry->crc32_hash = playlist_hash(entry->crc32);
+}
+
+static void playlist_index_insert(struct playlist_index *index,
+      uint32_t hash, size_t slot)
+{
+   size_t i = hash & index->mask;
+
+   while (index->buckets[i])
+      i = (i + 1) & index->mask;
+
+   index->buckets[i] = (uint32_t)(slot + 1);
+}
+
+static bool playlist_index_reset(struct playlist_index *index,
+      size_t buckets)
+{
+   if (index->buckets && index->mask + 1 == buckets)
+   {
+      memset(index->buckets, 0, buckets * sizeof(*index->buckets));
+      return true;
+   }
+
+   free(index->buckets);
+   index->mask    = 0;
+   index->buckets = (uint32_t*)calloc(buckets, sizeof(*index->buckets));
+
+   if (!index->buckets)
+      return false;
+
+   index->mask    = buckets - 1;
+   return true;
+}
+
+/* Rebuilds both hash indexes after entries were moved around.
+ * Buckets are sized for the allocated entries, so appends stay
+ * below half load without a rebuild until storage grows again. */
+static bool playlist_index_build(playlist_t *playlist)
+{
+   size_t i;
+   size_t buckets = 64;
+
+   while (buckets < playlist->alloc * 2)
+      buckets <<= 1;
+
+   if (     !playlist_index_reset(&playlist->path_index, buckets)
+         || !playlist_index_reset(&playlist->crc32_index, buckets))
+      return false;
+
+   for (i = 0; i < playlist->size; i++)
+   {
+      const struct playlist_entry *entry = &playlist->entries[i];
+
+      playlist_index_insert(&playlist->path_index, entry->path_hash, i);
+      if (entry->crc32)
+         playlist_index_insert(&playlist->crc32_index,
+               entry->crc32_hash, i);
+   }
+
+   playlist->index_dirty = false;
+   return true;
+}
+
+static void playlist_index_add(playlist_t *playlist, size_t slot)
+{
+   const struct playlist_entry *entry = &playlist->entries[slot];
+
+   if (playlist->index_dirty)
+      return;
+
+   playlist_index_insert(&playlist->path_index, entry->path_hash, slot);
+   if (entry->crc32)
+      playlist_index_insert(&playlist->crc32_index,
+            entry->crc32_hash, slot);
+}
+
+/* Renumbers the buckets of @index after the entry in @slot was
+ * moved to the top and the entries above it shifted down by one.
+ * Keys do not change, so no bucket has to move. */
+static void playlist_index_bump(struct playlist_index *index,
+      size_t slot, size_t top)
+{
+   size_t i;
+   uint32_t moved = (uint32_t)(slot + 1);
+   uint32_t to    = (uint32_t)(top + 1);
+
+   /* Branchless, so that it vectorizes; empty buckets stay 0. */
+   for (i = 0; i <= index->mask; i++)
+   {
+      uint32_t bucket   = index->buckets[i];
+      index->buckets[i] = (bucket == moved)
+         ? to : bucket - (bucket > moved);
+   }
+}
+
+/**
+ * playlist_find:
+ * @playlist            : Playlist handle.
+ * @by_crc32            : Match @key against the CRC field, not the path.
+ * @key                 : Path or CRC to look up.
+ * @core_path           : If not NULL, core path the entry must also have.
+ * @noncase             : Compare paths without case on Windows.
+ * @slot                : Storage slot of the match.
+ *
+ * Looks up the most recently pushed entry matching @key.
+ *
+ * Returns: true if a matching entry was found.
+ **/
+static bool playlist_find(playlist_t *playlist, bool by_crc32,
+      const char *key, const char *core_path, bool noncase,
+      size_t *slot)
+{
+   size_t i;
+   size_t best                  = 0;
+   bool found                   = false;
+   uint32_t hash                = playlist_hash(key);
+   struct playlist_index *index = by_crc32
+      ? &playlist->crc32_index : &playlist->path_index;
+   bool indexed                 = !playlist->index_dirty
+      || playlist_index_build(playlist);
+   size_t pos                   = indexed ? (hash & index->mask) : 0;
+
+   /* Without an index (out of memory), fall back to a linear scan. */
+   for (;;)
+   {
+      const struct playlist_entry *entry = NULL;
+
+      if (indexed)
+      {
+         if (!index->buckets[pos])
+            break;
+         i   = index->buckets[pos] - 1;
+         pos = (pos + 1) & index->mask;
+      }
+      else
+      {
+         if (pos >= playlist->size)
+            break;
+         i   = pos++;
+      }
+
+      entry = &playlist->entries[i];
+
+      if ((by_crc32 ? entry->crc32_hash : entry->path_hash) != hash)
+         continue;
+      if (!playlist_key_equal(key,
+               by_crc32 ? entry->crc32 : entry->path, noncase))
+         continue;
+      if (core_path && !string_is_equal(entry->core_path, core_path))
+         continue;
+
+      if (!found || i > best)
+         best = i;
+      found = true;
+   }
+
+   *slot = best;
+   return found;
+}
+
+/* Makes room for one more entry, doubling storage up to
+ * the playlist capacity. */
+static bool playlist_reserve(playlist_t *playlist)
+{
+   size_t alloc                   = playlist->alloc;
+   struct playlist_entry *entries = NULL;
+
+   if (playlist->size < alloc)
+      return true;
+
+   alloc   = alloc ? alloc * 2 : PLAYLIST_INITIAL_SIZE;
+   if (alloc > playlist->cap)
+      alloc = playlist->cap;
+   if (alloc <= playlist->size)
+      return false;
+
+   entries = (struct playlist_entry*)realloc(playlist->entries,
+         alloc * sizeof(*entries));
+   if (!entries)
+      return false;
+
+   playlist->entries     = entries;
+   playlist->alloc       = alloc;
+   playlist->index_dirty = true;
+   return true;
+}
+
+static void playlist_free_string(playlist_t *playlist, char *s)
+{
+   /* Strings inside the file contents are not allocated. */
+   if (s && !(s >= playlist->file_data
+            && s < playlist->file_data + playlist->file_size))
+      free(s);
+}
+
+void playlist_set_binary_format(bool enable)
+{
+   playlist_binary_format = enable;
+}
+
 uint32_t playlist_get_size(playlist_t *playlist)
 {
    if (!playlist)
@@ -89,21 +393,131 @@ void playlist_get_index(playlist_t *playlist,
       const char **crc32,
       const char **db_name)
 {
-   if (!playlist)
+   const struct playlist_entry *entry = NULL;
+
+   if (!playlist || idx >= playlist->size)
       return;
 
+   entry = &playlist->entries[PLAYLIST_SLOT(playlist, idx)];
+
    if (path)
-      *path      = playlist->entries[idx].path;
+      *path      = entry->path;
    if (label)
-      *label     = playlist->entries[idx].label;
+      *label     = entry->label;
    if (core_path)
-      *core_path = playlist->entries[idx].core_path;
+      *core_path = entry->core_path;
    if (core_name)
-      *core_name = playlist->entries[idx].core_name;
+      *core_name = entry->core_name;
    if (db_name)
-      *db_name   = playlist->entries[idx].db_name;
+      *db_name   = entry->db_name;
    if (crc32)
-      *crc32     = playlist->entries[idx].crc32;
+      *crc32     = entry->crc32;
+}
+
+/**
+ * playlist_free_entry:
+ * @entry               : Playlist entry handle.
+ *
+ * Frees playlist entry.
+ **/
+static void playlist_free_entry(playlist_t *playlist,
+      struct playlist_entry *entry)
+{
+   if (!entry)
+      return;
+
+   playlist_free_string(playlist, entry->path);
+   playlist_free_string(playlist, entry->label);
+   playlist_free_string(playlist, entry->core_path);
+   playlist_free_string(playlist, entry->core_name);
+   playlist_free_string(playlist, entry->db_name);
+   playlist_free_string(playlist, entry->crc32);
+
+   entry->path      = NULL;
+   entry->label     = NULL;
+   entry->core_path = NULL;
+   entry->core_name = NULL;
+   entry->db_name   = NULL;
+   entry->crc32     = NULL;
+}
+
+/* Removes the entry in @slot, keeping the order of the others. */
+static void playlist_remove_slot(playlist_t *playlist, size_t slot)
+{
+   playlist_free_entry(playlist, &playlist->entries[slot]);
+
+   memmove(playlist->entries + slot, playlist->entries + slot + 1,
+         (playlist->size - slot - 1) * sizeof(struct playlist_entry));
+
+   playlist->size--;
+   playlist->index_dirty = true;
+}
+
+static void playlist_write_le32(uint8_t *out, uint32_t val)
+{
+   out[0] = (uint8_t)(val);
+   out[1] = (uint8_t)(val >> 8);
+   out[2] = (uint8_t)(val >> 16);
+   out[3] = (uint8_t)(val >> 24);
+}
+
+static uint32_t playlist_read_le32(const uint8_t *in)
+{
+   return (uint32_t)in[0]       | ((uint32_t)in[1] << 8)
+      | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+/* Queues a journal record for the next playlist_write_file. */
+static void playlist_journal_add(playlist_t *playlist, uint8_t op,
+      const char **strings, unsigned count, uint32_t arg)
+{
+   unsigned i;
+   size_t size = 1 + (strings ? 0 : 4);
+   uint8_t *out;
+
+   if (!playlist->journal_valid || playlist->replaying)
+      return;
+
+   for (i = 0; i < count; i++)
+      size += (strings[i] ? strlen(strings[i]) : 0) + 1;
+
+   if (playlist->journal_size + 4 + size > playlist->journal_cap)
+   {
+      size_t cap       = (playlist->journal_cap + 4 + size) * 2;
+      uint8_t *journal = (uint8_t*)realloc(playlist->journal, cap);
+
+      if (!journal)
+      {
+         playlist->journal_valid = false;
+         return;
+      }
+
+      playlist->journal     = journal;
+      playlist->journal_cap = cap;
+   }
+
+   out = playlist->journal + playlist->journal_size;
+   playlist_write_le32(out, (uint32_t)size);
+   out[4] = op;
+   out   += 5;
+
+   if (!strings)
+   {
+      playlist_write_le32(out, arg);
+      out += 4;
+   }
+
+   for (i = 0; i < count; i++)
+   {
+      size_t len = strings[i] ? strlen(strings[i]) : 0;
+      if (len)
+         memcpy(out, strings[i], len);
+      out[len]   = '\0';
+      out       += len + 1;
+   }
+
+   playlist->journal_size += 4 + size;
+   playlist->journal_records++;
 }
 
 /**
@@ -116,13 +530,12 @@ void playlist_get_index(playlist_t *playlist,
 void playlist_delete_index(playlist_t *playlist,
       size_t idx)
 {
-   if (!playlist)
+   if (!playlist || idx >= playlist->size)
       return;
 
-   memmove(playlist->entries + idx, playlist->entries + idx + 1,
-         (playlist->size - idx) * sizeof(struct playlist_entry));
-
-   playlist->size     = playlist->size - 1;
+   playlist_remove_slot(playlist, PLAYLIST_SLOT(playlist, idx));
+   playlist_journal_add(playlist, PLAYLIST_JOURNAL_DELETE,
+         NULL, 0, (uint32_t)idx);
    playlist->modified = true;
 }
 
@@ -133,76 +546,67 @@ void playlist_get_index_by_path(playlist_t *playlist,
       char **crc32,
       char **db_name)
 {
-   size_t i;
-   if (!playlist)
+   size_t slot;
+   struct playlist_entry *entry = NULL;
+
+   if (!playlist || !search_path)
       return;
 
-   for (i = 0; i < playlist->size; i++)
-   {
-      if (!string_is_equal(playlist->entries[i].path, search_path))
-         continue;
+   if (!playlist_find(playlist, false, search_path, NULL, false, &slot))
+      return;
 
-      if (path)
-         *path      = playlist->entries[i].path;
-      if (label)
-         *label     = playlist->entries[i].label;
-      if (core_path)
-         *core_path = playlist->entries[i].core_path;
-      if (core_name)
-         *core_name = playlist->entries[i].core_name;
-      if (db_name)
-         *db_name   = playlist->entries[i].db_name;
-      if (crc32)
-         *crc32     = playlist->entries[i].crc32;
-      break;
-   }
+   entry = &playlist->entries[slot];
+
+   if (path)
+      *path      = entry->path;
+   if (label)
+      *label     = entry->label;
+   if (core_path)
+      *core_path = entry->core_path;
+   if (core_name)
+      *core_name = entry->core_name;
+   if (db_name)
+      *db_name   = entry->db_name;
+   if (crc32)
+      *crc32     = entry->crc32;
 }
 
 bool playlist_entry_exists(playlist_t *playlist,
       const char *path,
       const char *crc32)
 {
-   size_t i;
-   if (!playlist)
-      return false;
+   size_t slot;
 
-   for (i = 0; i < playlist->size; i++)
-      if (string_is_equal(playlist->entries[i].path, path))
-         return true;
+   if (!playlist || !path)
+      return false;
 
-   return false;
+   return playlist_find(playlist, false, path, NULL, false, &slot);
 }
 
 /**
- * playlist_free_entry:
- * @entry               : Playlist entry handle.
+ * playlist_get_index_by_crc32:
+ * @playlist            : Playlist handle.
+ * @crc32               : CRC field to look up, e.g. "0123ABCD|crc".
+ * @idx                 : Index of the matching playlist entry.
  *
- * Frees playlist entry.
+ * Looks up the most recent entry with the given CRC field.
+ *
+ * Returns: true if an entry was found.
  **/
-static void playlist_free_entry(struct playlist_entry *entry)
+bool playlist_get_index_by_crc32(playlist_t *playlist,
+      const char *crc32, size_t *idx)
 {
-   if (!entry)
-      return;
+   size_t slot;
 
-   if (entry->path != NULL)
-      free(entry->path);
-   if (entry->label != NULL)
-      free(entry->label);
-   if (entry->core_path != NULL)
-      free(entry->core_path);
-   if (entry->core_name != NULL)
-      free(entry->core_name);
-   if (entry->db_name != NULL)
-      free(entry->db_name);
-   if (entry->crc32 != NULL)
-      free(entry->crc32);
+   if (!playlist || !crc32)
+      return false;
 
-   entry->path      = NULL;
-   entry->label     = NULL;
-   entry->core_path = NULL;
-   entry->core_name = NULL;
-   entry->db_name   = NULL;
-   entry->crc32     = NULL;
+   if (!playlist_find(playlist, true, crc32, NULL, false, &slot))
+      return false;
+
+   if (idx)
+      *idx = PLAYLIST_SLOT(playlist, slot);
+   return true;
 }
 
 void playlist_update(playlist_t *playlist, size_t idx,
@@ -213,31 +617,31 @@ void playlist_update(playlist_t *playlist, size_t idx,
 {
    struct playlist_entry *entry = NULL;
 
-   if (!playlist || idx > playlist->size)
+   if (!playlist || idx >= playlist->size)
       return;
 
-   entry            = &playlist->entries[idx];
+   entry                   = &playlist->entries[PLAYLIST_SLOT(playlist, idx)];
+   /* The journal only holds pushes and deletes. */
+   playlist->journal_valid = false;
 
    if (path && (path != entry->path))
    {
-      if (entry->path != NULL)
-         free(entry->path);
-      entry->path        = strdup(path);
-      playlist->modified = true;
+      playlist_free_string(playlist, entry->path);
+      entry->path           = strdup(path);
+      playlist->modified    = true;
+      playlist->index_dirty = true;
    }
 
    if (label && (label != entry->label))
    {
-      if (entry->label != NULL)
-         free(entry->label);
+      playlist_free_string(playlist, entry->label);
       entry->label       = strdup(label);
       playlist->modified = true;
    }
 
    if (core_path && (core_path != entry->core_path))
    {
-      if (entry->core_path != NULL)
-         free(entry->core_path);
+      playlist_free_string(playlist, entry->core_path);
       entry->core_path   = NULL;
       entry->core_path   = strdup(core_path);
       playlist->modified = true;
@@ -245,27 +649,27 @@ void playlist_update(playlist_t *playlist, size_t idx,
 
    if (core_name && (core_name != entry->core_name))
    {
-      if (entry->core_name != NULL)
-         free(entry->core_name);
+      playlist_free_string(playlist, entry->core_name);
       entry->core_name   = strdup(core_name);
       playlist->modified = true;
    }
 
    if (db_name && (db_name != entry->db_name))
    {
-      if (entry->db_name != NULL)
-         free(entry->db_name);
+      playlist_free_string(playlist, entry->db_name);
       entry->db_name     = strdup(db_name);
       playlist->modified = true;
    }
 
    if (crc32 && (crc32 != entry->crc32))
    {
-      if (entry->crc32 != NULL)
-         free(entry->crc32);
-      entry->crc32       = strdup(crc32);
-      playlist->modified = true;
+      playlist_free_string(playlist, entry->crc32);
+      entry->crc32          = strdup(crc32);
+      playlist->modified    = true;
+      playlist->index_dirty = true;
    }
+
+   playlist_entry_rehash(entry);
 }
 
 /**
@@ -283,9 +687,11 @@ bool playlist_push(playlist_t *playlist,
       const char *crc32,
       const char *db_name)
 {
-   size_t i;
-   bool core_path_empty = string_is_empty(core_path);
-   bool core_name_empty = string_is_empty(core_name);
+   size_t slot;
+   const char *strings[PLAYLIST_ENTRIES];
+   struct playlist_entry *entry = NULL;
+   bool core_path_empty         = string_is_empty(core_path);
+   bool core_name_empty         = string_is_empty(core_name);
 
    if (core_path_empty || core_name_empty)
    {
@@ -309,93 +715,273 @@ bool playlist_push(playlist_t *playlist,
    if (!playlist)
       return false;
 
-   for (i = 0; i < playlist->size; i++)
+   /* Core name can have changed while still being the same core.
+    * Differentiate based on the core path only.
+    * Paths are compared without case on Windows, to prevent
+    * duplicates on case-insensitive file systems. */
+   if (playlist_find(playlist, false, path, core_path, true, &slot))
    {
       struct playlist_entry tmp;
-      bool equal_path;
-
-      equal_path = (!path && !playlist->entries[i].path) ||
-         (path && playlist->entries[i].path &&
-#ifdef _WIN32
-          /*prevent duplicates on case-insensitive operating systems*/
-          string_is_equal_noncase(path,playlist->entries[i].path)
-#else
-          string_is_equal(path,playlist->entries[i].path)
-#endif
-          );
-
-      /* Core name can have changed while still being the same core.
-       * Differentiate based on the core path only. */
-      if (!equal_path)
-         continue;
-
-      if (!string_is_equal(playlist->entries[i].core_path, core_path))
-         continue;
 
       /* If top entry, we don't want to push a new entry since
        * the top and the entry to be pushed are the same. */
-      if (i == 0)
+      if (slot == playlist->size - 1)
          return false;
 
       /* Seen it before, bump to top. */
-      tmp = playlist->entries[i];
-      memmove(playlist->entries + 1, playlist->entries,
-            i * sizeof(struct playlist_entry));
-      playlist->entries[0] = tmp;
+      tmp = playlist->entries[slot];
+      memmove(playlist->entries + slot, playlist->entries + slot + 1,
+            (playlist->size - slot - 1) * sizeof(struct playlist_entry));
+      playlist->entries[playlist->size - 1] = tmp;
+
+      if (!playlist->index_dirty)
+      {
+         playlist_index_bump(&playlist->path_index,
+               slot, playlist->size - 1);
+         playlist_index_bump(&playlist->crc32_index,
+               slot, playlist->size - 1);
+      }
 
       goto success;
    }
 
    if (playlist->size == playlist->cap)
    {
-      struct playlist_entry *entry = &playlist->entries[playlist->cap - 1];
-
-      if (entry)
-         playlist_free_entry(entry);
-      playlist->size--;
+      if (!playlist->cap)
+         return false;
+      playlist_remove_slot(playlist, 0);
    }
 
-   if (playlist->entries)
-   {
-      memmove(playlist->entries + 1, playlist->entries,
-            (playlist->cap - 1) * sizeof(struct playlist_entry));
-
-      playlist->entries[0].path         = NULL;
-      playlist->entries[0].label        = NULL;
-      playlist->entries[0].core_path    = NULL;
-      playlist->entries[0].core_name    = NULL;
-      playlist->entries[0].db_name      = NULL;
-      playlist->entries[0].crc32        = NULL;
-      if (!string_is_empty(path))
-         playlist->entries[0].path      = strdup(path);
-      if (!string_is_empty(label))
-         playlist->entries[0].label     = strdup(label);
-      if (!string_is_empty(core_path))
-         playlist->entries[0].core_path = strdup(core_path);
-      if (!string_is_empty(core_name))
-         playlist->entries[0].core_name = strdup(core_name);
-      if (!string_is_empty(db_name))
-         playlist->entries[0].db_name   = strdup(db_name);
-      if (!string_is_empty(crc32))
-         playlist->entries[0].crc32     = strdup(crc32);
-   }
+   if (!playlist_reserve(playlist))
+      return false;
 
+   entry            = &playlist->entries[playlist->size];
+   memset(entry, 0, sizeof(*entry));
+
+   if (!string_is_empty(path))
+      entry->path      = strdup(path);
+   if (!string_is_empty(label))
+      entry->label     = strdup(label);
+   if (!string_is_empty(core_path))
+      entry->core_path = strdup(core_path);
+   if (!string_is_empty(core_name))
+      entry->core_name = strdup(core_name);
+   if (!string_is_empty(db_name))
+      entry->db_name   = strdup(db_name);
+   if (!string_is_empty(crc32))
+      entry->crc32     = strdup(crc32);
+
+   playlist_entry_rehash(entry);
+   playlist_index_add(playlist, playlist->size);
    playlist->size++;
 
 success:
+   strings[0]         = path;
+   strings[1]         = label;
+   strings[2]         = core_path;
+   strings[3]         = core_name;
+   strings[4]         = crc32;
+   strings[5]         = db_name;
+   playlist_journal_add(playlist, PLAYLIST_JOURNAL_PUSH,
+         strings, PLAYLIST_ENTRIES, 0);
+
    playlist->modified = true;
 
    return true;
 }
 
-void playlist_write_file(playlist_t *playlist)
+/* String table for a binary playlist, sharing repeated strings. */
+struct playlist_strtab
+{
+   char *data;
+   size_t size;
+   size_t cap;
+   uint32_t *buckets;
+   size_t mask;
+};
+
+/* Returns the table offset of @s plus one, or 0 for no string. */
+static uint32_t playlist_strtab_add(struct playlist_strtab *tab,
+      const char *s)
+{
+   size_t len;
+   size_t i;
+
+   if (string_is_empty(s))
+      return 0;
+
+   for (i = playlist_hash(s) & tab->mask; tab->buckets[i];
+         i = (i + 1) & tab->mask)
+      if (string_is_equal(tab->data + tab->buckets[i] - 1, s))
+         return tab->buckets[i];
+
+   len = strlen(s) + 1;
+
+   if (tab->size + len > tab->cap)
+   {
+      size_t cap = (tab->size + len) * 2;
+      char *data = (char*)realloc(tab->data, cap);
+
+      if (!data)
+         return 0;
+
+      tab->data = data;
+      tab->cap  = cap;
+   }
+
+   memcpy(tab->data + tab->size, s, len);
+   tab->buckets[i] = (uint32_t)(tab->size + 1);
+   tab->size      += len;
+
+   return tab->buckets[i];
+}
+
+static bool playlist_write_binary(playlist_t *playlist, RFILE *file)
 {
    size_t i;
+   uint8_t header[PLAYLIST_BINARY_HEADER_SIZE];
+   struct playlist_strtab tab;
+   size_t buckets      = 64;
+   uint32_t generation = (uint32_t)cpu_features_get_time_usec();
+   uint8_t *records    = (uint8_t*)malloc(
+         playlist->size * PLAYLIST_BINARY_RECORD_SIZE + 1);
+   bool ret            = false;
+
+   if (generation == playlist->generation)
+      generation++;
+
+   memset(&tab, 0, sizeof(tab));
+
+   /* At most six new strings per entry, kept below half load. */
+   while (buckets < playlist->size * PLAYLIST_ENTRIES * 2)
+      buckets <<= 1;
+
+   tab.buckets = (uint32_t*)calloc(buckets, sizeof(*tab.buckets));
+   tab.mask    = buckets - 1;
+
+   if (!records || !tab.buckets)
+      goto end;
+
+   for (i = 0; i < playlist->size; i++)
+   {
+      const struct playlist_entry *entry = &playlist->entries[i];
+      uint8_t *record = records + i * PLAYLIST_BINARY_RECORD_SIZE;
+
+      playlist_write_le32(record +  0, playlist_strtab_add(&tab, entry->path));
+      playlist_write_le32(record +  4, playlist_strtab_add(&tab, entry->label));
+      playlist_write_le32(record +  8, playlist_strtab_add(&tab, entry->core_path));
+      playlist_write_le32(record + 12, playlist_strtab_add(&tab, entry->core_name));
+      playlist_write_le32(record + 16, playlist_strtab_add(&tab, entry->crc32));
+      playlist_write_le32(record + 20, playlist_strtab_add(&tab, entry->db_name));
+      playlist_write_le32(record + 24, entry->path_hash);
+      playlist_write_le32(record + 28, entry->crc32_hash);
+   }
+
+   memcpy(header, PLAYLIST_BINARY_MAGIC, 4);
+   playlist_write_le32(header +  4, PLAYLIST_BINARY_VERSION);
+   playlist_write_le32(header +  8, (uint32_t)playlist->size);
+   playlist_write_le32(header + 12, (uint32_t)tab.size);
+   playlist_write_le32(header + 16, generation);
+
+   ret =    filestream_write(file, header, sizeof(header))
+               == sizeof(header)
+         && filestream_write(file, records,
+               playlist->size * PLAYLIST_BINARY_RECORD_SIZE)
+               == (int64_t)(playlist->size * PLAYLIST_BINARY_RECORD_SIZE)
+         && (!tab.size || filestream_write(file, tab.data, tab.size)
+               == (int64_t)tab.size);
+
+   if (ret)
+   {
+      playlist->generation = generation;
+      playlist->disk_size  = sizeof(header)
+         + playlist->size * PLAYLIST_BINARY_RECORD_SIZE + tab.size;
+   }
+
+end:
+   free(records);
+   free(tab.data);
+   free(tab.buckets);
+   return ret;
+}
+
+static void playlist_write_text(playlist_t *playlist, RFILE *file)
+{
+   size_t i;
+
+   for (i = playlist->size; i-- > 0; )
+   {
+      const struct playlist_entry *entry = &playlist->entries[i];
+
+      filestream_printf(file, "%s\n%s\n%s\n%s\n%s\n%s\n",
+            entry->path    ? entry->path    : "",
+            entry->label   ? entry->label   : "",
+            entry->core_path,
+            entry->core_name,
+            entry->crc32   ? entry->crc32   : "",
+            entry->db_name ? entry->db_name : ""
+            );
+   }
+}
+
+/* Appends the pending journal records to a binary playlist file,
+ * unless the file changed since this playlist last read or wrote it. */
+static bool playlist_write_journal(playlist_t *playlist)
+{
+   uint8_t header[PLAYLIST_BINARY_HEADER_SIZE];
+   bool ret    = false;
+   RFILE *file = NULL;
+
+   if (     !playlist_binary_format
+         || !playlist->journal_valid
+         || playlist->journal_records >
+               PLAYLIST_JOURNAL_MAX + playlist->size / 4)
+      return false;
+
+   file = filestream_open(playlist->conf_path,
+         RETRO_VFS_FILE_ACCESS_READ_WRITE
+         | RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+      return false;
+
+   if (     filestream_get_size(file) != playlist->disk_size
+         || filestream_read(file, header, sizeof(header)) != sizeof(header)
+         || memcmp(header, PLAYLIST_BINARY_MAGIC, 4)
+         || playlist_read_le32(header + 16) != playlist->generation)
+   {
+      RARCH_LOG("Playlist file changed on disk, rewriting: %s\n",
+            playlist->conf_path);
+      goto end;
+   }
+
+   if (filestream_seek(file, 0, RETRO_VFS_SEEK_POSITION_END) >= 0)
+      ret = filestream_write(file, playlist->journal,
+            playlist->journal_size) == (int64_t)playlist->journal_size;
+
+   if (ret)
+      playlist->disk_size += playlist->journal_size;
+
+end:
+   filestream_close(file);
+   return ret;
+}
+
+void playlist_write_file(playlist_t *playlist)
+{
    RFILE *file = NULL;
 
    if (!playlist || !playlist->modified)
       return;
 
+   if (playlist_write_journal(playlist))
+   {
+      playlist->journal_size = 0;
+      playlist->modified     = false;
+      return;
+   }
+
    file = filestream_open(playlist->conf_path,
          RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
 
@@ -405,15 +991,14 @@ void playlist_write_file(playlist_t *playlist)
       return;
    }
 
-   for (i = 0; i < playlist->size; i++)
-      filestream_printf(file, "%s\n%s\n%s\n%s\n%s\n%s\n",
-            playlist->entries[i].path    ? playlist->entries[i].path    : "",
-            playlist->entries[i].label   ? playlist->entries[i].label   : "",
-            playlist->entries[i].core_path,
-            playlist->entries[i].core_name,
-            playlist->entries[i].crc32   ? playlist->entries[i].crc32   : "",
-            playlist->entries[i].db_name ? playlist->entries[i].db_name : ""
-            );
+   playlist->journal_valid   = false;
+   playlist->journal_size    = 0;
+   playlist->journal_records = 0;
+
+   if (playlist_binary_format)
+      playlist->journal_valid = playlist_write_binary(playlist, file);
+   else
+      playlist_write_text(playlist, file);
 
    playlist->modified = false;
 
@@ -430,8 +1015,6 @@ void playlist_write_file(playlist_t *playlist)
  */
 void playlist_free(playlist_t *playlist)
 {
-   size_t i;
-
    if (!playlist)
       return;
 
@@ -440,15 +1023,13 @@ void playlist_free(playlist_t *playlist)
 
    playlist->conf_path = NULL;
 
-   for (i = 0; i < playlist->size; i++)
-   {
-      struct playlist_entry *entry = &playlist->entries[i];
-
-      if (entry)
-         playlist_free_entry(entry);
-   }
+   playlist_clear(playlist);
 
    free(playlist->entries);
+   free(playlist->path_index.buckets);
+   free(playlist->crc32_index.buckets);
+   free(playlist->file_data);
+   free(playlist->journal);
    playlist->entries = NULL;
 
    free(playlist);
@@ -471,9 +1052,11 @@ void playlist_clear(playlist_t *playlist)
       struct playlist_entry *entry = &playlist->entries[i];
 
       if (entry)
-         playlist_free_entry(entry);
+         playlist_free_entry(playlist, entry);
    }
-   playlist->size = 0;
+   playlist->size          = 0;
+   playlist->index_dirty   = true;
+   playlist->journal_valid = false;
 }
 
 /**
@@ -495,6 +1078,7 @@ static bool playlist_read_file(
       playlist_t *playlist, const char *path)
 {
    unsigned i;
+   size_t first, last;
    char buf[PLAYLIST_ENTRIES][1024];
    intfstream_t *file = intfstream_open_file(
          path, RETRO_VFS_FILE_ACCESS_READ,
@@ -530,11 +1114,15 @@ static bool playlist_read_file(
             *last = '\0';
       }
 
-      entry = &playlist->entries[playlist->size];
-
       if (!*buf[2] || !*buf[3])
          continue;
 
+      if (!playlist_reserve(playlist))
+         goto end;
+
+      entry = &playlist->entries[playlist->size];
+      memset(entry, 0, sizeof(*entry));
+
       if (*buf[0])
          entry->path      = strdup(buf[0]);
       if (*buf[1])
@@ -546,15 +1134,214 @@ static bool playlist_read_file(
          entry->crc32     = strdup(buf[4]);
       if (*buf[5])
          entry->db_name   = strdup(buf[5]);
+      playlist_entry_rehash(entry);
       playlist->size++;
    }
 
 end:
+   /* The file lists the top entry first; storage is oldest first. */
+   for (first = 0, last = playlist->size; first + 1 < last; first++)
+   {
+      struct playlist_entry tmp   = playlist->entries[first];
+      playlist->entries[first]    = playlist->entries[--last];
+      playlist->entries[last]     = tmp;
+   }
+   playlist->index_dirty = true;
+
    intfstream_close(file);
    free(file);
    return true;
 }
 
+static const char *playlist_binary_string(const char *strings,
+      uint32_t size, uint32_t offset)
+{
+   if (!offset || offset > size)
+      return NULL;
+   return strings + offset - 1;
+}
+
+/* Replays the journal records in @data, returning false if the
+ * last one is cut short or malformed. */
+static bool playlist_read_journal(playlist_t *playlist,
+      const uint8_t *data, size_t size)
+{
+   size_t pos = 0;
+
+   while (pos < size)
+   {
+      const uint8_t *record = data + pos + 4;
+      uint32_t len          = 0;
+
+      if (size - pos < 5)
+         return false;
+
+      len = playlist_read_le32(data + pos);
+      if (!len || len > size - pos - 4)
+         return false;
+
+      switch (record[0])
+      {
+         case PLAYLIST_JOURNAL_PUSH:
+            {
+               unsigned i;
+               const char *strings[PLAYLIST_ENTRIES];
+               const char *str = (const char*)record + 1;
+               const char *end = (const char*)record + len;
+
+               for (i = 0; i < PLAYLIST_ENTRIES; i++)
+               {
+                  const char *nul = (const char*)memchr(str, '\0', end - str);
+                  if (!nul)
+                     return false;
+                  strings[i] = str;
+                  str        = nul + 1;
+               }
+
+               playlist_push(playlist, strings[0], strings[1],
+                     strings[2], strings[3], strings[4], strings[5]);
+            }
+            break;
+         case PLAYLIST_JOURNAL_DELETE:
+            if (len != 5)
+               return false;
+            playlist_delete_index(playlist, playlist_read_le32(record + 1));
+            break;
+         default:
+            return false;
+      }
+
+      playlist->journal_records++;
+      pos += 4 + len;
+   }
+
+   return true;
+}
+
+/**
+ * playlist_read_binary:
+ * @playlist            : Playlist handle.
+ * @path                : Path to playlist contents file.
+ *
+ * Loads a binary playlist file with a single read. Entries point at
+ * the strings in it rather than copying them.
+ *
+ * Returns: false if the file is not a binary playlist.
+ **/
+static bool playlist_read_binary(playlist_t *playlist, const char *path)
+{
+   size_t i, first;
+   uint32_t count, strings_size;
+   uint64_t strings_offset;
+   uint8_t header[PLAYLIST_BINARY_HEADER_SIZE];
+   const uint8_t *data = NULL;
+   int64_t size        = 0;
+   RFILE *file         = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+      return false;
+
+   if (     filestream_read(file, header, sizeof(header)) != sizeof(header)
+         || memcmp(header, PLAYLIST_BINARY_MAGIC, 4))
+   {
+      filestream_close(file);
+      return false;
+   }
+
+   size = filestream_get_size(file);
+   if (size > 0 && (uint64_t)(size_t)size == (uint64_t)size)
+      playlist->file_data = (char*)malloc((size_t)size);
+   if (playlist->file_data)
+      playlist->file_size = (size_t)size;
+
+   if (     !playlist->file_data
+         || filestream_seek(file, 0, RETRO_VFS_SEEK_POSITION_START) < 0
+         || filestream_read(file, playlist->file_data, size) != size)
+      goto error;
+
+   filestream_close(file);
+   file                = NULL;
+   data                = (const uint8_t*)playlist->file_data;
+
+   count          = playlist_read_le32(data + 8);
+   strings_size   = playlist_read_le32(data + 12);
+   strings_offset = PLAYLIST_BINARY_HEADER_SIZE
+      + (uint64_t)count * PLAYLIST_BINARY_RECORD_SIZE;
+
+   if (     playlist_read_le32(data + 4) != PLAYLIST_BINARY_VERSION
+         || strings_offset + strings_size > (uint64_t)size
+         || (strings_size && data[strings_offset + strings_size - 1]))
+      goto error;
+
+   /* Keep the newest entries if the file holds more than fit. */
+   first = count > playlist->cap ? count - playlist->cap : 0;
+
+   if (count > first)
+   {
+      playlist->entries = (struct playlist_entry*)malloc(
+            (count - first) * sizeof(*playlist->entries));
+      if (!playlist->entries)
+         goto error;
+      playlist->alloc   = count - first;
+   }
+
+   for (i = first; i < count; i++)
+   {
+      const char *strings          = (const char*)data + strings_offset;
+      const uint8_t *record        = data + PLAYLIST_BINARY_HEADER_SIZE
+         + i * PLAYLIST_BINARY_RECORD_SIZE;
+      struct playlist_entry *entry = &playlist->entries[playlist->size];
+
+      entry->path       = (char*)playlist_binary_string(strings,
+            strings_size, playlist_read_le32(record +  0));
+      entry->label      = (char*)playlist_binary_string(strings,
+            strings_size, playlist_read_le32(record +  4));
+      entry->core_path  = (char*)playlist_binary_string(strings,
+            strings_size, playlist_read_le32(record +  8));
+      entry->core_name  = (char*)playlist_binary_string(strings,
+            strings_size, playlist_read_le32(record + 12));
+      entry->crc32      = (char*)playlist_binary_string(strings,
+            strings_size, playlist_read_le32(record + 16));
+      entry->db_name    = (char*)playlist_binary_string(strings,
+            strings_size, playlist_read_le32(record + 20));
+      entry->path_hash  = playlist_read_le32(record + 24);
+      entry->crc32_hash = playlist_read_le32(record + 28);
+
+      /* Same rule as for text playlists. */
+      if (!entry->core_path || !entry->core_name)
+         continue;
+
+      playlist->size++;
+   }
+
+   playlist->journal_valid = !first && playlist->size == count;
+   playlist->generation    = playlist_read_le32(data + 16);
+   playlist->disk_size     = size;
+   playlist->replaying     = true;
+   if (!playlist_read_journal(playlist, data + strings_offset + strings_size,
+            (size_t)(size - strings_offset - strings_size)))
+      playlist->journal_valid = false;
+   playlist->replaying     = false;
+   playlist->modified      = false;
+   playlist->index_dirty   = true;
+
+   return true;
+
+error:
+   RARCH_ERR("Invalid binary playlist file: %s\n", path);
+   if (file)
+      filestream_close(file);
+   playlist_clear(playlist);
+   free(playlist->file_data);
+   free(playlist->entries);
+   playlist->file_data = NULL;
+   playlist->file_size = 0;
+   playlist->entries   = NULL;
+   playlist->alloc     = 0;
+   return true;
+}
+
 void playlist_free_cached(void)
 {
    playlist_free(playlist_cached);
@@ -583,31 +1370,25 @@ bool playlist_init_cached(const char *path, size_t size)
  * @path            	   : Path to playlist contents file.
  * @size                : Maximum capacity of playlist size.
  *
- * Creates and initializes a playlist.
+ * Creates and initializes a playlist. Storage for entries is
+ * allocated as the playlist grows, up to @size.
  *
  * Returns: handle to new playlist if successful, otherwise NULL
  **/
 playlist_t *playlist_init(const char *path, size_t size)
 {
-   struct playlist_entry *entries = NULL;
-   playlist_t           *playlist = (playlist_t*)malloc(sizeof(*playlist));
+   playlist_t *playlist = (playlist_t*)calloc(1, sizeof(*playlist));
    if (!playlist)
       return NULL;
 
-   entries = (struct playlist_entry*)calloc(size, sizeof(*entries));
-   if (!entries)
-   {
-      free(playlist);
-      return NULL;
-   }
-
-   playlist->modified  = false;
-   playlist->size      = 0;
-   playlist->cap       = size;
-   playlist->conf_path = strdup(path);
-   playlist->entries   = entries;
+   playlist->modified    = false;
+   playlist->index_dirty = true;
+   playlist->size        = 0;
+   playlist->cap         = size;
+   playlist->conf_path   = strdup(path);
 
-   playlist_read_file(playlist, path);
+   if (!playlist_read_binary(playlist, path))
+      playlist_read_file(playlist, path);
 
    return playlist;
 }
@@ -624,9 +1405,22 @@ static int playlist_qsort_func(const struct playlist_entry *a,
    return strcasecmp(a_label, b_label);
 }
 
+/* Storage is oldest first, so sorting it in descending
+ * order leaves the playlist itself in ascending order. */
+static int playlist_qsort_func_reverse(const struct playlist_entry *a,
+      const struct playlist_entry *b)
+{
+   return playlist_qsort_func(b, a);
+}
+
 void playlist_qsort(playlist_t *playlist)
 {
+   if (!playlist || !playlist->size)
+      return;
+
    qsort(playlist->entries, playlist->size,
          sizeof(struct playlist_entry),
-         (int (*)(const void *, const void *))playlist_qsort_func);
+         (int (*)(const void *, const void *))playlist_qsort_func_reverse);
+   playlist->index_dirty   = true;
+   playlist->journal_valid = false;
 }
@@ -31,7 +31,8 @@ typedef struct content_playlist       playlist_t;
  * @path            	   : Path to playlist contents file.
  * @size                : Maximum capacity of playlist size.
  *
- * Creates and initializes a playlist.
+ * Creates and initializes a playlist. Storage for entries is
+ * allocated as the playlist grows, up to @size.
  *
  * Returns: handle to new playlist if successful, otherwise NULL
  **/
@@ -76,8 +77,8 @@ void playlist_get_index(playlist_t *playlist,
       size_t idx,
       const char **path, const char **label,
       const char **core_path, const char **core_name,
-      const char **db_name,
-      const char **crc32);
+      const char **crc32,
+      const char **db_name);
 
 /**
  * playlist_delete_index:
@@ -101,26 +102,48 @@ void playlist_delete_index(playlist_t *playlist,
 bool playlist_push(playlist_t *playlist,
       const char *path, const char *label,
       const char *core_path, const char *core_name,
-      const char *db_name,
-      const char *crc32);
+      const char *crc32,
+      const char *db_name);
 
 void playlist_update(playlist_t *playlist, size_t idx,
       const char *path, const char *label,
       const char *core_path, const char *core_name,
-      const char *db_name,
-      const char *crc32);
+      const char *crc32,
+      const char *db_name);
 
 void playlist_get_index_by_path(playlist_t *playlist,
       const char *search_path,
       char **path, char **label,
       char **core_path, char **core_name,
-      char **db_name,
-      char **crc32);
+      char **crc32,
+      char **db_name);
 
 bool playlist_entry_exists(playlist_t *playlist,
       const char *path,
       const char *crc32);
 
+/**
+ * playlist_get_index_by_crc32:
+ * @playlist            : Playlist handle.
+ * @crc32               : CRC field to look up, e.g. "0123ABCD|crc".
+ * @idx                 : Index of the matching playlist entry.
+ *
+ * Looks up the most recent entry with the given CRC field.
+ *
+ * Returns: true if an entry was found.
+ **/
+bool playlist_get_index_by_crc32(playlist_t *playlist,
+      const char *crc32, size_t *idx);
+
+/**
+ * playlist_set_binary_format:
+ * @enable              : Write playlists in the binary format.
+ *
+ * Sets the format modified playlists are written in. Both formats
+ * are always read, so playlists convert on their next write.
+ **/
+void playlist_set_binary_format(bool enable);
+
 char *playlist_get_conf_path(playlist_t *playlist);
 
 uint32_t playlist_get_size(playlist_t *playlist);
@@ -215,16 +215,18 @@ typedef struct ffmpeg
 
    struct ffemu_params params;
 
+   /* Signalled when there is something to encode */
    scond_t *cond;
-   slock_t *cond_lock;
+   /* Signalled when the encoder has made room. Video and audio
+    * may be pushed from different threads, so both wait here. */
+   scond_t *space_cond;
    slock_t *lock;
    fifo_buffer_t *audio_fifo;
    fifo_buffer_t *video_fifo;
    fifo_buffer_t *attr_fifo;
    sthread_t *thread;
 
-   volatile bool alive;
-   volatile bool can_sleep;
+   bool alive;
 } ffmpeg_t;
 
 static bool ffmpeg_codec_has_sample_format(enum AVSampleFormat fmt,
@@ -672,8 +674,8 @@ static void ffmpeg_thread(void *data);
 static bool init_thread(ffmpeg_t *handle)
 {
    handle->lock = slock_new();
-   handle->cond_lock = slock_new();
    handle->cond = scond_new();
+   handle->space_cond = scond_new();
    handle->audio_fifo = fifo_new(32000 * sizeof(int16_t) *
          handle->params.channels * MAX_FRAMES / 60); /* Some arbitrary max size. */
    handle->attr_fifo = fifo_new(sizeof(struct ffemu_video_data) * MAX_FRAMES);
@@ -681,10 +683,9 @@ static bool init_thread(ffmpeg_t *handle)
             handle->video.pix_size * MAX_FRAMES);
 
    handle->alive = true;
-   handle->can_sleep = true;
    handle->thread = sthread_create(ffmpeg_thread, handle);
 
-   retro_assert(handle->lock && handle->cond_lock &&
+   retro_assert(handle->lock && handle->space_cond &&
       handle->cond && handle->audio_fifo &&
       handle->attr_fifo && handle->video_fifo && handle->thread);
 
@@ -696,17 +697,17 @@ static void deinit_thread(ffmpeg_t *handle)
    if (!handle->thread)
       return;
 
-   slock_lock(handle->cond_lock);
+   slock_lock(handle->lock);
    handle->alive = false;
-   handle->can_sleep = false;
-   slock_unlock(handle->cond_lock);
-
    scond_signal(handle->cond);
+   scond_broadcast(handle->space_cond);
+   slock_unlock(handle->lock);
+
    sthread_join(handle->thread);
 
    slock_free(handle->lock);
-   slock_free(handle->cond_lock);
    scond_free(handle->cond);
+   scond_free(handle->space_cond);
 
    handle->thread = NULL;
 }
@@ -841,34 +842,18 @@ static bool ffmpeg_push_video(void *data,
    if (drop_frame)
       return true;
 
-   for (;;)
-   {
-      unsigned avail;
-      slock_lock(handle->lock);
-      avail = fifo_write_avail(handle->attr_fifo);
-      slock_unlock(handle->lock);
-
-      if (!handle->alive)
-         return false;
+   slock_lock(handle->lock);
 
-      if (avail >= sizeof(*vid))
-         break;
+   while (handle->alive
+         && fifo_write_avail(handle->attr_fifo) < sizeof(*vid))
+      scond_wait(handle->space_cond, handle->lock);
 
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
-      {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
-      }
-      else
-         scond_signal(handle->cond);
-
-      slock_unlock(handle->cond_lock);
+   if (!handle->alive)
+   {
+      slock_unlock(handle->lock);
+      return false;
    }
 
-   slock_lock(handle->lock);
-
    /* Tightly pack our frame to conserve memory.
     * libretro tends to use a very large pitch.
     */
@@ -902,34 +887,19 @@ static bool ffmpeg_push_audio(void *data,
    if (!handle->config.audio_enable)
       return true;
 
-   for (;;)
-   {
-      unsigned avail;
-      slock_lock(handle->lock);
-      avail = fifo_write_avail(handle->audio_fifo);
-      slock_unlock(handle->lock);
-
-      if (!handle->alive)
-         return false;
-
-      if (avail >= audio_data->frames * handle->params.channels
-            * sizeof(int16_t))
-         break;
+   slock_lock(handle->lock);
 
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
-      {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
-      }
-      else
-         scond_signal(handle->cond);
+   while (handle->alive
+         && fifo_write_avail(handle->audio_fifo)
+         < audio_data->frames * handle->params.channels * sizeof(int16_t))
+      scond_wait(handle->space_cond, handle->lock);
 
-      slock_unlock(handle->cond_lock);
+   if (!handle->alive)
+   {
+      slock_unlock(handle->lock);
+      return false;
    }
 
-   slock_lock(handle->lock);
    fifo_write(handle->audio_fifo, audio_data->data,
          audio_data->frames * handle->params.channels * sizeof(int16_t));
    slock_unlock(handle->lock);
@@ -1395,7 +1365,7 @@ static void ffmpeg_thread(void *data)
       (ff->audio.codec->frame_size * ff->params.channels * sizeof(int16_t)) : 0;
    audio_buf      = audio_buf_size ? av_malloc(audio_buf_size) : NULL;
 
-   while (ff->alive)
+   for (;;)
    {
       struct ffemu_video_data attr_buf;
 
@@ -1403,28 +1373,25 @@ static void ffmpeg_thread(void *data)
       bool avail_audio = false;
 
       slock_lock(ff->lock);
-      if (fifo_read_avail(ff->attr_fifo) >= sizeof(attr_buf))
-         avail_video = true;
+      for (;;)
+      {
+         avail_video = fifo_read_avail(ff->attr_fifo) >= sizeof(attr_buf);
+         avail_audio = ff->config.audio_enable
+            && fifo_read_avail(ff->audio_fifo) >= audio_buf_size;
 
-      if (ff->config.audio_enable)
-         if (fifo_read_avail(ff->audio_fifo) >= audio_buf_size)
-            avail_audio = true;
-      slock_unlock(ff->lock);
+         if (avail_video || avail_audio || !ff->alive)
+            break;
 
-      if (!avail_video && !avail_audio)
-      {
-         slock_lock(ff->cond_lock);
-         if (ff->can_sleep)
-         {
-            ff->can_sleep = false;
-            scond_wait(ff->cond, ff->cond_lock);
-            ff->can_sleep = true;
-         }
-         else
-            scond_signal(ff->cond);
+         scond_wait(ff->cond, ff->lock);
+      }
 
-         slock_unlock(ff->cond_lock);
+      /* Whatever is left gets flushed by ffmpeg_finalize() */
+      if (!ff->alive)
+      {
+         slock_unlock(ff->lock);
+         break;
       }
+      slock_unlock(ff->lock);
 
       if (avail_video && video_buf)
       {
@@ -1432,8 +1399,8 @@ static void ffmpeg_thread(void *data)
          fifo_read(ff->attr_fifo, &attr_buf, sizeof(attr_buf));
          fifo_read(ff->video_fifo, video_buf,
                attr_buf.height * attr_buf.pitch);
+         scond_broadcast(ff->space_cond);
          slock_unlock(ff->lock);
-         scond_signal(ff->cond);
 
          attr_buf.data = video_buf;
          ffmpeg_push_video_thread(ff, &attr_buf);
@@ -1445,8 +1412,8 @@ static void ffmpeg_thread(void *data)
 
          slock_lock(ff->lock);
          fifo_read(ff->audio_fifo, audio_buf, audio_buf_size);
+         scond_broadcast(ff->space_cond);
          slock_unlock(ff->lock);
-         scond_signal(ff->cond);
 
          aud.frames = ff->audio.codec->frame_size;
          aud.data = audio_buf;
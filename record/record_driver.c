@@ -17,6 +17,9 @@
 #include <string.h>
 
 #include <file/file_path.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 #include <compat/strl.h>
 #include <string/stdstring.h>
 #include <retro_math.h>
@@ -55,6 +58,252 @@ static bool recording_use_output_dir           = false;
 static const record_driver_t *recording_driver = NULL;
 void *recording_data                           = NULL;
 
+#ifdef HAVE_THREADS
+/* Number of frames that can be waiting for the recording
+ * driver before new ones are recorded as duplicates. */
+#define RECORDING_CAPTURE_SLOTS 4
+
+struct recording_capture_slot
+{
+   uint8_t *data;
+   size_t capacity;
+   struct ffemu_video_data video;
+   /* Frames that came in while the queue was full. They are
+    * pushed as duplicates of this one, so the driver still
+    * sees one frame per video frame and stays in sync. */
+   unsigned dupes;
+};
+
+/* Frames are copied into a ring of slots on the main thread
+ * and handed to the recording driver by a worker thread, so
+ * a slow encoder repeats frames instead of stalling the frontend. */
+typedef struct recording_capture
+{
+   const record_driver_t *driver;
+   void *driver_data;
+
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+
+   struct recording_capture_slot slots[RECORDING_CAPTURE_SLOTS];
+   unsigned read_pos;
+   unsigned count;
+   unsigned pix_size;
+   bool alive;
+
+   unsigned frames_queued;
+   unsigned frames_duplicated;
+   unsigned peak_count;
+} recording_capture_t;
+
+static recording_capture_t *recording_capture  = NULL;
+
+static void recording_capture_thread(void *data)
+{
+   recording_capture_t *cap = (recording_capture_t*)data;
+
+   for (;;)
+   {
+      struct recording_capture_slot *slot = NULL;
+
+      slock_lock(cap->lock);
+      while (cap->alive && !cap->count)
+         scond_wait(cap->cond, cap->lock);
+
+      if (!cap->count)
+      {
+         slock_unlock(cap->lock);
+         break;
+      }
+
+      slot = &cap->slots[cap->read_pos];
+      slock_unlock(cap->lock);
+
+      /* The slot is only recycled once the driver returns. */
+      if (cap->driver->push_video)
+         cap->driver->push_video(cap->driver_data, &slot->video);
+
+      for (;;)
+      {
+         struct ffemu_video_data dupe;
+         unsigned dupes;
+
+         slock_lock(cap->lock);
+         dupes       = slot->dupes;
+         slot->dupes = 0;
+         if (!dupes)
+         {
+            cap->read_pos = (cap->read_pos + 1) % RECORDING_CAPTURE_SLOTS;
+            cap->count--;
+            slock_unlock(cap->lock);
+            break;
+         }
+         slock_unlock(cap->lock);
+
+         dupe         = slot->video;
+         dupe.data    = NULL;
+         dupe.is_dupe = true;
+
+         while (dupes--)
+            if (cap->driver->push_video)
+               cap->driver->push_video(cap->driver_data, &dupe);
+      }
+   }
+}
+
+static void recording_capture_free(void)
+{
+   unsigned i;
+   recording_capture_t *cap = recording_capture;
+
+   if (!cap)
+      return;
+
+   if (cap->thread)
+   {
+      /* Let the worker drain the frames that are still queued. */
+      slock_lock(cap->lock);
+      cap->alive = false;
+      scond_signal(cap->cond);
+      slock_unlock(cap->lock);
+
+      sthread_join(cap->thread);
+   }
+
+   RARCH_LOG("[recording]: %u frames queued, %u duplicated, "
+         "peak queue depth %u/%u.\n",
+         cap->frames_queued, cap->frames_duplicated,
+         cap->peak_count, RECORDING_CAPTURE_SLOTS);
+
+   for (i = 0; i < RECORDING_CAPTURE_SLOTS; i++)
+      free(cap->slots[i].data);
+
+   if (cap->lock)
+      slock_free(cap->lock);
+   if (cap->cond)
+      scond_free(cap->cond);
+
+   free(cap);
+   recording_capture = NULL;
+}
+
+static bool recording_capture_init(const record_driver_t *driver,
+      void *driver_data, enum ffemu_pix_format pix_fmt)
+{
+   recording_capture_t *cap = (recording_capture_t*)
+      calloc(1, sizeof(*cap));
+
+   if (!cap)
+      return false;
+
+   cap->driver      = driver;
+   cap->driver_data = driver_data;
+   cap->alive       = true;
+
+   switch (pix_fmt)
+   {
+      case FFEMU_PIX_RGB565:
+         cap->pix_size = 2;
+         break;
+      case FFEMU_PIX_BGR24:
+         cap->pix_size = 3;
+         break;
+      case FFEMU_PIX_ARGB8888:
+      default:
+         cap->pix_size = 4;
+         break;
+   }
+
+   recording_capture = cap;
+
+   cap->lock        = slock_new();
+   cap->cond        = scond_new();
+
+   if (!cap->lock || !cap->cond)
+      goto error;
+
+   cap->thread      = sthread_create(recording_capture_thread, cap);
+
+   if (!cap->thread)
+      goto error;
+
+   return true;
+
+error:
+   recording_capture_free();
+   return false;
+}
+
+/* Records the current frame as a repeat of the last one queued,
+ * if there is one. Must be called with the lock held. */
+static void recording_capture_dupe(recording_capture_t *cap)
+{
+   if (!cap->count)
+      return;
+
+   cap->slots[(cap->read_pos + cap->count - 1)
+      % RECORDING_CAPTURE_SLOTS].dupes++;
+   cap->frames_duplicated++;
+}
+
+/* Returns the slot to capture the next frame into with room
+ * for at least @size bytes, or NULL if every slot is still in
+ * flight, in which case the frame has been queued as a duplicate.
+ * The frame is handed over with recording_capture_commit(). */
+static struct recording_capture_slot *recording_capture_acquire(
+      recording_capture_t *cap, size_t size)
+{
+   struct recording_capture_slot *slot = NULL;
+
+   slock_lock(cap->lock);
+   if (cap->count == RECORDING_CAPTURE_SLOTS)
+   {
+      recording_capture_dupe(cap);
+      slock_unlock(cap->lock);
+      return NULL;
+   }
+   slot = &cap->slots[(cap->read_pos + cap->count)
+      % RECORDING_CAPTURE_SLOTS];
+   slock_unlock(cap->lock);
+
+   /* Free slots are owned by the main thread. */
+   if (size > slot->capacity)
+   {
+      uint8_t *data = (uint8_t*)realloc(slot->data, size);
+
+      if (!data)
+      {
+         slock_lock(cap->lock);
+         recording_capture_dupe(cap);
+         slock_unlock(cap->lock);
+         return NULL;
+      }
+
+      slot->data     = data;
+      slot->capacity = size;
+   }
+
+   return slot;
+}
+
+static void recording_capture_commit(recording_capture_t *cap,
+      struct recording_capture_slot *slot,
+      const struct ffemu_video_data *video)
+{
+   slot->video = *video;
+   slot->dupes = 0;
+
+   slock_lock(cap->lock);
+   cap->count++;
+   cap->frames_queued++;
+   if (cap->count > cap->peak_count)
+      cap->peak_count = cap->count;
+   scond_signal(cap->cond);
+   slock_unlock(cap->lock);
+}
+#endif
+
 /**
  * record_driver_find_ident:
  * @idx                : index of driver to get handle to.
@@ -191,6 +440,9 @@ void recording_dump_frame(const void *data, unsigned width,
 {
    bool has_gpu_record = false;
    uint8_t *gpu_buf    = NULL;
+#ifdef HAVE_THREADS
+   struct recording_capture_slot *slot = NULL;
+#endif
    struct ffemu_video_data
       ffemu_data       = {0};
 
@@ -241,6 +493,19 @@ void recording_dump_frame(const void *data, unsigned width,
       if (!gpu_buf)
          return;
 
+#ifdef HAVE_THREADS
+      if (recording_capture)
+      {
+         slot = recording_capture_acquire(recording_capture,
+               recording_gpu_width * recording_gpu_height * 3);
+
+         if (!slot)
+            return;
+
+         gpu_buf = slot->data;
+      }
+#endif
+
       /* Big bottleneck.
        * Since we might need to do read-backs asynchronously,
        * it might take 3-4 times before this returns true. */
@@ -258,6 +523,38 @@ void recording_dump_frame(const void *data, unsigned width,
    if (!has_gpu_record)
       ffemu_data.is_dupe = !data;
 
+#ifdef HAVE_THREADS
+   if (recording_capture)
+   {
+      recording_capture_t *cap = recording_capture;
+
+      if (!has_gpu_record)
+      {
+         size_t line_size = ffemu_data.is_dupe
+            ? 0 : ffemu_data.width * cap->pix_size;
+
+         if (!(slot = recording_capture_acquire(cap,
+                     line_size * ffemu_data.height)))
+            return;
+
+         if (!ffemu_data.is_dupe)
+         {
+            unsigned y;
+            const uint8_t *src = (const uint8_t*)data;
+
+            for (y = 0; y < ffemu_data.height; y++, src += pitch)
+               memcpy(slot->data + y * line_size, src, line_size);
+
+            ffemu_data.data  = slot->data;
+            ffemu_data.pitch = (int)line_size;
+         }
+      }
+
+      recording_capture_commit(cap, slot, &ffemu_data);
+      return;
+   }
+#endif
+
    if (recording_driver && recording_driver->push_video)
       recording_driver->push_video(recording_data, &ffemu_data);
 }
@@ -267,6 +564,10 @@ bool recording_deinit(void)
    if (!recording_data || !recording_driver)
       return false;
 
+#ifdef HAVE_THREADS
+   recording_capture_free();
+#endif
+
    if (recording_driver->finalize)
       recording_driver->finalize(recording_data);
 
@@ -456,6 +757,13 @@ bool recording_init(void)
       return false;
    }
 
+#ifdef HAVE_THREADS
+   /* Without the capture thread frames are pushed synchronously. */
+   if (!recording_capture_init(recording_driver, recording_data,
+            params.pix_fmt))
+      RARCH_WARN("[recording]: Failed to start capture thread.\n");
+#endif
+
    return true;
 }
 
@@ -48,6 +48,7 @@
 #include <retro_assert.h>
 #include <retro_miscellaneous.h>
 #include <queues/message_queue.h>
+#include <queues/message_channel.h>
 #include <queues/task_queue.h>
 #include <features/features_cpu.h>
 
@@ -248,10 +249,8 @@ static struct retro_frame_time_callback runloop_frame_time;
 static retro_keyboard_event_t runloop_key_event            = NULL;
 static retro_keyboard_event_t runloop_frontend_key_event   = NULL;
 static core_option_manager_t *runloop_core_options         = NULL;
-#ifdef HAVE_THREADS
-static slock_t *_runloop_msg_queue_lock                    = NULL;
-#endif
 static msg_queue_t *runloop_msg_queue                      = NULL;
+static msg_channel_t *runloop_msg_channel                  = NULL;
 
 static unsigned runloop_pending_windowed_scale             = 0;
 static unsigned runloop_max_frames                         = 0;
@@ -269,46 +268,20 @@ bool retroarch_core_set_on_cmdline(void)
 }
 #endif
 
-#ifdef HAVE_THREADS
-void runloop_msg_queue_lock(void)
-{
-   slock_lock(_runloop_msg_queue_lock);
-}
-
-void runloop_msg_queue_unlock(void)
-{
-   slock_unlock(_runloop_msg_queue_lock);
-}
-#endif
-
 static void retroarch_msg_queue_deinit(void)
 {
-#ifdef HAVE_THREADS
-   runloop_msg_queue_lock();
-#endif
-
-   if (!runloop_msg_queue)
-      return;
-
+   msg_channel_free(runloop_msg_channel);
    msg_queue_free(runloop_msg_queue);
 
-#ifdef HAVE_THREADS
-   runloop_msg_queue_unlock();
-   slock_free(_runloop_msg_queue_lock);
-   _runloop_msg_queue_lock = NULL;
-#endif
-
-   runloop_msg_queue = NULL;
+   runloop_msg_channel = NULL;
+   runloop_msg_queue   = NULL;
 }
 
 static void retroarch_msg_queue_init(void)
 {
    retroarch_msg_queue_deinit();
-   runloop_msg_queue = msg_queue_new(8);
-
-#ifdef HAVE_THREADS
-   _runloop_msg_queue_lock = slock_new();
-#endif
+   runloop_msg_queue   = msg_queue_new(8);
+   runloop_msg_channel = msg_channel_new(32);
 }
 
 static void retroarch_override_setting_free_state(void)
@@ -1847,6 +1820,7 @@ bool rarch_ctl(enum rarch_ctl_state state, void *data)
          return runloop_shutdown_initiated;
       case RARCH_CTL_DATA_DEINIT:
          task_queue_deinit();
+         take_screenshot_deinit();
          break;
       case RARCH_CTL_IS_CORE_OPTION_UPDATED:
          if (!runloop_core_options)
@@ -2332,38 +2306,36 @@ global_t *global_get_ptr(void)
 }
 
 
+/* Any thread may push; messages only reach msg_queue and the
+ * UI companion when the main thread drains the channel. A flushing
+ * message supersedes every message pushed before it, so pending
+ * flushing messages are coalesced into a single slot. This keeps
+ * frequent task progress updates from flooding the channel. */
 void runloop_msg_queue_push(const char *msg,
       unsigned prio, unsigned duration,
       bool flush)
 {
-   runloop_ctx_msg_info_t msg_info;
-
-#ifdef HAVE_THREADS
-   runloop_msg_queue_lock();
-#endif
+   msg_channel_push(runloop_msg_channel,
+         flush ? (const void*)&runloop_msg_channel : NULL,
+         msg, prio, duration, flush);
+}
 
+static void runloop_msg_queue_deliver(void *userdata, const char *msg,
+      unsigned prio, unsigned duration, bool flush)
+{
    if (flush)
       msg_queue_clear(runloop_msg_queue);
 
-   msg_info.msg      = msg;
-   msg_info.prio     = prio;
-   msg_info.duration = duration;
-   msg_info.flush    = flush;
-
-   if (runloop_msg_queue)
-   {
-      msg_queue_push(runloop_msg_queue, msg_info.msg,
-            msg_info.prio, msg_info.duration);
-
-      ui_companion_driver_msg_queue_push(msg_info.msg,
-            msg_info.prio, msg_info.duration, msg_info.flush);
-   }
+   msg_queue_push(runloop_msg_queue, msg, prio, duration);
 
-#ifdef HAVE_THREADS
-   runloop_msg_queue_unlock();
-#endif
+   ui_companion_driver_msg_queue_push(msg, prio, duration, flush);
 }
 
+static void runloop_msg_queue_drain(void)
+{
+   msg_channel_drain(runloop_msg_channel,
+         runloop_msg_queue_deliver, NULL);
+}
 
 void runloop_get_status(bool *is_paused, bool *is_idle,
       bool *is_slowmotion, bool *is_perfcnt_enable)
@@ -2374,20 +2346,39 @@ void runloop_get_status(bool *is_paused, bool *is_idle,
    *is_perfcnt_enable = runloop_perfcnt_enable;
 }
 
+/* Main thread only. */
 bool runloop_msg_queue_pull(const char **ret)
 {
-#ifdef HAVE_THREADS
-   runloop_msg_queue_lock();
-#endif
    if (!ret)
       return false;
+   runloop_msg_queue_drain();
    *ret = msg_queue_pull(runloop_msg_queue);
-#ifdef HAVE_THREADS
-   runloop_msg_queue_unlock();
-#endif
    return true;
 }
 
+#ifdef HAVE_MENU
+/* Main thread only. True while the OSD has messages to show,
+ * and once more after the last one is gone so that it gets
+ * cleared off the screen. */
+static bool runloop_msg_queue_pending(void)
+{
+   static bool was_pending = false;
+   bool pending            = false;
+
+   runloop_msg_queue_drain();
+
+   pending     = msg_queue_size(runloop_msg_queue) > 0;
+
+   if (pending || was_pending)
+   {
+      was_pending = pending;
+      return true;
+   }
+
+   return false;
+}
+#endif
+
 /* Time to exit out of the main loop?
  * Reasons for exiting:
  * a) Shutdown environment callback was invoked.
@@ -2474,6 +2465,7 @@ static enum runloop_state runloop_check_state(
 #ifdef HAVE_MENU
    bool menu_driver_binding_state   = menu_driver_is_binding_state();
    bool menu_is_alive               = menu_driver_is_alive();
+   bool menu_frame_skipped          = false;
 #endif
 
    BIT256_CLEAR_ALL_PTR(&current_input);
@@ -2632,6 +2624,7 @@ static enum runloop_state runloop_check_state(
    if (menu_is_alive)
    {
       static input_bits_t old_input = {{0}};
+      static bool old_focused       = false;
       menu_ctx_iterate_t iter;
 
       retro_ctx.poll_cb();
@@ -2661,16 +2654,28 @@ static enum runloop_state runloop_check_state(
                   rarch_is_inited, 
                   (current_core_type == CORE_TYPE_DUMMY));
 
-            menu_driver_render(runloop_idle, rarch_is_inited,
-                  (current_core_type == CORE_TYPE_DUMMY)
-                  )
-               ;
+            /* Any input, focus change or OSD message may change
+             * what is on screen; everything else invalidates
+             * the menu itself. --max-frames counts presented
+             * frames, so it never lets the menu go idle. */
+            if (     focused != old_focused
+                  || runloop_max_frames
+                  || memcmp(&current_input, &old_input, sizeof(old_input))
+                  || (settings->bools.video_font_enable
+                     && runloop_msg_queue_pending()))
+               menu_driver_invalidate();
+
+            menu_frame_skipped = !menu_driver_render(runloop_idle,
+                  rarch_is_inited,
+                  (current_core_type == CORE_TYPE_DUMMY));
+
             if (settings->bools.audio_enable_menu &&
                   !libretro_running)
                audio_driver_menu_sample();
          }
 
          old_input                 = current_input;
+         old_focused               = focused;
 
          if (!focused)
             return RUNLOOP_STATE_POLLED_AND_SLEEP;
@@ -2754,6 +2759,11 @@ static enum runloop_state runloop_check_state(
 
    if (menu_driver_is_alive())
    {
+      /* Nothing changed, so there is nothing to present either;
+       * sleep instead of spinning on a missing vsync. */
+      if (menu_frame_skipped)
+         return RUNLOOP_STATE_POLLED_AND_SLEEP;
+
       if (!settings->bools.menu_throttle_framerate && !settings->floats.fastforward_ratio)
          return RUNLOOP_STATE_MENU_ITERATE;
 
@@ -3234,6 +3244,8 @@ int runloop_iterate(unsigned *sleep_ms)
    settings_t *settings                         = config_get_ptr();
    unsigned max_users                           = *(input_driver_get_uint(INPUT_ACTION_MAX_USERS));
 
+   runloop_msg_queue_drain();
+
    if (runloop_frame_time.callback)
    {
       /* Updates frame timing if frame timing callback is in use by the core.
@@ -3313,6 +3325,9 @@ int runloop_iterate(unsigned *sleep_ms)
    if ((settings->uints.video_frame_delay > 0) && !input_nonblock_state)
       retro_sleep(settings->uints.video_frame_delay);
 
+   frame_telemetry_frame_begin();
+   frame_telemetry_event_begin(FRAME_TELEMETRY_CORE_RUN);
+
 #ifdef HAVE_RUNAHEAD
    /* Run Ahead Feature replaces the call to core_run in this loop */
    if (settings->bools.run_ahead_enabled && settings->uints.run_ahead_frames > 0)
@@ -3321,6 +3336,11 @@ int runloop_iterate(unsigned *sleep_ms)
 #endif
       core_run();
 
+   frame_telemetry_event_end(FRAME_TELEMETRY_CORE_RUN);
+   frame_telemetry_frame_end();
+
+   audio_driver_latency_auto_apply();
+
 #ifdef HAVE_CHEEVOS
    if (runloop_check_cheevos())
       cheevos_test();
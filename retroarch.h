@@ -355,12 +355,6 @@ bool retroarch_is_on_main_thread(void);
 
 rarch_system_info_t *runloop_get_system_info(void);
 
-#ifdef HAVE_THREADS
-void runloop_msg_queue_lock(void);
-
-void runloop_msg_queue_unlock(void);
-#endif
-
 #ifdef HAVE_DYNAMIC
 bool retroarch_core_set_on_cmdline(void);
 #endif
@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <boolean.h>
+
+#include <features/features_cpu.h>
+
+#include "../../../menu/menu_animation.h"
+
+#define BENCH_TWEENS 1000
+#define BENCH_ROUNDS 200
+
+/* The animation code only needs this much of the menu driver. */
+void menu_driver_invalidate(void)
+{
+}
+
+static float subjects[BENCH_TWEENS];
+static unsigned finished;
+
+static void bench_cb(void)
+{
+   finished++;
+}
+
+static void bench_report(const char *name, retro_time_t elapsed,
+      unsigned count)
+{
+   printf("%-24s %9.1f ms, %8.1f ns/op\n", name,
+         elapsed / 1000.0, elapsed * 1000.0 / count);
+}
+
+/* Roughly what XMB does on a tab switch: a few tags, mostly
+ * out-quad with some other curves mixed in. */
+static void bench_push(void)
+{
+   unsigned i;
+
+   for (i = 0; i < BENCH_TWEENS; i++)
+   {
+      menu_animation_ctx_entry_t entry;
+
+      subjects[i]        = 0.0f;
+
+      entry.easing_enum  = (i % 4) ? EASING_OUT_QUAD
+         : (enum menu_animation_easing_type)(i % EASING_LAST);
+      entry.tag          = i % 16;
+      entry.duration     = 200.0f + (i % 7) * 10.0f;
+      entry.target_value = 1.0f + i;
+      entry.subject      = &subjects[i];
+      entry.cb           = (i % 8) ? NULL : bench_cb;
+
+      menu_animation_push(&entry);
+   }
+}
+
+int main(void)
+{
+   unsigned round, i;
+   unsigned frames       = 0;
+   unsigned pushes       = 0;
+   unsigned kills        = 0;
+   retro_time_t t_push   = 0;
+   retro_time_t t_update = 0;
+   retro_time_t t_kill   = 0;
+   float dt              = 1000.0f / 60.0f;
+
+   printf("%u tweens, %u rounds\n", BENCH_TWEENS, BENCH_ROUNDS);
+
+   for (round = 0; round < BENCH_ROUNDS; round++)
+   {
+      retro_time_t start = cpu_features_get_time_usec();
+      bench_push();
+      t_push += cpu_features_get_time_usec() - start;
+      pushes += BENCH_TWEENS;
+
+      /* Run most of the tweens to completion... */
+      start = cpu_features_get_time_usec();
+      for (i = 0; i < 14; i++, frames++)
+         menu_animation_update(dt);
+      t_update += cpu_features_get_time_usec() - start;
+
+      /* ...then kill what is left tag by tag, like a new
+       * selection would. */
+      start = cpu_features_get_time_usec();
+      for (i = 0; i < 16; i++, kills++)
+      {
+         menu_animation_ctx_tag tag = i;
+         menu_animation_ctl(MENU_ANIMATION_CTL_KILL_BY_TAG, &tag);
+      }
+      t_kill += cpu_features_get_time_usec() - start;
+   }
+
+   bench_report("push",           t_push,   pushes);
+   bench_report("update (per tween)", t_update,
+         frames * BENCH_TWEENS);
+   bench_report("kill by tag",    t_kill,   kills);
+   printf("%u callbacks\n", finished);
+
+   menu_animation_ctl(MENU_ANIMATION_CTL_DEINIT, NULL);
+
+   return 0;
+}
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <boolean.h>
+
+#include <features/features_cpu.h>
+#include <streams/file_stream.h>
+
+#include "../../playlist.h"
+
+#define BENCH_ENTRIES 100000
+
+static void bench_report(const char *name, retro_time_t start,
+      unsigned count)
+{
+   retro_time_t elapsed = cpu_features_get_time_usec() - start;
+
+   printf("%-24s %9.1f ms, %8.3f us/op\n", name,
+         elapsed / 1000.0, (double)elapsed / count);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, found;
+   char path[64];
+   char crc[32];
+   char label[32];
+   retro_time_t start;
+   playlist_t *playlist = NULL;
+   const char *lpl      = argc > 1 ? argv[1] : "playlist_bench.lpl";
+
+   filestream_delete(lpl);
+
+   playlist = playlist_init(lpl, BENCH_ENTRIES);
+   if (!playlist)
+      return 1;
+
+   printf("%u entries\n", BENCH_ENTRIES);
+
+   /* What a content scan does for each match. */
+   start = cpu_features_get_time_usec();
+   for (i = 0; i < BENCH_ENTRIES; i++)
+   {
+      snprintf(path,  sizeof(path),  "/roms/system/game %06u.zip", i);
+      snprintf(crc,   sizeof(crc),   "%08X|crc", i * 2654435761u);
+      snprintf(label, sizeof(label), "Game %06u", i);
+
+      if (!playlist_entry_exists(playlist, path, crc))
+         playlist_push(playlist, path, label,
+               "DETECT", "DETECT", crc, "system.lpl");
+   }
+   bench_report("scan push", start, BENCH_ENTRIES);
+
+   start = cpu_features_get_time_usec();
+   for (i = 0, found = 0; i < BENCH_ENTRIES; i++)
+   {
+      snprintf(crc, sizeof(crc), "%08X|crc", i * 2654435761u);
+      found += playlist_get_index_by_crc32(playlist, crc, NULL);
+   }
+   bench_report("crc lookup", start, BENCH_ENTRIES);
+
+   /* Pushing an existing entry moves it to the top. */
+   start = cpu_features_get_time_usec();
+   for (i = 0; i < 1000; i++)
+   {
+      snprintf(path, sizeof(path), "/roms/system/game %06u.zip",
+            (i * 7919) % BENCH_ENTRIES);
+      playlist_push(playlist, path, NULL,
+            "DETECT", "DETECT", NULL, NULL);
+   }
+   bench_report("duplicate push", start, 1000);
+
+   for (i = 0; i < 2; i++)
+   {
+      bool binary = i == 1;
+
+      printf("%s format\n", binary ? "binary" : "text");
+      playlist_set_binary_format(binary);
+
+      /* Force a full write in the selected format. */
+      playlist_update(playlist, 0, NULL, "Renamed", NULL, NULL, NULL, NULL);
+
+      start = cpu_features_get_time_usec();
+      playlist_write_file(playlist);
+      bench_report("  write", start, BENCH_ENTRIES);
+      playlist_free(playlist);
+
+      start    = cpu_features_get_time_usec();
+      playlist = playlist_init(lpl, BENCH_ENTRIES);
+      bench_report("  read", start, BENCH_ENTRIES);
+
+      /* Binary playlists append single changes to a journal. */
+      playlist_push(playlist, "/roms/system/new.zip", "New",
+            "DETECT", "DETECT", NULL, NULL);
+      start = cpu_features_get_time_usec();
+      playlist_write_file(playlist);
+      bench_report("  write after push", start, 1);
+   }
+
+   printf("%u crc matches, %u entries read back\n",
+         found, (unsigned)playlist_size(playlist));
+
+   playlist_free(playlist);
+   filestream_delete(lpl);
+   return 0;
+}
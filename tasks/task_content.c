@@ -59,6 +59,10 @@
 #include <lists/string_list.h>
 #include <string/stdstring.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 #ifdef HAVE_MENU
 #include "../menu/menu_driver.h"
 #include "../menu/menu_shader.h"
@@ -95,15 +99,28 @@
 
 #define MAX_ARGS 32
 
+/* Content is read (and checksummed) in chunks of this size. */
+#define CONTENT_READ_CHUNK_SIZE (4 * 1024 * 1024)
+
+/* Files spanning at least this many chunks are read on a
+ * separate thread while the caller checksums behind it. */
+#define CONTENT_READ_AHEAD_CHUNKS 4
+
 typedef struct content_stream content_stream_t;
 typedef struct content_information_ctx content_information_ctx_t;
 
 struct content_stream
 {
-   uint32_t a;
-   const uint8_t *b;
-   size_t c;
-   uint32_t crc;
+   RFILE *file;
+   uint8_t *buf;
+   int64_t size;
+   int64_t pos;
+   bool done;
+   bool error;
+#ifdef HAVE_THREADS
+   slock_t *lock;
+   scond_t *cond;
+#endif
 };
 
 struct content_information_ctx
@@ -151,8 +168,199 @@ static char pending_subsystem_extensions[PATH_MAX_LENGTH];
 static char *pending_subsystem_roms[RARCH_MAX_SUBSYSTEM_ROMS];
 
 
-static int64_t content_file_read(const char *path, void **buf, int64_t *length)
+/* Reads the next chunk into stream->buf.
+ * Returns false once the stream is exhausted. */
+static bool content_stream_read_chunk(content_stream_t *stream)
+{
+   int64_t pos   = stream->pos;
+   int64_t chunk = MIN(stream->size - pos, CONTENT_READ_CHUNK_SIZE);
+   int64_t ret   = chunk > 0
+      ? filestream_read(stream->file, stream->buf + pos, chunk)
+      : 0;
+   bool error    = ret < 0;
+   bool done     = error || ret == 0 || pos + ret >= stream->size;
+
+   if (!error)
+      pos += ret;
+
+#ifdef HAVE_THREADS
+   if (stream->lock)
+      slock_lock(stream->lock);
+#endif
+   stream->pos   = pos;
+   stream->done  = done;
+   stream->error = error;
+#ifdef HAVE_THREADS
+   if (stream->lock)
+   {
+      scond_signal(stream->cond);
+      slock_unlock(stream->lock);
+   }
+#endif
+
+   return !done;
+}
+
+#ifdef HAVE_THREADS
+static void content_stream_thread(void *data)
+{
+   content_stream_t *stream = (content_stream_t*)data;
+
+   while (content_stream_read_chunk(stream));
+}
+
+/* Waits for the reader to get past @pos.
+ * Returns the number of bytes read so far. */
+static int64_t content_stream_wait(content_stream_t *stream, int64_t pos)
 {
+   int64_t avail;
+
+   slock_lock(stream->lock);
+   while (stream->pos <= pos && !stream->done)
+      scond_wait(stream->cond, stream->lock);
+   avail = stream->pos;
+   slock_unlock(stream->lock);
+
+   return avail;
+}
+#endif
+
+/**
+ * content_file_read_stream:
+ * @path         : path of the content file.
+ * @buf          : receives the content (NUL-terminated).
+ * @length       : receives the size of the content.
+ * @crc          : receives the CRC32 of the content, or NULL.
+ *
+ * Reads a file in chunks, checksumming each chunk while it is
+ * still in cache instead of in a second pass over the whole image.
+ * The file is memory mapped when the VFS supports it. Large files
+ * are read ahead on a separate thread so that I/O overlaps the CRC.
+ *
+ * Returns: true if successful, false on error.
+ **/
+static bool content_file_read_stream(const char *path,
+      void **buf, int64_t *length, uint32_t *crc)
+{
+   content_stream_t stream = {0};
+   int64_t crc_pos         = 0;
+   uint32_t crc_val        = 0;
+#ifdef HAVE_THREADS
+   sthread_t *thread       = NULL;
+#endif
+
+   stream.file = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_READ,
+         RETRO_VFS_FILE_ACCESS_HINT_FREQUENT_ACCESS);
+
+   if (!stream.file)
+      return false;
+
+   stream.size = filestream_get_size(stream.file);
+
+   if (stream.size < 0
+         || (int64_t)(size_t)(stream.size + 1) != stream.size + 1)
+      goto error;
+
+   stream.buf = (uint8_t*)malloc((size_t)(stream.size + 1));
+
+   if (!stream.buf)
+      goto error;
+
+#ifdef HAVE_THREADS
+   if (crc && stream.size >=
+         (int64_t)CONTENT_READ_AHEAD_CHUNKS * CONTENT_READ_CHUNK_SIZE)
+   {
+      stream.lock = slock_new();
+      stream.cond = scond_new();
+
+      if (stream.lock && stream.cond)
+         thread   = sthread_create(content_stream_thread, &stream);
+
+      /* Without a reader thread the chunks are read right here,
+       * which must not touch a half created lock/cond pair. */
+      if (!thread)
+      {
+         if (stream.cond)
+            scond_free(stream.cond);
+         if (stream.lock)
+            slock_free(stream.lock);
+         stream.cond = NULL;
+         stream.lock = NULL;
+      }
+   }
+
+   if (thread)
+   {
+      for (;;)
+      {
+         int64_t avail = content_stream_wait(&stream, crc_pos);
+
+         if (avail > crc_pos)
+         {
+            crc_val = encoding_crc32(crc_val,
+                  stream.buf + crc_pos, (size_t)(avail - crc_pos));
+            crc_pos = avail;
+         }
+         else
+            break;
+      }
+
+      sthread_join(thread);
+   }
+   else
+#endif
+   {
+      bool more = true;
+
+      while (more)
+      {
+         more = content_stream_read_chunk(&stream);
+
+         if (crc && stream.pos > crc_pos)
+         {
+            crc_val = encoding_crc32(crc_val,
+                  stream.buf + crc_pos, (size_t)(stream.pos - crc_pos));
+            crc_pos = stream.pos;
+         }
+      }
+   }
+
+#ifdef HAVE_THREADS
+   if (stream.cond)
+      scond_free(stream.cond);
+   if (stream.lock)
+      slock_free(stream.lock);
+#endif
+
+   filestream_close(stream.file);
+
+   if (stream.error)
+   {
+      free(stream.buf);
+      return false;
+   }
+
+   /* Allow for easy reading of strings, as filestream_read_file does. */
+   stream.buf[stream.pos] = '\0';
+
+   *buf    = stream.buf;
+   *length = stream.pos;
+   if (crc)
+      *crc = crc_val;
+
+   return true;
+
+error:
+   filestream_close(stream.file);
+   free(stream.buf);
+   return false;
+}
+
+static int64_t content_file_read(const char *path, void **buf,
+      int64_t *length, uint32_t *crc, bool *has_crc)
+{
+   *has_crc = false;
 #ifdef HAVE_COMPRESSION
    if (path_contains_compressed_file(path))
    {
@@ -160,7 +368,10 @@ static int64_t content_file_read(const char *path, void **buf, int64_t *length)
          return 1;
    }
 #endif
-   return filestream_read_file(path, buf, length);
+   if (!content_file_read_stream(path, buf, length, crc))
+      return 0;
+   *has_crc = crc != NULL;
+   return 1;
 }
 
 /**
@@ -327,11 +538,17 @@ static bool load_content_into_memory(
       int64_t *length)
 {
    uint8_t *ret_buf          = NULL;
+   uint32_t crc              = 0;
+   bool has_crc              = false;
+   /* If we have a media type, ignore CRC32 calculation. */
+   bool want_crc             = i == 0
+      && path_is_media_type(path) == RARCH_CONTENT_NONE;
 
    RARCH_LOG("%s: %s.\n",
          msg_hash_to_str(MSG_LOADING_CONTENT_FILE), path);
 
-   if (!content_file_read(path, (void**) &ret_buf, length))
+   if (!content_file_read(path, (void**) &ret_buf, length,
+            want_crc ? &crc : NULL, &has_crc))
       return false;
 
    if (*length < 0)
@@ -339,17 +556,22 @@ static bool load_content_into_memory(
 
    if (i == 0)
    {
-      enum rarch_content_type type = path_is_media_type(path);
-
-      /* If we have a media type, ignore CRC32 calculation. */
-      if (type == RARCH_CONTENT_NONE)
+      if (want_crc)
       {
+         struct patch_checksum checksum;
+
+         checksum.source     = crc;
+         checksum.target     = 0;
+         checksum.has_source = has_crc;
+         checksum.patched    = false;
+
          /* First content file is significant, attempt to do patching,
           * CRC checking, etc. */
 
-         /* Attempt to apply a patch. */
-         if (!content_ctx->patch_is_blocked)
-            patch_content(
+         /* Attempt to apply a patch. The patchers verify the
+          * checksum of their output, which becomes the content CRC. */
+         if (!content_ctx->patch_is_blocked
+               && patch_content(
                   content_ctx->is_ips_pref,
                   content_ctx->is_bps_pref,
                   content_ctx->is_ups_pref,
@@ -357,9 +579,13 @@ static bool load_content_into_memory(
                   content_ctx->name_bps,
                   content_ctx->name_ups,
                   (uint8_t**)&ret_buf,
-                  (void*)length);
-
-         content_rom_crc = encoding_crc32(0, ret_buf, (size_t)*length);
+                  (void*)length,
+                  &checksum))
+            content_rom_crc = checksum.target;
+         else if (has_crc)
+            content_rom_crc = crc;
+         else
+            content_rom_crc = encoding_crc32(0, ret_buf, (size_t)*length);
 
          RARCH_LOG("CRC32: 0x%x .\n", (unsigned)content_rom_crc);
       }
@@ -43,6 +43,19 @@
 #define COLLECTION_SIZE                99999
 #endif
 
+/* Matches pushed between writes of the open playlists. */
+#ifndef DATABASE_PLAYLIST_WRITE_INTERVAL
+#define DATABASE_PLAYLIST_WRITE_INTERVAL 256
+#endif
+
+/* A playlist open for the scan and the matches pushed to the
+ * top of it since it was last written. */
+typedef struct database_playlist
+{
+   playlist_t *playlist;
+   size_t pushed;
+} database_playlist_t;
+
 typedef struct database_state_handle
 {
    uint32_t crc;
@@ -67,6 +80,9 @@ typedef struct db_handle
    char *fullpath;
    database_info_handle_t *handle;
    database_state_handle_t state;
+   database_playlist_t *playlists;
+   size_t playlists_count;
+   unsigned playlists_pending;
 } db_handle_t;
 
 int cue_find_track(const char *cue_path, bool first,
@@ -761,6 +777,125 @@ static int database_info_list_iterate_new(database_state_handle_t *db_state,
    return 0;
 }
 
+/* Playlists stay open for the whole scan, so that each match is
+ * a lookup in memory instead of a read and rewrite of the file. */
+static playlist_t *task_database_get_playlist(db_handle_t *_db,
+      const char *path)
+{
+   size_t i;
+   database_playlist_t *playlists = NULL;
+   playlist_t *playlist           = NULL;
+
+   for (i = 0; i < _db->playlists_count; i++)
+      if (string_is_equal(
+               playlist_get_conf_path(_db->playlists[i].playlist), path))
+         return _db->playlists[i].playlist;
+
+   playlist  = playlist_init(path, COLLECTION_SIZE);
+   if (!playlist)
+      return NULL;
+
+   playlists = (database_playlist_t*)realloc(_db->playlists,
+         (_db->playlists_count + 1) * sizeof(*playlists));
+   if (!playlists)
+   {
+      playlist_free(playlist);
+      return NULL;
+   }
+
+   playlists[_db->playlists_count].playlist = playlist;
+   playlists[_db->playlists_count].pushed   = 0;
+   _db->playlists_count++;
+   _db->playlists                           = playlists;
+   return playlist;
+}
+
+/* The menu may have changed the file since the scan read it,
+ * so the matches are pushed onto a fresh copy of the file and
+ * that is written instead. It also replaces the open copy, so
+ * that later matches see the edits. */
+static void task_database_write_playlist(database_playlist_t *db_playlist)
+{
+   size_t i;
+   playlist_t *playlist = NULL;
+   size_t pushed        = db_playlist->pushed;
+
+   if (!pushed)
+      return;
+
+   db_playlist->pushed = 0;
+   playlist            = playlist_init(
+         playlist_get_conf_path(db_playlist->playlist), COLLECTION_SIZE);
+
+   if (!playlist)
+   {
+      playlist_write_file(db_playlist->playlist);
+      return;
+   }
+
+   if (pushed > playlist_size(db_playlist->playlist))
+      pushed = playlist_size(db_playlist->playlist);
+
+   /* Oldest first, so that they keep their order on top */
+   for (i = pushed; i-- > 0; )
+   {
+      const char *path      = NULL;
+      const char *label     = NULL;
+      const char *core_path = NULL;
+      const char *core_name = NULL;
+      const char *crc32     = NULL;
+      const char *db_name   = NULL;
+
+      playlist_get_index(db_playlist->playlist, i, &path, &label,
+            &core_path, &core_name, &crc32, &db_name);
+
+      if (!playlist_entry_exists(playlist, path, crc32))
+         playlist_push(playlist, path, label,
+               core_path, core_name, crc32, db_name);
+   }
+
+   playlist_write_file(playlist);
+   playlist_free(db_playlist->playlist);
+   db_playlist->playlist = playlist;
+}
+
+static void task_database_write_playlists(db_handle_t *_db)
+{
+   size_t i;
+
+   for (i = 0; i < _db->playlists_count; i++)
+      task_database_write_playlist(&_db->playlists[i]);
+
+   _db->playlists_pending = 0;
+}
+
+static void task_database_playlist_pushed(db_handle_t *_db,
+      playlist_t *playlist)
+{
+   size_t i;
+
+   for (i = 0; i < _db->playlists_count; i++)
+      if (_db->playlists[i].playlist == playlist)
+         _db->playlists[i].pushed++;
+
+   if (++_db->playlists_pending >= DATABASE_PLAYLIST_WRITE_INTERVAL)
+      task_database_write_playlists(_db);
+}
+
+static void task_database_free_playlists(db_handle_t *_db)
+{
+   size_t i;
+
+   task_database_write_playlists(_db);
+
+   for (i = 0; i < _db->playlists_count; i++)
+      playlist_free(_db->playlists[i].playlist);
+
+   free(_db->playlists);
+   _db->playlists       = NULL;
+   _db->playlists_count = 0;
+}
+
 static int database_info_list_iterate_found_match(
       db_handle_t *_db,
       database_state_handle_t *db_state,
@@ -797,7 +932,7 @@ static int database_info_list_iterate_found_match(
       fill_pathname_join(db_playlist_path, _db->playlist_directory,
             db_playlist_base_str, PATH_MAX_LENGTH * sizeof(char));
 
-   playlist = playlist_init(db_playlist_path, COLLECTION_SIZE);
+   playlist = task_database_get_playlist(_db, db_playlist_path);
 
    snprintf(db_crc, PATH_MAX_LENGTH * sizeof(char),
          "%08X|crc", db_info_entry->crc32);
@@ -841,16 +976,14 @@ static int database_info_list_iterate_found_match(
 
    if(!playlist_entry_exists(playlist, entry_path_str, db_crc))
    {
-      playlist_push(playlist, entry_path_str,
+      if (playlist_push(playlist, entry_path_str,
             db_info_entry->name,
             file_path_str(FILE_PATH_DETECT),
             file_path_str(FILE_PATH_DETECT),
-            db_crc, db_playlist_base_str);
+            db_crc, db_playlist_base_str))
+         task_database_playlist_pushed(_db, playlist);
    }
 
-   playlist_write_file(playlist);
-   playlist_free(playlist);
-
    database_info_list_free(db_state->info);
    free(db_state->info);
 
@@ -1001,7 +1134,7 @@ static int task_database_iterate_playlist_lutro(
             file_path_str(FILE_PATH_LUTRO_PLAYLIST),
             PATH_MAX_LENGTH * sizeof(char));
 
-   playlist = playlist_init(db_playlist_path, COLLECTION_SIZE);
+   playlist = task_database_get_playlist(_db, db_playlist_path);
 
    free(db_playlist_path);
 
@@ -1015,19 +1148,17 @@ static int task_database_iterate_playlist_lutro(
       fill_short_pathname_representation_noext(game_title,
             path, PATH_MAX_LENGTH * sizeof(char));
 
-      playlist_push(playlist, path,
+      if (playlist_push(playlist, path,
             game_title,
             file_path_str(FILE_PATH_DETECT),
             file_path_str(FILE_PATH_DETECT),
             file_path_str(FILE_PATH_DETECT),
-            file_path_str(FILE_PATH_LUTRO_PLAYLIST));
+            file_path_str(FILE_PATH_LUTRO_PLAYLIST)))
+         task_database_playlist_pushed(_db, playlist);
 
       free(game_title);
    }
 
-   playlist_write_file(playlist);
-   playlist_free(playlist);
-
    return 0;
 }
 
@@ -1255,6 +1386,7 @@ static void task_database_handler(retro_task_t *task)
          else
          {
             const char *msg = NULL;
+            task_database_write_playlists(db);
             if (db->is_directory)
                msg = msg_hash_to_str(MSG_SCANNING_OF_DIRECTORY_FINISHED);
             else
@@ -1287,6 +1419,8 @@ task_finished:
 
    if (db)
    {
+      task_database_free_playlists(db);
+
       if (!string_is_empty(db->playlist_directory))
          free(db->playlist_directory);
       if (!string_is_empty(db->content_database_path))
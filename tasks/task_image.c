@@ -155,8 +155,13 @@ static void task_image_cleanup(nbio_handle_t *nbio)
    {
       image_transfer_free(image->handle, image->type);
 
+      /* Still set if the task was cancelled after decoding began. */
+      if (image->ti.pixels)
+         free(image->ti.pixels);
+
       image->handle                 = NULL;
       image->cb                     = NULL;
+      image->ti.pixels              = NULL;
    }
    if (!string_is_empty(nbio->path))
       free(nbio->path);
@@ -276,6 +281,8 @@ bool task_image_load_handler(retro_task_t *task)
          img->height        = image->ti.height;
          img->pixels        = image->ti.pixels;
          img->supports_rgba = image->ti.supports_rgba;
+
+         image->ti.pixels   = NULL;
       }
 
       task_set_data(task, img);
@@ -286,7 +293,8 @@ bool task_image_load_handler(retro_task_t *task)
    return true;
 }
 
-bool task_push_image_load(const char *fullpath, retro_task_callback_t cb, void *user_data)
+static retro_task_t *task_image_load_push(const char *fullpath,
+      retro_task_callback_t cb, void *user_data)
 {
    nbio_handle_t             *nbio   = NULL;
    struct nbio_image_handle   *image = NULL;
@@ -366,7 +374,7 @@ bool task_push_image_load(const char *fullpath, retro_task_callback_t cb, void *
 
    task_queue_push(t);
 
-   return true;
+   return t;
 
 error:
    task_image_load_free(t);
@@ -382,5 +390,16 @@ error_msg:
    RARCH_ERR("[image load] Failed to open '%s': %s.\n",
          fullpath, strerror(errno));
 
-   return false;
+   return NULL;
+}
+
+bool task_push_image_load(const char *fullpath, retro_task_callback_t cb, void *user_data)
+{
+   return task_image_load_push(fullpath, cb, user_data) != NULL;
+}
+
+void *task_push_image_load_cancellable(const char *fullpath,
+      retro_task_callback_t cb, void *user_data)
+{
+   return task_image_load_push(fullpath, cb, user_data);
 }
@@ -174,42 +174,37 @@ static void task_netplay_crc_scan_handler(retro_task_t *task)
          }
          for (i = 0; i < state->lpl_list->size; i++)
          {
+            size_t idx;
             playlist_t *playlist = NULL;
-            unsigned playlist_size = 0;
             const char *lpl_path = state->lpl_list->elems[i].data;
 
             if (!strstr(lpl_path, file_path_str(FILE_PATH_LPL_EXTENSION)))
                continue;
 
             playlist      = playlist_init(lpl_path, 99999);
-            playlist_size = playlist_get_size(playlist);
 
-            for (j = 0; j < playlist_size; j++)
+            if (playlist_get_index_by_crc32(playlist,
+                     state->content_crc, &idx))
             {
-               const char *playlist_crc32    = NULL;
                const char *playlist_path     = NULL;
                playlist_get_index(playlist,
-                     j, &playlist_path, NULL, NULL, NULL, NULL, &playlist_crc32);
-
-               if (string_is_equal(playlist_crc32, state->content_crc))
-               {
-                  RARCH_LOG("[lobby] CRC match %s\n", playlist_crc32);
-                  strlcpy(state->content_path, playlist_path, sizeof(state->content_path));
-                  state->found = true;
-                  task_set_data(task, state);
-                  task_set_progress(task, 100);
-                  task_free_title(task);
-                  task_set_title(task, strdup(msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NETPLAY_COMPAT_CONTENT_FOUND)));
-                  task_set_finished(task, true);
-                  string_list_free(state->lpl_list);
-                  free(playlist);
-                  return;
-               }
-
-               task_set_progress(task, (int)(j / playlist_size * 100.0));
+                     idx, &playlist_path, NULL, NULL, NULL, NULL, NULL);
+
+               RARCH_LOG("[lobby] CRC match %s\n", state->content_crc);
+               strlcpy(state->content_path, playlist_path, sizeof(state->content_path));
+               state->found = true;
+               task_set_data(task, state);
+               task_set_progress(task, 100);
+               task_free_title(task);
+               task_set_title(task, strdup(msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NETPLAY_COMPAT_CONTENT_FOUND)));
+               task_set_finished(task, true);
+               string_list_free(state->lpl_list);
+               playlist_free(playlist);
+               return;
             }
 
-            free(playlist);
+            task_set_progress(task, (int)(i * 100.0 / state->lpl_list->size));
+            playlist_free(playlist);
          }
          /* CRC matching failed, goto filename matching */
          if (!state->found)
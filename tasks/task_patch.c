@@ -69,9 +69,6 @@ struct bps_data
    size_t modify_offset;
    size_t source_offset;
    size_t target_offset;
-   uint32_t modify_checksum;
-   uint32_t source_checksum;
-   uint32_t target_checksum;
    size_t source_relative_offset;
    size_t target_relative_offset;
    size_t output_offset;
@@ -88,20 +85,47 @@ struct ups_data
    unsigned patch_offset;
    unsigned source_offset;
    unsigned target_offset;
-   unsigned patch_checksum;
-   unsigned source_checksum;
-   unsigned target_checksum;
+};
+
+/* CRC32s shared between the content loader and the patchers.
+ * A source CRC that was already taken while reading the content
+ * spares the patcher a pass, and the target CRC a patcher verifies
+ * doubles as the CRC of the patched content. */
+struct patch_checksum
+{
+   uint32_t source;
+   uint32_t target;
+   bool has_source;
+   bool patched;
 };
 
 typedef enum patch_error (*patch_func_t)(const uint8_t*, uint64_t,
-      const uint8_t*, uint64_t, uint8_t*, uint64_t*);
+      const uint8_t*, uint64_t, uint8_t*, uint64_t*,
+      struct patch_checksum*);
+
+/* Returns the size of the patched content without applying the patch. */
+typedef enum patch_error (*patch_size_func_t)(const uint8_t*, uint64_t,
+      uint64_t, uint64_t*);
+
+static uint32_t patch_source_checksum(const struct patch_checksum *checksum,
+      const uint8_t *source_data, uint64_t source_length)
+{
+   if (checksum->has_source)
+      return checksum->source;
+   return encoding_crc32(0, source_data, (size_t)source_length);
+}
+
+static uint32_t patch_read_le32(const uint8_t *data)
+{
+   return  (uint32_t)data[0]        | ((uint32_t)data[1] << 8)
+         | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
 
 static uint8_t bps_read(struct bps_data *bps)
 {
-   uint8_t data         = bps->modify_data[bps->modify_offset++];
-   bps->modify_checksum = ~(encoding_crc32(
-         ~bps->modify_checksum, &data, 1));
-   return data;
+   if (bps->modify_offset < bps->modify_length)
+      return bps->modify_data[bps->modify_offset++];
+   return 0x00;
 }
 
 static uint64_t bps_decode(struct bps_data *bps)
@@ -112,7 +136,7 @@ static uint64_t bps_decode(struct bps_data *bps)
    {
       uint8_t x  = bps_read(bps);
       data      += (x & 0x7f) * shift;
-      if (x & 0x80)
+      if ((x & 0x80) || bps->modify_offset >= bps->modify_length)
          break;
       shift    <<= 7;
       data      += shift;
@@ -121,81 +145,114 @@ static uint64_t bps_decode(struct bps_data *bps)
    return data;
 }
 
-static void bps_write(struct bps_data *bps, uint8_t data)
+static enum patch_error bps_read_header(struct bps_data *bps,
+      uint64_t *source_size, uint64_t *target_size)
 {
-   bps->target_data[bps->output_offset++] = data;
-   bps->target_checksum = ~(encoding_crc32(~bps->target_checksum, &data, 1));
+   uint64_t markup_size;
+
+   if (bps->modify_length < 19)
+      return PATCH_PATCH_TOO_SMALL;
+
+   if (  (bps_read(bps) != 'B') ||
+         (bps_read(bps) != 'P') ||
+         (bps_read(bps) != 'S') ||
+         (bps_read(bps) != '1'))
+      return PATCH_PATCH_INVALID_HEADER;
+
+   *source_size  = bps_decode(bps);
+   *target_size  = bps_decode(bps);
+   markup_size   = bps_decode(bps);
+
+   if (     bps->modify_offset > bps->modify_length - 12
+         || markup_size > bps->modify_length - 12 - bps->modify_offset)
+      return PATCH_PATCH_INVALID;
+
+   bps->modify_offset += (size_t)markup_size;
+
+   return PATCH_SUCCESS;
+}
+
+static enum patch_error bps_target_size(
+      const uint8_t *modify_data, uint64_t modify_length,
+      uint64_t source_length, uint64_t *target_length)
+{
+   uint64_t source_size;
+   struct bps_data bps = {0};
+
+   bps.modify_data     = modify_data;
+   bps.modify_length   = (size_t)modify_length;
+
+   return bps_read_header(&bps, &source_size, target_length);
 }
 
 static enum patch_error bps_apply_patch(
       const uint8_t *modify_data, uint64_t modify_length,
       const uint8_t *source_data, uint64_t source_length,
-      uint8_t *target_data, uint64_t *target_length)
+      uint8_t *target_data, uint64_t *target_length,
+      struct patch_checksum *checksum)
 {
-   size_t i;
-   uint32_t checksum;
-   size_t modify_source_size;
-   size_t modify_target_size;
-   size_t modify_markup_size;
+   enum patch_error err;
+   uint64_t modify_source_size;
+   uint64_t modify_target_size;
+   size_t end;
    struct bps_data bps;
    uint32_t modify_source_checksum = 0;
    uint32_t modify_target_checksum = 0;
    uint32_t modify_modify_checksum = 0;
 
-   if (modify_length < 19)
-      return PATCH_PATCH_TOO_SMALL;
-
    bps.modify_data            = modify_data;
    bps.source_data            = source_data;
    bps.target_data            = target_data;
-   bps.modify_length          = modify_length;
-   bps.source_length          = source_length;
-   bps.target_length          = *target_length;
+   bps.modify_length          = (size_t)modify_length;
+   bps.source_length          = (size_t)source_length;
+   bps.target_length          = (size_t)*target_length;
    bps.modify_offset          = 0;
    bps.source_offset          = 0;
    bps.target_offset          = 0;
-   bps.modify_checksum        = ~0;
-   bps.source_checksum        = 0;
-   bps.target_checksum        = ~0;
    bps.source_relative_offset = 0;
    bps.target_relative_offset = 0;
    bps.output_offset          = 0;
 
-   if (  (bps_read(&bps) != 'B') ||
-         (bps_read(&bps) != 'P') ||
-         (bps_read(&bps) != 'S') ||
-         (bps_read(&bps) != '1'))
-      return PATCH_PATCH_INVALID_HEADER;
-
-   modify_source_size  = bps_decode(&bps);
-   modify_target_size  = bps_decode(&bps);
-   modify_markup_size  = bps_decode(&bps);
-
-   for (i = 0; i < modify_markup_size; i++)
-      bps_read(&bps);
+   err = bps_read_header(&bps, &modify_source_size, &modify_target_size);
+   if (err != PATCH_SUCCESS)
+      return err;
 
    if (modify_source_size > bps.source_length)
       return PATCH_SOURCE_TOO_SMALL;
    if (modify_target_size > bps.target_length)
       return PATCH_TARGET_TOO_SMALL;
 
-   while (bps.modify_offset < bps.modify_length - 12)
+   end = bps.modify_length - 12;
+
+   /* Copy whole runs instead of going byte by byte;
+    * checksums are taken afterwards in a single call each. */
+   while (bps.modify_offset < end)
    {
-      size_t length = bps_decode(&bps);
+      size_t length = (size_t)bps_decode(&bps);
       unsigned mode = length & 3;
 
       length = (length >> 2) + 1;
 
+      if (length > bps.target_length - bps.output_offset)
+         return PATCH_TARGET_TOO_SMALL;
+
       switch (mode)
       {
          case SOURCE_READ:
-            while (length--)
-               bps_write(&bps, bps.source_data[bps.output_offset]);
+            if (bps.output_offset + length > bps.source_length)
+               return PATCH_SOURCE_TOO_SMALL;
+            memcpy(bps.target_data + bps.output_offset,
+                  bps.source_data + bps.output_offset, length);
+            bps.output_offset += length;
             break;
 
          case TARGET_READ:
-            while (length--)
-               bps_write(&bps, bps_read(&bps));
+            if (length > end - bps.modify_offset)
+               return PATCH_PATCH_INVALID;
+            memcpy(bps.target_data + bps.output_offset,
+                  bps.modify_data + bps.modify_offset, length);
+            bps.modify_offset += length;
+            bps.output_offset += length;
             break;
 
          case SOURCE_COPY:
@@ -212,41 +269,47 @@ static enum patch_error bps_apply_patch(
             if (mode == SOURCE_COPY)
             {
                bps.source_offset += offset;
-               while (length--)
-                  bps_write(&bps, bps.source_data[bps.source_offset++]);
+               if (     bps.source_offset > bps.source_length
+                     || length > bps.source_length - bps.source_offset)
+                  return PATCH_SOURCE_TOO_SMALL;
+               memcpy(bps.target_data + bps.output_offset,
+                     bps.source_data + bps.source_offset, length);
+               bps.source_offset += length;
+               bps.output_offset += length;
             }
             else
             {
                bps.target_offset += offset;
+               if (bps.target_offset >= bps.output_offset)
+                  return PATCH_TARGET_INVALID;
+               /* May overlap the bytes being written, so that
+                * short runs repeat; this has to stay bytewise. */
                while (length--)
-                  bps_write(&bps, bps.target_data[bps.target_offset++]);
-               break;
+                  bps.target_data[bps.output_offset++] =
+                     bps.target_data[bps.target_offset++];
             }
             break;
          }
       }
    }
 
-   for (i = 0; i < 32; i += 8)
-      modify_source_checksum |= bps_read(&bps) << i;
-   for (i = 0; i < 32; i += 8)
-      modify_target_checksum |= bps_read(&bps) << i;
-
-   checksum = ~bps.modify_checksum;
-   for (i = 0; i < 32; i += 8)
-      modify_modify_checksum |= bps_read(&bps) << i;
+   if (bps.modify_offset != end)
+      return PATCH_PATCH_INVALID;
 
-   bps.source_checksum = encoding_crc32(0,
-         bps.source_data, bps.source_length);
-   bps.target_checksum = ~bps.target_checksum;
+   modify_source_checksum = patch_read_le32(bps.modify_data + end);
+   modify_target_checksum = patch_read_le32(bps.modify_data + end + 4);
+   modify_modify_checksum = patch_read_le32(bps.modify_data + end + 8);
 
-   if (bps.source_checksum != modify_source_checksum)
+   if (patch_source_checksum(checksum, bps.source_data, bps.source_length)
+         != modify_source_checksum)
       return PATCH_SOURCE_CHECKSUM_INVALID;
 
-   if (bps.target_checksum != modify_target_checksum)
+   checksum->target = encoding_crc32(0, bps.target_data, bps.output_offset);
+
+   if (checksum->target != modify_target_checksum)
       return PATCH_TARGET_CHECKSUM_INVALID;
 
-   if (checksum != modify_modify_checksum)
+   if (encoding_crc32(0, bps.modify_data, end + 8) != modify_modify_checksum)
       return PATCH_PATCH_CHECKSUM_INVALID;
 
    *target_length = modify_target_size;
@@ -257,24 +320,14 @@ static enum patch_error bps_apply_patch(
 static uint8_t ups_patch_read(struct ups_data *data)
 {
    if (data && data->patch_offset < data->patch_length)
-   {
-      uint8_t n = data->patch_data[data->patch_offset++];
-      data->patch_checksum =
-         ~(encoding_crc32(~data->patch_checksum, &n, 1));
-      return n;
-   }
+      return data->patch_data[data->patch_offset++];
    return 0x00;
 }
 
 static uint8_t ups_source_read(struct ups_data *data)
 {
    if (data && data->source_offset < data->source_length)
-   {
-      uint8_t n = data->source_data[data->source_offset++];
-      data->source_checksum =
-         ~(encoding_crc32(~data->source_checksum, &n, 1));
-      return n;
-   }
+      return data->source_data[data->source_offset++];
    return 0x00;
 }
 
@@ -282,16 +335,46 @@ static void ups_target_write(struct ups_data *data, uint8_t n)
 {
 
    if (data && data->target_offset < data->target_length)
-   {
       data->target_data[data->target_offset] = n;
-      data->target_checksum =
-         ~(encoding_crc32(~data->target_checksum, &n, 1));
-   }
 
    if (data)
       data->target_offset++;
 }
 
+/* Copies @length source bytes to the target a run at a time, with
+ * the same result as that many ups_target_write(ups_source_read()). */
+static void ups_copy(struct ups_data *data, uint64_t length)
+{
+   while (length)
+   {
+      uint64_t n        = length;
+      unsigned src_left = data->source_offset < data->source_length
+         ? data->source_length - data->source_offset : 0;
+      unsigned dst_left = data->target_offset < data->target_length
+         ? data->target_length - data->target_offset : 0;
+
+      if (src_left && n > src_left)
+         n = src_left;
+      if (dst_left && n > dst_left)
+         n = dst_left;
+
+      if (dst_left)
+      {
+         /* Reads past the end of the source yield zero. */
+         if (src_left)
+            memcpy(data->target_data + data->target_offset,
+                  data->source_data + data->source_offset, (size_t)n);
+         else
+            memset(data->target_data + data->target_offset, 0, (size_t)n);
+      }
+
+      if (src_left)
+         data->source_offset += (unsigned)n;
+      data->target_offset    += (unsigned)n;
+      length                 -= n;
+   }
+}
+
 static uint64_t ups_decode(struct ups_data *data)
 {
    uint64_t offset = 0, shift = 1;
@@ -300,7 +383,7 @@ static uint64_t ups_decode(struct ups_data *data)
       uint8_t x = ups_patch_read(data);
       offset   += (x & 0x7f) * shift;
 
-      if (x & 0x80)
+      if ((x & 0x80) || data->patch_offset >= data->patch_length)
          break;
       shift <<= 7;
       offset += shift;
@@ -308,16 +391,63 @@ static uint64_t ups_decode(struct ups_data *data)
    return offset;
 }
 
+static enum patch_error ups_read_header(struct ups_data *data,
+      unsigned *source_read_length, unsigned *target_read_length,
+      uint64_t *targetlength)
+{
+   if (data->patch_length < 18)
+      return PATCH_PATCH_INVALID;
+
+   if (
+         (ups_patch_read(data) != 'U') ||
+         (ups_patch_read(data) != 'P') ||
+         (ups_patch_read(data) != 'S') ||
+         (ups_patch_read(data) != '1')
+      )
+      return PATCH_PATCH_INVALID;
+
+   *source_read_length = (unsigned)ups_decode(data);
+   *target_read_length = (unsigned)ups_decode(data);
+
+   if (     (data->source_length != *source_read_length)
+         && (data->source_length != *target_read_length))
+      return PATCH_SOURCE_INVALID;
+
+   *targetlength = (data->source_length == *source_read_length ?
+         *target_read_length : *source_read_length);
+
+   return PATCH_SUCCESS;
+}
+
+static enum patch_error ups_target_size(
+      const uint8_t *patchdata, uint64_t patchlength,
+      uint64_t sourcelength, uint64_t *targetlength)
+{
+   unsigned source_read_length;
+   unsigned target_read_length;
+   struct ups_data data = {0};
+
+   data.patch_data      = patchdata;
+   data.patch_length    = (unsigned)patchlength;
+   data.source_length   = (unsigned)sourcelength;
+
+   return ups_read_header(&data, &source_read_length,
+         &target_read_length, targetlength);
+}
+
 static enum patch_error ups_apply_patch(
       const uint8_t *patchdata, uint64_t patchlength,
       const uint8_t *sourcedata, uint64_t sourcelength,
-      uint8_t *targetdata, uint64_t *targetlength)
+      uint8_t *targetdata, uint64_t *targetlength,
+      struct patch_checksum *checksum)
 {
-   size_t i;
+   enum patch_error err;
+   unsigned end;
    struct ups_data data;
    unsigned source_read_length;
    unsigned target_read_length;
-   uint32_t patch_result_checksum;
+   uint32_t source_checksum;
+   uint32_t target_checksum;
    uint32_t patch_read_checksum  = 0;
    uint32_t source_read_checksum = 0;
    uint32_t target_read_checksum = 0;
@@ -331,41 +461,21 @@ static enum patch_error ups_apply_patch(
    data.patch_offset    = 0;
    data.source_offset   = 0;
    data.target_offset   = 0;
-   data.patch_checksum  = ~0;
-   data.source_checksum = ~0;
-   data.target_checksum = ~0;
-
-   if (data.patch_length < 18)
-      return PATCH_PATCH_INVALID;
-
-   if (
-         (ups_patch_read(&data) != 'U') ||
-         (ups_patch_read(&data) != 'P') ||
-         (ups_patch_read(&data) != 'S') ||
-         (ups_patch_read(&data) != '1')
-      )
-      return PATCH_PATCH_INVALID;
-
-   source_read_length = (unsigned)ups_decode(&data);
-   target_read_length = (unsigned)ups_decode(&data);
-
-   if (     (data.source_length != source_read_length)
-         && (data.source_length != target_read_length))
-      return PATCH_SOURCE_INVALID;
 
-   *targetlength = (data.source_length == source_read_length ?
-         target_read_length : source_read_length);
+   err = ups_read_header(&data, &source_read_length,
+         &target_read_length, targetlength);
+   if (err != PATCH_SUCCESS)
+      return err;
 
    if (data.target_length < *targetlength)
       return PATCH_TARGET_TOO_SMALL;
 
    data.target_length = (unsigned)*targetlength;
+   end                = data.patch_length - 12;
 
-   while (data.patch_offset < data.patch_length - 12)
+   while (data.patch_offset < end)
    {
-      unsigned length = (unsigned)ups_decode(&data);
-      while (length--)
-         ups_target_write(&data, ups_source_read(&data));
+      ups_copy(&data, ups_decode(&data));
       while (true)
       {
          uint8_t patch_xor = ups_patch_read(&data);
@@ -375,39 +485,39 @@ static enum patch_error ups_apply_patch(
       }
    }
 
-   while (data.source_offset < data.source_length)
-      ups_target_write(&data, ups_source_read(&data));
-   while (data.target_offset < data.target_length)
-      ups_target_write(&data, ups_source_read(&data));
-
-
-   for (i = 0; i < 4; i++)
-      source_read_checksum |= ups_patch_read(&data) << (i * 8);
-   for (i = 0; i < 4; i++)
-      target_read_checksum |= ups_patch_read(&data) << (i * 8);
+   if (data.patch_offset != end)
+      return PATCH_PATCH_INVALID;
 
-   patch_result_checksum = ~data.patch_checksum;
-   data.source_checksum  = ~data.source_checksum;
-   data.target_checksum  = ~data.target_checksum;
+   if (data.source_offset < data.source_length)
+      ups_copy(&data, data.source_length - data.source_offset);
+   if (data.target_offset < data.target_length)
+      ups_copy(&data, data.target_length - data.target_offset);
 
-   for (i = 0; i < 4; i++)
-      patch_read_checksum |= ups_patch_read(&data) << (i * 8);
+   source_read_checksum = patch_read_le32(data.patch_data + end);
+   target_read_checksum = patch_read_le32(data.patch_data + end + 4);
+   patch_read_checksum  = patch_read_le32(data.patch_data + end + 8);
 
-   if (patch_result_checksum != patch_read_checksum)
+   if (encoding_crc32(0, data.patch_data, end + 8) != patch_read_checksum)
       return PATCH_PATCH_INVALID;
 
-   if (data.source_checksum == source_read_checksum
+   source_checksum  = patch_source_checksum(checksum,
+         data.source_data, data.source_length);
+   target_checksum  = encoding_crc32(0,
+         data.target_data, data.target_length);
+   checksum->target = target_checksum;
+
+   if (source_checksum == source_read_checksum
          && data.source_length == source_read_length)
    {
-      if (data.target_checksum == target_read_checksum
+      if (target_checksum == target_read_checksum
             && data.target_length == target_read_length)
          return PATCH_SUCCESS;
       return PATCH_TARGET_INVALID;
    }
-   else if (data.source_checksum == target_read_checksum
+   else if (source_checksum == target_read_checksum
          && data.source_length == target_read_length)
    {
-      if (data.target_checksum == source_read_checksum
+      if (target_checksum == source_read_checksum
             && data.target_length == source_read_length)
          return PATCH_SUCCESS;
       return PATCH_TARGET_INVALID;
@@ -416,10 +526,12 @@ static enum patch_error ups_apply_patch(
    return PATCH_SOURCE_INVALID;
 }
 
-static enum patch_error ips_apply_patch(
+/* Walks every IPS record without writing anything, so that a patch
+ * that passes can be applied in place without leaving the content
+ * half patched. */
+static enum patch_error ips_target_size(
       const uint8_t *patchdata, uint64_t patchlen,
-      const uint8_t *sourcedata, uint64_t sourcelength,
-      uint8_t *targetdata, uint64_t *targetlength)
+      uint64_t sourcelength, uint64_t *targetlength)
 {
    uint32_t offset = 5;
 
@@ -431,8 +543,6 @@ static enum patch_error ips_apply_patch(
          patchdata[4] != 'H')
       return PATCH_PATCH_INVALID;
 
-   memcpy(targetdata, sourcedata, (size_t)sourcelength);
-
    *targetlength = sourcelength;
 
    for (;;)
@@ -456,7 +566,9 @@ static enum patch_error ips_apply_patch(
             uint32_t size = patchdata[offset++] << 16;
             size |= patchdata[offset++] << 8;
             size |= patchdata[offset++] << 0;
-            *targetlength = size;
+            /* Records past a truncation are still written first. */
+            if (size > *targetlength)
+               *targetlength = size;
             return PATCH_SUCCESS;
          }
       }
@@ -472,8 +584,7 @@ static enum patch_error ips_apply_patch(
          if (offset > patchlen - length)
             break;
 
-         while (length--)
-            targetdata[address++] = patchdata[offset++];
+         offset += length;
       }
       else /* RLE */
       {
@@ -486,32 +597,167 @@ static enum patch_error ips_apply_patch(
          if (length == 0) /* Illegal */
             break;
 
-         while (length--)
-            targetdata[address++] = patchdata[offset];
-
          offset++;
       }
 
-      if (address > *targetlength)
-         *targetlength = address;
+      if (address + length > *targetlength)
+         *targetlength = address + length;
+   }
+
+   return PATCH_PATCH_INVALID;
+}
+
+/* @targetdata may alias @sourcedata, in which case the
+ * records are written straight into the content. */
+static enum patch_error ips_apply_patch(
+      const uint8_t *patchdata, uint64_t patchlen,
+      const uint8_t *sourcedata, uint64_t sourcelength,
+      uint8_t *targetdata, uint64_t *targetlength,
+      struct patch_checksum *checksum)
+{
+   uint32_t offset   = 5;
+   uint64_t capacity = *targetlength;
+   /* Everything below this has been initialized. */
+   uint64_t written  = sourcelength;
+
+   if (patchlen < 8 ||
+         patchdata[0] != 'P' ||
+         patchdata[1] != 'A' ||
+         patchdata[2] != 'T' ||
+         patchdata[3] != 'C' ||
+         patchdata[4] != 'H')
+      return PATCH_PATCH_INVALID;
+
+   if (capacity < sourcelength)
+      return PATCH_TARGET_TOO_SMALL;
+
+   if (targetdata != sourcedata)
+      memcpy(targetdata, sourcedata, (size_t)sourcelength);
+
+   *targetlength = sourcelength;
+
+   for (;;)
+   {
+      bool rle;
+      uint32_t address;
+      unsigned length;
+
+      if (offset > patchlen - 3)
+         break;
+
+      address  = patchdata[offset++] << 16;
+      address |= patchdata[offset++] << 8;
+      address |= patchdata[offset++] << 0;
+
+      if (address == 0x454f46) /* EOF */
+      {
+         if (offset == patchlen)
+            goto success;
+         else if (offset == patchlen - 3)
+         {
+            uint32_t size = patchdata[offset++] << 16;
+            size |= patchdata[offset++] << 8;
+            size |= patchdata[offset++] << 0;
+            *targetlength = size;
+            goto success;
+         }
+      }
+
+      if (offset > patchlen - 2)
+         break;
+
+      length  = patchdata[offset++] << 8;
+      length |= patchdata[offset++] << 0;
+
+      rle      = !length;
+
+      if (!rle) /* Copy */
+      {
+         if (offset > patchlen - length)
+            break;
+      }
+      else /* RLE */
+      {
+         if (offset > patchlen - 3)
+            break;
+
+         length  = patchdata[offset + 0] << 8;
+         length |= patchdata[offset + 1] << 0;
+
+         if (length == 0) /* Illegal */
+            break;
+      }
+
+      if (address + length > capacity)
+         return PATCH_TARGET_TOO_SMALL;
+
+      /* Records may leave a gap past the end of the source. */
+      if (address > written)
+         memset(targetdata + written, 0, (size_t)(address - written));
+
+      if (rle)
+      {
+         memset(targetdata + address, patchdata[offset + 2], length);
+         offset += 3;
+      }
+      else
+      {
+         memcpy(targetdata + address, patchdata + offset, length);
+         offset += length;
+      }
+
+      if (address + length > written)
+         written = address + length;
+      if (address + length > *targetlength)
+         *targetlength = address + length;
    }
 
    return PATCH_PATCH_INVALID;
+
+success:
+   if (*targetlength > capacity)
+      return PATCH_TARGET_TOO_SMALL;
+   if (*targetlength > written)
+      memset(targetdata + written, 0, (size_t)(*targetlength - written));
+   checksum->target = encoding_crc32(0, targetdata, (size_t)*targetlength);
+   return PATCH_SUCCESS;
 }
 
 static bool apply_patch_content(uint8_t **buf,
       ssize_t *size, const char *patch_desc, const char *patch_path,
-      patch_func_t func, void *patch_data, int64_t patch_size)
+      patch_func_t func, patch_size_func_t size_func, bool in_place,
+      void *patch_data, int64_t patch_size,
+      struct patch_checksum *checksum)
 {
    enum patch_error err     = PATCH_UNKNOWN;
    ssize_t ret_size         = *size;
    uint8_t *ret_buf         = *buf;
-   uint64_t target_size     = ret_size * 4; /* Just to be sure. */
-   uint8_t *patched_content = (uint8_t*)malloc((size_t)target_size);
+   uint64_t target_size     = 0;
+   uint64_t alloc_size      = 0;
+   uint8_t *patched_content = NULL;
 
    RARCH_LOG("Found %s file in \"%s\", attempting to patch ...\n",
          patch_desc, patch_path);
 
+   err = size_func((const uint8_t*)patch_data, patch_size,
+         ret_size, &target_size);
+
+   if (err != PATCH_SUCCESS)
+      goto error;
+
+   /* Allocate exactly what the patch produces, plus the
+    * terminator the content loader guarantees. */
+   alloc_size = target_size;
+   if (in_place && alloc_size < (uint64_t)ret_size)
+      alloc_size = ret_size;
+
+   if ((uint64_t)(size_t)(alloc_size + 1) != alloc_size + 1)
+      patched_content = NULL;
+   else if (in_place)
+      patched_content = (uint8_t*)realloc(ret_buf, (size_t)(alloc_size + 1));
+   else
+      patched_content = (uint8_t*)malloc((size_t)(alloc_size + 1));
+
    if (!patched_content)
    {
       RARCH_ERR("%s\n",
@@ -523,30 +769,47 @@ static bool apply_patch_content(uint8_t **buf,
       return false;
    }
 
+   if (in_place)
+   {
+      /* The buffer moved, but the content is still unpatched. */
+      ret_buf = patched_content;
+      *buf    = ret_buf;
+   }
+
+   target_size = alloc_size;
+
    err = func((const uint8_t*)patch_data, patch_size, ret_buf,
-         ret_size, patched_content, &target_size);
+         ret_size, patched_content, &target_size, checksum);
 
    if (err == PATCH_SUCCESS)
    {
       RARCH_LOG("%s (%s).\n",
             msg_hash_to_str(MSG_FATAL_ERROR_RECEIVED_IN),
             patch_desc);
-      free(ret_buf);
-      *buf  = patched_content;
-      *size = target_size;
+      if (!in_place)
+         free(ret_buf);
+      patched_content[target_size] = '\0';
+      *buf              = patched_content;
+      *size             = target_size;
+      checksum->patched = true;
+      return true;
    }
-   else
-      RARCH_ERR("%s %s: %s #%u\n",
-            msg_hash_to_str(MSG_FAILED_TO_PATCH),
-            patch_desc,
-            msg_hash_to_str(MSG_ERROR),
-            (unsigned)err);
+
+   if (!in_place)
+      free(patched_content);
+
+error:
+   RARCH_ERR("%s %s: %s #%u\n",
+         msg_hash_to_str(MSG_FAILED_TO_PATCH),
+         patch_desc,
+         msg_hash_to_str(MSG_ERROR),
+         (unsigned)err);
 
    return true;
 }
 
 static bool try_bps_patch(bool allow_bps, const char *name_bps,
-      uint8_t **buf, ssize_t *size)
+      uint8_t **buf, ssize_t *size, struct patch_checksum *checksum)
 {
    if (allow_bps && !string_is_empty(name_bps))
       if (path_is_valid(name_bps) && filestream_exists(name_bps))
@@ -562,7 +825,8 @@ static bool try_bps_patch(bool allow_bps, const char *name_bps,
          {
             ret                      = apply_patch_content(
                   buf, size, "BPS", name_bps,
-                  bps_apply_patch, patch_data, patch_size);
+                  bps_apply_patch, bps_target_size, false,
+                  patch_data, patch_size, checksum);
          }
 
          if (patch_data)
@@ -573,7 +837,7 @@ static bool try_bps_patch(bool allow_bps, const char *name_bps,
 }
 
 static bool try_ups_patch(bool allow_ups, const char *name_ups,
-      uint8_t **buf, ssize_t *size)
+      uint8_t **buf, ssize_t *size, struct patch_checksum *checksum)
 {
    if (allow_ups && !string_is_empty(name_ups))
       if (path_is_valid(name_ups) && filestream_exists(name_ups))
@@ -589,7 +853,8 @@ static bool try_ups_patch(bool allow_ups, const char *name_ups,
          {
             ret                      = apply_patch_content(
                   buf, size, "UPS", name_ups,
-                  ups_apply_patch, patch_data, patch_size);
+                  ups_apply_patch, ups_target_size, false,
+                  patch_data, patch_size, checksum);
          }
 
          if (patch_data)
@@ -600,7 +865,8 @@ static bool try_ups_patch(bool allow_ups, const char *name_ups,
 }
 
 static bool try_ips_patch(bool allow_ips,
-      const char *name_ips, uint8_t **buf, ssize_t *size)
+      const char *name_ips, uint8_t **buf, ssize_t *size,
+      struct patch_checksum *checksum)
 {
    if (allow_ips && !string_is_empty(name_ips))
       if (path_is_valid(name_ips) && filestream_exists(name_ips))
@@ -616,7 +882,8 @@ static bool try_ips_patch(bool allow_ips,
          {
             ret                      = apply_patch_content(
                   buf, size, "IPS", name_ips,
-                  ips_apply_patch, patch_data, patch_size);
+                  ips_apply_patch, ips_target_size, true,
+                  patch_data, patch_size, checksum);
          }
 
          if (patch_data)
@@ -630,11 +897,14 @@ static bool try_ips_patch(bool allow_ips,
  * patch_content:
  * @buf          : buffer of the content file.
  * @size         : size   of the content file.
+ * @checksum     : CRC32 of the content, if already known. Receives
+ *                 the CRC32 of the patched content on success.
  *
  * Apply patch to the content file in-memory.
  *
+ * Returns: true if the content was patched.
  **/
-static void patch_content(
+static bool patch_content(
       bool is_ips_pref,
       bool is_bps_pref,
       bool is_ups_pref,
@@ -642,27 +912,32 @@ static void patch_content(
       const char *name_bps,
       const char *name_ups,
       uint8_t **buf,
-      void *data)
+      void *data,
+      struct patch_checksum *checksum)
 {
    ssize_t *size    = (ssize_t*)data;
    bool allow_ups   = !is_bps_pref && !is_ips_pref;
    bool allow_ips   = !is_ups_pref && !is_bps_pref;
    bool allow_bps   = !is_ups_pref && !is_ips_pref;
 
+   checksum->patched = false;
+
    if (    (unsigned)is_ips_pref
          + (unsigned)is_bps_pref
          + (unsigned)is_ups_pref > 1)
    {
       RARCH_WARN("%s\n",
             msg_hash_to_str(MSG_SEVERAL_PATCHES_ARE_EXPLICITLY_DEFINED));
-      return;
+      return false;
    }
 
-   if (     !try_ips_patch(allow_ips, name_ips, buf, size)
-         && !try_bps_patch(allow_bps, name_bps, buf, size)
-         && !try_ups_patch(allow_ups, name_ups, buf, size))
+   if (     !try_ips_patch(allow_ips, name_ips, buf, size, checksum)
+         && !try_bps_patch(allow_bps, name_bps, buf, size, checksum)
+         && !try_ups_patch(allow_ups, name_ups, buf, size, checksum))
    {
       RARCH_LOG("%s\n",
             msg_hash_to_str(MSG_DID_NOT_FIND_A_VALID_CONTENT_PATCH));
    }
+
+   return checksum->patched;
 }
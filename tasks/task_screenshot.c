@@ -31,6 +31,7 @@
 #include <string/stdstring.h>
 #include <gfx/scaler/scaler.h>
 #include <gfx/video_frame.h>
+#include <features/features_cpu.h>
 
 #ifdef HAVE_RBMP
 #include <formats/rbmp.h>
@@ -75,6 +76,13 @@ struct screenshot_task_state
    struct scaler_ctx scaler;
 };
 
+#if defined(HAVE_RPNG)
+/* Shared by all screenshots so that repeated captures
+ * (savestate thumbnails, bursts) reuse the encoder buffers.
+ * Screenshot tasks never run concurrently. */
+static rpng_encoder_t *screenshot_encoder = NULL;
+#endif
+
 /**
  * task_screenshot_handler:
  * @task : the task being worked on
@@ -123,7 +131,15 @@ static void task_screenshot_handler(retro_task_t *task)
 
    scaler_ctx_gen_reset(&state->scaler);
 
-   ret = rpng_save_image_bgr24(
+   if (!screenshot_encoder)
+      screenshot_encoder = rpng_encoder_new(
+            cpu_features_get_core_amount(), false);
+
+   /* Savestate thumbnails favour speed over file size. */
+   rpng_encoder_set_fast(screenshot_encoder, state->silence);
+
+   ret = rpng_encoder_save_image_bgr24(
+         screenshot_encoder,
          state->filename,
          state->out_buffer,
          state->width,
@@ -366,6 +382,14 @@ static bool take_screenshot_choice(const char *name_base, bool savestate,
    return ret;
 }
 
+void take_screenshot_deinit(void)
+{
+#if defined(HAVE_RPNG)
+   rpng_encoder_free(screenshot_encoder);
+   screenshot_encoder = NULL;
+#endif
+}
+
 bool take_screenshot(const char *name_base, bool silence, bool has_valid_framebuffer)
 {
    bool is_paused         = false;
@@ -124,6 +124,11 @@ bool task_push_netplay_nat_traversal(void *nat_traversal_state, uint16_t port);
 bool task_push_image_load(const char *fullpath,
       retro_task_callback_t cb, void *userdata);
 
+/* Same as task_push_image_load(), but returns the task (NULL on
+ * failure) so that it can be passed to task_queue_cancel_task(). */
+void *task_push_image_load_cancellable(const char *fullpath,
+      retro_task_callback_t cb, void *userdata);
+
 #ifdef HAVE_LIBRETRODB
 bool task_push_dbscan(
       const char *playlist_directory,
@@ -225,6 +230,8 @@ bool task_audio_mixer_load_handler(retro_task_t *task);
 
 bool take_screenshot(const char *path, bool silence, bool has_valid_framebuffer);
 
+void take_screenshot_deinit(void);
+
 bool event_load_save_files(void);
 
 bool event_save_files(void);
@@ -0,0 +1,11 @@
+#include "stub.h"
+#include "new_patch.c"
+int new_apply(int kind, const uint8_t *p, uint64_t pl, const uint8_t *s, uint64_t sl, uint8_t **out, uint64_t *ol, uint32_t *crc, int inplace, int known)
+{
+   uint8_t *buf = malloc(sl+1); ssize_t size = sl; struct patch_checksum c; bool r;
+   memcpy(buf,s,sl);
+   c.source = encoding_crc32(0,s,sl); c.has_source = known; c.patched=false; c.target=0;
+   r = apply_patch_content(&buf,&size,"X","x", kind==0?ips_apply_patch:kind==1?bps_apply_patch:ups_apply_patch,
+      kind==0?ips_target_size:kind==1?bps_target_size:ups_target_size, kind==0 && inplace, (void*)p, pl, &c);
+   *out=buf; *ol=size; *crc=c.target; return c.patched ? 1 : 0;
+}
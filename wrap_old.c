@@ -0,0 +1,8 @@
+#include "stub.h"
+#include "old_patch.c"
+int old_apply(int kind, const uint8_t *p, uint64_t pl, const uint8_t *s, uint64_t sl, uint8_t **out, uint64_t *ol)
+{
+   uint64_t tl = sl*4+1024; uint8_t *t = malloc(tl); enum patch_error e;
+   patch_func_t f = kind==0?ips_apply_patch:kind==1?bps_apply_patch:ups_apply_patch;
+   e = f(p,pl,s,sl,t,&tl); *out=t; *ol=tl; return e;
+}